@@ -0,0 +1,1796 @@
+// orbitlib_bench: micro- and macro-benchmarks of the core orbitlib functions
+//
+// Usage: orbitlib_bench [--json] [--filter <substring>] [--min-time <s>] [--fixtures <dir>] [--trace <file.json>] [--check-lambert]
+//                       [--check-partials] [--check-optim] [--check-alloc] [--check-mga]
+//                       [--check-windows] [--check-matrix] [--check-moid] [--check-conjunctions] [--check-montecarlo]
+//                       [--check-propagator] [--check-trajectory]
+//
+// --check-lambert solves the inputs of the Lambert cases once and reports solution counts, solver iterations and arrival accuracy
+// instead of timing.
+// --check-partials validates the analytic Lambert partials against finite differences on the Lambert inputs instead of timing.
+// --check-alloc loads ephemerides into a system through a context with a different (arena) allocator and checks that all memory
+// of the system stays owned by the system's allocator.
+// --check-optim compares search_optimal_transfers() with an exhaustive 1-day grid (delta-v evaluations and best delta-v) instead of
+// timing.
+// --check-mga compares the best direct and single-flyby trajectories of search_mga_trajectories() with a brute-force enumeration of
+// the same grid.
+// --check-windows compares find_launch_windows() with the phase angle crossings of a dense scan.
+// --check-matrix saves and maps a transfer matrix and compares its entries with Hohmann transfers and Lambert delta-vs computed
+// directly.
+// --check-moid compares calc_moid() with a brute-force search over the true anomalies of both orbits.
+// --check-conjunctions compares search_conjunctions() with the minima of a dense scan of every pair's distance.
+// --check-montecarlo compares run_monte_carlo() on 1 and several threads and its covariance with the linearly propagated one.
+// --check-propagator compares the numerical propagator without perturbations with the Kepler solution and its J2 node drift with
+// the secular rate.
+// --check-trajectory compares the states of a trajectory with Kepler's equation and checks its serialization round trip.
+//
+// Reports ns/op, solver iterations/op (if available) and heap allocations/op (if the build wraps the allocator).
+// All inputs are synthetic and bundled (bench/fixtures) or generated at runtime, so no network access is needed.
+
+#include "orbitlib.h"
+#include "orbitlib_fileio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#ifndef ORBITLIB_BENCH_FIXTURE_DIR
+#define ORBITLIB_BENCH_FIXTURE_DIR "bench/fixtures"
+#endif
+
+#define BENCH_SYNTHETIC_EPHEM_ID 1001
+#define BENCH_NUM_INPUTS 64
+#define BENCH_MAX_REVS 4
+#define BENCH_DATE_FLAGS (DATE_FMT_CLOCKTIME | DATE_FMT_MILLIS | DATE_FMT_ISO_T)
+
+
+/*
+ * ------------------------------------
+ * Timing & Allocation Counting
+ * ------------------------------------
+ */
+
+static double get_time_ns() {
+#ifdef _WIN32
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (double) count.QuadPart * 1e9 / (double) freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+#endif
+}
+
+static int64_t num_allocs = 0;
+
+#ifdef BENCH_COUNT_ALLOCS
+// linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (counts allocations of orbitlib and the benchmark, not libc-internal ones)
+void * __real_malloc(size_t size);
+void * __real_calloc(size_t num, size_t size);
+void * __real_realloc(void *ptr, size_t size);
+
+void * __wrap_malloc(size_t size) {
+	num_allocs++;
+	return __real_malloc(size);
+}
+
+void * __wrap_calloc(size_t num, size_t size) {
+	num_allocs++;
+	return __real_calloc(num, size);
+}
+
+void * __wrap_realloc(void *ptr, size_t size) {
+	num_allocs++;
+	return __real_realloc(ptr, size);
+}
+#endif
+
+// results are accumulated here so the compiler can't drop the benchmarked calls
+static volatile double bench_sink = 0;
+// the batch uses closed forms instead of plane constructions -> rounding differences only
+#define HYPERBOLA_BATCH_TOLERANCE 1e-9
+
+// largest deviation of get_hyperbola_params_batch() from get_hyperbola_params() on the inputs of the hyperbola cases
+static double max_hyperbola_batch_deviation = 0;
+// date_format() calls with too small buffers that didn't fail cleanly (return -1, empty string, nothing written past the buffer)
+static int64_t num_date_buffer_errors = 0;
+
+
+/*
+ * ------------------------------------
+ * Benchmark Cases
+ * ------------------------------------
+ */
+
+typedef struct BenchCase {
+	char name[64];
+	void (*run)(struct BenchCase *bench_case, int64_t num_ops);
+	Body *cb;
+	Orbit orbits[BENCH_NUM_INPUTS];
+	OSV osvs[BENCH_NUM_INPUTS];
+	double values[BENCH_NUM_INPUTS];
+	Body *ephem_body;
+	char filepath[256];
+	int date_type;
+	int hyperbola_type;
+	Vector3 v_body[BENCH_NUM_INPUTS];	// central body velocities of the hyperbola cases (osvs: arrival and departure velocities)
+	Datetime dates[BENCH_NUM_INPUTS];
+	char date_strings[BENCH_NUM_INPUTS][DATE_STRING_MAX];	// dates formatted with BENCH_DATE_FLAGS
+	int solver;		// solver whose iterations are reported (-1 if none)
+} BenchCase;
+
+typedef struct BenchResult {
+	double ns_per_op;
+	double iterations_per_op;	// negative if not available
+	double allocs_per_op;		// negative if not available
+	int64_t num_ops;
+} BenchResult;
+
+static void run_propagate_orbit_time(BenchCase *bench_case, int64_t num_ops) {
+	double sum = 0;
+	for(int64_t i = 0; i < num_ops; i++) {
+		int idx = (int) (i % BENCH_NUM_INPUTS);
+		sum += propagate_orbit_time(bench_case->orbits[idx], bench_case->values[idx]).ta;
+	}
+	bench_sink += sum;
+}
+
+static void run_propagate_osv_covariance(BenchCase *bench_case, int64_t num_ops) {
+	double cov[6][6] = {{0}};
+	for(int k = 0; k < 6; k++) cov[k][k] = k < 3 ? 1e6 : 1;
+	double sum = 0;
+	for(int64_t i = 0; i < num_ops; i++) {
+		int idx = (int) (i % BENCH_NUM_INPUTS);
+		OSV osv;
+		double out_cov[6][6];
+		propagate_osv_covariance_batch(&bench_case->osvs[idx], &cov, 1, bench_case->cb, bench_case->values[idx], &osv, &out_cov);
+		sum += osv.r.x + out_cov[0][0];
+	}
+	bench_sink += sum;
+}
+
+static void run_lambert3(BenchCase *bench_case, int64_t num_ops) {
+	double sum = 0;
+	for(int64_t i = 0; i < num_ops; i++) {
+		int idx = (int) (i % BENCH_NUM_INPUTS);
+		Lambert3 transfer = calc_lambert3(bench_case->osvs[idx].r, bench_case->osvs[idx].v, bench_case->values[idx], bench_case->cb);
+		sum += transfer.v0.x;
+	}
+	bench_sink += sum;
+}
+
+static void run_lambert3_partials(BenchCase *bench_case, int64_t num_ops) {
+	double sum = 0;
+	LambertPartials partials;
+	for(int64_t i = 0; i < num_ops; i++) {
+		int idx = (int) (i % BENCH_NUM_INPUTS);
+		Lambert3 transfer = calc_lambert3_partials(bench_case->osvs[idx].r, bench_case->osvs[idx].v, bench_case->values[idx], bench_case->cb, &partials);
+		sum += transfer.v0.x + partials.dv0_dtof[0];
+	}
+	bench_sink += sum;
+}
+
+// one op = one transfer time (sweeps over all inputs with the positions of the first input)
+static void run_lambert3_tof_sweep(BenchCase *bench_case, int64_t num_ops) {
+	double sum = 0;
+	Lambert3 solutions[BENCH_NUM_INPUTS];
+	for(int64_t i = 0; i < num_ops; i += BENCH_NUM_INPUTS) {
+		int num_dts = num_ops - i < BENCH_NUM_INPUTS ? (int) (num_ops - i) : BENCH_NUM_INPUTS;
+		calc_lambert3_tof_sweep(bench_case->osvs[0].r, bench_case->osvs[0].v, bench_case->values, num_dts, bench_case->cb, solutions);
+		sum += solutions[num_dts-1].v0.x;
+	}
+	bench_sink += sum;
+}
+
+static void run_lambert3_multirev(BenchCase *bench_case, int64_t num_ops) {
+	double sum = 0;
+	Lambert3 solutions[LAMBERT_MAX_SOLUTIONS(BENCH_MAX_REVS)];
+	for(int64_t i = 0; i < num_ops; i++) {
+		int idx = (int) (i % BENCH_NUM_INPUTS);
+		int num_solutions = calc_lambert3_multirev(bench_case->osvs[idx].r, bench_case->osvs[idx].v, bench_case->values[idx], bench_case->cb,
+												   BENCH_MAX_REVS, solutions, LAMBERT_MAX_SOLUTIONS(BENCH_MAX_REVS));
+		sum += num_solutions > 0 ? solutions[num_solutions-1].v0.x : 0;
+	}
+	bench_sink += sum;
+}
+
+static void run_osv_from_ephem(BenchCase *bench_case, int64_t num_ops) {
+	Body *body = bench_case->ephem_body;
+	double sum = 0;
+	for(int64_t i = 0; i < num_ops; i++) {
+		int idx = (int) (i % BENCH_NUM_INPUTS);
+		sum += osv_from_ephem(body->ephem, body->num_ephems, bench_case->values[idx], body->orbit.cb).r.x;
+	}
+	bench_sink += sum;
+}
+
+static void run_constr_orbit_from_osv(BenchCase *bench_case, int64_t num_ops) {
+	double sum = 0;
+	for(int64_t i = 0; i < num_ops; i++) {
+		int idx = (int) (i % BENCH_NUM_INPUTS);
+		sum += constr_orbit_from_osv(bench_case->osvs[idx].r, bench_case->osvs[idx].v, bench_case->cb).ta;
+	}
+	bench_sink += sum;
+}
+
+static void run_get_hyperbola_params(BenchCase *bench_case, int64_t num_ops) {
+	double sum = 0;
+	for(int64_t i = 0; i < num_ops; i++) {
+		int idx = (int) (i % BENCH_NUM_INPUTS);
+		HyperbolaParams hyp = get_hyperbola_params(bench_case->osvs[idx].r, bench_case->osvs[idx].v, bench_case->v_body[idx], bench_case->cb, 200e3, bench_case->hyperbola_type);
+		sum += hyp.rp + hyp.incoming.decl + hyp.outgoing.bvazi;
+	}
+	bench_sink += sum;
+}
+
+// one op is one hyperbola (evaluated in batches of BENCH_NUM_INPUTS)
+static void run_get_hyperbola_params_batch(BenchCase *bench_case, int64_t num_ops) {
+	Vector3 v_arr[BENCH_NUM_INPUTS], v_dep[BENCH_NUM_INPUTS];
+	double rp[BENCH_NUM_INPUTS], c3_energy[BENCH_NUM_INPUTS], decl[2][BENCH_NUM_INPUTS], bplane_angle[2][BENCH_NUM_INPUTS], bvazi[2][BENCH_NUM_INPUTS];
+	HyperbolaParamsArrays out = {rp, c3_energy, {decl[0], bplane_angle[0], bvazi[0]}, {decl[1], bplane_angle[1], bvazi[1]}};
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) {
+		v_arr[i] = bench_case->osvs[i].r;
+		v_dep[i] = bench_case->osvs[i].v;
+	}
+	double sum = 0;
+	for(int64_t i = 0; i < num_ops; i += BENCH_NUM_INPUTS) {
+		int num = num_ops - i < BENCH_NUM_INPUTS ? (int) (num_ops - i) : BENCH_NUM_INPUTS;
+		get_hyperbola_params_batch(v_arr, v_dep, bench_case->v_body, num, bench_case->cb, 200e3, bench_case->hyperbola_type, &out);
+		sum += rp[0] + decl[0][0] + bvazi[1][0];
+	}
+	bench_sink += sum;
+}
+
+static void run_convert_JD_date(BenchCase *bench_case, int64_t num_ops) {
+	double sum = 0;
+	for(int64_t i = 0; i < num_ops; i++) {
+		int idx = (int) (i % BENCH_NUM_INPUTS);
+		sum += convert_JD_date(bench_case->values[idx], bench_case->date_type).s;
+	}
+	bench_sink += sum;
+}
+
+static void run_date_format(BenchCase *bench_case, int64_t num_ops) {
+	char buf[DATE_STRING_MAX];
+	double sum = 0;
+	for(int64_t i = 0; i < num_ops; i++) {
+		int idx = (int) (i % BENCH_NUM_INPUTS);
+		sum += date_format(bench_case->dates[idx], buf, sizeof(buf), BENCH_DATE_FLAGS) + buf[0];
+	}
+	bench_sink += sum;
+}
+
+// formats into a buffer one byte too small for the terminator; the byte after the buffer must stay untouched
+static void run_date_format_bounded(BenchCase *bench_case, int64_t num_ops) {
+	char buf[DATE_STRING_MAX + 1];
+	double sum = 0;
+	for(int64_t i = 0; i < num_ops; i++) {
+		int idx = (int) (i % BENCH_NUM_INPUTS);
+		size_t buf_size = strlen(bench_case->date_strings[idx]);
+		buf[buf_size] = '#';
+		int len = date_format(bench_case->dates[idx], buf, buf_size, BENCH_DATE_FLAGS);
+		if(len != -1 || (buf_size > 0 && buf[0] != '\0') || buf[buf_size] != '#') num_date_buffer_errors++;
+		sum += len;
+	}
+	bench_sink += sum;
+}
+
+static void run_date_parse(BenchCase *bench_case, int64_t num_ops) {
+	double sum = 0;
+	for(int64_t i = 0; i < num_ops; i++) {
+		int idx = (int) (i % BENCH_NUM_INPUTS);
+		Datetime date = {0};
+		const char *s = bench_case->date_strings[idx];
+		sum += date_parse(s, strlen(s), bench_case->date_type, &date) + date.s;
+	}
+	bench_sink += sum;
+}
+
+static void run_load_cfg_file(BenchCase *bench_case, int64_t num_ops) {
+	for(int64_t i = 0; i < num_ops; i++) {
+		CelestSystem *system = load_celestial_system_from_cfg_file(bench_case->filepath);
+		if(system == NULL) return;
+		bench_sink += system->num_bodies;
+		free_celestial_system(system);
+	}
+}
+
+static BenchResult run_bench_case(BenchCase *bench_case, double min_time_ns) {
+	bench_case->run(bench_case, 1);	// warm-up
+
+	int64_t num_ops = 1;
+	double elapsed;
+	int64_t allocs;
+	uint64_t iterations;
+	for(;;) {
+		int64_t allocs0 = num_allocs;
+		uint64_t iterations0 = bench_case->solver >= 0 ? get_solver_stats(bench_case->solver).iterations : 0;
+		double t0 = get_time_ns();
+		bench_case->run(bench_case, num_ops);
+		elapsed = get_time_ns() - t0;
+		allocs = num_allocs - allocs0;
+		iterations = bench_case->solver >= 0 ? get_solver_stats(bench_case->solver).iterations - iterations0 : 0;
+		if(elapsed >= min_time_ns || num_ops >= ((int64_t) 1 << 40)) break;
+		// aim for the minimum time with the next run (at most 10x more ops)
+		double factor = elapsed > 0 ? 1.2 * min_time_ns / elapsed : 10;
+		if(factor > 10) factor = 10;
+		if(factor < 2) factor = 2;
+		num_ops = (int64_t) ((double) num_ops * factor);
+	}
+
+	BenchResult result = {
+			.ns_per_op = elapsed / (double) num_ops,
+			.iterations_per_op = bench_case->solver >= 0 && are_solver_stats_enabled() ? (double) iterations / (double) num_ops : -1,
+			.num_ops = num_ops
+	};
+#ifdef BENCH_COUNT_ALLOCS
+	result.allocs_per_op = (double) allocs / (double) num_ops;
+#else
+	(void) allocs;
+	result.allocs_per_op = -1;
+#endif
+	return result;
+}
+
+
+/*
+ * ------------------------------------
+ * Inputs
+ * ------------------------------------
+ */
+
+static void init_propagation_case(BenchCase *bench_case, Body *cb, double e, double dt_factor) {
+	bench_case->run = run_propagate_orbit_time;
+	bench_case->solver = SOLVER_PROPAGATE_ORBIT_TIME;
+	bench_case->cb = cb;
+	double a = e < 1 ? 1.5e11 : -1.5e11;
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) {
+		// spread initial true anomalies; hyperbolas stay within their asymptotes
+		double ta = e < 1 ? 2*M_PI * i / BENCH_NUM_INPUTS : (-0.5 + (double) i / BENCH_NUM_INPUTS) * 0.8 * acos(-1/e);
+		bench_case->orbits[i] = constr_orbit_from_elements(a, e, deg2rad(5), deg2rad(10), deg2rad(20), pi_norm(ta), cb);
+		double T = e < 1 ? calc_orbital_period(bench_case->orbits[i]) : 86400*365.25;
+		bench_case->values[i] = dt_factor * T * (0.9 + 0.2 * i / BENCH_NUM_INPUTS);
+	}
+	snprintf(bench_case->name, sizeof(bench_case->name), "propagate_orbit_time/e=%.2f/dt=%gT", e, dt_factor);
+}
+
+static void init_covariance_case(BenchCase *bench_case, Body *cb, double e) {
+	init_propagation_case(bench_case, cb, e, 0.5);
+	bench_case->run = run_propagate_osv_covariance;
+	bench_case->solver = -1;
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) bench_case->osvs[i] = osv_from_orbit(bench_case->orbits[i]);
+	snprintf(bench_case->name, sizeof(bench_case->name), "propagate_osv_covariance_batch/e=%.2f/dt=0.5T", e);
+}
+
+static void init_lambert_case(BenchCase *bench_case, Body *cb, double transfer_angle_deg, int with_partials) {
+	bench_case->run = with_partials ? run_lambert3_partials : run_lambert3;
+	bench_case->solver = SOLVER_LAMBERT2;
+	bench_case->cb = cb;
+	double r0 = 1.5e11, r1 = 2.2e11;
+	double dta = deg2rad(transfer_angle_deg);
+	// time of flight scaled with the transfer angle (Hohmann transfer time as reference)
+	double hohmann_dt = M_PI * sqrt(pow((r0+r1)/2, 3) / cb->mu);
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) {
+		double theta = 2*M_PI * i / BENCH_NUM_INPUTS;
+		// reuse the osv slots as (r0, r1) pairs
+		bench_case->osvs[i].r = vec3(r0*cos(theta), r0*sin(theta), 0);
+		bench_case->osvs[i].v = vec3(r1*cos(theta+dta), r1*sin(theta+dta), 0.02*r1*sin(dta/2));
+		bench_case->values[i] = hohmann_dt * (dta / M_PI) * (0.3 + 0.3 * i / BENCH_NUM_INPUTS);
+	}
+	snprintf(bench_case->name, sizeof(bench_case->name), "%s/transfer_angle=%g", with_partials ? "calc_lambert3_partials" : "calc_lambert3", transfer_angle_deg);
+}
+
+static void init_lambert_sweep_case(BenchCase *bench_case, Body *cb, double transfer_angle_deg) {
+	bench_case->run = run_lambert3_tof_sweep;
+	bench_case->solver = SOLVER_LAMBERT2;
+	bench_case->cb = cb;
+	double r0 = 1.5e11, r1 = 2.2e11;
+	double dta = deg2rad(transfer_angle_deg);
+	double hohmann_dt = M_PI * sqrt(pow((r0+r1)/2, 3) / cb->mu);
+	bench_case->osvs[0].r = vec3(r0, 0, 0);
+	bench_case->osvs[0].v = vec3(r1*cos(dta), r1*sin(dta), 0.02*r1*sin(dta/2));
+	// same transfer times as the calc_lambert3 cases, in ascending order
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) bench_case->values[i] = hohmann_dt * (dta / M_PI) * (0.3 + 0.3 * i / BENCH_NUM_INPUTS);
+	snprintf(bench_case->name, sizeof(bench_case->name), "calc_lambert3_tof_sweep/transfer_angle=%g", transfer_angle_deg);
+}
+
+static void init_lambert_multirev_case(BenchCase *bench_case, Body *cb) {
+	bench_case->run = run_lambert3_multirev;
+	bench_case->solver = SOLVER_LAMBERT_MULTIREV;
+	bench_case->cb = cb;
+	double r0 = 1.5e11, r1 = 2.2e11;
+	double hohmann_dt = M_PI * sqrt(pow((r0+r1)/2, 3) / cb->mu);
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) {
+		double theta = 2*M_PI * i / BENCH_NUM_INPUTS;
+		double dta = deg2rad(20 + 320.0 * i / BENCH_NUM_INPUTS);
+		bench_case->osvs[i].r = vec3(r0*cos(theta), r0*sin(theta), 0);
+		bench_case->osvs[i].v = vec3(r1*cos(theta+dta), r1*sin(theta+dta), 0.02*r1*sin(dta/2));
+		// long enough for several revolutions
+		bench_case->values[i] = hohmann_dt * (2 + 8.0 * i / BENCH_NUM_INPUTS);
+	}
+	snprintf(bench_case->name, sizeof(bench_case->name), "calc_lambert3_multirev/max_revs=%d", BENCH_MAX_REVS);
+}
+
+static void init_constr_orbit_case(BenchCase *bench_case, Body *cb) {
+	bench_case->run = run_constr_orbit_from_osv;
+	bench_case->solver = -1;
+	bench_case->cb = cb;
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) {
+		double e = 0.9 * i / BENCH_NUM_INPUTS;
+		Orbit orbit = constr_orbit_from_elements(1.5e11, e, deg2rad(i % 30), deg2rad(7*i), deg2rad(13*i), deg2rad(29*i % 360), cb);
+		bench_case->osvs[i] = osv_from_orbit(orbit);
+	}
+	snprintf(bench_case->name, sizeof(bench_case->name), "constr_orbit_from_osv");
+}
+
+static double get_angle_deviation(double a, double b) {
+	double deviation = fmod(fabs(a - b), 2*M_PI);
+	return fmin(deviation, 2*M_PI - deviation);
+}
+
+// largest deviation of the batch from the scalar results (relative for rp and C3, absolute for angles [rad])
+static double compare_hyperbola_batch(BenchCase *bench_case) {
+	Vector3 v_arr[BENCH_NUM_INPUTS], v_dep[BENCH_NUM_INPUTS];
+	double rp[BENCH_NUM_INPUTS], c3_energy[BENCH_NUM_INPUTS], decl[2][BENCH_NUM_INPUTS], bplane_angle[2][BENCH_NUM_INPUTS], bvazi[2][BENCH_NUM_INPUTS];
+	HyperbolaParamsArrays out = {rp, c3_energy, {decl[0], bplane_angle[0], bvazi[0]}, {decl[1], bplane_angle[1], bvazi[1]}};
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) {
+		v_arr[i] = bench_case->osvs[i].r;
+		v_dep[i] = bench_case->osvs[i].v;
+	}
+	get_hyperbola_params_batch(v_arr, v_dep, bench_case->v_body, BENCH_NUM_INPUTS, bench_case->cb, 200e3, bench_case->hyperbola_type, &out);
+
+	double max_deviation = 0;
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) {
+		HyperbolaParams hyp = get_hyperbola_params(v_arr[i], v_dep[i], bench_case->v_body[i], bench_case->cb, 200e3, bench_case->hyperbola_type);
+		double deviations[] = {
+				fabs(rp[i] - hyp.rp) / hyp.rp,
+				fabs(c3_energy[i] - hyp.c3_energy) / hyp.c3_energy,
+				bench_case->hyperbola_type != HYP_DEPARTURE ? get_angle_deviation(decl[0][i], hyp.incoming.decl) : 0,
+				bench_case->hyperbola_type != HYP_DEPARTURE ? get_angle_deviation(bplane_angle[0][i], hyp.incoming.bplane_angle) : 0,
+				bench_case->hyperbola_type != HYP_DEPARTURE ? get_angle_deviation(bvazi[0][i], hyp.incoming.bvazi) : 0,
+				bench_case->hyperbola_type != HYP_ARRIVAL ? get_angle_deviation(decl[1][i], hyp.outgoing.decl) : 0,
+				bench_case->hyperbola_type != HYP_ARRIVAL ? get_angle_deviation(bplane_angle[1][i], hyp.outgoing.bplane_angle) : 0,
+				bench_case->hyperbola_type != HYP_ARRIVAL ? get_angle_deviation(bvazi[1][i], hyp.outgoing.bvazi) : 0
+		};
+		for(int j = 0; j < (int) (sizeof(deviations)/sizeof(double)); j++) {
+			if(!(deviations[j] <= max_deviation)) max_deviation = deviations[j];	// also catches NaN
+		}
+	}
+	return max_deviation;
+}
+
+static void init_hyperbola_case(BenchCase *bench_case, Body *body, enum HyperbolaType type, int batch) {
+	bench_case->run = batch ? run_get_hyperbola_params_batch : run_get_hyperbola_params;
+	bench_case->solver = -1;
+	bench_case->cb = body;
+	bench_case->hyperbola_type = type;
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) {
+		// body on a circular heliocentric orbit; excess speeds of 2-9 km/s in all directions
+		double theta = deg2rad(5.7*i), vinf = 2000 + 7000.0 * i / BENCH_NUM_INPUTS;
+		Vector3 v_body = vec3(-29780*sin(theta), 29780*cos(theta), 0);
+		Vector3 vinf_arr = scale_vec3(norm_vec3(vec3(cos(deg2rad(37*i)), sin(deg2rad(37*i)), sin(deg2rad(11*i)))), vinf);
+		Vector3 vinf_dep = scale_vec3(norm_vec3(vec3(cos(deg2rad(53*i+90)), sin(deg2rad(53*i+90)), cos(deg2rad(17*i)))), vinf);
+		bench_case->v_body[i] = v_body;
+		bench_case->osvs[i] = (OSV) {add_vec3(v_body, vinf_arr), add_vec3(v_body, vinf_dep)};
+	}
+	const char *type_name = type == HYP_DEPARTURE ? "departure" : type == HYP_ARRIVAL ? "arrival" : "flyby";
+	snprintf(bench_case->name, sizeof(bench_case->name), "get_hyperbola_params%s/%s", batch ? "_batch" : "", type_name);
+	if(batch) {
+		double deviation = compare_hyperbola_batch(bench_case);
+		if(!(deviation <= max_hyperbola_batch_deviation)) max_hyperbola_batch_deviation = deviation;
+	}
+}
+
+static void init_ephem_case(BenchCase *bench_case, Body *body) {
+	bench_case->run = run_osv_from_ephem;
+	bench_case->solver = -1;
+	bench_case->ephem_body = body;
+	double first = body->ephem[0].epoch;
+	double last = body->ephem[body->num_ephems-1].epoch;
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) {
+		// pseudo-random spread over the ephemeris window
+		bench_case->values[i] = first + (last-first) * ((i * 37) % BENCH_NUM_INPUTS + 0.5) / BENCH_NUM_INPUTS;
+	}
+	snprintf(bench_case->name, sizeof(bench_case->name), "osv_from_ephem/num_ephems=%d", body->num_ephems);
+}
+
+static void init_date_case(BenchCase *bench_case, enum DateType date_type) {
+	bench_case->run = run_convert_JD_date;
+	bench_case->solver = -1;
+	bench_case->date_type = date_type;
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) {
+		bench_case->values[i] = date_type == DATE_ISO ? 2433282.5 + 200.37 * i : 0.5 + 31.17 * i * i;
+	}
+	snprintf(bench_case->name, sizeof(bench_case->name), "convert_JD_date/%s", date_type == DATE_ISO ? "iso" : "kerbal");
+}
+
+// mode: 0 = date_format, 1 = date_format into too small buffers, 2 = date_parse
+static void init_date_string_case(BenchCase *bench_case, enum DateType date_type, int mode) {
+	bench_case->run = mode == 0 ? run_date_format : mode == 1 ? run_date_format_bounded : run_date_parse;
+	bench_case->solver = -1;
+	bench_case->date_type = date_type;
+	for(int i = 0; i < BENCH_NUM_INPUTS; i++) {
+		double jd = date_type == DATE_ISO ? 2433282.5 + 200.37 * i : 0.5 + 31.17 * i * i;
+		bench_case->dates[i] = convert_JD_date(jd, date_type);
+		date_format(bench_case->dates[i], bench_case->date_strings[i], DATE_STRING_MAX, BENCH_DATE_FLAGS);
+	}
+	snprintf(bench_case->name, sizeof(bench_case->name), "%s/%s%s", mode == 2 ? "date_parse" : "date_format",
+			 date_type == DATE_ISO ? "iso" : "kerbal", mode == 1 ? "/buffer_too_small" : "");
+}
+
+static void init_cfg_case(BenchCase *bench_case, const char *filepath, const char *label) {
+	bench_case->run = run_load_cfg_file;
+	bench_case->solver = -1;
+	snprintf(bench_case->filepath, sizeof(bench_case->filepath), "%s", filepath);
+	snprintf(bench_case->name, sizeof(bench_case->name), "load_celestial_system_from_cfg_file/%s", label);
+}
+
+// writes a synthetic catalog with the given number of planets (each with num_moons moons) to filepath
+static int write_synthetic_catalog(const char *filepath, int num_planets, int num_moons) {
+	FILE *file = fopen(filepath, "w");
+	if(file == NULL) return 0;
+	fprintf(file, "[Synthetic Large]\npropagation_method = ELEMENTS\nut0 = 2451545.0\ntime_scale = TDB\n"
+				  "number_of_bodies = %d\ncentral_body = Star\nunits = M_DEG_PA\n\n", num_planets * (1 + num_moons));
+	fprintf(file, "[Star]\ncolor = [1.000, 0.900, 0.600]\nid = 100\ngravitational_parameter = 1.32712440018e20\n"
+				  "radius = 696000000\nrotational_period = 2192832\n\n");
+	int id = 101;
+	for(int p = 0; p < num_planets; p++) {
+		fprintf(file, "[Planet_%04d]\ncolor = [0.500, 0.500, 0.500]\nid = %d\ngravitational_parameter = %e\nradius = %d\n"
+					  "rotational_period = 86400\nsemi_major_axis = %e\neccentricity = %.3f\ninclination = %.2f\nraan = %d\n"
+					  "argument_of_periapsis = %d\nmean_anomaly_ut0 = %.3f\nparent_body = Star\n\n",
+				p, id++, 3e14 * (1 + p % 5), 3000000 + 1000 * p, 5e10 * (1 + 0.05 * p), 0.01 + 0.02 * (p % 7), 0.5 * (p % 9),
+				(37 * p) % 360, (53 * p) % 360, fmod(1.3 * p, 6.28));
+		for(int m = 0; m < num_moons; m++) {
+			fprintf(file, "[Planet_%04d_Moon_%d]\ncolor = [0.700, 0.700, 0.700]\nid = %d\ngravitational_parameter = %e\n"
+						  "radius = %d\nrotational_period = 2360592\nsemi_major_axis = %e\neccentricity = %.3f\ninclination = %d\n"
+						  "raan = %d\nargument_of_periapsis = %d\nmean_anomaly_ut0 = %d\nparent_body = Planet_%04d\n\n",
+					p, m, id++, 4.9e12 / (m + 1), 1700000 - 100000 * m, 3.8e8 * (m + 1), 0.05 * (m % 4), 5 + m, 20 * m, 90 * m, m % 6, p);
+		}
+	}
+	fclose(file);
+	return 1;
+}
+
+
+/*
+ * ------------------------------------
+ * Output
+ * ------------------------------------
+ */
+
+static void print_json_number(double value, const char *format) {
+	if(value < 0 || isnan(value)) printf("null");
+	else printf(format, value);
+}
+
+static void print_results(BenchCase *cases, BenchResult *results, int num_cases, int json, double min_time) {
+	if(json) {
+		printf("{\n  \"min_time_s\": %g,\n  \"solver_stats\": ", min_time);
+		dump_solver_stats_json(stdout);
+		printf(",\n  \"benchmarks\": [\n");
+		for(int i = 0; i < num_cases; i++) {
+			printf("    {\"name\": \"%s\", \"ns_per_op\": ", cases[i].name);
+			print_json_number(results[i].ns_per_op, "%.3f");
+			printf(", \"iterations_per_op\": ");
+			print_json_number(results[i].iterations_per_op, "%.3f");
+			printf(", \"allocs_per_op\": ");
+			print_json_number(results[i].allocs_per_op, "%.3f");
+			printf(", \"ops\": %lld}%s\n", (long long) results[i].num_ops, i < num_cases-1 ? "," : "");
+		}
+		printf("  ]\n}\n");
+		return;
+	}
+
+	printf("%-52s %14s %10s %10s\n", "benchmark", "ns/op", "iter/op", "allocs/op");
+	for(int i = 0; i < num_cases; i++) {
+		printf("%-52s %14.1f ", cases[i].name, results[i].ns_per_op);
+		if(results[i].iterations_per_op >= 0) printf("%10.2f ", results[i].iterations_per_op);
+		else printf("%10s ", "-");
+		if(results[i].allocs_per_op >= 0) printf("%10.2f\n", results[i].allocs_per_op);
+		else printf("%10s\n", "-");
+	}
+}
+
+
+/*
+ * ------------------------------------
+ * Lambert Solver Check
+ * ------------------------------------
+ */
+
+// relative distance from r1 within which a propagated solution counts as reaching it (the solver stops within 1s of the transfer time)
+#define LAMBERT_ARRIVAL_TOLERANCE 1e-5
+
+// solves the inputs of the Lambert cases once; returns the number of solutions not reaching r1
+static int check_lambert_solutions(BenchCase *cases, int num_cases, const char *filter) {
+	int num_missed = 0;
+	printf("%-40s %8s %8s %12s %14s\n", "case", "solved", "reached", "iter/solve", "max rel. error");
+	for(int i = 0; i < num_cases; i++) {
+		if(cases[i].run != run_lambert3) continue;
+		if(filter != NULL && strstr(cases[i].name, filter) == NULL) continue;
+		int num_solved = 0, num_reached = 0;
+		double max_error = 0;
+		uint64_t calls0 = get_solver_stats(SOLVER_LAMBERT2).calls, iterations0 = get_solver_stats(SOLVER_LAMBERT2).iterations;
+		for(int j = 0; j < BENCH_NUM_INPUTS; j++) {
+			Vector3 r0 = cases[i].osvs[j].r, r1 = cases[i].osvs[j].v;
+			Lambert3 transfer = calc_lambert3(r0, r1, cases[i].values[j], cases[i].cb);
+			if(transfer.success != LAMBERT_SUCCESS) continue;
+			num_solved++;
+			OSV arrival = propagate_osv_time((OSV) {r0, transfer.v0}, cases[i].cb, cases[i].values[j]);
+			double error = mag_vec3(subtract_vec3(arrival.r, r1)) / mag_vec3(r1);
+			if(!(error < LAMBERT_ARRIVAL_TOLERANCE)) continue;
+			num_reached++;
+			if(error > max_error) max_error = error;
+		}
+		uint64_t calls = get_solver_stats(SOLVER_LAMBERT2).calls - calls0;
+		uint64_t iterations = get_solver_stats(SOLVER_LAMBERT2).iterations - iterations0;
+		printf("%-40s %5d/%-2d %8d ", cases[i].name, num_solved, BENCH_NUM_INPUTS, num_reached);
+		if(are_solver_stats_enabled() && calls > 0) printf("%12.2f ", (double) iterations / (double) calls);
+		else printf("%12s ", "-");
+		printf("%14.2e\n", max_error);
+		num_missed += num_solved - num_reached;
+	}
+	return num_missed;
+}
+
+
+/*
+ * ------------------------------------
+ * Lambert Partials Validation
+ * ------------------------------------
+ */
+
+// finite differences are limited by the time of flight tolerance of the Lambert solver (1s); formula errors show up as O(1)
+#define PARTIALS_TOLERANCE 1e-2
+
+// compares analytic and finite-difference partials on the inputs of the Lambert cases; returns the number of failed cases
+static int check_lambert_partials(BenchCase *cases, int num_cases, const char *filter) {
+	int num_failed = 0;
+	for(int i = 0; i < num_cases; i++) {
+		if(cases[i].run != run_lambert3_partials) continue;
+		if(filter != NULL && strstr(cases[i].name, filter) == NULL) continue;
+		double max_deviation = 0;
+		int num_checked = 0, num_missed = 0;
+		for(int j = 0; j < BENCH_NUM_INPUTS; j++) {
+			LambertPartials analytic, finite_diff;
+			Vector3 r0 = cases[i].osvs[j].r, r1 = cases[i].osvs[j].v;
+			Lambert3 transfer = calc_lambert3_partials(r0, r1, cases[i].values[j], cases[i].cb, &analytic);
+			if(transfer.success != LAMBERT_SUCCESS) continue;
+			// partials of a solution not reaching r1 are meaningless -> the case fails
+			OSV arrival = propagate_osv_time_stm((OSV) {r0, transfer.v0}, cases[i].cb, cases[i].values[j], NULL);
+			if(!(mag_vec3(subtract_vec3(arrival.r, r1)) < LAMBERT_ARRIVAL_TOLERANCE * mag_vec3(r1))) {num_missed++; continue;}
+			if(!calc_lambert3_partials_fd(r0, r1, cases[i].values[j], cases[i].cb, &finite_diff)) continue;
+			double deviation = compare_lambert_partials(&analytic, &finite_diff);
+			if(!(deviation <= max_deviation)) max_deviation = deviation;	// also catches NaN
+			num_checked++;
+		}
+		int failed = num_missed > 0 || !(max_deviation <= PARTIALS_TOLERANCE);
+		printf("%-40s %3d inputs (%d not reaching r1)  max rel. deviation: %.2e  %s\n", cases[i].name, num_checked, num_missed, max_deviation, failed ? "FAIL" : "ok");
+		num_failed += failed;
+	}
+	return num_failed;
+}
+
+
+/*
+ * ------------------------------------
+ * Mixed Allocator Check
+ * ------------------------------------
+ */
+
+#define TRACKING_ALLOCATOR_MAX_PTRS 1024
+
+// allocator remembering its live allocations, so pointers it didn't allocate are detected instead of freed
+typedef struct TrackingAllocator {
+	void *ptrs[TRACKING_ALLOCATOR_MAX_PTRS];
+	int num_ptrs;
+	int num_foreign;	// frees and reallocs of pointers not allocated by this allocator
+} TrackingAllocator;
+
+static int find_tracked_ptr(TrackingAllocator *tracker, void *ptr) {
+	for(int i = 0; i < tracker->num_ptrs; i++) if(tracker->ptrs[i] == ptr) return i;
+	return -1;
+}
+
+static void * tracking_malloc(size_t size, void *user_data) {
+	TrackingAllocator *tracker = user_data;
+	if(tracker->num_ptrs == TRACKING_ALLOCATOR_MAX_PTRS) return NULL;
+	void *ptr = malloc(size);
+	if(ptr != NULL) tracker->ptrs[tracker->num_ptrs++] = ptr;
+	return ptr;
+}
+
+static void * tracking_realloc(void *ptr, size_t size, void *user_data) {
+	TrackingAllocator *tracker = user_data;
+	if(ptr == NULL) return tracking_malloc(size, user_data);
+	int idx = find_tracked_ptr(tracker, ptr);
+	if(idx < 0) {tracker->num_foreign++; return NULL;}
+	void *new_ptr = realloc(ptr, size);
+	if(new_ptr != NULL) tracker->ptrs[idx] = new_ptr;
+	return new_ptr;
+}
+
+static void tracking_free(void *ptr, void *user_data) {
+	TrackingAllocator *tracker = user_data;
+	if(ptr == NULL) return;
+	int idx = find_tracked_ptr(tracker, ptr);
+	if(idx < 0) {tracker->num_foreign++; return;}
+	free(ptr);
+	tracker->ptrs[idx] = tracker->ptrs[--tracker->num_ptrs];
+}
+
+// system (with a subsystem) allocated with a tracking allocator; ephemerides loaded twice (file, then context cache) through an
+// arena context; returns 1 if memory of the system was allocated or freed with another allocator
+static int check_mixed_allocators(const char *fixture_dir) {
+	TrackingAllocator *tracker = calloc(1, sizeof(TrackingAllocator));
+	OrbitlibAllocator tracking_allocator = {tracking_malloc, tracking_realloc, tracking_free, tracker};
+	OrbitlibContextConfig config = get_default_orbitlib_context_config();
+	config.allocator = &tracking_allocator;
+	OrbitlibContext *system_ctx = new_orbitlib_context(&config);
+
+	OrbitlibArena *arena = new_orbitlib_arena(0);
+	OrbitlibAllocator arena_allocator = get_orbitlib_arena_allocator(arena);
+	config = get_default_orbitlib_context_config();
+	config.ephem_directory = fixture_dir;
+	config.allow_download = 0;
+	config.allocator = &arena_allocator;
+	OrbitlibContext *arena_ctx = new_orbitlib_context(&config);
+
+	OrbitlibContext *prev_ctx = bind_orbitlib_context(system_ctx);
+	CelestSystem *system = new_system();
+	system->prop_method = EPHEMS;
+	system->cb = new_body();
+	system->num_bodies = 2;
+	system->bodies = orbitlib_malloc(system->num_bodies * sizeof(Body *));
+	Body *planet = system->bodies[0] = new_body();
+	Body *moon = system->bodies[1] = new_body();
+	planet->id = BENCH_SYNTHETIC_EPHEM_ID;
+	planet->orbit.cb = system->cb;
+	moon->orbit.cb = planet;
+	int num_tracked = tracker->num_ptrs;
+
+	// subsystems and ephemerides added while another allocator is current
+	bind_orbitlib_context(arena_ctx);
+	parse_and_sort_into_celestial_subsystems(system);
+	get_body_ephems_ctx(arena_ctx, planet);
+	int num_file_ephems = planet->num_ephems;
+	get_body_ephems_ctx(arena_ctx, planet);
+	int num_cached_ephems = planet->num_ephems;
+	bind_orbitlib_context(prev_ctx);
+
+	// subsystem struct and bodies array, ephemerides (the bodies array was shrunk in place)
+	int num_added = tracker->num_ptrs - num_tracked;
+	free_celestial_system(system);
+	int num_leaked = tracker->num_ptrs;
+
+	int failed = num_file_ephems == 0 || num_cached_ephems != num_file_ephems || num_added != 3 || num_leaked != 0 || tracker->num_foreign != 0;
+	printf("mixed allocators: %d ephemerides (file), %d (cache), %d allocations added to the system, %d leaked, %d foreign frees  %s\n",
+		   num_file_ephems, num_cached_ephems, num_added, num_leaked, tracker->num_foreign, failed ? "FAIL" : "ok");
+
+	free_orbitlib_context(arena_ctx);
+	free_orbitlib_context(system_ctx);
+	free_orbitlib_arena(arena);
+	for(int i = 0; i < tracker->num_ptrs; i++) free(tracker->ptrs[i]);
+	free(tracker);
+	return failed;
+}
+
+
+/*
+ * ------------------------------------
+ * Transfer Optimization Check
+ * ------------------------------------
+ */
+
+#define OPTIM_WINDOW_DAYS 800
+// the exhaustive grid only resolves whole days; the seeded search has to get within this of its minimum [m/s]
+#define OPTIM_DV_TOLERANCE 1.0
+
+static Body * new_synthetic_planet(const char *name, Body *cb, double mu, double radius, double a, double e, double i_deg, double raan_deg, double arg_peri_deg, double ta_deg) {
+	Body *body = new_body();
+	snprintf(body->name, sizeof(body->name), "%s", name);
+	body->mu = mu;
+	body->radius = radius;
+	body->orbit = constr_orbit_from_elements(a, e, deg2rad(i_deg), deg2rad(raan_deg), deg2rad(arg_peri_deg), deg2rad(ta_deg), cb);
+	return body;
+}
+
+// Earth-, Mars- and Venus-like planets (bodies 0-2) on Keplerian orbits around a copy of the star
+static CelestSystem * new_synthetic_planet_system(Body *sun) {
+	CelestSystem *system = new_system();
+	system->prop_method = ORB_ELEMENTS;
+	system->ut0 = 2451545.0;
+	system->cb = new_body();
+	*system->cb = *sun;
+	system->cb->system = system;
+	system->num_bodies = 3;
+	system->bodies = malloc(system->num_bodies * sizeof(Body*));
+	system->bodies[0] = new_synthetic_planet("Earth-like", system->cb, 3.986004418e14, 6371e3, 1.496e11, 0.0167, 0, 0, 102.9, 100);
+	system->bodies[1] = new_synthetic_planet("Mars-like", system->cb, 4.282837e13, 3389.5e3, 2.2794e11, 0.0934, 1.85, 49.6, 286.5, 20);
+	system->bodies[2] = new_synthetic_planet("Venus-like", system->cb, 3.24859e14, 6051.8e3, 1.0821e11, 0.0068, 3.39, 76.7, 54.9, 200);
+	return system;
+}
+
+// seeded search vs. exhaustive 1-day grid for an Earth-Mars-like pair on Keplerian orbits; returns 1 if the search misses the grid's minimum
+static int check_transfer_optimization(Body *sun) {
+	CelestSystem *system = new_synthetic_planet_system(sun);
+	Body *dep_body = system->bodies[0];
+	Body *arr_body = system->bodies[1];
+	TransferOptimParams params = get_default_transfer_optim_params();
+	params.departure_body = dep_body;
+	params.arrival_body = arr_body;
+	params.min_departure_epoch = 2451545.0;
+	params.max_departure_epoch = params.min_departure_epoch + OPTIM_WINDOW_DAYS;
+
+	// seeded search; its evaluations are the seed grid plus one local optimization per grid minimum, which optimize_transfer()
+	// replays with the same initial steps (the search only returns the merged minima)
+	TransferOptimResult search_results[16];
+	double t0 = get_time_ns();
+	int num_search_results = search_optimal_transfers(NULL, &params, search_results, 16);
+	double search_time = get_time_ns() - t0;
+	int num_seeds = params.num_departure_seeds * params.num_duration_seeds;
+	double dep_spacing = (params.max_departure_epoch - params.min_departure_epoch) / (params.num_departure_seeds - 1);
+	double dur_spacing = (params.max_duration - params.min_duration) / (params.num_duration_seeds - 1);
+	double *seed_dv = malloc(num_seeds * sizeof(double));
+	for(int i = 0; i < num_seeds; i++) {
+		int dep = i / params.num_duration_seeds, dur = i % params.num_duration_seeds;
+		seed_dv[i] = calc_transfer_dv(&params, params.min_departure_epoch + dep * dep_spacing, params.min_duration + dur * dur_spacing).dv;
+	}
+	int64_t search_evaluations = num_seeds;
+	for(int i = 0; i < num_seeds; i++) {
+		int dep = i / params.num_duration_seeds, dur = i % params.num_duration_seeds;
+		int is_minimum = isfinite(seed_dv[i]);
+		for(int di = -1; di <= 1 && is_minimum; di++) {
+			for(int dj = -1; dj <= 1; dj++) {
+				int ni = dep + di, nj = dur + dj;
+				if((di == 0 && dj == 0) || ni < 0 || nj < 0 || ni >= params.num_departure_seeds || nj >= params.num_duration_seeds) continue;
+				if(seed_dv[ni * params.num_duration_seeds + nj] < seed_dv[i]) {is_minimum = 0; break;}
+			}
+		}
+		if(is_minimum) search_evaluations += optimize_transfer(&params, params.min_departure_epoch + dep * dep_spacing, params.min_duration + dur * dur_spacing).num_evaluations;
+	}
+	free(seed_dv);
+
+	// exhaustive grid with 1-day steps
+	TransferOptimResult grid_best = {.dv = INFINITY};
+	int64_t grid_evaluations = 0;
+	t0 = get_time_ns();
+	for(double dep = params.min_departure_epoch; dep <= params.max_departure_epoch; dep += 1) {
+		for(double dur = params.min_duration; dur <= params.max_duration; dur += 1) {
+			TransferOptimResult transfer = calc_transfer_dv(&params, dep, dur);
+			grid_evaluations++;
+			if(transfer.dv < grid_best.dv) grid_best = transfer;
+		}
+	}
+	double grid_time = get_time_ns() - t0;
+
+	double search_dv = num_search_results > 0 ? search_results[0].dv : INFINITY;
+	printf("%-28s %12s %12s %14s %10s\n", "method", "evaluations", "dv [m/s]", "departure [JD]", "duration");
+	printf("%-28s %12lld %12.2f %14.3f %10.3f   (%.1f ms)\n", "search_optimal_transfers", (long long) search_evaluations, search_dv,
+		   num_search_results > 0 ? search_results[0].departure_epoch : NAN, num_search_results > 0 ? search_results[0].duration : NAN, search_time * 1e-6);
+	printf("%-28s %12lld %12.2f %14.3f %10.3f   (%.1f ms)\n", "1-day grid", (long long) grid_evaluations, grid_best.dv,
+		   grid_best.departure_epoch, grid_best.duration, grid_time * 1e-6);
+	int failed = !(search_dv <= grid_best.dv + OPTIM_DV_TOLERANCE);
+	printf("search - grid: %+.2f m/s  %s\n", search_dv - grid_best.dv, failed ? "FAIL" : "ok");
+
+	free_celestial_system(system);
+	return failed;
+}
+
+
+/*
+ * ------------------------------------
+ * MGA Search Check
+ * ------------------------------------
+ */
+
+// the search and the brute force evaluate the same legs in a different order; only rounding may differ [m/s]
+#define MGA_DV_TOLERANCE 1e-6
+
+// best delta-v of the sequence departure -> (flyby ->) arrival over the search grid, enumerating every leg combination
+static double calc_mga_grid_minimum(const MgaSearchParams *params, Body *flyby_body) {
+	Body *dep_body = params->departure_body, *arr_body = params->arrival_body, *cb = dep_body->orbit.cb;
+	int num_epochs = (int) ((params->max_departure_epoch - params->min_departure_epoch) / params->departure_epoch_step) + 1;
+	int num_durations = (int) ((params->max_leg_duration - params->min_leg_duration) / params->leg_duration_step) + 1;
+	double min_dv = INFINITY;
+	for(int i = 0; i < num_epochs; i++) {
+		double epoch0 = params->min_departure_epoch + i * params->departure_epoch_step;
+		OSV osv0 = get_body_osv(dep_body, epoch0);
+		for(int j = 0; j < num_durations; j++) {
+			double duration0 = params->min_leg_duration + j * params->leg_duration_step;
+			Body *body1 = flyby_body != NULL ? flyby_body : arr_body;
+			OSV osv1 = get_body_osv(body1, epoch0 + duration0);
+			Lambert3 leg0 = calc_lambert3(osv0.r, osv1.r, duration0 * 86400, cb);
+			if(leg0.success != LAMBERT_SUCCESS) continue;
+			double dv_dep = dv_departure(dep_body, dep_body->radius + params->departure_altitude, mag_vec3(subtract_vec3(leg0.v0, osv0.v)), params->transfer_type);
+			if(flyby_body == NULL) {
+				double dv_arr = dv_arrival(arr_body, arr_body->radius + params->arrival_altitude, mag_vec3(subtract_vec3(leg0.v1, osv1.v)), params->transfer_type);
+				min_dv = fmin(min_dv, dv_dep + dv_arr);
+				continue;
+			}
+			double vinf_in = mag_vec3(subtract_vec3(leg0.v1, osv1.v));
+			for(int k = 0; k < num_durations; k++) {
+				double duration1 = params->min_leg_duration + k * params->leg_duration_step;
+				OSV osv2 = get_body_osv(arr_body, epoch0 + duration0 + duration1);
+				Lambert3 leg1 = calc_lambert3(osv1.r, osv2.r, duration1 * 86400, cb);
+				if(leg1.success != LAMBERT_SUCCESS) continue;
+				double dv_flyby = fabs(mag_vec3(subtract_vec3(leg1.v0, osv1.v)) - vinf_in);
+				if(dv_flyby > params->max_vinf_mismatch) continue;
+				if(get_flyby_periapsis(leg0.v1, leg1.v0, osv1.v, flyby_body) < flyby_body->radius + flyby_body->atmo_alt + params->min_flyby_altitude) continue;
+				double dv_arr = dv_arrival(arr_body, arr_body->radius + params->arrival_altitude, mag_vec3(subtract_vec3(leg1.v1, osv2.v)), params->transfer_type);
+				min_dv = fmin(min_dv, dv_dep + dv_flyby + dv_arr);
+			}
+		}
+	}
+	return min_dv;
+}
+
+// branch-and-bound MGA search vs. brute-force enumeration of the same grid for the direct and the single-flyby sequence of
+// Keplerian planets; returns the number of sequences whose best delta-v differs
+static int check_mga_search(Body *sun) {
+	CelestSystem *system = new_synthetic_planet_system(sun);
+	Body *flyby_body = system->bodies[2];
+	MgaSearchParams params = get_default_mga_search_params();
+	params.departure_body = system->bodies[0];
+	params.arrival_body = system->bodies[1];
+	params.flyby_bodies = &flyby_body;
+	params.num_flyby_bodies = 1;
+	params.max_flybys = 1;
+	params.min_departure_epoch = 2451545.0;
+	params.max_departure_epoch = params.min_departure_epoch + 200;
+	params.min_leg_duration = 60;
+	params.max_leg_duration = 400;
+	params.max_vinf_mismatch = 3000;
+	params.max_results = 2;
+
+	MgaTrajectory results[2];
+	MgaSearchStats stats;
+	double t0 = get_time_ns();
+	int num_results = search_mga_trajectories(NULL, &params, results, &stats);
+	double search_time = get_time_ns() - t0;
+
+	int num_failed = 0;
+	for(int i = 0; i < 2; i++) {
+		Body *sequence_flyby = i == 0 ? NULL : flyby_body;
+		const MgaTrajectory *found = NULL;
+		for(int j = 0; j < num_results; j++) if(results[j].num_bodies == (i == 0 ? 2 : 3)) found = &results[j];
+		t0 = get_time_ns();
+		double grid_dv = calc_mga_grid_minimum(&params, sequence_flyby);
+		double grid_time = get_time_ns() - t0;
+		double search_dv = found != NULL ? found->dv : INFINITY;
+		int failed = isfinite(grid_dv) ? !(fabs(search_dv - grid_dv) <= MGA_DV_TOLERANCE) : found != NULL;
+		printf("%-14s search: %10.2f m/s  brute force: %10.2f m/s (%.1f ms)  %s\n", i == 0 ? "direct" : "single flyby",
+			   search_dv, grid_dv, grid_time * 1e-6, failed ? "FAIL" : "ok");
+		num_failed += failed;
+	}
+	printf("search: %lld legs (%lld pruned) in %.1f ms\n", (long long) stats.num_legs, (long long) stats.num_pruned, search_time * 1e-6);
+
+	free_celestial_system(system);
+	return num_failed;
+}
+
+
+/*
+ * ------------------------------------
+ * Launch Window Check
+ * ------------------------------------
+ */
+
+#define WINDOW_SCAN_YEARS 20
+#define WINDOW_SCAN_STEP 0.1
+// the windows are refined to 1 minute, the scan interpolates linearly over its step [days]
+#define WINDOW_EPOCH_MAX_DEVIATION 0.01
+
+// find_launch_windows() vs. the crossings of the Hohmann phase angle found by a dense scan, for an outward and an inward
+// transfer of Keplerian planets; returns the number of transfers whose windows differ
+static int check_launch_windows(Body *sun) {
+	CelestSystem *system = new_synthetic_planet_system(sun);
+	int num_failed = 0;
+	for(int i = 1; i <= 2; i++) {
+		Body *dep_body = system->bodies[0], *arr_body = system->bodies[i];
+		double min_epoch = 2451545.0, max_epoch = min_epoch + WINDOW_SCAN_YEARS * 365.25;
+		LaunchWindow windows[32];
+		double t0 = get_time_ns();
+		int num_windows = find_launch_windows(dep_body, arr_body, min_epoch, max_epoch, windows, 32);
+		double search_time = get_time_ns() - t0;
+
+		// crossings of the required phase angle (not of the wrap-around at +-pi) between scan points
+		double phase_angle = calc_hohmann_phase_angle(dep_body, arr_body);
+		int num_crossings = 0, num_matched = 0;
+		double max_deviation = 0;
+		t0 = get_time_ns();
+		double prev_epoch = min_epoch, prev_offset = NAN;
+		for(double epoch = min_epoch; epoch <= max_epoch; epoch += WINDOW_SCAN_STEP) {
+			double offset = pi_norm(calc_phase_angle(dep_body, arr_body, epoch) - phase_angle);
+			if(offset > M_PI) offset -= 2*M_PI;
+			if((prev_offset < 0) != (offset < 0) && fabs(offset - prev_offset) < M_PI) {
+				double crossing = prev_epoch + prev_offset / (prev_offset - offset) * (epoch - prev_epoch);
+				num_crossings++;
+				double deviation = INFINITY;
+				for(int j = 0; j < num_windows; j++) deviation = fmin(deviation, fabs(windows[j].departure_epoch - crossing));
+				if(deviation <= WINDOW_EPOCH_MAX_DEVIATION) num_matched++;
+				if(!(deviation <= max_deviation)) max_deviation = deviation;
+			}
+			prev_epoch = epoch;
+			prev_offset = offset;
+		}
+		double scan_time = get_time_ns() - t0;
+
+		int failed = num_windows != num_crossings || num_matched != num_crossings;
+		printf("%s -> %-12s %2d windows (%.2f ms)  %2d scan crossings (%.1f ms)  max. deviation: %.2e days  %s\n", dep_body->name, arr_body->name,
+			   num_windows, search_time * 1e-6, num_crossings, scan_time * 1e-6, max_deviation, failed ? "FAIL" : "ok");
+		num_failed += failed;
+	}
+	free_celestial_system(system);
+	return num_failed;
+}
+
+
+/*
+ * ------------------------------------
+ * Transfer Matrix Check
+ * ------------------------------------
+ */
+
+// stored windows are recomputed with the same functions; only rounding may differ [m/s]
+#define MATRIX_DV_TOLERANCE 1e-6
+
+// writes the first size bytes of data followed by num_zeros zero bytes; returns 1 on success
+static int write_resized_file(const char *filepath, const void *data, size_t size, size_t num_zeros) {
+	FILE *file = fopen(filepath, "wb");
+	if(file == NULL) return 0;
+	int success = fwrite(data, 1, size, file) == size;
+	for(size_t i = 0; i < num_zeros && success; i++) success = fputc(0, file) != EOF;
+	if(fclose(file) != 0) success = 0;
+	return success;
+}
+
+// transfer matrix of Keplerian planets saved and mapped again; the mapped tables have to be identical, its entries have to match
+// Hohmann transfers and Lambert delta-vs computed directly, and truncated or extended files have to be rejected; returns 1 on failure
+static int check_transfer_matrix(Body *sun, const char *tmp_dir) {
+	char filepath[256], corrupt_filepath[256];
+	snprintf(filepath, sizeof(filepath), "%s/orbitlib_bench_matrix.bin", tmp_dir);
+	snprintf(corrupt_filepath, sizeof(corrupt_filepath), "%s/orbitlib_bench_matrix_corrupt.bin", tmp_dir);
+	CelestSystem *system = new_synthetic_planet_system(sun);
+	TransferMatrixParams params = get_default_transfer_matrix_params();
+	params.min_departure_epoch = 2451545.0;
+	params.max_departure_epoch = params.min_departure_epoch + 1000;
+
+	double t0 = get_time_ns();
+	TransferMatrix *matrix = build_transfer_matrix(NULL, system, &params);
+	double build_time = get_time_ns() - t0;
+	int saved = matrix != NULL && save_transfer_matrix(matrix, filepath);
+	t0 = get_time_ns();
+	TransferMatrix *loaded = saved ? load_transfer_matrix(filepath) : NULL;
+	double load_time = get_time_ns() - t0;
+	int identical = loaded != NULL && loaded->is_mapped && loaded->data_size == matrix->data_size &&
+					memcmp(loaded->data, matrix->data, matrix->data_size) == 0;
+
+	// entries of the mapped matrix vs. direct calculations
+	TransferOptimParams optim_params = get_default_transfer_optim_params();
+	optim_params.transfer_type = params.transfer_type;
+	optim_params.departure_altitude = params.departure_altitude;
+	optim_params.arrival_altitude = params.arrival_altitude;
+	int num_windows_checked = 0, num_mismatches = 0;
+	double max_deviation = 0;
+	int *body_idx = malloc(system->num_bodies * sizeof(int));	// indices of the system's bodies resolved once
+	for(int i = 0; i < system->num_bodies && loaded != NULL; i++) body_idx[i] = find_transfer_matrix_body(loaded, system->bodies[i]->name);
+	for(int i = 0; i < system->num_bodies && loaded != NULL; i++) {
+		int dep_idx = body_idx[i];
+		for(int j = 0; j < system->num_bodies; j++) {
+			if(i == j) continue;
+			int arr_idx = body_idx[j];
+			const TransferMatrixEntry *entry = get_transfer_matrix_entry(loaded, dep_idx, arr_idx);
+			Hohmann hohmann = calc_hohmann_transfer(system->bodies[i]->orbit.a, system->bodies[j]->orbit.a, system->cb);
+			if(entry == NULL || entry->hohmann_duration != hohmann.dur || entry->hohmann_dv_departure != hohmann.dv_dep ||
+			   entry->hohmann_dv_arrival != hohmann.dv_arr || entry->num_windows == 0) {
+				num_mismatches++;
+				continue;
+			}
+			int num_windows;
+			const TransferMatrixWindow *windows = get_transfer_matrix_windows(loaded, dep_idx, arr_idx, &num_windows);
+			optim_params.departure_body = system->bodies[i];
+			optim_params.arrival_body = system->bodies[j];
+			for(int k = 0; k < num_windows; k++) {
+				TransferOptimResult transfer = calc_transfer_dv(&optim_params, windows[k].departure_epoch, windows[k].duration);
+				double deviation = fabs(transfer.dv - windows[k].dv);
+				if(!(deviation <= max_deviation)) max_deviation = deviation;
+				if(k > 0 && windows[k].dv < windows[k-1].dv) num_mismatches++;
+				num_windows_checked++;
+			}
+		}
+	}
+
+	// files shorter or longer than their header says
+	int num_accepted_corrupt = 0;
+	for(int i = 0; i < 2 && matrix != NULL; i++) {
+		if(!write_resized_file(corrupt_filepath, matrix->data, matrix->data_size - (i == 0 ? 8 : 0), i == 0 ? 0 : 8)) continue;
+		TransferMatrix *corrupt = load_transfer_matrix(corrupt_filepath);
+		if(corrupt != NULL) num_accepted_corrupt++;
+		free_transfer_matrix(corrupt);
+	}
+
+	int failed = !identical || num_mismatches > 0 || num_windows_checked == 0 || !(max_deviation <= MATRIX_DV_TOLERANCE) || num_accepted_corrupt > 0;
+	printf("transfer matrix: %zu bytes built in %.1f ms, mapped in %.3f ms (%s)\n", matrix != NULL ? matrix->data_size : 0,
+		   build_time * 1e-6, load_time * 1e-6, identical ? "identical" : "differs");
+	printf("%d windows recomputed (max. dv deviation: %.2e m/s), %d entry mismatches, %d corrupt files accepted  %s\n",
+		   num_windows_checked, max_deviation, num_mismatches, num_accepted_corrupt, failed ? "FAIL" : "ok");
+
+	free(body_idx);
+	free_transfer_matrix(loaded);
+	free_transfer_matrix(matrix);
+	remove(filepath);
+	remove(corrupt_filepath);
+	free_celestial_system(system);
+	return failed;
+}
+
+
+/*
+ * ------------------------------------
+ * MOID Check
+ * ------------------------------------
+ */
+
+#define MOID_CHECK_NUM_PAIRS 40
+#define MOID_BRUTE_FORCE_GRID 256
+#define MOID_BRUTE_FORCE_MINIMA 8
+#define MOID_BRUTE_FORCE_ZOOMS 32
+// absolute and relative agreement of calc_moid() with the brute force [m]
+#define MOID_ABS_TOLERANCE 1e3
+#define MOID_REL_TOLERANCE 1e-6
+
+// deterministic pseudo-random number in [0, 1)
+static double next_bench_random(uint64_t *state) {
+	*state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (double) (*state >> 11) / 9007199254740992.0;
+}
+
+// range of true anomalies calc_moid() considers (hyperbolas up to close to their asymptotes)
+static double get_moid_max_ta(Orbit orbit) {
+	return orbit.e < 1 ? M_PI : 0.98 * acos(-1 / orbit.e);
+}
+
+// position on the orbit at a true anomaly, from the conic equation (independent of calc_moid()'s anomaly parametrization)
+static Vector3 get_orbit_position_at_ta(Orbit orbit, double ta) {
+	double r = orbit.a * (1 - orbit.e*orbit.e) / (1 + orbit.e * cos(ta));
+	return heliocentric_rot(vec2(r * cos(ta), r * sin(ta)), orbit.raan, orbit.arg_peri, orbit.i);
+}
+
+static double calc_ta_grid_distance(Orbit orbit0, Orbit orbit1, double ta0, double ta1) {
+	return mag_vec3(subtract_vec3(get_orbit_position_at_ta(orbit0, ta0), get_orbit_position_at_ta(orbit1, ta1)));
+}
+
+// MOID from a grid over the true anomalies of both orbits whose local minima are zoomed in on by repeatedly shrinking grids
+static double calc_moid_brute_force(Orbit orbit0, Orbit orbit1) {
+	const int n = MOID_BRUTE_FORCE_GRID;
+	double max_ta0 = get_moid_max_ta(orbit0), max_ta1 = get_moid_max_ta(orbit1);
+	double step0 = 2 * max_ta0 / (orbit0.e < 1 ? n : n-1), step1 = 2 * max_ta1 / (orbit1.e < 1 ? n : n-1);
+	double *grid = malloc(n * n * sizeof(double));
+	for(int i = 0; i < n; i++) {
+		for(int j = 0; j < n; j++) grid[i*n + j] = calc_ta_grid_distance(orbit0, orbit1, -max_ta0 + i * step0, -max_ta1 + j * step1);
+	}
+
+	// local minima of the grid (ellipses wrap around)
+	int minima[MOID_BRUTE_FORCE_MINIMA];
+	int num_minima = 0;
+	for(int i = 0; i < n; i++) {
+		for(int j = 0; j < n; j++) {
+			int is_minimum = 1;
+			for(int di = -1; di <= 1 && is_minimum; di++) {
+				for(int dj = -1; dj <= 1; dj++) {
+					int ni = i + di, nj = j + dj;
+					if(orbit0.e < 1) ni = (ni + n) % n;
+					if(orbit1.e < 1) nj = (nj + n) % n;
+					if((di == 0 && dj == 0) || ni < 0 || nj < 0 || ni >= n || nj >= n) continue;
+					if(grid[ni*n + nj] < grid[i*n + j]) {is_minimum = 0; break;}
+				}
+			}
+			if(!is_minimum) continue;
+			// keep the smallest minima
+			if(num_minima == MOID_BRUTE_FORCE_MINIMA && grid[minima[num_minima-1]] <= grid[i*n + j]) continue;
+			int k = num_minima < MOID_BRUTE_FORCE_MINIMA ? num_minima++ : MOID_BRUTE_FORCE_MINIMA-1;
+			while(k > 0 && grid[minima[k-1]] > grid[i*n + j]) {minima[k] = minima[k-1]; k--;}
+			minima[k] = i*n + j;
+		}
+	}
+
+	double moid = INFINITY;
+	for(int m = 0; m < num_minima; m++) {
+		double ta0 = -max_ta0 + (minima[m] / n) * step0, ta1 = -max_ta1 + (minima[m] % n) * step1;
+		double width0 = 2 * step0, width1 = 2 * step1, best = grid[minima[m]];
+		for(int zoom = 0; zoom < MOID_BRUTE_FORCE_ZOOMS; zoom++) {
+			double best_ta0 = ta0, best_ta1 = ta1;
+			for(int i = -10; i <= 10; i++) {
+				for(int j = -10; j <= 10; j++) {
+					double x0 = ta0 + i * width0 / 10, x1 = ta1 + j * width1 / 10;
+					if(fabs(x0) > max_ta0 && orbit0.e >= 1) continue;
+					if(fabs(x1) > max_ta1 && orbit1.e >= 1) continue;
+					double distance = calc_ta_grid_distance(orbit0, orbit1, x0, x1);
+					if(distance < best) {best = distance; best_ta0 = x0; best_ta1 = x1;}
+				}
+			}
+			ta0 = best_ta0;
+			ta1 = best_ta1;
+			width0 /= 2;
+			width1 /= 2;
+		}
+		moid = fmin(moid, best);
+	}
+	free(grid);
+	return moid;
+}
+
+// calc_moid() vs. brute force for random pairs of ellipses, ellipses and hyperbolas and of hyperbolas; returns the number of
+// pairs that disagree
+static int check_moid_computation(Body *sun) {
+	uint64_t state = 1;
+	int num_failed = 0;
+	double max_deviation = 0, moid_time = 0, brute_force_time = 0;
+	for(int k = 0; k < MOID_CHECK_NUM_PAIRS; k++) {
+		Orbit orbits[2];
+		for(int i = 0; i < 2; i++) {
+			// the last pairs include hyperbolas
+			int is_hyperbola = (i == 0 && k >= MOID_CHECK_NUM_PAIRS - 4) || (i == 1 && k >= MOID_CHECK_NUM_PAIRS - 8);
+			double e = is_hyperbola ? 1.2 + 2 * next_bench_random(&state) : 0.6 * next_bench_random(&state);
+			double a = is_hyperbola ? -(0.2 + next_bench_random(&state)) * 1.496e11 : (0.7 + 0.9 * next_bench_random(&state)) * 1.496e11;
+			orbits[i] = constr_orbit_from_elements(a, e, deg2rad(40 * next_bench_random(&state)), 2*M_PI * next_bench_random(&state),
+												   2*M_PI * next_bench_random(&state), 0, sun);
+		}
+		double t0 = get_time_ns();
+		MoidResult result = calc_moid(orbits[0], orbits[1]);
+		double t1 = get_time_ns();
+		double brute_force = calc_moid_brute_force(orbits[0], orbits[1]);
+		brute_force_time += get_time_ns() - t1;
+		moid_time += t1 - t0;
+
+		// the returned anomalies have to give the returned distance
+		double ta_distance = calc_ta_grid_distance(orbits[0], orbits[1], result.ta0, result.ta1);
+		double tolerance = MOID_ABS_TOLERANCE + MOID_REL_TOLERANCE * brute_force;
+		double deviation = fabs(result.moid - brute_force);
+		if(!(deviation <= max_deviation)) max_deviation = deviation;
+		if(!(deviation <= tolerance) || !(fabs(ta_distance - result.moid) <= tolerance)) {
+			printf("pair %2d (e=%.3f, e=%.3f): calc_moid: %.6e m (at its anomalies: %.6e m)  brute force: %.6e m  FAIL\n",
+				   k, orbits[0].e, orbits[1].e, result.moid, ta_distance, brute_force);
+			num_failed++;
+		}
+	}
+	printf("MOID: %d pairs (%.3f ms)  brute force (%.1f ms)  max. deviation: %.2e m  %s\n", MOID_CHECK_NUM_PAIRS, moid_time * 1e-6,
+		   brute_force_time * 1e-6, max_deviation, num_failed > 0 ? "FAIL" : "ok");
+	return num_failed;
+}
+
+
+/*
+ * ------------------------------------
+ * Conjunction Check
+ * ------------------------------------
+ */
+
+#define CONJUNCTION_CHECK_NUM_OBJECTS 48
+#define CONJUNCTION_CHECK_MAX_EVENTS 4096
+// sampling step of the dense scan [s] (far below the duration of a close approach at orbital speeds)
+#define CONJUNCTION_SCAN_STEP 2.0
+// upper bound of the relative speed of the objects [m/s] (minima further than it allows from the threshold aren't refined)
+#define CONJUNCTION_SCAN_MAX_SPEED 16e3
+// agreement of the search with the refined scan minima [s] and [m]
+#define CONJUNCTION_EPOCH_TOLERANCE 1e-2
+#define CONJUNCTION_DISTANCE_TOLERANCE 1.0
+
+// position on an orbit after dt from Kepler's equation (propagate_osv_time() only meets the time within 1s)
+static Vector3 get_orbit_position_at_time(Orbit orbit, double dt) {
+	double e = orbit.e;
+	if(e > 1) {
+		double hyp_anomaly = 2 * atanh(sqrt((e - 1) / (e + 1)) * tan(orbit.ta / 2));
+		double mean_anomaly = e * sinh(hyp_anomaly) - hyp_anomaly + sqrt(orbit.cb->mu / pow(-orbit.a, 3)) * dt;
+		hyp_anomaly = asinh(mean_anomaly / e);
+		for(int i = 0; i < 50; i++) {
+			double delta = (e * sinh(hyp_anomaly) - hyp_anomaly - mean_anomaly) / (e * cosh(hyp_anomaly) - 1);
+			hyp_anomaly -= delta;
+			if(fabs(delta) < 1e-15 * fmax(fabs(hyp_anomaly), 1)) break;
+		}
+		return get_orbit_position_at_ta(orbit, 2 * atan(sqrt((e + 1) / (e - 1)) * tanh(hyp_anomaly / 2)));
+	}
+	double ecc_anomaly = 2 * atan(sqrt((1 - e) / (1 + e)) * tan(orbit.ta / 2));
+	double mean_anomaly = ecc_anomaly - e * sin(ecc_anomaly) + sqrt(orbit.cb->mu / pow(orbit.a, 3)) * dt;
+	for(int i = 0; i < 50; i++) {
+		double delta = (ecc_anomaly - e * sin(ecc_anomaly) - mean_anomaly) / (1 - e * cos(ecc_anomaly));
+		ecc_anomaly -= delta;
+		if(fabs(delta) < 1e-15 * fmax(fabs(ecc_anomaly), 1)) break;
+	}
+	return get_orbit_position_at_ta(orbit, 2 * atan2(sqrt(1 + e) * sin(ecc_anomaly / 2), sqrt(1 - e) * cos(ecc_anomaly / 2)));
+}
+
+static double calc_pair_distance(const Orbit *orbits, int idx0, int idx1, double dt) {
+	return mag_vec3(subtract_vec3(get_orbit_position_at_time(orbits[idx1], dt), get_orbit_position_at_time(orbits[idx0], dt)));
+}
+
+// minimum of the pair's distance within [dt0, dt1] by golden-section search; dt: output for its time [s]
+static double refine_pair_distance(const Orbit *orbits, int idx0, int idx1, double dt0, double dt1, double *dt) {
+	const double ratio = (sqrt(5) - 1) / 2;
+	double x0 = dt1 - ratio * (dt1 - dt0), x1 = dt0 + ratio * (dt1 - dt0);
+	double f0 = calc_pair_distance(orbits, idx0, idx1, x0), f1 = calc_pair_distance(orbits, idx0, idx1, x1);
+	for(int i = 0; i < 80; i++) {
+		if(f0 < f1) {
+			dt1 = x1; x1 = x0; f1 = f0;
+			x0 = dt1 - ratio * (dt1 - dt0);
+			f0 = calc_pair_distance(orbits, idx0, idx1, x0);
+		} else {
+			dt0 = x0; x0 = x1; f0 = f1;
+			x1 = dt0 + ratio * (dt1 - dt0);
+			f1 = calc_pair_distance(orbits, idx0, idx1, x1);
+		}
+	}
+	*dt = f0 < f1 ? x0 : x1;
+	return fmin(f0, f1);
+}
+
+// search_conjunctions() vs. the minima of every pair's distance sampled densely over the time span (and refined), for random
+// low orbits around a planet; returns 1 if an event is missing, extra or off
+static int check_conjunctions(Body *planet) {
+	uint64_t state = 2;
+	Orbit orbits[CONJUNCTION_CHECK_NUM_OBJECTS];
+	OSV osvs[CONJUNCTION_CHECK_NUM_OBJECTS];
+	for(int i = 0; i < CONJUNCTION_CHECK_NUM_OBJECTS; i++) {
+		double a = 7000e3 + 40e3 * (next_bench_random(&state) - 0.5);
+		Orbit orbit = orbits[i] = constr_orbit_from_elements(a, 0.002 * next_bench_random(&state), deg2rad(100 * next_bench_random(&state)),
+												 2*M_PI * next_bench_random(&state), 2*M_PI * next_bench_random(&state), 2*M_PI * next_bench_random(&state), planet);
+		osvs[i] = osv_from_orbit(orbit);
+	}
+	ConjunctionParams params = get_default_conjunction_params();
+	params.min_epoch = 2451545.0;
+	params.max_epoch = params.min_epoch + 0.25;
+	params.time_step = 60.0 / 86400;
+	params.threshold = 50e3;
+
+	ConjunctionEvent *events = malloc(CONJUNCTION_CHECK_MAX_EVENTS * sizeof(ConjunctionEvent));
+	ConjunctionStats stats;
+	double t0 = get_time_ns();
+	int num_events = search_conjunctions(NULL, osvs, CONJUNCTION_CHECK_NUM_OBJECTS, params.min_epoch, planet, &params, events, CONJUNCTION_CHECK_MAX_EVENTS, &stats);
+	double search_time = get_time_ns() - t0;
+
+	// positions of all objects at the scan times
+	t0 = get_time_ns();
+	double duration = (params.max_epoch - params.min_epoch) * 86400;
+	int num_samples = (int) (duration / CONJUNCTION_SCAN_STEP) + 1;
+	Vector3 *positions = malloc((size_t) CONJUNCTION_CHECK_NUM_OBJECTS * num_samples * sizeof(Vector3));
+	for(int i = 0; i < CONJUNCTION_CHECK_NUM_OBJECTS; i++) {
+		for(int k = 0; k < num_samples; k++) positions[i * num_samples + k] = get_orbit_position_at_time(orbits[i], k * CONJUNCTION_SCAN_STEP);
+	}
+	double *distances = malloc(num_samples * sizeof(double));
+	int num_scan_events = 0, num_matched = 0;
+	double max_epoch_deviation = 0, max_distance_deviation = 0;
+	for(int i = 0; i < CONJUNCTION_CHECK_NUM_OBJECTS; i++) {
+		for(int j = i+1; j < CONJUNCTION_CHECK_NUM_OBJECTS; j++) {
+			for(int k = 0; k < num_samples; k++) distances[k] = mag_vec3(subtract_vec3(positions[j * num_samples + k], positions[i * num_samples + k]));
+			for(int k = 0; k < num_samples; k++) {
+				// local minima of the samples, refined between their neighbours (closest at an end of the span: the end itself)
+				if((k > 0 && distances[k] > distances[k-1]) || (k < num_samples-1 && distances[k] >= distances[k+1])) continue;
+				double dt = k * CONJUNCTION_SCAN_STEP, distance = distances[k];
+				if(distance > params.threshold + CONJUNCTION_SCAN_MAX_SPEED * CONJUNCTION_SCAN_STEP) continue;
+				if(k > 0 && k < num_samples-1) distance = refine_pair_distance(orbits, i, j, dt - CONJUNCTION_SCAN_STEP, dt + CONJUNCTION_SCAN_STEP, &dt);
+				if(!(distance <= params.threshold)) continue;
+				num_scan_events++;
+				for(int e = 0; e < num_events; e++) {
+					if(events[e].idx0 != i || events[e].idx1 != j) continue;
+					double epoch_deviation = fabs((events[e].epoch - params.min_epoch) * 86400 - dt);
+					if(epoch_deviation > CONJUNCTION_SCAN_STEP) continue;
+					double distance_deviation = fabs(events[e].distance - distance);
+					if(epoch_deviation > max_epoch_deviation) max_epoch_deviation = epoch_deviation;
+					if(!(distance_deviation <= max_distance_deviation)) max_distance_deviation = distance_deviation;
+					num_matched++;
+					break;
+				}
+			}
+		}
+	}
+	double scan_time = get_time_ns() - t0;
+
+	int failed = num_events != stats.num_events || num_events != num_scan_events || num_matched != num_scan_events ||
+				 !(max_epoch_deviation <= CONJUNCTION_EPOCH_TOLERANCE) || !(max_distance_deviation <= CONJUNCTION_DISTANCE_TOLERANCE);
+	printf("conjunctions: %d events (%.1f ms, %lld candidates)  dense scan: %d events (%.1f ms), %d matched\n", num_events, search_time * 1e-6,
+		   (long long) stats.num_candidates, num_scan_events, scan_time * 1e-6, num_matched);
+	printf("max. deviation: %.2e s, %.2e m  %s\n", max_epoch_deviation, max_distance_deviation, failed ? "FAIL" : "ok");
+
+	free(distances);
+	free(positions);
+	free(events);
+	return failed;
+}
+
+
+/*
+ * ------------------------------------
+ * Monte Carlo Check
+ * ------------------------------------
+ */
+
+#define MONTE_CARLO_CHECK_SAMPLES 20000
+#define MONTE_CARLO_CHECK_THREADS 7
+// sampling error of a standard deviation from 20000 samples is about 0.5%
+#define MONTE_CARLO_SIGMA_TOLERANCE 0.03
+
+// run_monte_carlo() with 1 and with several threads has to give bit-identical samples and statistics, and for small dispersions
+// the sample covariance has to match the covariance propagated with the state transition matrix; returns 1 on failure
+static int check_monte_carlo(Body *sun) {
+	OSV nominal = osv_from_orbit(constr_orbit_from_elements(1.496e11, 0.1, deg2rad(5), deg2rad(10), deg2rad(20), deg2rad(30), sun));
+	DispersionModel dispersions = {.pos_sigma = 10e3, .vel_sigma = 0.1, .dv = vec3(0, 0, 0)};
+	MonteCarloParams params = get_default_monte_carlo_params();
+	params.num_samples = MONTE_CARLO_CHECK_SAMPLES;
+	params.seed = 42;
+	params.duration = 100 * 86400;
+
+	MonteCarloSample *samples[2];
+	MonteCarloStats stats[2];
+	double times[2];
+	int num_ok = 0;
+	for(int i = 0; i < 2; i++) {
+		OrbitlibContextConfig config = get_default_orbitlib_context_config();
+		config.num_threads = i == 0 ? 0 : MONTE_CARLO_CHECK_THREADS;
+		OrbitlibContext *ctx = new_orbitlib_context(&config);
+		samples[i] = malloc(params.num_samples * sizeof(MonteCarloSample));
+		double t0 = get_time_ns();
+		num_ok += run_monte_carlo(ctx, nominal, sun, &dispersions, &params, samples[i], &stats[i]);
+		times[i] = get_time_ns() - t0;
+		free_orbitlib_context(ctx);
+	}
+	int identical = num_ok == 2 && memcmp(samples[0], samples[1], params.num_samples * sizeof(MonteCarloSample)) == 0 &&
+					memcmp(&stats[0].mean, &stats[1].mean, sizeof(OSV)) == 0 && memcmp(stats[0].cov, stats[1].cov, sizeof(stats[0].cov)) == 0;
+
+	// linear covariance propagation of the initial dispersions
+	double cov0[6][6] = {{0}}, cov1[6][6];
+	for(int k = 0; k < 6; k++) cov0[k][k] = k < 3 ? dispersions.pos_sigma * dispersions.pos_sigma : dispersions.vel_sigma * dispersions.vel_sigma;
+	OSV osv1;
+	propagate_osv_covariance_batch(&nominal, &cov0, 1, sun, params.duration, &osv1, &cov1);
+	double max_deviation = 0;
+	for(int k = 0; k < 6 && num_ok == 2; k++) {
+		double deviation = fabs(sqrt(stats[0].cov[k][k]) / sqrt(cov1[k][k]) - 1);
+		if(!(deviation <= max_deviation)) max_deviation = deviation;
+	}
+
+	int failed = !identical || !(max_deviation <= MONTE_CARLO_SIGMA_TOLERANCE);
+	printf("monte carlo: %d samples, 1 thread: %.1f ms, %d threads: %.1f ms (%s)\n", params.num_samples, times[0] * 1e-6,
+		   MONTE_CARLO_CHECK_THREADS + 1, times[1] * 1e-6, identical ? "identical" : "differ");
+	printf("max. deviation of the sample standard deviations from the STM covariance: %.2f%%  %s\n", max_deviation * 100, failed ? "FAIL" : "ok");
+	free(samples[0]);
+	free(samples[1]);
+	return failed;
+}
+
+
+/*
+ * ------------------------------------
+ * Numerical Propagator Check
+ * ------------------------------------
+ */
+
+// global error of the numerical propagation relative to the orbit's size (tolerances of 1e-12 per step; ten revolutions of an
+// orbit with e=0.97 accumulate about 6e-8)
+#define PROPAGATOR_KEPLER_TOLERANCE 1e-6
+// short-periodic J2 terms and osculating vs. mean elements perturb the node by less than this fraction of the drift
+#define PROPAGATOR_NODE_DRIFT_TOLERANCE 0.01
+
+// numerical propagation without perturbations vs. the Kepler solution (single and batched), and the J2 drift of the node of a
+// low orbit vs. its secular rate; returns the number of failed comparisons
+static int check_numerical_propagator(Body *sun, Body *planet) {
+	PropagatorParams params = get_default_propagator_params();
+	params.use_j2 = 0;
+	params.use_third_bodies = 0;
+	params.rel_tol = 1e-12;
+	params.abs_tol_pos = 1e-5;
+	params.abs_tol_vel = 1e-8;
+
+	// ellipses over ten periods, a hyperbola over a year
+	const double eccentricities[PROPAGATOR_BATCH_LANES] = {0, 0.01, 0.1, 0.3, 0.6, 0.9, 0.97, 1.5};
+	OSV osvs[PROPAGATOR_BATCH_LANES], batch[PROPAGATOR_BATCH_LANES];
+	double dt = 10 * 365.25 * 86400;
+	for(int i = 0; i < PROPAGATOR_BATCH_LANES; i++) {
+		double e = eccentricities[i];
+		osvs[i] = osv_from_orbit(constr_orbit_from_elements(e < 1 ? 1.5e11 : -1.5e11, e, deg2rad(5), deg2rad(10), deg2rad(20), deg2rad(10 * i), sun));
+	}
+	double t0 = get_time_ns();
+	propagate_osv_numerical_batch(osvs, PROPAGATOR_BATCH_LANES, 2451545.0, sun, dt / 10, &params, batch);
+	double batch_time = get_time_ns() - t0;
+	double max_kepler_error = 0, max_batch_error = 0, scalar_time = 0;
+	for(int i = 0; i < PROPAGATOR_BATCH_LANES; i++) {
+		double e = eccentricities[i];
+		double duration = e < 1 ? 10 * calc_orbital_period(constr_orbit_from_osv(osvs[i].r, osvs[i].v, sun)) : 365.25 * 86400;
+		OSV kepler = propagate_osv_time_stm(osvs[i], sun, duration, NULL);
+		t0 = get_time_ns();
+		OSV numerical = propagate_osv_numerical(osvs[i], 2451545.0, sun, duration, &params);
+		scalar_time += get_time_ns() - t0;
+		double error = mag_vec3(subtract_vec3(numerical.r, kepler.r)) / 1.5e11;
+		if(!(error <= max_kepler_error)) max_kepler_error = error;
+
+		// the batch shares step sizes across lanes, so its states only agree within the tolerances
+		OSV scalar = propagate_osv_numerical(osvs[i], 2451545.0, sun, dt / 10, &params);
+		error = mag_vec3(subtract_vec3(batch[i].r, scalar.r)) / 1.5e11;
+		if(!(error <= max_batch_error)) max_batch_error = error;
+	}
+	int kepler_failed = !(max_kepler_error <= PROPAGATOR_KEPLER_TOLERANCE);
+	int batch_failed = !(max_batch_error <= PROPAGATOR_KEPLER_TOLERANCE);
+	printf("no perturbations vs. Kepler: max. rel. position error %.2e (%.1f ms)  %s\n", max_kepler_error, scalar_time * 1e-6, kepler_failed ? "FAIL" : "ok");
+	printf("batch vs. single:            max. rel. position error %.2e (%.1f ms)  %s\n", max_batch_error, batch_time * 1e-6, batch_failed ? "FAIL" : "ok");
+
+	// nodal regression dRAAN/dt = -3/2 n J2 (R/p)² cos(i) about the pole (z axis) over whole revolutions
+	Body oblate = *planet;
+	oblate.j2 = 1.08263e-3;
+	oblate.north_pole_ra = 0;
+	oblate.north_pole_decl = M_PI / 2;
+	params.use_j2 = 1;
+	Orbit orbit = constr_orbit_from_elements(7000e3, 0.001, deg2rad(50), deg2rad(30), 0, 0, &oblate);
+	double n = sqrt(oblate.mu / pow(orbit.a, 3)), p = orbit.a * (1 - orbit.e * orbit.e);
+	double duration = 150 * calc_orbital_period(orbit);
+	t0 = get_time_ns();
+	OSV osv = propagate_osv_numerical(osv_from_orbit(orbit), 2451545.0, &oblate, duration, &params);
+	double j2_time = get_time_ns() - t0;
+	double drift = pi_norm(constr_orbit_from_osv(osv.r, osv.v, &oblate).raan - orbit.raan + M_PI) - M_PI;
+	double expected = -1.5 * n * oblate.j2 * pow(oblate.radius / p, 2) * cos(orbit.i) * duration;
+	double deviation = fabs(drift / expected - 1);
+	int j2_failed = !(deviation <= PROPAGATOR_NODE_DRIFT_TOLERANCE);
+	printf("J2 node drift: %.4f deg, secular rate: %.4f deg (%.1f ms)  %s\n", rad2deg(drift), rad2deg(expected), j2_time * 1e-6, j2_failed ? "FAIL" : "ok");
+	return kepler_failed + batch_failed + j2_failed;
+}
+
+
+/*
+ * ------------------------------------
+ * Trajectory Check
+ * ------------------------------------
+ */
+
+#define TRAJECTORY_CHECK_SAMPLES 200
+// agreement of the trajectory's states with Kepler's equation relative to the distance from the central body
+#define TRAJECTORY_POSITION_TOLERANCE 1e-9
+
+// trajectory of coasts and impulses around a star and a hyperbolic coast around a planet: states vs. Kepler's equation from each
+// segment's start, continuity across the impulses and a serialization round trip; returns 1 on failure
+static int check_trajectory(Body *sun) {
+	CelestSystem *system = new_synthetic_planet_system(sun);
+	system->cb->id = 10;
+	for(int i = 0; i < system->num_bodies; i++) system->bodies[i]->id = 11 + i;
+	Body *star = system->cb, *earth = system->bodies[0];
+
+	double epoch0 = 2451545.0;
+	Trajectory *trajectory = new_trajectory();
+	OSV departure = get_body_osv(earth, epoch0);
+	add_trajectory_coast(trajectory, departure, epoch0, epoch0 + 100, star);
+	add_trajectory_impulse(trajectory, scale_vec3(norm_vec3(departure.v), 2500), epoch0 + 400);
+	add_trajectory_impulse(trajectory, vec3(0, 0, 800), epoch0 + 900);
+	OSV flyby = {vec3(-3e8, 1e7, 0), vec3(3000, 0, 0)};
+	int num_segments = add_trajectory_coast(trajectory, flyby, epoch0 + 1000, epoch0 + 1000 + 2e8 / 86400, earth) + 1;
+
+	// states at evenly spread epochs vs. Kepler's equation
+	double max_error = 0;
+	int num_not_covered = 0;
+	for(int i = 0; i < num_segments; i++) {
+		const TrajectorySegment *segment = &trajectory->segments[i];
+		Orbit orbit = constr_orbit_from_osv(segment->osv.r, segment->osv.v, segment->cb);
+		for(int k = 0; k <= TRAJECTORY_CHECK_SAMPLES; k++) {
+			double epoch = segment->start_epoch + (segment->end_epoch - segment->start_epoch) * k / TRAJECTORY_CHECK_SAMPLES;
+			Body *cb;
+			OSV osv = get_trajectory_osv(trajectory, epoch, &cb);
+			// shared boundaries belong to the later segment
+			if(k == TRAJECTORY_CHECK_SAMPLES && i < num_segments-1 && trajectory->segments[i+1].start_epoch == epoch) continue;
+			if(cb != segment->cb) {num_not_covered++; continue;}
+			Vector3 r = get_orbit_position_at_time(orbit, (epoch - segment->start_epoch) * 86400);
+			double error = mag_vec3(subtract_vec3(osv.r, r)) / mag_vec3(r);
+			if(!(error <= max_error)) max_error = error;
+		}
+	}
+
+	// impulses: same position, velocity changed by dv
+	double max_impulse_error = 0;
+	for(int i = 1; i < num_segments; i++) {
+		const TrajectorySegment *prev = &trajectory->segments[i-1], *segment = &trajectory->segments[i];
+		if(segment->start_epoch != prev->end_epoch) continue;
+		Vector3 r = get_orbit_position_at_time(constr_orbit_from_osv(prev->osv.r, prev->osv.v, prev->cb), (prev->end_epoch - prev->start_epoch) * 86400);
+		OSV end = propagate_osv_time_stm(prev->osv, prev->cb, (prev->end_epoch - prev->start_epoch) * 86400, NULL);
+		double error = fmax(mag_vec3(subtract_vec3(segment->osv.r, r)) / mag_vec3(r),
+							mag_vec3(subtract_vec3(subtract_vec3(segment->osv.v, end.v), segment->dv)) / mag_vec3(segment->dv));
+		if(!(error <= max_impulse_error)) max_impulse_error = error;
+	}
+
+	// serialization round trip (too small buffers are not written to)
+	size_t size = serialize_trajectory(trajectory, NULL, 0);
+	char *buffer = calloc(1, size);
+	int too_small_untouched = serialize_trajectory(trajectory, buffer, size - 1) == size && buffer[0] == 0;
+	serialize_trajectory(trajectory, buffer, size);
+	Trajectory *restored = deserialize_trajectory(buffer, size, system);
+	int num_restore_mismatches = restored == NULL || restored->num_segments != num_segments;
+	for(int i = 0; i < num_segments && restored != NULL; i++) {
+		const TrajectorySegment *segment = &trajectory->segments[i], *copy = &restored->segments[i];
+		if(copy->cb != segment->cb || copy->start_epoch != segment->start_epoch || copy->end_epoch != segment->end_epoch ||
+		   memcmp(&copy->osv, &segment->osv, sizeof(OSV)) != 0 || memcmp(&copy->dv, &segment->dv, sizeof(Vector3)) != 0) {
+			num_restore_mismatches++;
+			continue;
+		}
+		double epoch = (segment->start_epoch + segment->end_epoch) / 2;
+		OSV a = get_trajectory_osv(trajectory, epoch, NULL), b = get_trajectory_osv(restored, epoch, NULL);
+		if(memcmp(&a, &b, sizeof(OSV)) != 0) num_restore_mismatches++;
+	}
+
+	int failed = num_not_covered > 0 || !(max_error <= TRAJECTORY_POSITION_TOLERANCE) || !(max_impulse_error <= TRAJECTORY_POSITION_TOLERANCE) ||
+				 !too_small_untouched || num_restore_mismatches > 0;
+	printf("trajectory: %d segments, max. rel. position error vs. Kepler: %.2e, at impulses: %.2e, %d epochs not covered\n",
+		   num_segments, max_error, max_impulse_error, num_not_covered);
+	printf("serialized: %zu bytes, %d mismatches after the round trip  %s\n", size, num_restore_mismatches, failed ? "FAIL" : "ok");
+
+	free(buffer);
+	free_trajectory(restored);
+	free_trajectory(trajectory);
+	free_celestial_system(system);
+	return failed;
+}
+
+
+int main(int argc, char **argv) {
+	int json = 0;
+	const char *filter = NULL;
+	const char *fixture_dir = ORBITLIB_BENCH_FIXTURE_DIR;
+	const char *trace_file = NULL;
+	double min_time = 0.2;
+	int check_lambert = 0;
+	int check_partials = 0;
+	int check_optim = 0;
+	int check_alloc = 0;
+	int check_mga = 0;
+	int check_windows = 0;
+	int check_matrix = 0;
+	int check_moid = 0;
+	int check_conjunction = 0;
+	int check_montecarlo = 0;
+	int check_propagator = 0;
+	int check_trajectories = 0;
+
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--json") == 0) json = 1;
+		else if(strcmp(argv[i], "--filter") == 0 && i+1 < argc) filter = argv[++i];
+		else if(strcmp(argv[i], "--min-time") == 0 && i+1 < argc) min_time = strtod(argv[++i], NULL);
+		else if(strcmp(argv[i], "--fixtures") == 0 && i+1 < argc) fixture_dir = argv[++i];
+		else if(strcmp(argv[i], "--trace") == 0 && i+1 < argc) trace_file = argv[++i];
+		else if(strcmp(argv[i], "--check-lambert") == 0) check_lambert = 1;
+		else if(strcmp(argv[i], "--check-partials") == 0) check_partials = 1;
+		else if(strcmp(argv[i], "--check-optim") == 0) check_optim = 1;
+		else if(strcmp(argv[i], "--check-alloc") == 0) check_alloc = 1;
+		else if(strcmp(argv[i], "--check-mga") == 0) check_mga = 1;
+		else if(strcmp(argv[i], "--check-windows") == 0) check_windows = 1;
+		else if(strcmp(argv[i], "--check-matrix") == 0) check_matrix = 1;
+		else if(strcmp(argv[i], "--check-moid") == 0) check_moid = 1;
+		else if(strcmp(argv[i], "--check-conjunctions") == 0) check_conjunction = 1;
+		else if(strcmp(argv[i], "--check-montecarlo") == 0) check_montecarlo = 1;
+		else if(strcmp(argv[i], "--check-propagator") == 0) check_propagator = 1;
+		else if(strcmp(argv[i], "--check-trajectory") == 0) check_trajectories = 1;
+		else {
+			fprintf(stderr, "Usage: %s [--json] [--filter <substring>] [--min-time <s>] [--fixtures <dir>] [--trace <file.json>] [--check-lambert] [--check-partials] [--check-optim] [--check-alloc] [--check-mga] [--check-windows] [--check-matrix] [--check-moid] [--check-conjunctions] [--check-montecarlo] [--check-propagator] [--check-trajectory]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	Body *sun = new_body();
+	snprintf(sun->name, sizeof(sun->name), "Star");
+	sun->mu = 1.32712440018e20;
+	sun->radius = 696000000;
+
+	// synthetic ephemeris (bundled fixture, never downloaded)
+	if(!is_ephem_available(BENCH_SYNTHETIC_EPHEM_ID, fixture_dir)) {
+		fprintf(stderr, "Benchmark fixtures not found in %s (use --fixtures <dir>)\n", fixture_dir);
+		return 1;
+	}
+	Body *planet = new_body();
+	snprintf(planet->name, sizeof(planet->name), "Planet");
+	planet->mu = 3.986004418e14;
+	planet->radius = 6371e3;
+
+	Body *ephem_body = new_body();
+	ephem_body->id = BENCH_SYNTHETIC_EPHEM_ID;
+	ephem_body->orbit.cb = sun;
+	get_body_ephems(ephem_body, (Datetime) {.y = 2000, .m = 1, .d = 1}, (Datetime) {.y = 2010, .m = 1, .d = 1}, (Datetime) {.d = 30}, fixture_dir);
+
+	// large synthetic catalog generated at runtime
+	char large_catalog[256];
+	const char *tmp_dir = getenv("TMPDIR");
+	if(tmp_dir == NULL) tmp_dir = getenv("TEMP");
+	if(tmp_dir == NULL) tmp_dir = ".";
+	snprintf(large_catalog, sizeof(large_catalog), "%s/orbitlib_bench_catalog.cfg", tmp_dir);
+	int has_large_catalog = write_synthetic_catalog(large_catalog, 400, 4);
+
+	char small_catalog[256];
+	snprintf(small_catalog, sizeof(small_catalog), "%s/synthetic.cfg", fixture_dir);
+
+	const double eccentricities[] = {0, 0.3, 0.9, 0.99, 1.5};
+	const double dt_factors[] = {0.01, 0.5, 10};
+	const double transfer_angles[] = {30, 90, 150, 210, 270, 300};
+
+	int max_cases = 64;
+	BenchCase *cases = calloc(max_cases, sizeof(BenchCase));
+	int num_cases = 0;
+	for(int i = 0; i < (int) (sizeof(eccentricities)/sizeof(double)); i++) {
+		for(int j = 0; j < (int) (sizeof(dt_factors)/sizeof(double)); j++) {
+			init_propagation_case(&cases[num_cases++], sun, eccentricities[i], dt_factors[j]);
+		}
+	}
+	for(int i = 0; i < (int) (sizeof(eccentricities)/sizeof(double)); i++) init_covariance_case(&cases[num_cases++], sun, eccentricities[i]);
+	for(int i = 0; i < (int) (sizeof(transfer_angles)/sizeof(double)); i++) init_lambert_case(&cases[num_cases++], sun, transfer_angles[i], 0);
+	for(int i = 0; i < (int) (sizeof(transfer_angles)/sizeof(double)); i++) init_lambert_case(&cases[num_cases++], sun, transfer_angles[i], 1);
+	for(int i = 0; i < (int) (sizeof(transfer_angles)/sizeof(double)); i++) init_lambert_sweep_case(&cases[num_cases++], sun, transfer_angles[i]);
+	init_lambert_multirev_case(&cases[num_cases++], sun);
+	init_ephem_case(&cases[num_cases++], ephem_body);
+	init_constr_orbit_case(&cases[num_cases++], sun);
+	init_hyperbola_case(&cases[num_cases++], planet, HYP_DEPARTURE, 0);
+	init_hyperbola_case(&cases[num_cases++], planet, HYP_DEPARTURE, 1);
+	init_hyperbola_case(&cases[num_cases++], planet, HYP_FLYBY, 0);
+	init_hyperbola_case(&cases[num_cases++], planet, HYP_FLYBY, 1);
+	init_date_case(&cases[num_cases++], DATE_ISO);
+	init_date_case(&cases[num_cases++], DATE_KERBAL);
+	for(int mode = 0; mode < 3; mode++) {
+		init_date_string_case(&cases[num_cases++], DATE_ISO, mode);
+		init_date_string_case(&cases[num_cases++], DATE_KERBAL, mode);
+	}
+	init_cfg_case(&cases[num_cases++], small_catalog, "72_bodies");
+	if(has_large_catalog) init_cfg_case(&cases[num_cases++], large_catalog, "2000_bodies");
+
+	if(check_lambert || check_partials || check_optim || check_alloc || check_mga || check_windows || check_matrix || check_moid || check_conjunction || check_montecarlo || check_propagator || check_trajectories) {
+		int num_failed = check_lambert ? check_lambert_solutions(cases, num_cases, filter) : 0;
+		if(check_partials) num_failed += check_lambert_partials(cases, num_cases, filter);
+		if(check_optim) num_failed += check_transfer_optimization(sun);
+		if(check_alloc) num_failed += check_mixed_allocators(fixture_dir);
+		if(check_mga) num_failed += check_mga_search(sun);
+		if(check_windows) num_failed += check_launch_windows(sun);
+		if(check_matrix) num_failed += check_transfer_matrix(sun, tmp_dir);
+		if(check_moid) num_failed += check_moid_computation(sun);
+		if(check_conjunction) num_failed += check_conjunctions(planet);
+		if(check_montecarlo) num_failed += check_monte_carlo(sun);
+		if(check_propagator) num_failed += check_numerical_propagator(sun, planet);
+		if(check_trajectories) num_failed += check_trajectory(sun);
+		if(has_large_catalog) remove(large_catalog);
+		free(cases);
+		free(ephem_body->ephem);
+		free(ephem_body);
+		free(planet);
+		free(sun);
+		return num_failed > 0;
+	}
+
+	if(trace_file != NULL) {
+		if(is_tracing_available()) start_tracing();
+		else fprintf(stderr, "orbitlib was built without tracing (ORBITLIB_TRACING)\n");
+	}
+
+	BenchResult *results = calloc(num_cases, sizeof(BenchResult));
+	int num_selected = 0;
+	for(int i = 0; i < num_cases; i++) {
+		if(filter != NULL && strstr(cases[i].name, filter) == NULL) continue;
+		if(!json) fprintf(stderr, "Running %s...\n", cases[i].name);
+		results[num_selected] = run_bench_case(&cases[i], min_time * 1e9);
+		cases[num_selected] = cases[i];
+		num_selected++;
+	}
+	print_results(cases, results, num_selected, json, min_time);
+	int hyperbola_batch_failed = !(max_hyperbola_batch_deviation <= HYPERBOLA_BATCH_TOLERANCE);
+	if(!json) printf("get_hyperbola_params_batch max. deviation from get_hyperbola_params: %.2e  %s\n", max_hyperbola_batch_deviation, hyperbola_batch_failed ? "FAIL" : "ok");
+	else if(hyperbola_batch_failed) fprintf(stderr, "get_hyperbola_params_batch deviates from get_hyperbola_params by %.2e\n", max_hyperbola_batch_deviation);
+	if(num_date_buffer_errors > 0) fprintf(stderr, "date_format() did not fail cleanly with too small buffers %lld times\n", (long long) num_date_buffer_errors);
+	if(trace_file != NULL && is_tracing_available()) {
+		stop_tracing();
+		export_trace_json(trace_file);
+	}
+
+	if(has_large_catalog) remove(large_catalog);
+	free(results);
+	free(cases);
+	free(ephem_body->ephem);
+	free(ephem_body);
+	free(planet);
+	free(sun);
+	return num_date_buffer_errors > 0 || hyperbola_batch_failed;
+}
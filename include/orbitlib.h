@@ -6,5 +6,21 @@
 #include "orbitlib_ephemeris.h"
 #include "orbitlib_datetime.h"
 #include "orbitlib_transfer.h"
+#include "orbitlib_timescale.h"
+#include "orbitlib_catalog.h"
+#include "orbitlib_stats.h"
+#include "orbitlib_diag.h"
+#include "orbitlib_trace.h"
+#include "orbitlib_context.h"
+#include "orbitlib_alloc.h"
+#include "orbitlib_mga.h"
+#include "orbitlib_optim.h"
+#include "orbitlib_window.h"
+#include "orbitlib_matrix.h"
+#include "orbitlib_moid.h"
+#include "orbitlib_conjunction.h"
+#include "orbitlib_montecarlo.h"
+#include "orbitlib_propagator.h"
+#include "orbitlib_trajectory.h"
 
 #endif // ORBITLIB_ORBITLIB_H
@@ -0,0 +1,125 @@
+#ifndef ORBITLIB_ORBITLIB_ALLOC_H
+#define ORBITLIB_ORBITLIB_ALLOC_H
+
+#include <stddef.h>
+
+/**
+ * @brief Allocator hooks used for all library objects (systems, bodies, ephemerides, file lists); NULL functions fall back to the C library
+ */
+typedef struct OrbitlibAllocator {
+	void * (*malloc)(size_t size, void *user_data);				/**< Allocates size bytes (aligned for any type); NULL if out of memory */
+	void * (*realloc)(void *ptr, size_t size, void *user_data);	/**< Resizes an allocation (ptr can be NULL); NULL if out of memory (ptr stays valid) */
+	void (*free)(void *ptr, void *user_data);					/**< Frees an allocation (ptr can be NULL) */
+	void *user_data;											/**< User data passed to the functions */
+} OrbitlibAllocator;
+
+/**
+ * @brief Bump allocator handing out memory from large blocks; all allocations are released at once with reset_orbitlib_arena()
+ */
+typedef struct OrbitlibArena OrbitlibArena;
+
+
+/*
+ * ------------------------------------
+ * Allocator Hooks
+ * ------------------------------------
+ */
+
+/**
+ * @brief Sets the process-wide allocator (used on threads without a bound context or if the bound context has no allocator)
+ *
+ * Should be set before any library objects are allocated (not synchronized with allocations on other threads).
+ *
+ * @param allocator The allocator (copied; NULL to reset to the C library)
+ */
+void set_orbitlib_allocator(const OrbitlibAllocator *allocator);
+
+/**
+ * @brief Returns the allocator used for allocations on the calling thread (the bound context's allocator or the process-wide allocator)
+ *
+ * @return The current allocator
+ */
+OrbitlibAllocator get_orbitlib_allocator();
+
+/**
+ * @brief Allocates memory with the current allocator (see get_orbitlib_allocator())
+ *
+ * @param size Number of bytes
+ * @return Pointer to the allocated memory; NULL if out of memory
+ */
+void * orbitlib_malloc(size_t size);
+
+/**
+ * @brief Allocates zero-initialized memory for an array with the current allocator
+ *
+ * @param num Number of elements
+ * @param size Size of each element
+ * @return Pointer to the allocated memory; NULL if out of memory
+ */
+void * orbitlib_calloc(size_t num, size_t size);
+
+/**
+ * @brief Resizes memory allocated with the current allocator
+ *
+ * @param ptr Pointer to the memory (NULL to allocate new memory)
+ * @param size New number of bytes
+ * @return Pointer to the resized memory; NULL if out of memory (ptr stays valid)
+ */
+void * orbitlib_realloc(void *ptr, size_t size);
+
+/**
+ * @brief Frees memory allocated with the current allocator (e.g. the result of list_files_with_extension())
+ *
+ * @param ptr Pointer to the memory (can be NULL)
+ */
+void orbitlib_free(void *ptr);
+
+
+/*
+ * ------------------------------------
+ * Arena
+ * ------------------------------------
+ */
+
+/**
+ * @brief Creates an arena
+ *
+ * Allocations larger than the block size get a block of their own. The arena is thread-safe.
+ *
+ * @param block_size Size of the memory blocks in bytes (0 for the default of 1 MiB)
+ * @return Pointer to the newly created arena (to be freed with free_orbitlib_arena()); NULL if out of memory
+ */
+OrbitlibArena * new_orbitlib_arena(size_t block_size);
+
+/**
+ * @brief Releases all allocations of the arena at once (the first block is kept for reuse)
+ *
+ * @param arena The arena
+ */
+void reset_orbitlib_arena(OrbitlibArena *arena);
+
+/**
+ * @brief Frees the arena including all its allocations
+ *
+ * @param arena The arena to be freed
+ */
+void free_orbitlib_arena(OrbitlibArena *arena);
+
+/**
+ * @brief Returns the number of bytes currently allocated from the arena (incl. alignment padding)
+ *
+ * @param arena The arena
+ * @return Number of allocated bytes
+ */
+size_t get_orbitlib_arena_usage(OrbitlibArena *arena);
+
+/**
+ * @brief Returns allocator hooks allocating from the arena (freeing single allocations only releases the most recent one)
+ *
+ * @param arena The arena (must outlive all allocations made through the hooks)
+ * @return The allocator
+ */
+OrbitlibAllocator get_orbitlib_arena_allocator(OrbitlibArena *arena);
+
+
+#endif //ORBITLIB_ORBITLIB_ALLOC_H
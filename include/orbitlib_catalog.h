@@ -0,0 +1,48 @@
+#ifndef ORBITLIB_ORBITLIB_CATALOG_H
+#define ORBITLIB_ORBITLIB_CATALOG_H
+
+#include "orbitlib_celestial.h"
+
+/*
+ * ------------------------------------
+ * Static Catalogs
+ * ------------------------------------
+ */
+
+/**
+ * @brief Returns the number of celestial systems compiled into the library
+ *
+ * The catalogs are generated at build time from the system configs listed in ORBITLIB_CATALOG_FILES
+ * (0 if the library is built with ORBITLIB_STATIC_CATALOGS=OFF)
+ *
+ * @return Number of static celestial systems
+ */
+int get_num_static_celestial_systems();
+
+/**
+ * @brief Returns a celestial system compiled into the library (read-only; no loading or parsing involved)
+ *
+ * @param index Index of the system (0 to get_num_static_celestial_systems()-1)
+ * @return Pointer to the static system (must not be modified or freed); NULL if the index is out of range
+ */
+const CelestSystem * get_static_celestial_system(int index);
+
+/**
+ * @brief Returns the celestial system compiled into the library with the given name
+ *
+ * @param name Name of the system (as defined in its config file)
+ * @return Pointer to the static system (must not be modified or freed); NULL if there is no such system
+ */
+const CelestSystem * get_static_celestial_system_by_name(const char *name);
+
+/**
+ * @brief Creates a modifiable copy of a celestial system compiled into the library
+ *
+ * @param system The static system
+ * @param include_ephems Copy ephemerides if non-zero (otherwise the copy is propagated with orbital elements)
+ * @return Pointer to the copied system (to be freed with free_celestial_system); NULL on failure
+ */
+CelestSystem * copy_static_celestial_system(const CelestSystem *system, int include_ephems);
+
+
+#endif //ORBITLIB_ORBITLIB_CATALOG_H
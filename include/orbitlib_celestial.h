@@ -3,6 +3,8 @@
 
 #include "orbitlib_orbit.h"
 #include "orbitlib_ephemeris.h"
+#include "orbitlib_timescale.h"
+#include "orbitlib_alloc.h"
 
 /**
  * @brief Represents a celestial body with physical and orbital properties
@@ -20,6 +22,7 @@ typedef struct Body {
 	double north_pole_ra;		/**< Right Ascension of the north pole relative to helio-centric coordinate system [rad] */
 	double north_pole_decl;		/**< Declination of the north pole relative to helio-centric coordinate system [rad] */
 	double rot_ut0;				/**< Rotation at UT0 (Angle between xz-plane (x+) and prime meridian) [rad] */
+	double j2;					/**< Second zonal harmonic of the gravity field (oblateness; 0 for a point mass) */
 	struct CelestSystem *system;/**< Pointer to the system this body is the central body of */
 	struct Orbit orbit;         /**< Orbit of the body at reference time (UT0) */
 	struct Ephem *ephem;        /**< Pointer to ephemeris data (if available) */
@@ -46,6 +49,9 @@ typedef struct CelestSystem {
 	struct Body **bodies;                      	/**< Array of pointers to orbiting bodies */
 	enum CelestSystemPropMethod prop_method;   	/**< Propagation method: orbital elements or ephemerides */
 	double ut0;                                	/**< Reference time (UT0) for the system */
+	enum TimeScale time_scale;					/**< Time scale of UT0 and all ephemeris epochs of the system */
+	void *mem_block;							/**< Single memory block holding the whole system incl. subsystems, bodies and ephemerides (snapshots and clones; NULL if allocated individually) */
+	OrbitlibAllocator allocator;				/**< Allocator the system, its bodies and ephemerides were allocated with (used by free_celestial_system()) */
 } CelestSystem;
 
 /*
@@ -58,6 +64,8 @@ typedef struct CelestSystem {
 /**
  * @brief Allocates and initializes a new celestial body
  *
+ * The body is allocated with the current allocator (see get_orbitlib_allocator()).
+ *
  * @return Pointer to the newly created Body
  */
 struct Body * new_body();
@@ -85,6 +93,8 @@ void set_body_color(struct Body *body, double red, double green, double blue);
 /**
  * @brief Allocates and initializes a new celestial system
  *
+ * The system is allocated with the current allocator (see get_orbitlib_allocator()), which is recorded in the system.
+ *
  * @return Pointer to the newly created CelestSystem
  */
 CelestSystem * new_system();
@@ -188,7 +198,7 @@ CelestSystem ** init_available_systems_from_path(const char *directory, int *num
 /**
  * @brief Frees memory associated with a single celestial system
  *
- * Deallocates all heap-allocated memory used by the system and its bodies.
+ * Deallocates all heap-allocated memory used by the system and its bodies with the allocator the system was allocated with.
  *
  * @param system Pointer to the system to free
  */
@@ -205,6 +215,24 @@ void free_celestial_system(CelestSystem *system);
 void free_celestial_systems(CelestSystem **systems, int num_systems);
 
 
+/*
+ * ------------------------------------
+ * Body State
+ * ------------------------------------
+ */
+
+/**
+ * @brief Returns the state vector of a body relative to its central body at the given epoch
+ *
+ * Uses the body's ephemerides if its system propagates with ephemerides and they are loaded; otherwise its orbital elements.
+ *
+ * @param body Pointer to the body
+ * @param epoch Epoch (Julian date)
+ * @return Orbital state vector (zero for a top-level central body)
+ */
+OSV get_body_osv(struct Body *body, double epoch);
+
+
 /*
  * ------------------------------------
  * Altitude / Radius Conversions
@@ -0,0 +1,83 @@
+#ifndef ORBITLIB_ORBITLIB_CONJUNCTION_H
+#define ORBITLIB_ORBITLIB_CONJUNCTION_H
+
+#include "orbitlib_orbit.h"
+#include "orbitlib_context.h"
+#include <stdint.h>
+
+
+/*
+ * ------------------------------------
+ * Conjunction Search Types
+ * ------------------------------------
+ */
+
+/**
+ * @brief Parameters of a conjunction search
+ */
+typedef struct ConjunctionParams {
+	double min_epoch;		/**< Start of the time span (Julian date) */
+	double max_epoch;		/**< End of the time span (Julian date) */
+	double time_step;		/**< Step of the coarse time grid [days] (each pair is assumed to have at most one close approach per step) */
+	double threshold;		/**< Maximum distance of reported close approaches [m] */
+} ConjunctionParams;
+
+/**
+ * @brief Close approach of two objects
+ */
+typedef struct ConjunctionEvent {
+	int idx0;				/**< Index of the first object (idx0 < idx1) */
+	int idx1;				/**< Index of the second object */
+	double epoch;			/**< Epoch of the closest approach (Julian date; start or end of the time span if the objects are closest there) */
+	double distance;		/**< Distance at the closest approach [m] */
+	double rel_speed;		/**< Relative speed at the closest approach [m/s] */
+} ConjunctionEvent;
+
+/**
+ * @brief Counters of a conjunction search
+ */
+typedef struct ConjunctionStats {
+	int num_steps;				/**< Number of steps of the coarse time grid */
+	int64_t num_candidates;		/**< Number of candidate pairs refined (overlapping bounds of their motion during a step) */
+	int64_t num_events;			/**< Number of close approaches found (can exceed the capacity of the output array) */
+} ConjunctionStats;
+
+
+/*
+ * ------------------------------------
+ * Conjunction Search
+ * ------------------------------------
+ */
+
+/**
+ * @brief Returns default conjunction search parameters (time span still needs to be set)
+ *
+ * @return Parameters with a time step of 1 day and a threshold of 1000 km
+ */
+ConjunctionParams get_default_conjunction_params();
+
+/**
+ * @brief Finds all close approaches of a set of objects on Keplerian orbits around the same central body within a time span
+ *
+ * All objects are propagated on a coarse time grid. For each step, the motion of each object is bounded by a box (its chord
+ * padded by the maximum deviation of the curved path), and the boxes are binned into a uniform spatial grid, so only objects
+ * sharing a cell are compared. The epoch of the closest approach of each candidate pair is found by a bracketed root search
+ * on the relative radial velocity. Propagation, candidate search and refinement run on the context's threads.
+ * Bodies can be included with their state from get_body_osv() at the reference epoch.
+ *
+ * @param ctx The library context providing the threads (NULL for the default context)
+ * @param osvs States of the objects at the reference epoch
+ * @param num_objects Number of objects
+ * @param epoch Reference epoch of the states (Julian date)
+ * @param cb Central body of all objects
+ * @param params The search parameters
+ * @param events Output array for the close approaches (sorted by epoch)
+ * @param max_events Capacity of the output array (the earliest close approaches are kept)
+ * @param stats Output parameter for search counters (can be NULL)
+ * @return Number of close approaches written to the output array
+ */
+int search_conjunctions(OrbitlibContext *ctx, const OSV *osvs, int num_objects, double epoch, Body *cb, const ConjunctionParams *params,
+						ConjunctionEvent *events, int max_events, ConjunctionStats *stats);
+
+
+#endif //ORBITLIB_ORBITLIB_CONJUNCTION_H
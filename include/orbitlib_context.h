@@ -0,0 +1,108 @@
+#ifndef ORBITLIB_ORBITLIB_CONTEXT_H
+#define ORBITLIB_ORBITLIB_CONTEXT_H
+
+#include "orbitlib_datetime.h"
+#include "orbitlib_diag.h"
+#include "orbitlib_alloc.h"
+
+/**
+ * @brief Library context holding the configuration and state that would otherwise be global (ephemeris directory and time window,
+ * ephemeris cache, thread pool, diagnostic sink and allocator); independently configured contexts can be used concurrently
+ */
+typedef struct OrbitlibContext OrbitlibContext;
+
+/**
+ * @brief Configuration of a library context
+ */
+typedef struct OrbitlibContextConfig {
+	const char *ephem_directory;	/**< Directory of the ephemeris files (copied; default: "../Ephemerides") */
+	Datetime ephem_min_date;		/**< Start of the ephemeris time window requested for downloads (default: 1950-01-01) */
+	Datetime ephem_max_date;		/**< End of the ephemeris time window requested for downloads (default: 2100-01-01) */
+	Datetime ephem_time_step;		/**< Time step between downloaded ephemerides (default: 1 month) */
+	int allow_download;				/**< Download missing ephemeris files from JPL's Horizons API (default: 1) */
+	int cache_ephems;				/**< Keep loaded ephemerides in memory for subsequent loads with this context (default: 1) */
+	int num_threads;				/**< Worker threads of the context's thread pool besides the calling thread (default: 0; negative: number of processors - 1) */
+	DiagSink diag_sink;				/**< Sink for diagnostic records of solver calls made through or bound to this context (buffered like all records and delivered by drain_diag_records(); NULL: global sink) */
+	void *diag_user_data;			/**< User data passed to the diagnostic sink */
+	const OrbitlibAllocator *allocator;	/**< Allocator for library objects allocated through or on threads bound to this context (copied; NULL: process-wide allocator) */
+} OrbitlibContextConfig;
+
+
+/*
+ * ------------------------------------
+ * Context Creation
+ * ------------------------------------
+ */
+
+/**
+ * @brief Returns the default configuration (matches the behavior of the functions without context)
+ *
+ * @return The default configuration
+ */
+OrbitlibContextConfig get_default_orbitlib_context_config();
+
+/**
+ * @brief Creates a library context
+ *
+ * @param config The configuration (NULL for the default configuration)
+ * @return Pointer to the newly created context (to be freed with free_orbitlib_context()); NULL on failure
+ */
+OrbitlibContext * new_orbitlib_context(const OrbitlibContextConfig *config);
+
+/**
+ * @brief Frees a library context including its cache and thread pool (must not be in use anymore)
+ *
+ * @param ctx The context to be freed
+ */
+void free_orbitlib_context(OrbitlibContext *ctx);
+
+/**
+ * @brief Returns the process-wide default context used by the functions without context parameter
+ *
+ * @return The default context (must not be freed)
+ */
+OrbitlibContext * get_default_orbitlib_context();
+
+
+/*
+ * ------------------------------------
+ * Context Usage
+ * ------------------------------------
+ */
+
+/**
+ * @brief Binds a context to the calling thread, so diagnostic records of solver calls on this thread go to the context's sink
+ * and library objects are allocated with the context's allocator
+ *
+ * Functions taking a context bind it for their duration themselves (also on the context's worker threads).
+ *
+ * @param ctx The context to be bound (NULL to unbind)
+ * @return The previously bound context (to restore it afterwards)
+ */
+OrbitlibContext * bind_orbitlib_context(OrbitlibContext *ctx);
+
+/**
+ * @brief Returns the ephemeris directory of the context
+ *
+ * @param ctx The context
+ * @return The ephemeris directory
+ */
+const char * get_context_ephem_directory(OrbitlibContext *ctx);
+
+/**
+ * @brief Returns the number of threads working on parallel tasks of the context (worker threads + calling thread)
+ *
+ * @param ctx The context
+ * @return Number of threads (1 if the context has no thread pool)
+ */
+int get_context_num_threads(OrbitlibContext *ctx);
+
+/**
+ * @brief Discards all ephemerides cached by the context
+ *
+ * @param ctx The context
+ */
+void clear_context_ephem_cache(OrbitlibContext *ctx);
+
+
+#endif //ORBITLIB_ORBITLIB_CONTEXT_H
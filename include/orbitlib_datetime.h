@@ -1,6 +1,12 @@
 #ifndef ORBITLIB_ORBITLIB_DATETIME_H
 #define ORBITLIB_ORBITLIB_DATETIME_H
 
+#include <stddef.h>
+
+/**
+ * @brief Buffer size that fits every date string produced by date_format() and clocktime_format() (including null terminator)
+ */
+#define DATE_STRING_MAX 32
 
 /**
  * @brief ISO ("Earth time"; UT0 = 2000-01-01T12:00; 1y = 12M = 365.25d; 1d = 24h)  -  Kerbal time (UT0 = 0001-001T00:00; 1y = 426d; 1d = 6h)  -  Kerbal imitating ISO (UT0 = 0001-001T00:00; 1y = 365d; 1d = 24h)
@@ -21,6 +27,18 @@ typedef struct Datetime {
 } Datetime;
 
 
+/**
+ * @brief Flags for date_format() and clocktime_format() (can be combined with '|')
+ */
+enum DateFormatFlags {
+	DATE_FMT_DATE       = 0,	/**< Only the date (YYYY-MM-DD or YYYY-DDD) */
+	DATE_FMT_CLOCKTIME  = 1,	/**< Append the clocktime (hh:mm:ss) */
+	DATE_FMT_NO_SECONDS = 2,	/**< Omit the seconds of the clocktime (hh:mm) */
+	DATE_FMT_MILLIS     = 4,	/**< Append milliseconds to the seconds (hh:mm:ss.sss) */
+	DATE_FMT_ISO_T      = 8		/**< Separate date and clocktime with 'T' instead of ' ' (ISO 8601) */
+};
+
+
 /**
  * @brief Prints date in the format [ISO] YYYY-MM-DD hh:mm:ss.f (ISO 8601), [KER] YYYY-DDD hh:mm:ss (Kerbal time) or [ILK] YYYY-DDD hh:mm:ss (ISO-like Kerbal time)
  *
@@ -41,11 +59,37 @@ void print_date(Datetime date, int line_break);
 int is_string_valid_date_format(const char *s, enum DateType date_type);
 
 
+/**
+ * @brief Writes the date (ISO 8601 or Kerbal time) into a buffer of given size (locale-independent, no allocation)
+ *
+ * Seconds are rounded to the displayed precision; the carry never rolls over the date itself.
+ *
+ * @param date The date to be formatted
+ * @param buf The buffer the string should be written to
+ * @param buf_size Size of the buffer (DATE_STRING_MAX always suffices)
+ * @param flags Combination of DateFormatFlags
+ *
+ * @return Length of the written string (without null terminator) or -1 if the buffer is too small (buffer then holds an empty string)
+ */
+int date_format(Datetime date, char *buf, size_t buf_size, int flags);
+
+/**
+ * @brief Writes the clocktime (hh:mm, hh:mm:ss or hh:mm:ss.sss) into a buffer of given size (locale-independent, no allocation)
+ *
+ * @param date The date of which the clocktime should be formatted
+ * @param buf The buffer the string should be written to
+ * @param buf_size Size of the buffer
+ * @param flags Combination of DATE_FMT_NO_SECONDS and DATE_FMT_MILLIS (other flags are ignored)
+ *
+ * @return Length of the written string (without null terminator) or -1 if the buffer is too small (buffer then holds an empty string)
+ */
+int clocktime_format(Datetime date, char *buf, size_t buf_size, int flags);
+
 /**
  * @brief Returns a string with the date (ISO 8601 or Kerbal time)
  *
  * @param date The date to be converted to a string
- * @param s The string the date should be saved in
+ * @param s The string the date should be saved in (at least DATE_STRING_MAX bytes)
  * @param clocktime Set to 1 if clocktime should be shown, 0 if only date should be shown
  */
 void date_to_string(Datetime date, char *s, int clocktime);
@@ -54,19 +98,36 @@ void date_to_string(Datetime date, char *s, int clocktime);
  * @brief Returns a string with the clocktime (hh:mm or hh:mm:ss)
  *
  * @param date The date to be converted to a string
- * @param s The string the date should be saved in
+ * @param s The string the date should be saved in (at least 9 bytes with seconds, 6 bytes without)
  * @param seconds Set to 1 if seconds should be shown, 0 if only hours and minutes should be shown
  */
 void clocktime_to_string(Datetime date, char *s, int seconds);
 
 
 /**
- * @brief Parses string and returns date (ISO 8601 or Kerbal time) (excluding time)
+ * @brief Parses and validates a date string of given length (locale-independent, no allocation)
+ *
+ * Accepted formats: "YYYY-MM-DD" (ISO 8601) or "YYYY-DDD" (Kerbal and ISO-like Kerbal), optionally followed by
+ * a clocktime separated by 'T' or ' ' ("hh:mm", "hh:mm:ss" or "hh:mm:ss.fff"; ISO dates may end with 'Z').
+ * Leading and trailing whitespace is ignored.
+ *
+ * @param s The string to be parsed (does not need to be null-terminated)
+ * @param len Number of characters to parse
+ * @param date_type Type of the date (ISO, Kerbal, ISO-like Kerbal)
+ * @param date Output parameter for the parsed date (unchanged if parsing fails)
+ *
+ * @return 1 if the string is a valid date, 0 otherwise
+ */
+int date_parse(const char *s, size_t len, enum DateType date_type, Datetime *date);
+
+
+/**
+ * @brief Parses string and returns date (ISO 8601 or Kerbal time) (optionally including clocktime; see date_parse())
  *
  * @param s The string to be parsed into date
  * @param date_type Type of the date (ISO, Kerbal, ISO-like Kerbal)
  *
- * @return The date parsed from the given string
+ * @return The date parsed from the given string (all fields zero if the string is invalid)
  */
 Datetime date_from_string(char *s, enum DateType date_type);
 
@@ -0,0 +1,94 @@
+#ifndef ORBITLIB_ORBITLIB_DIAG_H
+#define ORBITLIB_ORBITLIB_DIAG_H
+
+#include "orbitlib_stats.h"
+#include <stdint.h>
+
+#define DIAG_RECORD_NUM_VALUES 8		/**< Number of values stored per diagnostic record */
+#define DIAG_RING_BUFFER_SIZE 256		/**< Number of records buffered per thread (further records are dropped until drained) */
+
+/**
+ * @brief Failure codes of diagnostic records; the meaning of the record values is listed per code
+ */
+enum DiagCode {
+	DIAG_LAMBERT_FAIL_ECC,			/**< Negative eccentricity; values: r0, r1, delta_ta, target_dt, ta0, min_ta0, max_ta0, e */
+	DIAG_LAMBERT_FAIL_NAN,			/**< Time of flight is NaN; values: r0, r1, delta_ta, target_dt, ta0, ta1, a, e */
+	DIAG_LAMBERT_MAX_ITERATIONS,	/**< No convergence within the iteration cap; values: r0, r1, delta_ta, target_dt, ta0, dt */
+	DIAG_PROPAGATION_ITERATION_CAP,	/**< propagate_orbit_time() hit its iteration cap; values: a, e, ta0, dt, t, target_t */
+	DIAG_KEPLER_ITERATION_CAP,		/**< Kepler's equation did not converge; values: e, mean_anomaly, ecc_anomaly, last correction */
+	NUM_DIAG_CODES
+};
+
+/**
+ * @brief Compact diagnostic record pushed by a solver
+ */
+typedef struct DiagRecord {
+	uint16_t solver;							/**< Solver that pushed the record (enum SolverId) */
+	uint16_t code;								/**< Failure code (enum DiagCode) */
+	uint32_t thread;							/**< Index of the recording thread (in order of the threads' first record; UINT32_MAX if unknown) */
+	uint64_t timestamp;							/**< Monotonic timestamp [ns] */
+	double values[DIAG_RECORD_NUM_VALUES];		/**< Solver inputs and state at the failure (see enum DiagCode; unused values are 0) */
+} DiagRecord;
+
+/**
+ * @brief Callback receiving drained diagnostic records
+ *
+ * @param records The records (only valid during the call)
+ * @param num_records Number of records
+ * @param user_data User data given at registration
+ */
+typedef void (*DiagSink)(const DiagRecord *records, int num_records, void *user_data);
+
+
+/*
+ * ------------------------------------
+ * Diagnostic Sink
+ * ------------------------------------
+ */
+
+/**
+ * @brief Registers the sink that receives drained diagnostic records (replaces a previously registered sink)
+ *
+ * Solvers only record while a sink is registered (here or in the context bound to the calling thread); otherwise recording is a
+ * no-op.
+ *
+ * @param sink The sink (NULL to stop recording)
+ * @param user_data User data passed to the sink
+ */
+void set_diag_sink(DiagSink sink, void *user_data);
+
+/**
+ * @brief Forwards all buffered records of all threads to their sinks
+ *
+ * The records are pushed lock-free into per-thread ring buffers; draining can happen from any thread at any time.
+ * Records made while a context with a sink was bound go to that context's sink, all others to the registered sink (one batch
+ * per run of consecutive records with the same sink). The sinks are called from the draining thread.
+ *
+ * @return Number of forwarded records
+ */
+int drain_diag_records();
+
+/**
+ * @brief Returns the number of records dropped because a ring buffer was full
+ *
+ * @return Number of dropped records since program start
+ */
+uint64_t get_num_dropped_diag_records();
+
+/**
+ * @brief Returns the name of the failure code (e.g. "LAMBERT_FAIL_ECC")
+ *
+ * @param code The failure code
+ * @return Name of the code
+ */
+const char * get_diag_code_name(enum DiagCode code);
+
+/**
+ * @brief Prints a diagnostic record in human-readable form (e.g. to be used inside a sink)
+ *
+ * @param record The record
+ */
+void print_diag_record(const DiagRecord *record);
+
+
+#endif //ORBITLIB_ORBITLIB_DIAG_H
@@ -4,12 +4,13 @@
 #include "geometrylib.h"
 #include "orbitlib_celestial.h"
 #include "orbitlib_datetime.h"
+#include "orbitlib_context.h"
 
 /**
  * @brief Represents the ephemeral data consisting of epoch, position, and velocity components
  */
 typedef struct Ephem {
-	double epoch;	/**< Epoch associated with the ephemeral data (Julian Date) */
+	double epoch;	/**< Epoch associated with the ephemeral data (Julian Date; in the time scale of the body's system) */
 	Vector3 r;		/**< Position Vector */
 	Vector3 v;		/**< Velocity Vector */
 } Ephem;
@@ -22,14 +23,41 @@ typedef struct Ephem {
 void print_ephem(struct Ephem ephem);
 
 
+/**
+ * @brief Checks whether the ephemeris file of a body is stored locally
+ *
+ * @param body_code Body ID as defined by JPL's Horizon API
+ * @param ephem_directory Directory the ephemeris files are stored in
+ * @return 1 if the file exists, 0 otherwise
+ */
+int is_ephem_available(int body_code, const char *ephem_directory);
+
+
 /**
  * @brief Retrieves the ephemeral data of requested body for requested time (from JPL's Horizon API or from file)
  *
+ * The time window only applies to downloads of missing files; get_body_ephems_ctx() takes it from a context instead.
+ * The ephemerides are allocated with the allocator of the system the body belongs to (the current allocator if it belongs to none).
+ *
  * @param body The body for which the ephemerides should be stored
- * @param central_body The central body of the body's system
+ * @param min_date Start of the time window requested for downloads
+ * @param max_date End of the time window requested for downloads
+ * @param time_step Time step between downloaded ephemerides
+ * @param ephem_directory Directory the ephemeris files are stored in
  */
 void get_body_ephems(Body *body, Datetime min_date, Datetime max_date, Datetime time_step, const char *ephem_directory);
 
+/**
+ * @brief Retrieves the ephemeral data of the body using the ephemeris directory, time window and cache of the given context
+ *
+ * Missing files are only downloaded if the context allows it. Like with get_body_ephems(), the ephemerides are allocated with the
+ * allocator of the system the body belongs to (not the context's allocator), so free_celestial_system() can release them.
+ *
+ * @param ctx The library context (NULL for the default context)
+ * @param body The body for which the ephemerides should be stored
+ */
+void get_body_ephems_ctx(OrbitlibContext *ctx, Body *body);
+
 /**
  * @brief Interpolates an ephemeris list to get the state vector at a given epoch
  *
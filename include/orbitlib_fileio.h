@@ -2,6 +2,17 @@
 #define ORBITLIB_ORBITLIB_FILEIO_H
 
 #include "orbitlib_celestial.h"
+#include "orbitlib_context.h"
+#include <stddef.h>
+
+/**
+ * @brief Position and description of an error encountered while parsing a system config (.cfg)
+ */
+typedef struct CfgParseError {
+	int line;			/**< Line of the error (starting at 1; 0 if the error is not bound to a position) */
+	int column;			/**< Column of the error (starting at 1; 0 if the error is not bound to a position) */
+	char message[128];	/**< Description of the error */
+} CfgParseError;
 
 /*
  * ------------------------------------
@@ -39,7 +50,7 @@ void download_file(const char *url, const char *filepath);
  * @param path Directory to search
  * @param extension File extension to match (e.g., ".cfg")
  * @param count Output parameter for the number of matching files
- * @return Array of matching filenames (must be freed by caller)
+ * @return Array of matching filenames (array and filenames allocated with the current allocator; must be freed by caller with orbitlib_free())
  */
 char **list_files_with_extension(const char *path, const char *extension, int *count);
 
@@ -68,9 +79,97 @@ void store_system_in_config_file(CelestSystem *system, const char *directory);
 /**
  * @brief Loads a celestial system from a configuration file
  *
+ * Parse errors are printed to stderr as "file:line:column: message".
+ * Uses the default context (see load_celestial_system_from_cfg_file_ctx()).
+ *
  * @param filename Path to the configuration file
- * @return Pointer to the loaded celestial system
+ * @return Pointer to the loaded celestial system (NULL if the file could not be read or parsed)
  */
 CelestSystem * load_celestial_system_from_cfg_file(char *filename);
 
+/**
+ * @brief Loads a celestial system from a configuration file using the ephemeris settings, cache and threads of the given context
+ *
+ * Parse errors are printed to stderr as "file:line:column: message".
+ *
+ * @param ctx The library context (NULL for the default context)
+ * @param filename Path to the configuration file
+ * @return Pointer to the loaded celestial system (NULL if the file could not be read or parsed)
+ */
+CelestSystem * load_celestial_system_from_cfg_file_ctx(OrbitlibContext *ctx, const char *filename);
+
+/**
+ * @brief Loads a celestial system from the contents of a configuration file in a single pass
+ *
+ * Supports the legacy (km, kPa) and the M_DEG_PA unit conventions. Unknown keys are ignored.
+ * Ephemerides are not loaded (see load_celestial_system_ephems()).
+ *
+ * @param buffer Contents of the configuration file (modified during parsing; must hold size+1 bytes)
+ * @param size Number of characters in the buffer
+ * @param error Output parameter for the position and description of a parse error (can be NULL)
+ * @return Pointer to the loaded celestial system (NULL if parsing failed)
+ */
+CelestSystem * load_celestial_system_from_cfg_buffer(char *buffer, size_t size, CfgParseError *error);
+
+/**
+ * @brief Loads the ephemerides of all bodies of a system and its subsystems and updates their orbits at UT0 accordingly
+ *
+ * Missing ephemeris files are downloaded from JPL's Horizon API with the time window and step of the default context
+ * (see get_body_ephems() and get_default_orbitlib_context_config()).
+ *
+ * @param system Pointer to the celestial system
+ * @param ephem_directory Directory the ephemeris files are stored in
+ */
+void load_celestial_system_ephems(CelestSystem *system, const char *ephem_directory);
+
+/**
+ * @brief Loads the ephemerides of all bodies of a system and its subsystems using the given context and updates their orbits at UT0 accordingly
+ *
+ * The bodies are loaded in parallel on the context's thread pool; cached ephemerides of the context are reused.
+ *
+ * @param ctx The library context (NULL for the default context)
+ * @param system Pointer to the celestial system
+ */
+void load_celestial_system_ephems_ctx(OrbitlibContext *ctx, CelestSystem *system);
+
+
+
+/*
+ * ------------------------------------
+ * Binary Snapshot
+ * ------------------------------------
+ */
+
+/**
+ * @brief Stores a fully loaded celestial system (bodies, resolved orbits, subsystem layout and optionally ephemerides) as a versioned binary snapshot
+ *
+ * Snapshots are a cache format: they are only valid for the same build configuration (struct layout, pointer size and endianness).
+ * Without ephemerides, the stored systems use orbital elements for propagation.
+ *
+ * @param system Pointer to the top-level system to store
+ * @param filepath Path of the snapshot file
+ * @param include_ephems Set to 1 if ephemerides should be embedded, 0 otherwise
+ * @return 1 if the snapshot was written, 0 otherwise
+ */
+int save_celestial_system_snapshot(CelestSystem *system, const char *filepath, int include_ephems);
+
+/**
+ * @brief Loads a celestial system from a binary snapshot with a single read and pointer fix-up
+ *
+ * The whole system is held in one memory block (see CelestSystem::mem_block) and is freed with free_celestial_system().
+ *
+ * @param filepath Path of the snapshot file
+ * @return Pointer to the loaded celestial system (NULL if the file is missing, incompatible or corrupt)
+ */
+CelestSystem * load_celestial_system_snapshot(const char *filepath);
+
+/**
+ * @brief Creates a deep copy of a celestial system in a single memory block (same layout as a loaded snapshot)
+ *
+ * @param system Pointer to the top-level system to copy
+ * @param include_ephems Set to 1 if ephemerides should be copied, 0 otherwise (copy then uses orbital elements for propagation)
+ * @return Pointer to the copy (freed with free_celestial_system()); NULL if out of memory
+ */
+CelestSystem * clone_celestial_system(CelestSystem *system, int include_ephems);
+
 #endif //ORBITLIB_ORBITLIB_FILEIO_H
@@ -0,0 +1,182 @@
+#ifndef ORBITLIB_ORBITLIB_MATRIX_H
+#define ORBITLIB_ORBITLIB_MATRIX_H
+
+#include "orbitlib_optim.h"
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+ * ------------------------------------
+ * Transfer Matrix Types
+ * ------------------------------------
+ */
+
+/**
+ * @brief Parameters of the precomputation of a transfer matrix
+ */
+typedef struct TransferMatrixParams {
+	double min_departure_epoch;			/**< Start of the epoch horizon for the Lambert windows (Julian date) */
+	double max_departure_epoch;			/**< End of the epoch horizon for the Lambert windows (Julian date) */
+	double min_duration_factor;			/**< Minimum Lambert transfer duration relative to the pair's Hohmann duration */
+	double max_duration_factor;			/**< Maximum Lambert transfer duration relative to the pair's Hohmann duration */
+	int seeds_per_synodic_period;		/**< Coarse departure seeds per synodic period of the pair */
+	int max_departure_seeds;			/**< Upper limit of the departure seeds of a pair (pairs with short synodic periods) */
+	int num_duration_seeds;				/**< Coarse seeds along the duration range */
+	int max_windows;					/**< Maximum number of Lambert windows stored per pair (the ones with the lowest delta-v) */
+	enum Transfer_Type transfer_type;	/**< Departure and arrival maneuvers of the Lambert windows */
+	double departure_altitude;			/**< Periapsis altitude of the departure hyperbola [m] */
+	double arrival_altitude;			/**< Periapsis altitude of the arrival hyperbola [m] */
+} TransferMatrixParams;
+
+/**
+ * @brief Body of a transfer matrix (identified by name, as pointers are not valid across processes)
+ */
+typedef struct TransferMatrixBody {
+	char name[32];		/**< Name of the body */
+	int32_t id;			/**< Body ID (see Body::id) */
+	int32_t group;		/**< Index of the group (subsystem) the body belongs to */
+	int32_t index;		/**< Index of the body within its group */
+	int32_t reserved;
+} TransferMatrixBody;
+
+/**
+ * @brief Group of bodies orbiting the same central body (one subsystem of the celestial system)
+ */
+typedef struct TransferMatrixGroup {
+	char cb_name[32];		/**< Name of the central body */
+	int32_t first_body;		/**< Index of the group's first body in the matrix (bodies of a group are consecutive) */
+	int32_t num_bodies;		/**< Number of bodies in the group */
+	uint64_t first_entry;	/**< Index of the group's first entry (num_bodies x num_bodies entries, departure-major) */
+} TransferMatrixGroup;
+
+/**
+ * @brief Precomputed transfer between two bodies of a group
+ */
+typedef struct TransferMatrixEntry {
+	double hohmann_duration;		/**< Duration of the Hohmann transfer between the semi-major axes [s] */
+	double hohmann_dv_departure;	/**< Delta-v of the Hohmann transfer at departure [m/s] */
+	double hohmann_dv_arrival;		/**< Delta-v of the Hohmann transfer at arrival [m/s] */
+	int32_t num_windows;			/**< Number of stored Lambert windows (0 for the diagonal) */
+	int32_t reserved;
+} TransferMatrixEntry;
+
+/**
+ * @brief Minimum-delta-v Lambert window of a pair within the epoch horizon
+ */
+typedef struct TransferMatrixWindow {
+	double departure_epoch;		/**< Departure epoch (Julian date) */
+	double duration;			/**< Transfer duration [days] */
+	double dv_departure;		/**< Delta-v of the departure maneuver [m/s] */
+	double dv_arrival;			/**< Delta-v of the arrival maneuver [m/s] */
+	double dv;					/**< Total delta-v [m/s] */
+} TransferMatrixWindow;
+
+/**
+ * @brief Transfer matrix of all body pairs within each subsystem of a celestial system
+ *
+ * All tables lie in one block of fixed-width records that is also the file format, so a saved matrix is used
+ * directly from its memory mapping.
+ */
+typedef struct TransferMatrix {
+	const TransferMatrixBody *bodies;		/**< Bodies of all groups */
+	const TransferMatrixGroup *groups;		/**< Groups (subsystems) */
+	const TransferMatrixEntry *entries;		/**< Entries of all groups */
+	const TransferMatrixWindow *windows;	/**< max_windows Lambert windows per entry (sorted by total delta-v) */
+	int num_bodies;							/**< Number of bodies */
+	int num_groups;							/**< Number of groups */
+	int max_windows;						/**< Capacity of Lambert windows per entry */
+	double min_departure_epoch;				/**< Start of the epoch horizon (Julian date) */
+	double max_departure_epoch;				/**< End of the epoch horizon (Julian date) */
+	void *data;								/**< Memory block holding all tables */
+	size_t data_size;						/**< Size of the memory block [bytes] */
+	int is_mapped;							/**< 1 if the memory block is a read-only file mapping */
+} TransferMatrix;
+
+
+/*
+ * ------------------------------------
+ * Transfer Matrix
+ * ------------------------------------
+ */
+
+/**
+ * @brief Returns default transfer matrix parameters (epoch horizon still needs to be set)
+ *
+ * @return Parameters with Lambert durations of 0.5-1.5 times the Hohmann duration, 8 departure seeds per synodic period
+ * (at most 256), 6 duration seeds, 4 windows per pair and circular departure and capture at arrival at 200km altitude
+ */
+TransferMatrixParams get_default_transfer_matrix_params();
+
+/**
+ * @brief Precomputes Hohmann transfers and minimum-delta-v Lambert windows for every ordered pair of bodies orbiting the same central body
+ *
+ * The pairs are computed in parallel on the context's threads. The Lambert windows are found by search_optimal_transfers()
+ * with the departure seeds spread over the epoch horizon according to the pair's synodic period.
+ *
+ * @param ctx The library context providing the threads (NULL for the default context)
+ * @param system The top-level celestial system (all subsystems are included)
+ * @param params The precomputation parameters
+ * @return The transfer matrix (freed with free_transfer_matrix(); NULL if the parameters are invalid or out of memory)
+ */
+TransferMatrix * build_transfer_matrix(OrbitlibContext *ctx, CelestSystem *system, const TransferMatrixParams *params);
+
+/**
+ * @brief Stores a transfer matrix as a binary file (native byte order, checked on load)
+ *
+ * @param matrix The transfer matrix
+ * @param filepath Path of the file
+ * @return 1 if the file was written, 0 otherwise
+ */
+int save_transfer_matrix(const TransferMatrix *matrix, const char *filepath);
+
+/**
+ * @brief Maps a transfer matrix file into memory (read-only; no parsing or copying)
+ *
+ * @param filepath Path of the file
+ * @return The transfer matrix (freed with free_transfer_matrix(); NULL if the file is missing, incompatible or corrupt)
+ */
+TransferMatrix * load_transfer_matrix(const char *filepath);
+
+/**
+ * @brief Frees a transfer matrix (unmaps it if it was loaded from a file)
+ *
+ * @param matrix The transfer matrix (can be NULL)
+ */
+void free_transfer_matrix(TransferMatrix *matrix);
+
+/**
+ * @brief Finds the index of a body in a transfer matrix by name
+ *
+ * Compares the names of all bodies (O(number of bodies)), so resolve the indices once and keep them for the constant-time
+ * queries instead of calling this per query.
+ *
+ * @param matrix The transfer matrix
+ * @param name Name of the body
+ * @return Index of the body (-1 if it is not part of the matrix)
+ */
+int find_transfer_matrix_body(const TransferMatrix *matrix, const char *name);
+
+/**
+ * @brief Returns the precomputed transfer between two bodies (constant time)
+ *
+ * @param matrix The transfer matrix
+ * @param departure_body Index of the departure body
+ * @param arrival_body Index of the arrival body
+ * @return The entry (NULL for invalid indices or bodies of different groups)
+ */
+const TransferMatrixEntry * get_transfer_matrix_entry(const TransferMatrix *matrix, int departure_body, int arrival_body);
+
+/**
+ * @brief Returns the precomputed Lambert windows between two bodies (constant time)
+ *
+ * @param matrix The transfer matrix
+ * @param departure_body Index of the departure body
+ * @param arrival_body Index of the arrival body
+ * @param num_windows Output parameter for the number of windows
+ * @return The windows sorted by total delta-v (NULL and 0 windows for invalid indices or bodies of different groups)
+ */
+const TransferMatrixWindow * get_transfer_matrix_windows(const TransferMatrix *matrix, int departure_body, int arrival_body, int *num_windows);
+
+
+#endif //ORBITLIB_ORBITLIB_MATRIX_H
@@ -0,0 +1,107 @@
+#ifndef ORBITLIB_ORBITLIB_MGA_H
+#define ORBITLIB_ORBITLIB_MGA_H
+
+#include "orbitlib_transfer.h"
+#include "orbitlib_context.h"
+#include <stdint.h>
+
+#define MGA_MAX_FLYBYS 6
+#define MGA_MAX_SEQUENCE_LENGTH (MGA_MAX_FLYBYS + 2)
+
+
+/*
+ * ------------------------------------
+ * MGA Search Types
+ * ------------------------------------
+ */
+
+/**
+ * @brief Parameters of a multiple-gravity-assist (MGA) sequence search
+ *
+ * All bodies have to orbit the same central body. Legs are Lambert arcs between the bodies; flybys can be powered
+ * (the difference in excess speed is counted as delta-v).
+ */
+typedef struct MgaSearchParams {
+	Body *departure_body;			/**< Body the trajectory departs from */
+	Body *arrival_body;				/**< Body the trajectory ends at */
+	Body **flyby_bodies;			/**< Candidate bodies for flybys (can include the departure and arrival body) */
+	int num_flyby_bodies;			/**< Number of candidate flyby bodies */
+	int max_flybys;					/**< Maximum number of flybys in a sequence (at most MGA_MAX_FLYBYS) */
+	double min_departure_epoch;		/**< Start of the departure window (Julian date) */
+	double max_departure_epoch;		/**< End of the departure window (Julian date) */
+	double departure_epoch_step;	/**< Step between departure epochs [days] */
+	double min_leg_duration;		/**< Minimum duration of a leg [days] */
+	double max_leg_duration;		/**< Maximum duration of a leg [days] */
+	double leg_duration_step;		/**< Step between leg durations [days] */
+	double max_duration;			/**< Maximum duration of the whole trajectory [days] (0: unlimited) */
+	enum Transfer_Type transfer_type;	/**< Departure and arrival maneuvers (flyby types: no arrival maneuver) */
+	double departure_altitude;		/**< Periapsis altitude of the departure hyperbola [m] */
+	double arrival_altitude;		/**< Periapsis altitude of the arrival hyperbola [m] */
+	double min_flyby_altitude;		/**< Minimum periapsis altitude of flybys above the atmosphere [m] */
+	double max_vinf_mismatch;		/**< Maximum difference of incoming and outgoing excess speed at a flyby [m/s] */
+	double max_dv;					/**< Upper bound on the total delta-v of returned trajectories [m/s] */
+	int max_results;				/**< Maximum number of returned trajectories (top-k) */
+} MgaSearchParams;
+
+/**
+ * @brief Trajectory found by the MGA search
+ */
+typedef struct MgaTrajectory {
+	int num_bodies;									/**< Number of encountered bodies incl. departure and arrival body */
+	Body *bodies[MGA_MAX_SEQUENCE_LENGTH];			/**< Encountered bodies (departure, flybys, arrival) */
+	double epochs[MGA_MAX_SEQUENCE_LENGTH];			/**< Epochs of the encounters (Julian date) */
+	double vinf[MGA_MAX_SEQUENCE_LENGTH];			/**< Excess speed at the encounters (departure: outgoing; else: incoming) [m/s] */
+	double dv_departure;							/**< Delta-v of the departure maneuver [m/s] */
+	double dv_flybys;								/**< Delta-v of all powered flybys [m/s] */
+	double dv_arrival;								/**< Delta-v of the arrival maneuver [m/s] */
+	double dv;										/**< Total delta-v [m/s] */
+} MgaTrajectory;
+
+/**
+ * @brief Counters of an MGA search
+ */
+typedef struct MgaSearchStats {
+	int64_t num_legs;		/**< Number of evaluated legs (Lambert solutions) */
+	int64_t num_pruned;		/**< Number of legs not expanded further (failed Lambert solution, flyby bounds or delta-v bound) */
+} MgaSearchStats;
+
+
+/*
+ * ------------------------------------
+ * MGA Search
+ * ------------------------------------
+ */
+
+/**
+ * @brief Returns default search parameters (bodies and departure window still need to be set)
+ *
+ * @return Search parameters with a leg duration range of 30-1500 days, 2 flybys, circular departure and capture at arrival
+ * at 200km altitude, a maximum vinf mismatch of 100 m/s and the 10 best trajectories
+ */
+MgaSearchParams get_default_mga_search_params();
+
+/**
+ * @brief Searches for the flyby sequences with the lowest total delta-v from the departure body to the arrival body
+ *
+ * The sequences are explored as a tree (depth-first from each departure epoch and first leg) on the context's threads.
+ * Branches are pruned if a leg has no Lambert solution, if a flyby exceeds the excess speed mismatch or is below the minimum
+ * flyby altitude, or if the delta-v so far already exceeds the k-th best trajectory found (branch-and-bound).
+ * Only the best trajectory of each body sequence is kept.
+ *
+ * @param ctx The library context providing the threads (NULL for the default context)
+ * @param params The search parameters
+ * @param results Output array for at least params->max_results trajectories (sorted by total delta-v)
+ * @param stats Output parameter for search counters (can be NULL)
+ * @return Number of trajectories found (0 if none were found or the parameters are invalid)
+ */
+int search_mga_trajectories(OrbitlibContext *ctx, const MgaSearchParams *params, MgaTrajectory *results, MgaSearchStats *stats);
+
+/**
+ * @brief Prints the bodies, dates and delta-vs of an MGA trajectory
+ *
+ * @param trajectory The trajectory
+ */
+void print_mga_trajectory(const MgaTrajectory *trajectory);
+
+
+#endif //ORBITLIB_ORBITLIB_MGA_H
@@ -0,0 +1,85 @@
+#ifndef ORBITLIB_ORBITLIB_MOID_H
+#define ORBITLIB_ORBITLIB_MOID_H
+
+#include "orbitlib_orbit.h"
+#include "orbitlib_context.h"
+#include <stdint.h>
+
+
+/*
+ * ------------------------------------
+ * MOID Types
+ * ------------------------------------
+ */
+
+/**
+ * @brief Minimum orbit intersection distance (MOID) of two orbits and the points where it occurs
+ */
+typedef struct MoidResult {
+	double moid;	/**< Minimum distance between the two orbits [m] (NAN if it couldn't be determined) */
+	double ta0;		/**< True anomaly of the closest point on the first orbit [radians] */
+	double ta1;		/**< True anomaly of the closest point on the second orbit [radians] */
+} MoidResult;
+
+/**
+ * @brief Pair of orbits found by a MOID screening
+ */
+typedef struct MoidPair {
+	int idx0;			/**< Index of the orbit in the first list */
+	int idx1;			/**< Index of the orbit in the second list */
+	MoidResult moid;	/**< MOID of the pair */
+} MoidPair;
+
+/**
+ * @brief Counters of a MOID screening
+ */
+typedef struct MoidScreenStats {
+	int64_t num_pairs;			/**< Number of pairs of the two lists */
+	int64_t num_prefiltered;	/**< Number of pairs rejected by their apsides (or different central bodies) */
+	int64_t num_computed;		/**< Number of pairs whose MOID was computed */
+	int64_t num_found;			/**< Number of pairs within the threshold (can exceed the capacity of the output array) */
+} MoidScreenStats;
+
+
+/*
+ * ------------------------------------
+ * MOID
+ * ------------------------------------
+ */
+
+/**
+ * @brief Calculates the minimum orbit intersection distance (MOID) of two orbits around the same central body
+ *
+ * The distance of each point of one orbit to the other, elliptic orbit is found algebraically (roots of a quartic), and the
+ * minimum along the first orbit is refined by golden-section searches around the minima of a coarse scan. Two hyperbolic orbits
+ * (and degenerate cases of the algebraic solution) fall back to a grid over both orbits refined by Newton's method.
+ * Hyperbolas are only considered up to close to their asymptotes.
+ *
+ * @param orbit0 First orbit
+ * @param orbit1 Second orbit
+ * @return The MOID and the true anomalies of the closest points
+ */
+MoidResult calc_moid(Orbit orbit0, Orbit orbit1);
+
+/**
+ * @brief Finds all pairs of orbits of two lists whose MOID is within a threshold
+ *
+ * Pairs whose radial ranges (periapsis to apoapsis) are further apart than the threshold are rejected without computing
+ * their MOID. The remaining pairs are computed in parallel on the context's threads.
+ *
+ * @param ctx The library context providing the threads (NULL for the default context)
+ * @param orbits0 First list of orbits (e.g. planets or spacecraft)
+ * @param num_orbits0 Number of orbits in the first list
+ * @param orbits1 Second list of orbits (e.g. catalogued small bodies)
+ * @param num_orbits1 Number of orbits in the second list
+ * @param threshold Maximum MOID of returned pairs [m]
+ * @param pairs Output array for the pairs (sorted by MOID)
+ * @param max_pairs Capacity of the output array (the pairs with the smallest MOID are kept)
+ * @param stats Output parameter for screening counters (can be NULL)
+ * @return Number of pairs written to the output array
+ */
+int screen_moid(OrbitlibContext *ctx, const Orbit *orbits0, int num_orbits0, const Orbit *orbits1, int num_orbits1, double threshold,
+				MoidPair *pairs, int max_pairs, MoidScreenStats *stats);
+
+
+#endif //ORBITLIB_ORBITLIB_MOID_H
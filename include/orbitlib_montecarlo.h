@@ -0,0 +1,103 @@
+#ifndef ORBITLIB_ORBITLIB_MONTECARLO_H
+#define ORBITLIB_ORBITLIB_MONTECARLO_H
+
+#include "orbitlib_orbit.h"
+#include "orbitlib_context.h"
+#include <stdint.h>
+
+
+/*
+ * ------------------------------------
+ * Monte Carlo Types
+ * ------------------------------------
+ */
+
+/**
+ * @brief Dispersions of the initial state and of an impulsive manoeuvre (all errors normally distributed, 1-sigma values)
+ */
+typedef struct DispersionModel {
+	double pos_sigma;			/**< Position error per axis [m] */
+	double vel_sigma;			/**< Velocity error per axis [m/s] */
+	Vector3 dv;					/**< Nominal impulsive manoeuvre executed at the initial epoch [m/s] (zero vector for none) */
+	double dv_mag_sigma;		/**< Proportional magnitude error of the manoeuvre (fraction of |dv|) */
+	double dv_pointing_sigma;	/**< Pointing error of the manoeuvre per axis perpendicular to dv [radians] */
+} DispersionModel;
+
+/**
+ * @brief Parameters of a Monte Carlo dispersion analysis
+ */
+typedef struct MonteCarloParams {
+	int num_samples;			/**< Number of samples */
+	uint64_t seed;				/**< Seed of the random streams (same seed, same samples; independent of the number of threads) */
+	double epoch;				/**< Epoch of the nominal state (Julian date; only used for the target's position) */
+	double duration;			/**< Propagation horizon [s] */
+	struct Body *target;		/**< Body whose B-plane the arrival states are mapped into (orbiting the central body; NULL for none) */
+} MonteCarloParams;
+
+/**
+ * @brief Arrival of one sample
+ */
+typedef struct MonteCarloSample {
+	OSV osv;					/**< State at the end of the horizon (relative to the central body) */
+	double b_t;					/**< B-plane coordinate along T [m] (NAN if the approach to the target is not hyperbolic) */
+	double b_r;					/**< B-plane coordinate along R [m] (NAN if the approach to the target is not hyperbolic) */
+} MonteCarloSample;
+
+/**
+ * @brief Arrival statistics of a Monte Carlo dispersion analysis
+ *
+ * The B-plane frame is the one of the nominal approach: S along the incoming asymptote, T = S x z (normalized, z of the
+ * central body's frame), R = S x T.
+ */
+typedef struct MonteCarloStats {
+	int num_samples;			/**< Number of samples */
+	OSV nominal;				/**< Nominal state at the end of the horizon */
+	OSV mean;					/**< Mean state at the end of the horizon */
+	double cov[6][6];			/**< Sample covariance of the state at the end of the horizon (x, y, z, vx, vy, vz) */
+	int has_bplane;				/**< 1 if the nominal approach to the target is hyperbolic and the B-plane statistics are valid */
+	double nominal_b_t;			/**< Nominal B-plane coordinate along T [m] */
+	double nominal_b_r;			/**< Nominal B-plane coordinate along R [m] */
+	int num_bplane_samples;		/**< Number of samples with a hyperbolic approach (B-plane statistics are taken over these) */
+	double mean_b_t;			/**< Mean B-plane coordinate along T [m] */
+	double mean_b_r;			/**< Mean B-plane coordinate along R [m] */
+	double cov_b[2][2];			/**< Sample covariance of the B-plane coordinates (T, R) [m²] */
+	double ellipse_semi_major;	/**< Semi-major axis of the 1-sigma dispersion ellipse in the B-plane [m] */
+	double ellipse_semi_minor;	/**< Semi-minor axis of the 1-sigma dispersion ellipse in the B-plane [m] */
+	double ellipse_angle;		/**< Angle of the ellipse's major axis from T towards R [radians] */
+} MonteCarloStats;
+
+
+/*
+ * ------------------------------------
+ * Monte Carlo Dispersion Analysis
+ * ------------------------------------
+ */
+
+/**
+ * @brief Returns default Monte Carlo parameters (horizon still needs to be set)
+ *
+ * @return Parameters with 10000 samples, seed 0 and no target
+ */
+MonteCarloParams get_default_monte_carlo_params();
+
+/**
+ * @brief Samples dispersed initial states and manoeuvres, propagates them over the horizon (Keplerian) and gathers arrival statistics
+ *
+ * Each sample draws its errors from its own counter-based random stream (Philox4x32-10 keyed by the seed, counter = sample index),
+ * and statistics are accumulated in fixed blocks of samples merged in order, so results are identical for any number of threads.
+ * Samples are processed in parallel on the context's threads.
+ *
+ * @param ctx The library context providing the threads (NULL for the default context)
+ * @param nominal Nominal state at the epoch (before the manoeuvre)
+ * @param cb Central body of the propagation
+ * @param dispersions Dispersion model of the state and the manoeuvre
+ * @param params Sample count, seed, horizon and B-plane target
+ * @param samples Output array for the arrival of each sample (num_samples entries; can be NULL)
+ * @param stats Output parameter for the arrival statistics
+ * @return 1 on success, 0 on invalid parameters or if out of memory
+ */
+int run_monte_carlo(OrbitlibContext *ctx, OSV nominal, Body *cb, const DispersionModel *dispersions, const MonteCarloParams *params,
+					MonteCarloSample *samples, MonteCarloStats *stats);
+
+
+#endif //ORBITLIB_ORBITLIB_MONTECARLO_H
@@ -0,0 +1,97 @@
+#ifndef ORBITLIB_ORBITLIB_OPTIM_H
+#define ORBITLIB_ORBITLIB_OPTIM_H
+
+#include "orbitlib_transfer.h"
+#include "orbitlib_context.h"
+
+
+/*
+ * ------------------------------------
+ * Transfer Optimization Types
+ * ------------------------------------
+ */
+
+/**
+ * @brief Parameters of the minimum-delta-v optimization of the departure epoch and duration of a transfer between two bodies
+ * orbiting the same central body
+ */
+typedef struct TransferOptimParams {
+	Body *departure_body;				/**< Body the transfer departs from */
+	Body *arrival_body;					/**< Body the transfer arrives at */
+	enum Transfer_Type transfer_type;	/**< Departure and arrival maneuvers (flyby types: no arrival maneuver) */
+	double departure_altitude;			/**< Periapsis altitude of the departure hyperbola [m] */
+	double arrival_altitude;			/**< Periapsis altitude of the arrival hyperbola [m] */
+	double min_departure_epoch;			/**< Start of the departure window (Julian date) */
+	double max_departure_epoch;			/**< End of the departure window (Julian date) */
+	double min_duration;				/**< Minimum transfer duration [days] */
+	double max_duration;				/**< Maximum transfer duration [days] */
+	int num_departure_seeds;			/**< Number of coarse seeds along the departure window */
+	int num_duration_seeds;				/**< Number of coarse seeds along the duration range */
+	double epoch_tolerance;				/**< Convergence tolerance of the departure epoch and duration [s] */
+	double dv_tolerance;				/**< Convergence tolerance of the delta-v [m/s] */
+	int max_evaluations;				/**< Maximum number of delta-v evaluations per local optimization */
+} TransferOptimParams;
+
+/**
+ * @brief Locally optimal transfer
+ */
+typedef struct TransferOptimResult {
+	double departure_epoch;		/**< Departure epoch (Julian date) */
+	double duration;			/**< Transfer duration [days] */
+	double dv_departure;		/**< Delta-v of the departure maneuver [m/s] */
+	double dv_arrival;			/**< Delta-v of the arrival maneuver [m/s] */
+	double dv;					/**< Total delta-v [m/s] (INFINITY if no transfer was found) */
+	int num_evaluations;		/**< Number of delta-v evaluations (Lambert solutions) */
+	int converged;				/**< 1 if the tolerances were met, 0 if the evaluation limit was hit */
+} TransferOptimResult;
+
+
+/*
+ * ------------------------------------
+ * Transfer Optimization
+ * ------------------------------------
+ */
+
+/**
+ * @brief Returns default optimization parameters (bodies and departure window still need to be set)
+ *
+ * @return Parameters with a duration range of 30-1000 days, 12x6 seeds, tolerances of 60s and 0.1 m/s, at most 200 evaluations,
+ * circular departure and capture at arrival at 200km altitude
+ */
+TransferOptimParams get_default_transfer_optim_params();
+
+/**
+ * @brief Calculates the delta-v of a transfer departing at the given epoch with the given duration
+ *
+ * @param params The optimization parameters (bodies, transfer type and altitudes)
+ * @param departure_epoch Departure epoch (Julian date)
+ * @param duration Transfer duration [days]
+ * @return The transfer (dv = INFINITY if the Lambert solver failed)
+ */
+TransferOptimResult calc_transfer_dv(const TransferOptimParams *params, double departure_epoch, double duration);
+
+/**
+ * @brief Refines a departure epoch and duration to a local delta-v minimum (Nelder-Mead within the departure window and duration range)
+ *
+ * @param params The optimization parameters
+ * @param departure_epoch Departure epoch of the seed (Julian date)
+ * @param duration Transfer duration of the seed [days]
+ * @return The locally optimal transfer
+ */
+TransferOptimResult optimize_transfer(const TransferOptimParams *params, double departure_epoch, double duration);
+
+/**
+ * @brief Finds locally optimal transfers by refining the local minima of a coarse seed grid over the departure window and duration range
+ *
+ * The seeds are refined in parallel on the context's threads; minima converging to the same transfer are merged.
+ *
+ * @param ctx The library context providing the threads (NULL for the default context)
+ * @param params The optimization parameters
+ * @param results Output array for the transfers (sorted by total delta-v)
+ * @param max_results Maximum number of transfers
+ * @return Number of transfers found
+ */
+int search_optimal_transfers(OrbitlibContext *ctx, const TransferOptimParams *params, TransferOptimResult *results, int max_results);
+
+
+#endif //ORBITLIB_ORBITLIB_OPTIM_H
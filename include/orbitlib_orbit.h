@@ -32,6 +32,18 @@ typedef struct OSV {
 	Vector3 v; /**< Velocity vector [m/s] */
 } OSV;
 
+/**
+ * @brief Initial state of a Keplerian propagation with the invariants of its universal Kepler equation (see prepare_universal_orbit())
+ */
+typedef struct UniversalOrbit {
+	OSV osv;			/**< Initial orbital state vector */
+	double mu;			/**< Gravitational parameter of the central body [m³/s²] */
+	double sqrt_mu;		/**< Square root of the gravitational parameter */
+	double r0;			/**< Initial distance from the central body [m] */
+	double sigma0;		/**< Radial velocity term r0·v0 / sqrt(mu) of the initial state */
+	double alpha;		/**< Reciprocal semi-major axis 2/r0 - v0²/mu [1/m] */
+} UniversalOrbit;
+
 
 /*
  * ------------------------------------
@@ -211,6 +223,54 @@ Orbit propagate_orbit_time(Orbit orbit, double dt);
  */
 OSV propagate_osv_time(OSV osv, Body *cb, double dt);
 
+/**
+ * @brief Propagates an orbital state vector forward in time with universal variables and calculates the state transition matrix
+ *
+ * The state transition matrix holds the partial derivatives of the propagated state (r, v) with respect to the initial state (r0, v0)
+ * (analytic; Battin's formulation).
+ *
+ * @param osv Initial orbital state vector
+ * @param cb Central body of the orbit
+ * @param dt Time step to propagate [s]
+ * @param stm Output parameter for the 6x6 state transition matrix (row: propagated x, y, z, vx, vy, vz; column: initial state; can be NULL)
+ * @return Orbital state vector propagated by dt seconds
+ */
+OSV propagate_osv_time_stm(OSV osv, Body *cb, double dt, double stm[6][6]);
+
+/**
+ * @brief Prepares an orbital state vector for repeated propagations from it (see propagate_universal_orbit())
+ *
+ * @param osv Initial orbital state vector
+ * @param cb Central body of the orbit
+ * @return The initial state with the invariants of its universal Kepler equation
+ */
+UniversalOrbit prepare_universal_orbit(OSV osv, Body *cb);
+
+/**
+ * @brief Propagates a prepared initial state forward in time with universal variables (same result as propagate_osv_time_stm())
+ *
+ * @param orbit Prepared initial state
+ * @param dt Time step to propagate [s]
+ * @return Orbital state vector propagated by dt seconds
+ */
+OSV propagate_universal_orbit(const UniversalOrbit *orbit, double dt);
+
+/**
+ * @brief Propagates orbital state vectors and their covariances forward in time
+ *
+ * Linear covariance propagation P = STM * P0 * STM^T with the analytic state transition matrix of propagate_osv_time_stm()
+ * (one propagation per state instead of finite differences).
+ *
+ * @param osvs Initial orbital state vectors
+ * @param covs Covariances of the initial states (order x, y, z, vx, vy, vz; symmetric)
+ * @param num Number of states
+ * @param cb Central body of all orbits
+ * @param dt Time step to propagate [s]
+ * @param out_osvs Output array for the propagated states (can be osvs)
+ * @param out_covs Output array for the propagated covariances (can be covs)
+ */
+void propagate_osv_covariance_batch(const OSV *osvs, double (*covs)[6][6], int num, Body *cb, double dt, OSV *out_osvs, double (*out_covs)[6][6]);
+
 /**
  * @brief Propagates an orbital state vector by a change in true anomaly
  *
@@ -0,0 +1,139 @@
+#ifndef ORBITLIB_ORBITLIB_PROPAGATOR_H
+#define ORBITLIB_ORBITLIB_PROPAGATOR_H
+
+#include "orbitlib_orbit.h"
+
+// maximum number of perturbing bodies of a propagator (the most massive ones are kept)
+#define PROPAGATOR_MAX_THIRD_BODIES 16
+// states integrated in lockstep by the batch propagator
+#define PROPAGATOR_BATCH_LANES 8
+
+
+/*
+ * ------------------------------------
+ * Numerical Propagator Types
+ * ------------------------------------
+ */
+
+/**
+ * @brief Force model and step size control of the numerical propagator
+ */
+typedef struct PropagatorParams {
+	double rel_tol;				/**< Relative tolerance of the local error per step */
+	double abs_tol_pos;			/**< Absolute tolerance of the local position error per step [m] */
+	double abs_tol_vel;			/**< Absolute tolerance of the local velocity error per step [m/s] */
+	double max_step;			/**< Maximum step size [s] (0 for none) */
+	int use_j2;					/**< 1 to include the oblateness (J2) of the central body (symmetric about its north_pole_ra/north_pole_decl axis) */
+	int use_third_bodies;		/**< 1 to include the bodies orbiting the central body and the central body's own central body as point masses */
+} PropagatorParams;
+
+/**
+ * @brief Perturbing body of a propagator (moved on its Keplerian orbit relative to its attractor)
+ */
+typedef struct PropagatorThirdBody {
+	struct Body *body;			/**< The perturbing body */
+	struct Body *attractor;		/**< Central body of the perturbing body's orbit */
+	double mu;					/**< Gravitational parameter of the perturbing body [m³/s²] */
+	OSV osv;					/**< State of the perturbing body relative to its attractor at t_ref */
+	double t_ref;				/**< Time of the reference state [s since the start epoch] */
+	int is_parent;				/**< 1 if the perturbing body is the attractor of the central body (position is the negated state) */
+} PropagatorThirdBody;
+
+/**
+ * @brief State of a numerical propagation (Dormand-Prince 5(4) with dense output); owned by the caller, steps don't allocate
+ */
+typedef struct Propagator {
+	struct Body *cb;			/**< Central body */
+	PropagatorParams params;	/**< Force model and tolerances */
+	double epoch;				/**< Start epoch (Julian date) */
+	double t;					/**< Current time [s since the start epoch] */
+	OSV osv;					/**< Current state relative to the central body */
+	double h;					/**< Size of the next step attempt [s] */
+	double k[7][6];				/**< Stages of the last step (k[0]: derivative at the current state) */
+	double dense_t0;			/**< Start time of the last accepted step [s since the start epoch] */
+	double dense_h;				/**< Size of the last accepted step [s] (0 before the first step) */
+	double dense[5][6];			/**< Coefficients of the continuous extension of the last accepted step */
+	Vector3 pole;				/**< North pole of the central body (axis of the J2 field) */
+	int num_third_bodies;		/**< Number of perturbing bodies */
+	PropagatorThirdBody third_bodies[PROPAGATOR_MAX_THIRD_BODIES];	/**< Perturbing bodies */
+	int num_steps;				/**< Number of accepted steps */
+	int num_rejected;			/**< Number of rejected steps */
+} Propagator;
+
+
+/*
+ * ------------------------------------
+ * Numerical Propagation
+ * ------------------------------------
+ */
+
+/**
+ * @brief Returns default propagator parameters
+ *
+ * @return Parameters with a relative tolerance of 1e-10, absolute tolerances of 1 mm and 1 µm/s, J2 and third bodies enabled
+ */
+PropagatorParams get_default_propagator_params();
+
+/**
+ * @brief Initializes a numerical propagation around a central body
+ *
+ * The perturbing bodies are the bodies orbiting the central body and the central body's own central body (if any); their
+ * states at the start epoch are taken from get_body_osv() and refreshed every step for systems propagated with ephemerides.
+ *
+ * @param prop The propagator to initialize
+ * @param osv Initial state relative to the central body
+ * @param epoch Epoch of the initial state (Julian date)
+ * @param cb Central body
+ * @param params Force model and tolerances
+ */
+void init_propagator(Propagator *prop, OSV osv, double epoch, Body *cb, const PropagatorParams *params);
+
+/**
+ * @brief Advances the propagation by one accepted adaptive step, without stepping past t_end
+ *
+ * @param prop The propagator
+ * @param t_end Time not to step past [s since the start epoch] (earlier than the current time to propagate backwards)
+ * @return 1 if a step was taken, 0 if t_end is reached or the step size became too small
+ */
+int step_propagator(Propagator *prop, double t_end);
+
+/**
+ * @brief Returns the state at a time within the last accepted step (4th order continuous extension; no force evaluations)
+ *
+ * @param prop The propagator
+ * @param t Time within the last step [s since the start epoch]
+ * @return Interpolated state relative to the central body
+ */
+OSV interpolate_propagator(const Propagator *prop, double t);
+
+/**
+ * @brief Propagates an orbital state vector numerically with the perturbations of the given parameters
+ *
+ * @param osv Initial state relative to the central body
+ * @param epoch Epoch of the initial state (Julian date)
+ * @param cb Central body
+ * @param dt Time to propagate [s] (negative to propagate backwards)
+ * @param params Force model and tolerances
+ * @return Propagated state (NAN components if the step size became too small)
+ */
+OSV propagate_osv_numerical(OSV osv, double epoch, Body *cb, double dt, const PropagatorParams *params);
+
+/**
+ * @brief Propagates many orbital state vectors numerically over the same time span
+ *
+ * The states are integrated in lockstep in groups of PROPAGATOR_BATCH_LANES (shared step sizes from the largest error of the
+ * group, structure of arrays, perturbing bodies evaluated once per stage for the whole group). Results match
+ * propagate_osv_numerical() within the tolerances.
+ *
+ * @param osvs Initial states relative to the central body
+ * @param num Number of states
+ * @param epoch Epoch of the initial states (Julian date)
+ * @param cb Central body
+ * @param dt Time to propagate [s] (negative to propagate backwards)
+ * @param params Force model and tolerances
+ * @param out Output array for the propagated states (can be osvs; NAN components if the step size became too small)
+ */
+void propagate_osv_numerical_batch(const OSV *osvs, int num, double epoch, Body *cb, double dt, const PropagatorParams *params, OSV *out);
+
+
+#endif //ORBITLIB_ORBITLIB_PROPAGATOR_H
@@ -0,0 +1,79 @@
+#ifndef ORBITLIB_ORBITLIB_STATS_H
+#define ORBITLIB_ORBITLIB_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ * @brief Iterative solvers with convergence statistics
+ */
+enum SolverId {
+	SOLVER_LAMBERT2,				/**< calc_lambert2() (also used by calc_lambert3()) */
+	SOLVER_PROPAGATE_ORBIT_TIME,	/**< propagate_orbit_time() */
+	SOLVER_KEPLER,					/**< calc_true_anomaly_from_mean_anomaly() */
+	SOLVER_LAMBERT_MULTIREV,		/**< Multi-revolution branches of calc_lambert2_multirev() (one call per branch) */
+	NUM_SOLVERS
+};
+
+#define SOLVER_STATS_NUM_BINS 12	/**< Histogram bins: bin 0 = no iterations, bin k = [2^(k-1), 2^k) iterations, last bin open-ended */
+#define SOLVER_STATS_NUM_RESULTS 5	/**< Number of LAMBERT_SOLVER_SUCCESS codes */
+
+/**
+ * @brief Convergence statistics of a solver (merged over all threads)
+ */
+typedef struct SolverStats {
+	uint64_t calls;										/**< Number of solver calls */
+	uint64_t iterations;								/**< Total number of iterations */
+	uint64_t max_iterations;							/**< Maximum number of iterations of a single call */
+	uint64_t cap_hits;									/**< Number of calls stopped by the iteration cap */
+	uint64_t histogram[SOLVER_STATS_NUM_BINS];			/**< Iteration histogram (see SOLVER_STATS_NUM_BINS) */
+	uint64_t results[SOLVER_STATS_NUM_RESULTS];			/**< Hit counts per LAMBERT_SOLVER_SUCCESS code (Lambert solver only) */
+	double time;										/**< Cumulative time spent in the solver [s] */
+} SolverStats;
+
+
+/*
+ * ------------------------------------
+ * Solver Statistics
+ * ------------------------------------
+ */
+
+/**
+ * @brief Checks whether the library was built with solver statistics (CMake option ORBITLIB_SOLVER_STATS)
+ *
+ * Without it, no statistics are recorded and all counters stay zero.
+ *
+ * @return 1 if statistics are recorded, 0 otherwise
+ */
+int are_solver_stats_enabled();
+
+/**
+ * @brief Returns the statistics of a solver merged over all threads (counters are thread-local and merged on read)
+ *
+ * @param solver The solver
+ * @return The merged statistics
+ */
+SolverStats get_solver_stats(enum SolverId solver);
+
+/**
+ * @brief Resets the statistics of all solvers and threads (calls running concurrently may be partially counted)
+ */
+void reset_solver_stats();
+
+/**
+ * @brief Returns the name of the solver (e.g. "lambert2")
+ *
+ * @param solver The solver
+ * @return Name of the solver
+ */
+const char * get_solver_name(enum SolverId solver);
+
+/**
+ * @brief Writes the statistics of all solvers as JSON object
+ *
+ * @param file The file to write to (e.g. stdout)
+ */
+void dump_solver_stats_json(FILE *file);
+
+
+#endif //ORBITLIB_ORBITLIB_STATS_H
@@ -0,0 +1,124 @@
+#ifndef ORBITLIB_ORBITLIB_TIMESCALE_H
+#define ORBITLIB_ORBITLIB_TIMESCALE_H
+
+
+/**
+ * @brief Time scale of a Julian Date (UTC: civil time with leap seconds; TAI: atomic time; TT: Terrestrial Time = TAI + 32.184s; TDB: Barycentric Dynamical Time, e.g. used by JPL's Horizons vectors)
+ */
+enum TimeScale {TIMESCALE_UTC, TIMESCALE_TAI, TIMESCALE_TT, TIMESCALE_TDB};
+
+/**
+ * @brief Represents an epoch as Julian Date tagged with its time scale
+ */
+typedef struct Epoch {
+	double jd;              /**< Julian Date */
+	enum TimeScale scale;   /**< Time scale the Julian Date is given in */
+} Epoch;
+
+/**
+ * @brief Entry of the leap second table: TAI-UTC offset valid from the given UTC Julian Date on
+ */
+typedef struct LeapSecond {
+	double jd_utc;      /**< Julian Date (UTC) from which the offset is valid */
+	double tai_utc;     /**< TAI-UTC [s] */
+} LeapSecond;
+
+
+/*
+ * ------------------------------------
+ * Leap Second Table
+ * ------------------------------------
+ */
+
+/**
+ * @brief Loads the leap second table from a local file in the IERS/IETF "leap-seconds.list" format (no network access)
+ *
+ * Each non-comment line holds the NTP timestamp (seconds since 1900-01-01) and the TAI-UTC offset valid from then on.
+ * Lines starting with '#' are ignored. The loaded table replaces the built-in table (not thread-safe with respect to concurrent conversions).
+ *
+ * @param filepath Path to the leap second file
+ * @return 1 if the table was loaded, 0 otherwise (previous table stays in use)
+ */
+int load_leap_second_table(const char *filepath);
+
+/**
+ * @brief Restores the built-in leap second table (leap seconds up to 2017-01-01)
+ */
+void reset_leap_second_table();
+
+/**
+ * @brief Returns the leap second table currently in use
+ *
+ * @param num_entries Output parameter for the number of entries in the table
+ * @return Pointer to the table entries (sorted by date)
+ */
+const LeapSecond * get_leap_second_table(int *num_entries);
+
+
+/*
+ * ------------------------------------
+ * Time Scale Offsets & Conversions
+ * ------------------------------------
+ */
+
+/**
+ * @brief Returns TAI-UTC at the given UTC epoch (dates before 1972 use the 1972 offset)
+ *
+ * @param jd_utc Julian Date (UTC)
+ * @return TAI-UTC [s]
+ */
+double get_tai_utc_offset(double jd_utc);
+
+/**
+ * @brief Returns TDB-TT at the given epoch using the analytic series of USNO Circular 179 (accuracy ~10µs between 1600 and 2200)
+ *
+ * @param jd_tt Julian Date (TT; TDB can be used as well as the difference is negligible)
+ * @return TDB-TT [s]
+ */
+double get_tdb_tt_offset(double jd_tt);
+
+/**
+ * @brief Converts a Julian Date from one time scale to another
+ *
+ * @param jd Julian Date given in time scale 'from'
+ * @param from Time scale of the given Julian Date
+ * @param to Time scale of the returned Julian Date
+ * @return Julian Date in time scale 'to'
+ */
+double convert_jd_time_scale(double jd, enum TimeScale from, enum TimeScale to);
+
+/**
+ * @brief Converts an epoch to another time scale
+ *
+ * @param epoch The epoch to be converted
+ * @param to Time scale of the returned epoch
+ * @return The epoch in the requested time scale
+ */
+Epoch convert_epoch_time_scale(Epoch epoch, enum TimeScale to);
+
+
+/*
+ * ------------------------------------
+ * Time Scale Names
+ * ------------------------------------
+ */
+
+/**
+ * @brief Returns the name of the time scale ("UTC", "TAI", "TT" or "TDB")
+ *
+ * @param scale The time scale
+ * @return Name of the time scale
+ */
+const char * time_scale_to_string(enum TimeScale scale);
+
+/**
+ * @brief Parses the name of a time scale ("UTC", "TAI", "TT" or "TDB")
+ *
+ * @param s The string to be parsed
+ * @param scale Output parameter for the parsed time scale (unchanged if parsing fails)
+ * @return 1 if the name is valid, 0 otherwise
+ */
+int time_scale_from_string(const char *s, enum TimeScale *scale);
+
+
+#endif //ORBITLIB_ORBITLIB_TIMESCALE_H
@@ -0,0 +1,46 @@
+#ifndef ORBITLIB_ORBITLIB_TRACE_H
+#define ORBITLIB_ORBITLIB_TRACE_H
+
+
+/*
+ * ------------------------------------
+ * Tracing
+ * ------------------------------------
+ */
+
+/**
+ * @brief Checks whether the library was built with tracing instrumentation (CMake option ORBITLIB_TRACING)
+ *
+ * Without it, the instrumentation compiles to nothing and no spans are recorded.
+ *
+ * @return 1 if tracing is compiled in, 0 otherwise
+ */
+int is_tracing_available();
+
+/**
+ * @brief Starts recording spans of the library's major entry points (system/ephemeris loading, downloads, Lambert solver, ...)
+ *
+ * Spans are recorded to per-thread buffers until stop_tracing() is called.
+ */
+void start_tracing();
+
+/**
+ * @brief Stops recording spans (recorded spans are kept until clear_trace())
+ */
+void stop_tracing();
+
+/**
+ * @brief Discards all recorded spans (must not be called while traced library calls are running on other threads)
+ */
+void clear_trace();
+
+/**
+ * @brief Exports all recorded spans in the Chrome trace event format (JSON; viewable in chrome://tracing or Perfetto)
+ *
+ * @param filepath Path of the JSON file to be written
+ * @return 1 if the file was written, 0 otherwise (including builds without tracing)
+ */
+int export_trace_json(const char *filepath);
+
+
+#endif //ORBITLIB_ORBITLIB_TRACE_H
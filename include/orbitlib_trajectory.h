@@ -0,0 +1,153 @@
+#ifndef ORBITLIB_ORBITLIB_TRAJECTORY_H
+#define ORBITLIB_ORBITLIB_TRAJECTORY_H
+
+#include "orbitlib_orbit.h"
+#include "orbitlib_celestial.h"
+#include <stddef.h>
+
+
+/*
+ * ------------------------------------
+ * Trajectory Types
+ * ------------------------------------
+ */
+
+/**
+ * @brief Coast arc of a trajectory, optionally starting with an impulsive manoeuvre
+ */
+typedef struct TrajectorySegment {
+	double start_epoch;		/**< Start of the coast (Julian date) */
+	double end_epoch;		/**< End of the coast (Julian date) */
+	struct Body *cb;		/**< Central body of the coast */
+	OSV osv;				/**< State at the start epoch relative to the central body (after the impulse) */
+	Vector3 dv;				/**< Impulse at the start epoch [m/s] (zero vector for none) */
+	Orbit orbit;			/**< Orbit at the start epoch */
+	UniversalOrbit universal_orbit;	/**< Start state prepared for the propagation to epochs within the segment */
+} TrajectorySegment;
+
+/**
+ * @brief Piecewise conic trajectory (coasts ordered by time, not overlapping)
+ */
+typedef struct Trajectory {
+	TrajectorySegment *segments;	/**< Segments ordered by start epoch */
+	int num_segments;				/**< Number of segments */
+	int max_segments;				/**< Capacity of the segment array */
+} Trajectory;
+
+
+/*
+ * ------------------------------------
+ * Trajectory Construction
+ * ------------------------------------
+ */
+
+/**
+ * @brief Allocates an empty trajectory
+ *
+ * @return Pointer to the new trajectory (NULL if out of memory)
+ */
+Trajectory * new_trajectory();
+
+/**
+ * @brief Frees a trajectory and its segments
+ *
+ * @param trajectory The trajectory to free (can be NULL)
+ */
+void free_trajectory(Trajectory *trajectory);
+
+/**
+ * @brief Appends a coast arc to the trajectory
+ *
+ * @param trajectory The trajectory
+ * @param osv State at the start epoch relative to the central body
+ * @param start_epoch Start of the coast (Julian date; not before the end of the last segment)
+ * @param end_epoch End of the coast (Julian date)
+ * @param cb Central body of the coast
+ * @return Index of the new segment (-1 if the epochs are out of order or out of memory)
+ */
+int add_trajectory_coast(Trajectory *trajectory, OSV osv, double start_epoch, double end_epoch, Body *cb);
+
+/**
+ * @brief Appends an impulsive manoeuvre at the end of the last segment followed by a coast around the same central body
+ *
+ * @param trajectory The trajectory (with at least one segment)
+ * @param dv Velocity change [m/s]
+ * @param end_epoch End of the following coast (Julian date)
+ * @return Index of the new segment (-1 if there is no segment, the epoch is out of order or out of memory)
+ */
+int add_trajectory_impulse(Trajectory *trajectory, Vector3 dv, double end_epoch);
+
+
+/*
+ * ------------------------------------
+ * Trajectory Evaluation
+ * ------------------------------------
+ */
+
+/**
+ * @brief Finds the segment covering an epoch (binary search; the later segment at shared boundaries)
+ *
+ * @param trajectory The trajectory
+ * @param epoch Epoch (Julian date)
+ * @return Index of the segment (-1 if the epoch is not covered)
+ */
+int find_trajectory_segment(const Trajectory *trajectory, double epoch);
+
+/**
+ * @brief Returns the state of the trajectory at an epoch
+ *
+ * Propagates the segment's prepared start state (invariants of the universal Kepler equation computed once per segment) with
+ * universal variables (no element conversion).
+ *
+ * @param trajectory The trajectory
+ * @param epoch Epoch (Julian date)
+ * @param cb Output parameter for the central body at the epoch (can be NULL; NULL if the epoch is not covered)
+ * @return State relative to the central body (NAN components if the epoch is not covered)
+ */
+OSV get_trajectory_osv(const Trajectory *trajectory, double epoch, Body **cb);
+
+/**
+ * @brief Samples a segment as a polyline whose deviation from the conic stays within a tolerance
+ *
+ * Intervals are bisected until the conic's point at the interval's mid-time is within the tolerance of the chord and the chord
+ * spans at most 15° around the central body, so sharply curved parts (periapsis passes) get more points than straight ones.
+ *
+ * @param trajectory The trajectory
+ * @param segment Index of the segment
+ * @param tolerance Maximum distance of the conic from the polyline [m]
+ * @param points Output array for the positions relative to the segment's central body (can be NULL to query the count)
+ * @param epochs Output array for the epochs of the points (can be NULL)
+ * @param max_points Capacity of the output arrays
+ * @return Number of points of the polyline (can exceed max_points, then only the first max_points are written)
+ */
+int sample_trajectory_segment(const Trajectory *trajectory, int segment, double tolerance, Vector3 *points, double *epochs, int max_points);
+
+
+/*
+ * ------------------------------------
+ * Serialization
+ * ------------------------------------
+ */
+
+/**
+ * @brief Serializes a trajectory to a compact binary form (fixed-width records; central bodies referenced by ID)
+ *
+ * @param trajectory The trajectory
+ * @param buffer Output buffer (can be NULL to query the size)
+ * @param buffer_size Size of the output buffer [bytes]
+ * @return Size of the serialized trajectory [bytes] (nothing is written if it exceeds buffer_size)
+ */
+size_t serialize_trajectory(const Trajectory *trajectory, void *buffer, size_t buffer_size);
+
+/**
+ * @brief Restores a trajectory serialized by serialize_trajectory()
+ *
+ * @param buffer The serialized trajectory
+ * @param size Size of the serialized trajectory [bytes]
+ * @param system Celestial system holding the central bodies (searched including subsystems by body ID)
+ * @return Pointer to the new trajectory (NULL if the data is invalid, a body is not found or out of memory)
+ */
+Trajectory * deserialize_trajectory(const void *buffer, size_t size, CelestSystem *system);
+
+
+#endif //ORBITLIB_ORBITLIB_TRAJECTORY_H
@@ -43,6 +43,18 @@ enum LAMBERT_SOLVER_SUCCESS {
 	LAMBERT_FAIL_ECC         /**< Invalid eccentricity */
 };
 
+/**
+ * @brief Branch of a multi-revolution Lambert solution
+ *
+ * For N > 0 revolutions, the transfer time has a minimum over the elliptic transfer orbits; longer transfer times are
+ * reached on both sides of it.
+ */
+enum LambertBranch {
+	LAMBERT_BRANCH_SINGLE,   /**< Zero-revolution solution (unique) */
+	LAMBERT_BRANCH_LEFT,     /**< Departure true anomaly below the one of the minimum-time transfer */
+	LAMBERT_BRANCH_RIGHT     /**< Departure true anomaly above the one of the minimum-time transfer */
+};
+
 /**
  * @brief Lambert solution for 2D orbits including true anomalies and success status
  */
@@ -51,6 +63,8 @@ typedef struct Lambert2 {
 	double true_anomaly0;                /**< Initial true anomaly [radians] */
 	double true_anomaly1;                /**< Final true anomaly [radians] */
 	enum LAMBERT_SOLVER_SUCCESS success; /**< Status of Lambert solver */
+	int num_revs;                        /**< Number of complete revolutions before arrival */
+	enum LambertBranch branch;           /**< Branch of multi-revolution solutions */
 } Lambert2;
 
 /**
@@ -60,8 +74,26 @@ typedef struct Lambert3 {
 	Vector3 r0, v0;                     /**< Initial position and velocity vectors */
 	Vector3 r1, v1;                     /**< Final position and velocity vectors */
 	enum LAMBERT_SOLVER_SUCCESS success; /**< Status of Lambert solver */
+	int num_revs;                       /**< Number of complete revolutions before arrival */
+	enum LambertBranch branch;          /**< Branch of multi-revolution solutions */
 } Lambert3;
 
+/** Maximum number of Lambert solutions with up to max_revs complete revolutions (zero-revolution solution plus two branches per revolution) */
+#define LAMBERT_MAX_SOLUTIONS(max_revs) (1 + 2*(max_revs))
+
+/**
+ * @brief Partial derivatives of the terminal velocities of a Lambert solution with respect to its boundary conditions
+ * (matrices: row = velocity component, column = position component)
+ */
+typedef struct LambertPartials {
+	double dv0_dr0[3][3];	/**< Partials of the initial velocity with respect to the initial position [1/s] */
+	double dv0_dr1[3][3];	/**< Partials of the initial velocity with respect to the final position [1/s] */
+	double dv0_dtof[3];		/**< Partials of the initial velocity with respect to the time of flight [m/s²] */
+	double dv1_dr0[3][3];	/**< Partials of the final velocity with respect to the initial position [1/s] */
+	double dv1_dr1[3][3];	/**< Partials of the final velocity with respect to the final position [1/s] */
+	double dv1_dtof[3];		/**< Partials of the final velocity with respect to the time of flight [m/s²] */
+} LambertPartials;
+
 /**
  * @brief Enumeration of hyperbolic transfer orbit types
  */
@@ -91,6 +123,25 @@ typedef struct HyperbolaParams {
 	struct HyperbolaLegParams outgoing; /**< Outgoing leg parameters (ignored if type == HYP_ARRIVAL) */
 } HyperbolaParams;
 
+/**
+ * @brief Output arrays of one hyperbola leg for batched evaluation (structure of arrays; NULL arrays are not computed)
+ */
+typedef struct HyperbolaLegArrays {
+	double *decl;         /**< Declination angles [radians] */
+	double *bplane_angle; /**< B-plane angles [radians] */
+	double *bvazi;        /**< B-vector azimuths [radians] */
+} HyperbolaLegArrays;
+
+/**
+ * @brief Output arrays of batched hyperbola evaluation (structure of arrays; NULL arrays are not computed)
+ */
+typedef struct HyperbolaParamsArrays {
+	double *rp;                  /**< Periapsis radii [m] */
+	double *c3_energy;           /**< Characteristic energies (C3) [m²/s²] */
+	HyperbolaLegArrays incoming; /**< Incoming leg parameters (ignored if type == HYP_DEPARTURE) */
+	HyperbolaLegArrays outgoing; /**< Outgoing leg parameters (ignored if type == HYP_ARRIVAL) */
+} HyperbolaParamsArrays;
+
 
 /*
  * ------------------------------------
@@ -129,6 +180,28 @@ double dv_circ(struct Body *body, double rp, double vinf);
  */
 double dv_capture(struct Body *body, double rp, double vinf);
 
+/**
+ * @brief Calculates delta-v of the departure maneuver of a transfer type (from a circular or capture orbit)
+ *
+ * @param body Pointer to the departure body
+ * @param rp Radius of periapsis of the departure hyperbola [m]
+ * @param vinf Hyperbolic excess speed [m/s]
+ * @param type Transfer type
+ * @return Delta-v of the departure maneuver [m/s]
+ */
+double dv_departure(struct Body *body, double rp, double vinf, enum Transfer_Type type);
+
+/**
+ * @brief Calculates delta-v of the arrival maneuver of a transfer type (into a circular or capture orbit; 0 for flybys)
+ *
+ * @param body Pointer to the arrival body
+ * @param rp Radius of periapsis of the arrival hyperbola [m]
+ * @param vinf Hyperbolic excess speed [m/s]
+ * @param type Transfer type
+ * @return Delta-v of the arrival maneuver [m/s]
+ */
+double dv_arrival(struct Body *body, double rp, double vinf, enum Transfer_Type type);
+
 
 /*
  * ------------------------------------
@@ -169,6 +242,97 @@ Lambert2 calc_lambert2(double r0, double r1, double delta_ta, double target_dt,
  */
 Lambert3 calc_lambert3(Vector3 r0, Vector3 r1, double target_dt, Body *cb);
 
+/**
+ * @brief Computes all 2D Lambert solutions with up to max_revs complete revolutions
+ *
+ * The zero-revolution solution is the one of calc_lambert2(). For each number of revolutions, the elliptic transfer orbits
+ * are searched for the minimum transfer time once; if it is below the target time, both branches are solved. The search
+ * stops at the first number of revolutions that can not reach the target time (minimum transfer time grows with revolutions).
+ *
+ * @param r0 Initial radius [m]
+ * @param r1 Final radius [m]
+ * @param delta_ta Change in true anomaly [radians]
+ * @param target_dt Desired transfer time [s]
+ * @param cb Pointer to the central body
+ * @param max_revs Maximum number of complete revolutions
+ * @param solutions Output array for the converged solutions (ordered by revolutions, left before right branch)
+ * @param max_solutions Capacity of the output array (LAMBERT_MAX_SOLUTIONS(max_revs) for all solutions)
+ * @return Number of solutions written to the output array
+ */
+int calc_lambert2_multirev(double r0, double r1, double delta_ta, double target_dt, Body *cb, int max_revs, Lambert2 *solutions, int max_solutions);
+
+/**
+ * @brief Computes all 3D Lambert solutions with up to max_revs complete revolutions (see calc_lambert2_multirev())
+ *
+ * The orientation of the transfer plane is set up once and shared by all solutions.
+ *
+ * @param r0 Initial position vector [m]
+ * @param r1 Final position vector [m]
+ * @param target_dt Desired transfer time [s]
+ * @param cb Pointer to the central body
+ * @param max_revs Maximum number of complete revolutions
+ * @param solutions Output array for the converged solutions (ordered by revolutions, left before right branch)
+ * @param max_solutions Capacity of the output array (LAMBERT_MAX_SOLUTIONS(max_revs) for all solutions)
+ * @return Number of solutions written to the output array
+ */
+int calc_lambert3_multirev(Vector3 r0, Vector3 r1, double target_dt, Body *cb, int max_revs, Lambert3 *solutions, int max_solutions);
+
+/**
+ * @brief Computes 3D Lambert solutions between two fixed positions for many transfer times (e.g. the transfer time axis of a porkchop plot)
+ *
+ * The transfer geometry (radii, transfer angle, transfer plane orientation and the bracket of departure true anomalies)
+ * is set up once. Each transfer time is solved by continuation from the previous solutions, which is most effective
+ * for monotonically ordered transfer times with small steps.
+ *
+ * @param r0 Initial position vector [m]
+ * @param r1 Final position vector [m]
+ * @param target_dts Array of desired transfer times [s]
+ * @param num_dts Number of transfer times
+ * @param cb Pointer to the central body
+ * @param solutions Output array for one solution per transfer time (same as calc_lambert3(), check the solver status)
+ * @return Number of transfer times solved successfully
+ */
+int calc_lambert3_tof_sweep(Vector3 r0, Vector3 r1, const double *target_dts, int num_dts, Body *cb, Lambert3 *solutions);
+
+/**
+ * @brief Computes a 3D Lambert solution and the analytic partial derivatives of its terminal velocities with respect to
+ * the positions and the time of flight (from the state transition matrix of the transfer orbit)
+ *
+ * Partials with respect to departure and arrival epochs follow with the chain rule (position derivative = body velocity).
+ * Transfers of 180° have no unique transfer plane; their partials are NaN.
+ *
+ * @param r0 Initial position vector [m]
+ * @param r1 Final position vector [m]
+ * @param target_dt Desired transfer time [s]
+ * @param cb Pointer to the central body
+ * @param partials Output parameter for the partial derivatives (only set if the solver succeeded)
+ * @return Lambert3 struct containing position, velocity vectors and solver status
+ */
+Lambert3 calc_lambert3_partials(Vector3 r0, Vector3 r1, double target_dt, Body *cb, LambertPartials *partials);
+
+/**
+ * @brief Approximates the partial derivatives of a Lambert solution with central finite differences (validation of calc_lambert3_partials())
+ *
+ * Needs 14 additional Lambert solutions; the accuracy is limited by the convergence tolerance of the Lambert solver.
+ *
+ * @param r0 Initial position vector [m]
+ * @param r1 Final position vector [m]
+ * @param target_dt Desired transfer time [s]
+ * @param cb Pointer to the central body
+ * @param partials Output parameter for the partial derivatives
+ * @return 1 if all Lambert solutions succeeded, 0 otherwise
+ */
+int calc_lambert3_partials_fd(Vector3 r0, Vector3 r1, double target_dt, Body *cb, LambertPartials *partials);
+
+/**
+ * @brief Returns the largest deviation between two sets of Lambert partials, relative to the magnitude of the respective block
+ *
+ * @param partials Partials to be checked
+ * @param reference Reference partials
+ * @return Largest relative deviation
+ */
+double compare_lambert_partials(const LambertPartials *partials, const LambertPartials *reference);
+
 
 /*
  * ------------------------------------
@@ -215,6 +379,24 @@ double get_flyby_inclination(Vector3 v_arr, Vector3 v_dep, Vector3 v_body, Plane
  */
 HyperbolaParams get_hyperbola_params(Vector3 v_arr, Vector3 v_dep, Vector3 v_body, struct Body *body, double rp, enum HyperbolaType type);
 
+/**
+ * @brief Calculates the parameters of many hyperbolic orbits of the same type around the same body (e.g. the cells of a porkchop plot);
+ * same results as get_hyperbola_params() for each input
+ *
+ * Inputs are processed in blocks converted to structure of arrays; angles use atan2 closed forms instead of plane constructions.
+ *
+ * @param v_arr Velocity vectors at arrival [m/s] (ignored if type == HYP_DEPARTURE, can be NULL then)
+ * @param v_dep Velocity vectors at departure [m/s] (ignored if type == HYP_ARRIVAL, can be NULL then)
+ * @param v_body Velocity vectors of the central body [m/s]
+ * @param num Number of inputs (length of all input and output arrays)
+ * @param body Pointer to the central body
+ * @param rp Radius of periapsis of the hyperbolic orbits (same as for get_hyperbola_params())
+ * @param type Type of hyperbolic orbit (departure, arrival, or flyby)
+ * @param out Output arrays (NULL arrays are skipped)
+ */
+void get_hyperbola_params_batch(const Vector3 *v_arr, const Vector3 *v_dep, const Vector3 *v_body, int num, struct Body *body, double rp,
+								enum HyperbolaType type, HyperbolaParamsArrays *out);
+
 /**
  * @brief Determines if a flyby is viable by comparing the difference in excess speed between incoming and outgoing velocity vectors,
  * and the radius of periapsis (not being inside body or body's atmosphere)
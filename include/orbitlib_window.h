@@ -0,0 +1,78 @@
+#ifndef ORBITLIB_ORBITLIB_WINDOW_H
+#define ORBITLIB_ORBITLIB_WINDOW_H
+
+#include "orbitlib_transfer.h"
+
+
+/*
+ * ------------------------------------
+ * Launch Window Types
+ * ------------------------------------
+ */
+
+/**
+ * @brief Hohmann-like launch window between two bodies orbiting the same central body
+ */
+typedef struct LaunchWindow {
+	double departure_epoch;		/**< Departure epoch at which the phase angle is met (Julian date) */
+	double arrival_epoch;		/**< Arrival epoch after the Hohmann transfer (Julian date) */
+	double phase_angle;			/**< Phase angle of the arrival body ahead of the departure body at departure [radians] */
+	Hohmann transfer;			/**< Hohmann transfer between the departure radius and the arrival body's radius at arrival */
+} LaunchWindow;
+
+
+/*
+ * ------------------------------------
+ * Launch Windows
+ * ------------------------------------
+ */
+
+/**
+ * @brief Calculates the synodic period of two bodies orbiting the same central body (period of their relative geometry)
+ *
+ * @param body0 First body
+ * @param body1 Second body
+ * @return Synodic period [s] (INFINITY for equal orbital periods)
+ */
+double calc_synodic_period(Body *body0, Body *body1);
+
+/**
+ * @brief Calculates the phase angle required for a Hohmann transfer between the semi-major axes of the bodies' orbits
+ *
+ * @param departure_body Body the transfer departs from
+ * @param arrival_body Body the transfer arrives at
+ * @return Angle of the arrival body ahead of the departure body at departure (in the direction of motion) [radians, -pi to pi]
+ */
+double calc_hohmann_phase_angle(Body *departure_body, Body *arrival_body);
+
+/**
+ * @brief Calculates the phase angle between two bodies at an epoch (from ephemerides or orbital elements, see get_body_osv())
+ *
+ * @param departure_body Body the angle is measured from (its orbital plane and direction of motion define the sign)
+ * @param arrival_body Body the angle is measured to
+ * @param epoch Epoch (Julian date)
+ * @return Angle of the arrival body ahead of the departure body [radians, -pi to pi]
+ */
+double calc_phase_angle(Body *departure_body, Body *arrival_body, double epoch);
+
+/**
+ * @brief Finds all Hohmann-like launch windows between two bodies within a time span
+ *
+ * The windows are predicted from the synodic period and the phase angle at the start of the span, then each one is refined
+ * by a bracketed root find of the phase angle on the bodies' actual states. The cost grows with the number of windows,
+ * not with the length of the span. At most one window is returned per synodic period: if strongly eccentric orbits briefly
+ * reverse the relative motion, the additional crossings of the phase angle are not reported, and predictions whose refined
+ * phase angle does not meet the required one are dropped.
+ *
+ * @param departure_body Body the transfers depart from
+ * @param arrival_body Body the transfers arrive at (orbiting the same central body)
+ * @param min_epoch Start of the time span (Julian date)
+ * @param max_epoch End of the time span (Julian date)
+ * @param windows Output array for the windows (sorted by departure epoch)
+ * @param max_windows Capacity of the output array
+ * @return Number of windows found
+ */
+int find_launch_windows(Body *departure_body, Body *arrival_body, double min_epoch, double max_epoch, LaunchWindow *windows, int max_windows);
+
+
+#endif //ORBITLIB_ORBITLIB_WINDOW_H
@@ -0,0 +1,247 @@
+#include "orbitlib_alloc.h"
+#include "alloc_internal.h"
+#include "context_internal.h"
+#include "threading.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+
+static OrbitlibAllocator global_allocator = {NULL, NULL, NULL, NULL};
+
+
+/*
+ * ------------------------------------
+ * Allocator Hooks
+ * ------------------------------------
+ */
+
+void * allocator_malloc(const OrbitlibAllocator *allocator, size_t size) {
+	return allocator->malloc != NULL ? allocator->malloc(size, allocator->user_data) : malloc(size);
+}
+
+void * allocator_realloc(const OrbitlibAllocator *allocator, void *ptr, size_t size) {
+	return allocator->realloc != NULL ? allocator->realloc(ptr, size, allocator->user_data) : realloc(ptr, size);
+}
+
+void allocator_free(const OrbitlibAllocator *allocator, void *ptr) {
+	if(ptr == NULL) return;
+	if(allocator->free != NULL) allocator->free(ptr, allocator->user_data);
+	else free(ptr);
+}
+
+void set_orbitlib_allocator(const OrbitlibAllocator *allocator) {
+	if(allocator != NULL) global_allocator = *allocator;
+	else global_allocator = (OrbitlibAllocator) {NULL, NULL, NULL, NULL};
+}
+
+static const OrbitlibAllocator * get_current_allocator() {
+	OrbitlibContext *ctx = get_bound_orbitlib_context();
+	if(ctx != NULL && ctx->allocator.malloc != NULL) return &ctx->allocator;
+	return &global_allocator;
+}
+
+OrbitlibAllocator get_orbitlib_allocator() {
+	return *get_current_allocator();
+}
+
+void * orbitlib_malloc(size_t size) {
+	return allocator_malloc(get_current_allocator(), size);
+}
+
+void * orbitlib_calloc(size_t num, size_t size) {
+	if(size > 0 && num > SIZE_MAX / size) return NULL;
+	void *ptr = allocator_malloc(get_current_allocator(), num * size);
+	if(ptr != NULL) memset(ptr, 0, num * size);
+	return ptr;
+}
+
+void * orbitlib_realloc(void *ptr, size_t size) {
+	return allocator_realloc(get_current_allocator(), ptr, size);
+}
+
+void orbitlib_free(void *ptr) {
+	allocator_free(get_current_allocator(), ptr);
+}
+
+
+/*
+ * ------------------------------------
+ * Arena
+ * ------------------------------------
+ */
+
+#define ARENA_ALIGN (_Alignof(max_align_t) > sizeof(size_t) ? _Alignof(max_align_t) : sizeof(size_t))
+#define ARENA_ROUND_UP(size) (((size) + ARENA_ALIGN-1) & ~(ARENA_ALIGN-1))
+// every allocation is preceded by its size (needed for realloc)
+#define ARENA_ALLOC_HEADER_SIZE ARENA_ROUND_UP(sizeof(size_t))
+#define ARENA_DEFAULT_BLOCK_SIZE (1 << 20)
+
+typedef struct ArenaBlock {
+	struct ArenaBlock *next;
+	size_t size, used;
+} ArenaBlock;
+
+#define ARENA_BLOCK_HEADER_SIZE ARENA_ROUND_UP(sizeof(ArenaBlock))
+
+struct OrbitlibArena {
+	OrbitlibMutex mutex;
+	size_t block_size;
+	ArenaBlock *blocks;		// first block is the one allocations are bumped from; the oldest block is last
+	char *last_alloc;		// most recent allocation in the first block (can be grown or released in place; NULL if none)
+	size_t usage;
+};
+
+static char * get_block_data(ArenaBlock *block) {
+	return (char *) block + ARENA_BLOCK_HEADER_SIZE;
+}
+
+static size_t get_alloc_size(char *ptr) {
+	return *(size_t *) (ptr - ARENA_ALLOC_HEADER_SIZE);
+}
+
+static ArenaBlock * new_arena_block(size_t size) {
+	ArenaBlock *block = malloc(ARENA_BLOCK_HEADER_SIZE + size);
+	if(block == NULL) return NULL;
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+static void * arena_alloc_locked(OrbitlibArena *arena, size_t size) {
+	size_t needed = ARENA_ALLOC_HEADER_SIZE + ARENA_ROUND_UP(size);
+	ArenaBlock *block = arena->blocks;
+	
+	if(block == NULL || block->used + needed > block->size) {
+		if(needed > arena->block_size) {
+			// oversized allocation gets a block of its own behind the current block (current block stays usable)
+			ArenaBlock *large = new_arena_block(needed);
+			if(large == NULL) return NULL;
+			large->used = needed;
+			if(block != NULL) {
+				large->next = block->next;
+				block->next = large;
+			} else {
+				arena->blocks = large;
+			}
+			arena->usage += needed;
+			char *ptr = get_block_data(large) + ARENA_ALLOC_HEADER_SIZE;
+			*(size_t *) (ptr - ARENA_ALLOC_HEADER_SIZE) = size;
+			if(block == NULL) arena->last_alloc = NULL;
+			return ptr;
+		}
+		ArenaBlock *new_block = new_arena_block(arena->block_size);
+		if(new_block == NULL) return NULL;
+		new_block->next = block;
+		arena->blocks = block = new_block;
+	}
+	
+	char *ptr = get_block_data(block) + block->used + ARENA_ALLOC_HEADER_SIZE;
+	*(size_t *) (ptr - ARENA_ALLOC_HEADER_SIZE) = size;
+	block->used += needed;
+	arena->usage += needed;
+	arena->last_alloc = ptr;
+	return ptr;
+}
+
+static void * arena_malloc(size_t size, void *user_data) {
+	OrbitlibArena *arena = user_data;
+	orbitlib_mutex_lock(&arena->mutex);
+	void *ptr = arena_alloc_locked(arena, size);
+	orbitlib_mutex_unlock(&arena->mutex);
+	return ptr;
+}
+
+static void * arena_realloc(void *ptr, size_t size, void *user_data) {
+	if(ptr == NULL) return arena_malloc(size, user_data);
+	OrbitlibArena *arena = user_data;
+	orbitlib_mutex_lock(&arena->mutex);
+	size_t old_size = get_alloc_size(ptr);
+	
+	// most recent allocation -> resize in place if it fits into the block
+	if(ptr == arena->last_alloc) {
+		ArenaBlock *block = arena->blocks;
+		size_t offset = (char *) ptr - get_block_data(block);
+		size_t used = offset + ARENA_ROUND_UP(size);
+		if(used <= block->size) {
+			arena->usage = arena->usage - block->used + used;
+			block->used = used;
+			*(size_t *) ((char *) ptr - ARENA_ALLOC_HEADER_SIZE) = size;
+			orbitlib_mutex_unlock(&arena->mutex);
+			return ptr;
+		}
+	} else if(size <= old_size) {
+		orbitlib_mutex_unlock(&arena->mutex);
+		return ptr;
+	}
+	
+	void *new_ptr = arena_alloc_locked(arena, size);
+	if(new_ptr != NULL) memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+	orbitlib_mutex_unlock(&arena->mutex);
+	return new_ptr;
+}
+
+static void arena_free(void *ptr, void *user_data) {
+	OrbitlibArena *arena = user_data;
+	orbitlib_mutex_lock(&arena->mutex);
+	// only the most recent allocation can be released; everything else is released with the reset
+	if(ptr == arena->last_alloc) {
+		ArenaBlock *block = arena->blocks;
+		size_t used = (char *) ptr - ARENA_ALLOC_HEADER_SIZE - get_block_data(block);
+		arena->usage -= block->used - used;
+		block->used = used;
+		arena->last_alloc = NULL;
+	}
+	orbitlib_mutex_unlock(&arena->mutex);
+}
+
+OrbitlibArena * new_orbitlib_arena(size_t block_size) {
+	OrbitlibArena *arena = malloc(sizeof(OrbitlibArena));
+	if(arena == NULL) return NULL;
+	orbitlib_mutex_init(&arena->mutex);
+	arena->block_size = ARENA_ROUND_UP(block_size > 0 ? block_size : ARENA_DEFAULT_BLOCK_SIZE);
+	arena->blocks = NULL;
+	arena->last_alloc = NULL;
+	arena->usage = 0;
+	return arena;
+}
+
+void reset_orbitlib_arena(OrbitlibArena *arena) {
+	orbitlib_mutex_lock(&arena->mutex);
+	ArenaBlock *block = arena->blocks;
+	// keep the oldest block
+	while(block != NULL && block->next != NULL) {
+		ArenaBlock *next = block->next;
+		free(block);
+		block = next;
+	}
+	if(block != NULL) block->used = 0;
+	arena->blocks = block;
+	arena->last_alloc = NULL;
+	arena->usage = 0;
+	orbitlib_mutex_unlock(&arena->mutex);
+}
+
+void free_orbitlib_arena(OrbitlibArena *arena) {
+	if(arena == NULL) return;
+	ArenaBlock *block = arena->blocks;
+	while(block != NULL) {
+		ArenaBlock *next = block->next;
+		free(block);
+		block = next;
+	}
+	orbitlib_mutex_destroy(&arena->mutex);
+	free(arena);
+}
+
+size_t get_orbitlib_arena_usage(OrbitlibArena *arena) {
+	orbitlib_mutex_lock(&arena->mutex);
+	size_t usage = arena->usage;
+	orbitlib_mutex_unlock(&arena->mutex);
+	return usage;
+}
+
+OrbitlibAllocator get_orbitlib_arena_allocator(OrbitlibArena *arena) {
+	return (OrbitlibAllocator) {arena_malloc, arena_realloc, arena_free, arena};
+}
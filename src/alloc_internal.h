@@ -0,0 +1,19 @@
+#ifndef ORBITLIB_ALLOC_INTERNAL_H
+#define ORBITLIB_ALLOC_INTERNAL_H
+
+#include "orbitlib_alloc.h"
+
+// allocation with a specific allocator (e.g. the one a system was allocated with; all functions NULL -> C library)
+void * allocator_malloc(const OrbitlibAllocator *allocator, size_t size);
+void * allocator_realloc(const OrbitlibAllocator *allocator, void *ptr, size_t size);
+void allocator_free(const OrbitlibAllocator *allocator, void *ptr);
+
+struct Body;
+struct CelestSystem;
+
+// allocator owning a body's ephemerides (the one of the system the body belongs to; the current allocator for bodies outside of systems)
+OrbitlibAllocator get_body_allocator(const struct Body *body);
+// system whose memory (incl. its bodies array) is owned by the given allocator
+struct CelestSystem * new_system_with_allocator(const OrbitlibAllocator *allocator);
+
+#endif //ORBITLIB_ALLOC_INTERNAL_H
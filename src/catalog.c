@@ -0,0 +1,36 @@
+#include "orbitlib_catalog.h"
+#include "orbitlib_fileio.h"
+#include <string.h>
+
+
+#ifdef ORBITLIB_STATIC_CATALOGS
+// defined in the generated orbitlib_catalogs.c
+extern const int orbitlib_num_static_catalogs;
+extern const CelestSystem * const orbitlib_static_catalogs[];
+#else
+static const int orbitlib_num_static_catalogs = 0;
+static const CelestSystem * const orbitlib_static_catalogs[1] = {NULL};
+#endif
+
+
+int get_num_static_celestial_systems() {
+	return orbitlib_num_static_catalogs;
+}
+
+const CelestSystem * get_static_celestial_system(int index) {
+	if(index < 0 || index >= orbitlib_num_static_catalogs) return NULL;
+	return orbitlib_static_catalogs[index];
+}
+
+const CelestSystem * get_static_celestial_system_by_name(const char *name) {
+	for(int i = 0; i < orbitlib_num_static_catalogs; i++) {
+		if(strcmp(orbitlib_static_catalogs[i]->name, name) == 0) return orbitlib_static_catalogs[i];
+	}
+	return NULL;
+}
+
+CelestSystem * copy_static_celestial_system(const CelestSystem *system, int include_ephems) {
+	if(system == NULL) return NULL;
+	// the static storage is writable (only exposed as const), and cloning only reads from it
+	return clone_celestial_system((CelestSystem *) system, include_ephems);
+}
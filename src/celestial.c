@@ -4,10 +4,11 @@
 #include <stdio.h>
 #include <math.h>
 #include "orbitlib_fileio.h"
+#include "alloc_internal.h"
 
 
 struct Body * new_body() {
-	struct Body *new_body = (struct Body*) malloc(sizeof(struct Body));
+	struct Body *new_body = (struct Body*) orbitlib_malloc(sizeof(struct Body));
 	sprintf(new_body->name, "BODY");
 	new_body->color[0] = 0.5;
 	new_body->color[1] = 0.5;
@@ -22,6 +23,7 @@ struct Body * new_body() {
 	new_body->north_pole_decl = M_PI/2;
 	new_body->north_pole_ra = 0;
 	new_body->rot_ut0 = 0;
+	new_body->j2 = 0;
 	new_body->system = NULL;
 	new_body->ephem = NULL;
 	new_body->num_ephems = 0;
@@ -48,7 +50,13 @@ void set_body_color(struct Body *body, double red, double green, double blue) {
 }
 
 CelestSystem * new_system() {
-	CelestSystem *system = malloc(sizeof(CelestSystem));
+	OrbitlibAllocator allocator = get_orbitlib_allocator();
+	return new_system_with_allocator(&allocator);
+}
+
+CelestSystem * new_system_with_allocator(const OrbitlibAllocator *allocator) {
+	CelestSystem *system = allocator_malloc(allocator, sizeof(CelestSystem));
+	if(system == NULL) return NULL;
 	sprintf(system->name,"CELESTIAL SYSTEM");
 	system->num_bodies = 0;
 	system->cb = NULL;
@@ -56,9 +64,17 @@ CelestSystem * new_system() {
 	system->home_body = NULL;
 	system->prop_method = EPHEMS;
 	system->ut0 = 0;
+	system->time_scale = TIMESCALE_TDB;
+	system->mem_block = NULL;
+	system->allocator = *allocator;
 	return system;
 }
 
+OrbitlibAllocator get_body_allocator(const struct Body *body) {
+	if(body->orbit.cb != NULL && body->orbit.cb->system != NULL) return body->orbit.cb->system->allocator;
+	return get_orbitlib_allocator();
+}
+
 int get_number_of_subsystems(CelestSystem *system) {
 	int num_subsystems = 0;
 	for(int i = 0; i < system->num_bodies; i++) {
@@ -124,34 +140,50 @@ CelestSystem ** init_available_systems_from_path(const char *directory, int *num
 	*num_systems = 0;
 	char **paths = list_files_with_extension(directory, ".cfg", num_systems);
 	
-	CelestSystem **p_systems = (CelestSystem **) malloc(*num_systems * sizeof(struct System*));
+	CelestSystem **p_systems = (CelestSystem **) orbitlib_malloc(*num_systems * sizeof(struct System*));
 	
 	char path[50];
 	for(int i = 0; i < *num_systems; i++) {
 		sprintf(path, "%s/%s", directory, paths[i]);
 		p_systems[i] = load_celestial_system_from_cfg_file(path);
+		orbitlib_free(paths[i]);
 	}
 	
-	free(paths);
+	orbitlib_free(paths);
 	return p_systems;
 }
 
 void free_celestial_system(CelestSystem *system) {
 	if(system == NULL) return;
+	OrbitlibAllocator allocator = system->allocator;
+	if(system->mem_block != NULL) {
+		allocator_free(&allocator, system->mem_block);
+		return;
+	}
 	for(int i = 0; i < system->num_bodies; i++) {
 		if(system->bodies[i]->system != NULL) free_celestial_system(system->bodies[i]->system);
-		if(system->bodies[i]->ephem != NULL) free(system->bodies[i]->ephem);
-		free(system->bodies[i]);
+		allocator_free(&allocator, system->bodies[i]->ephem);
+		allocator_free(&allocator, system->bodies[i]);
 	}
-	if(system->cb->orbit.cb == NULL) free(system->cb);
-	free(system);
+	if(system->cb->orbit.cb == NULL) allocator_free(&allocator, system->cb);
+	allocator_free(&allocator, system->bodies);
+	allocator_free(&allocator, system);
 }
 
 void free_celestial_systems(CelestSystem **systems, int num_systems) {
 	for(int i = 0; i < num_systems; i++) {
 		free_celestial_system(systems[i]);
 	}
-	free(systems);
+	orbitlib_free(systems);
+}
+
+OSV get_body_osv(struct Body *body, double epoch) {
+	if(body->orbit.cb == NULL) return (OSV) {vec3(0,0,0), vec3(0,0,0)};
+	CelestSystem *system = body->orbit.cb->system;
+	if(system != NULL && system->prop_method == EPHEMS && body->ephem != NULL && body->num_ephems > 0) {
+		return osv_from_ephem(body->ephem, body->num_ephems, epoch, body->orbit.cb);
+	}
+	return osv_from_elements(body->orbit, epoch);
 }
 
 void print_celestial_system(CelestSystem *system) {
@@ -0,0 +1,424 @@
+#include "orbitlib_conjunction.h"
+#include "context_internal.h"
+#include "trace_internal.h"
+#include "rootfind_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// objects per propagation task
+#define CONJUNCTION_OBJECT_CHUNK 256
+// buckets of the spatial grid per candidate search task
+#define CONJUNCTION_BUCKET_CHUNK 1024
+// objects spanning more cells per axis are compared against all objects instead of being binned
+#define CONJUNCTION_MAX_CELL_SPAN 4
+// candidate pairs buffered by a task before they are added to the shared list
+#define CONJUNCTION_CANDIDATE_BUFFER 256
+// convergence tolerance of the epoch of the closest approach [s]
+#define CONJUNCTION_TIME_TOLERANCE 1e-3
+
+
+typedef struct ConjunctionBox {
+	Vector3 min, max;
+} ConjunctionBox;
+
+typedef struct ConjunctionCandidate {
+	int idx0, idx1;
+} ConjunctionCandidate;
+
+typedef struct ConjunctionSearch {
+	const OSV *osvs;
+	int num_objects;
+	double epoch;
+	Body *cb;
+	const ConjunctionParams *params;
+	double *min_radius;			// periapsis radius of each object
+	double *period;				// orbital period of each object (INFINITY for open orbits)
+
+	// current step
+	double t0, t1;
+	int is_first_step, is_last_step;
+	OSV *states0, *states1;		// states at the start and end of the step
+	ConjunctionBox *boxes;		// bounds of the motion during the step
+
+	// spatial grid (cells hashed into buckets; objects of a bucket are consecutive)
+	double cell_size;
+	uint32_t num_buckets;
+	uint32_t *bucket_start;
+	int *bucket_objects;
+	size_t max_bucket_objects;
+	int *large_objects;			// objects not binned (box spans too many cells)
+	int num_large_objects;
+
+	OrbitlibMutex mutex;
+	ConjunctionCandidate *candidates;
+	int num_candidates, max_candidates;
+	ConjunctionEvent *events;
+	int num_events, max_events;
+	int64_t total_candidates;
+	int out_of_memory;
+} ConjunctionSearch;
+
+
+ConjunctionParams get_default_conjunction_params() {
+	ConjunctionParams params = {
+			.min_epoch = 0,
+			.max_epoch = 0,
+			.time_step = 1,
+			.threshold = 1e6
+	};
+	return params;
+}
+
+static OSV get_conjunction_state(const ConjunctionSearch *search, int idx, double epoch) {
+	return propagate_osv_time_stm(search->osvs[idx], search->cb, (epoch - search->epoch) * 86400, NULL);
+}
+
+// appends to a growable array under the search's mutex (0 if out of memory)
+static int append_conjunction_items(ConjunctionSearch *search, void **array, int *num_items, int *max_items, const void *items, int num_new, size_t item_size) {
+	orbitlib_mutex_lock(&search->mutex);
+	if(*num_items + num_new > *max_items) {
+		int max = *max_items > 0 ? *max_items : 256;
+		while(max < *num_items + num_new) max *= 2;
+		void *grown = orbitlib_realloc(*array, max * item_size);
+		if(grown == NULL) {
+			search->out_of_memory = 1;
+			orbitlib_mutex_unlock(&search->mutex);
+			return 0;
+		}
+		*array = grown;
+		*max_items = max;
+	}
+	memcpy((char *) *array + *num_items * item_size, items, num_new * item_size);
+	*num_items += num_new;
+	orbitlib_mutex_unlock(&search->mutex);
+	return 1;
+}
+
+
+/*
+ * ------------------------------------
+ * Propagation and Bounds
+ * ------------------------------------
+ */
+
+static void propagate_conjunction_task(void *arg, int index) {
+	ConjunctionSearch *search = arg;
+	int end = (index + 1) * CONJUNCTION_OBJECT_CHUNK < search->num_objects ? (index + 1) * CONJUNCTION_OBJECT_CHUNK : search->num_objects;
+	double dt = (search->t1 - search->t0) * 86400;
+	for(int i = index * CONJUNCTION_OBJECT_CHUNK; i < end; i++) {
+		search->states1[i] = get_conjunction_state(search, i, search->t1);
+		if(search->is_first_step && search->t0 == search->t1) continue;
+
+		// the path deviates from the chord by at most max|acceleration| * dt²/8; closest to the central body at an end of the
+		// step, unless it passes the periapsis
+		OSV osv0 = search->states0[i], osv1 = search->states1[i];
+		double r_min;
+		if(dt >= search->period[i] / 2 || (dot_vec3(osv0.r, osv0.v) < 0 && dot_vec3(osv1.r, osv1.v) >= 0)) r_min = search->min_radius[i];
+		else r_min = fmin(mag_vec3(osv0.r), mag_vec3(osv1.r));
+		double pad = search->cb->mu / (r_min*r_min) * dt*dt / 8 + search->params->threshold / 2;
+
+		search->boxes[i].min = vec3(fmin(osv0.r.x, osv1.r.x) - pad, fmin(osv0.r.y, osv1.r.y) - pad, fmin(osv0.r.z, osv1.r.z) - pad);
+		search->boxes[i].max = vec3(fmax(osv0.r.x, osv1.r.x) + pad, fmax(osv0.r.y, osv1.r.y) + pad, fmax(osv0.r.z, osv1.r.z) + pad);
+	}
+}
+
+static int do_boxes_overlap(const ConjunctionBox *a, const ConjunctionBox *b) {
+	return a->min.x <= b->max.x && b->min.x <= a->max.x &&
+		   a->min.y <= b->max.y && b->min.y <= a->max.y &&
+		   a->min.z <= b->max.z && b->min.z <= a->max.z;
+}
+
+
+/*
+ * ------------------------------------
+ * Spatial Grid
+ * ------------------------------------
+ */
+
+static uint32_t get_cell_bucket(const ConjunctionSearch *search, int64_t ix, int64_t iy, int64_t iz) {
+	uint64_t hash = (uint64_t) ix * 73856093u ^ (uint64_t) iy * 19349663u ^ (uint64_t) iz * 83492791u;
+	return (uint32_t) (hash ^ (hash >> 32)) & (search->num_buckets - 1);
+}
+
+static int64_t get_cell_coord(const ConjunctionSearch *search, double x) {
+	return (int64_t) floor(x / search->cell_size);
+}
+
+// cells covered by a box (0 if it spans too many cells per axis)
+static int get_box_cells(const ConjunctionSearch *search, const ConjunctionBox *box, int64_t min_cell[3], int64_t max_cell[3]) {
+	double min[3] = {box->min.x, box->min.y, box->min.z}, max[3] = {box->max.x, box->max.y, box->max.z};
+	for(int k = 0; k < 3; k++) {
+		min_cell[k] = get_cell_coord(search, min[k]);
+		max_cell[k] = get_cell_coord(search, max[k]);
+		if(max_cell[k] - min_cell[k] >= CONJUNCTION_MAX_CELL_SPAN) return 0;
+	}
+	return 1;
+}
+
+// bins all boxes into the buckets of the spatial grid (counting sort by bucket)
+static int build_conjunction_grid(ConjunctionSearch *search) {
+	// cells about twice the average extent of the boxes -> most boxes cover up to 8 cells
+	double extent_sum = 0;
+	for(int i = 0; i < search->num_objects; i++) {
+		Vector3 size = subtract_vec3(search->boxes[i].max, search->boxes[i].min);
+		extent_sum += fmax(size.x, fmax(size.y, size.z));
+	}
+	search->cell_size = fmax(2 * extent_sum / search->num_objects, search->params->threshold);
+
+	memset(search->bucket_start, 0, (search->num_buckets + 1) * sizeof(uint32_t));
+	search->num_large_objects = 0;
+	size_t num_entries = 0;
+	int64_t min_cell[3], max_cell[3];
+	for(int i = 0; i < search->num_objects; i++) {
+		if(!get_box_cells(search, &search->boxes[i], min_cell, max_cell)) {
+			search->large_objects[search->num_large_objects++] = i;
+			continue;
+		}
+		for(int64_t ix = min_cell[0]; ix <= max_cell[0]; ix++)
+			for(int64_t iy = min_cell[1]; iy <= max_cell[1]; iy++)
+				for(int64_t iz = min_cell[2]; iz <= max_cell[2]; iz++) {
+					search->bucket_start[get_cell_bucket(search, ix, iy, iz) + 1]++;
+					num_entries++;
+				}
+	}
+	if(num_entries > search->max_bucket_objects) {
+		int *bucket_objects = orbitlib_realloc(search->bucket_objects, num_entries * sizeof(int));
+		if(bucket_objects == NULL) return 0;
+		search->bucket_objects = bucket_objects;
+		search->max_bucket_objects = num_entries;
+	}
+	for(uint32_t b = 0; b < search->num_buckets; b++) search->bucket_start[b+1] += search->bucket_start[b];
+
+	// fill (bucket_start is advanced while filling and restored afterwards)
+	for(int i = 0; i < search->num_objects; i++) {
+		if(!get_box_cells(search, &search->boxes[i], min_cell, max_cell)) continue;
+		for(int64_t ix = min_cell[0]; ix <= max_cell[0]; ix++)
+			for(int64_t iy = min_cell[1]; iy <= max_cell[1]; iy++)
+				for(int64_t iz = min_cell[2]; iz <= max_cell[2]; iz++) {
+					search->bucket_objects[search->bucket_start[get_cell_bucket(search, ix, iy, iz)]++] = i;
+				}
+	}
+	for(uint32_t b = search->num_buckets; b > 0; b--) search->bucket_start[b] = search->bucket_start[b-1];
+	search->bucket_start[0] = 0;
+	return 1;
+}
+
+static void add_conjunction_candidate(ConjunctionSearch *search, ConjunctionCandidate *buffer, int *num_buffered, int idx0, int idx1) {
+	buffer[(*num_buffered)++] = idx0 < idx1 ? (ConjunctionCandidate) {idx0, idx1} : (ConjunctionCandidate) {idx1, idx0};
+	if(*num_buffered == CONJUNCTION_CANDIDATE_BUFFER) {
+		append_conjunction_items(search, (void **) &search->candidates, &search->num_candidates, &search->max_candidates,
+								 buffer, *num_buffered, sizeof(ConjunctionCandidate));
+		*num_buffered = 0;
+	}
+}
+
+// tasks: chunks of buckets, followed by one task per large object
+static void find_conjunction_candidates_task(void *arg, int index) {
+	ConjunctionSearch *search = arg;
+	ConjunctionCandidate buffer[CONJUNCTION_CANDIDATE_BUFFER];
+	int num_buffered = 0;
+	int num_bucket_tasks = (int) ((search->num_buckets + CONJUNCTION_BUCKET_CHUNK - 1) / CONJUNCTION_BUCKET_CHUNK);
+
+	if(index < num_bucket_tasks) {
+		uint32_t end = (uint32_t) (index + 1) * CONJUNCTION_BUCKET_CHUNK < search->num_buckets ? (uint32_t) (index + 1) * CONJUNCTION_BUCKET_CHUNK : search->num_buckets;
+		for(uint32_t b = (uint32_t) index * CONJUNCTION_BUCKET_CHUNK; b < end; b++) {
+			for(uint32_t m = search->bucket_start[b]; m < search->bucket_start[b+1]; m++) {
+				int i = search->bucket_objects[m];
+				for(uint32_t n = m+1; n < search->bucket_start[b+1]; n++) {
+					int j = search->bucket_objects[n];
+					const ConjunctionBox *box_i = &search->boxes[i], *box_j = &search->boxes[j];
+					if(i == j || !do_boxes_overlap(box_i, box_j)) continue;
+					// pairs sharing several cells are only reported from the cell of the overlap's minimum corner
+					uint32_t bucket = get_cell_bucket(search, get_cell_coord(search, fmax(box_i->min.x, box_j->min.x)),
+													  get_cell_coord(search, fmax(box_i->min.y, box_j->min.y)),
+													  get_cell_coord(search, fmax(box_i->min.z, box_j->min.z)));
+					if(bucket == b) add_conjunction_candidate(search, buffer, &num_buffered, i, j);
+				}
+			}
+		}
+	} else {
+		int large_idx = index - num_bucket_tasks;
+		int i = search->large_objects[large_idx];
+		for(int j = 0; j < search->num_objects; j++) {
+			if(j == i || !do_boxes_overlap(&search->boxes[i], &search->boxes[j])) continue;
+			// pairs of large objects only once
+			int is_large = 0;
+			for(int k = 0; k < large_idx && !is_large; k++) is_large = search->large_objects[k] == j;
+			if(!is_large) add_conjunction_candidate(search, buffer, &num_buffered, i, j);
+		}
+	}
+	if(num_buffered > 0) {
+		append_conjunction_items(search, (void **) &search->candidates, &search->num_candidates, &search->max_candidates,
+								 buffer, num_buffered, sizeof(ConjunctionCandidate));
+	}
+}
+
+
+/*
+ * ------------------------------------
+ * Refinement
+ * ------------------------------------
+ */
+
+// relative radial velocity of the pair (root at the closest approach); rel: relative state
+static double calc_conjunction_range_rate(const ConjunctionSearch *search, ConjunctionCandidate pair, double epoch, OSV *rel) {
+	OSV osv0 = get_conjunction_state(search, pair.idx0, epoch), osv1 = get_conjunction_state(search, pair.idx1, epoch);
+	*rel = (OSV) {subtract_vec3(osv1.r, osv0.r), subtract_vec3(osv1.v, osv0.v)};
+	return dot_vec3(rel->r, rel->v);
+}
+
+typedef struct ConjunctionRangeRateRoot {
+	const ConjunctionSearch *search;
+	ConjunctionCandidate pair;
+	OSV rel;	// relative state at the last evaluation
+} ConjunctionRangeRateRoot;
+
+static double calc_conjunction_range_rate_root(double s, void *data) {
+	ConjunctionRangeRateRoot *root = data;
+	return calc_conjunction_range_rate(root->search, root->pair, root->search->t0 + s / 86400, &root->rel);
+}
+
+static void add_conjunction_event(ConjunctionSearch *search, ConjunctionCandidate pair, double epoch, OSV rel) {
+	double distance = mag_vec3(rel.r);
+	if(!(distance <= search->params->threshold)) return;
+	ConjunctionEvent event = {pair.idx0, pair.idx1, epoch, distance, mag_vec3(rel.v)};
+	append_conjunction_items(search, (void **) &search->events, &search->num_events, &search->max_events, &event, 1, sizeof(ConjunctionEvent));
+}
+
+static void refine_conjunction_task(void *arg, int index) {
+	ConjunctionSearch *search = arg;
+	ConjunctionCandidate pair = search->candidates[index];
+	OSV rel0 = {subtract_vec3(search->states0[pair.idx1].r, search->states0[pair.idx0].r), subtract_vec3(search->states0[pair.idx1].v, search->states0[pair.idx0].v)};
+	OSV rel1 = {subtract_vec3(search->states1[pair.idx1].r, search->states1[pair.idx0].r), subtract_vec3(search->states1[pair.idx1].v, search->states1[pair.idx0].v)};
+	double f0 = dot_vec3(rel0.r, rel0.v), f1 = dot_vec3(rel1.r, rel1.v);
+
+	// closest at the ends of the time span
+	if(search->is_first_step && f0 >= 0) add_conjunction_event(search, pair, search->t0, rel0);
+	if(search->is_last_step && f1 < 0) add_conjunction_event(search, pair, search->t1, rel1);
+	if(!(f0 < 0 && f1 >= 0)) return;
+
+	// root of the range rate [s since the start of the step]
+	ConjunctionRangeRateRoot root = {search, pair, rel0};
+	double s = find_bracketed_root(calc_conjunction_range_rate_root, &root, 0, f0, (search->t1 - search->t0) * 86400, f1, CONJUNCTION_TIME_TOLERANCE, NULL);
+	add_conjunction_event(search, pair, search->t0 + s / 86400, root.rel);
+}
+
+
+/*
+ * ------------------------------------
+ * Search
+ * ------------------------------------
+ */
+
+static int compare_conjunction_events(const void *a, const void *b) {
+	const ConjunctionEvent *event_a = a, *event_b = b;
+	if(event_a->epoch != event_b->epoch) return (event_a->epoch > event_b->epoch) - (event_a->epoch < event_b->epoch);
+	if(event_a->idx0 != event_b->idx0) return event_a->idx0 - event_b->idx0;
+	return event_a->idx1 - event_b->idx1;
+}
+
+static void free_conjunction_search(ConjunctionSearch *search) {
+	orbitlib_free(search->events);
+	orbitlib_free(search->candidates);
+	orbitlib_free(search->large_objects);
+	orbitlib_free(search->bucket_objects);
+	orbitlib_free(search->bucket_start);
+	orbitlib_free(search->boxes);
+	orbitlib_free(search->states1);
+	orbitlib_free(search->states0);
+	orbitlib_free(search->period);
+	orbitlib_free(search->min_radius);
+}
+
+int search_conjunctions(OrbitlibContext *ctx, const OSV *osvs, int num_objects, double epoch, Body *cb, const ConjunctionParams *params,
+						ConjunctionEvent *events, int max_events, ConjunctionStats *stats) {
+	if(stats != NULL) *stats = (ConjunctionStats) {0, 0, 0};
+	if(num_objects < 2 || cb == NULL || !(params->time_step > 0) || params->max_epoch < params->min_epoch || !(params->threshold >= 0)) return 0;
+	if(ctx == NULL) ctx = get_default_orbitlib_context();
+	TRACE_BEGIN(span, "search_conjunctions");
+
+	ConjunctionSearch search = {
+			.osvs = osvs,
+			.num_objects = num_objects,
+			.epoch = epoch,
+			.cb = cb,
+			.params = params,
+			.min_radius = orbitlib_malloc(num_objects * sizeof(double)),
+			.period = orbitlib_malloc(num_objects * sizeof(double)),
+			.states0 = orbitlib_malloc(num_objects * sizeof(OSV)),
+			.states1 = orbitlib_malloc(num_objects * sizeof(OSV)),
+			.boxes = orbitlib_malloc(num_objects * sizeof(ConjunctionBox)),
+			.large_objects = orbitlib_malloc(num_objects * sizeof(int))
+	};
+	// power of two with about two buckets per binned box cell
+	search.num_buckets = 1024;
+	while(search.num_buckets < 16 * (uint32_t) num_objects && search.num_buckets < (1u << 30)) search.num_buckets *= 2;
+	search.bucket_start = orbitlib_malloc((search.num_buckets + 1) * sizeof(uint32_t));
+	if(search.min_radius == NULL || search.period == NULL || search.states0 == NULL || search.states1 == NULL ||
+	   search.boxes == NULL || search.large_objects == NULL || search.bucket_start == NULL) {
+		free_conjunction_search(&search);
+		TRACE_END(span);
+		return 0;
+	}
+	for(int i = 0; i < num_objects; i++) {
+		Orbit orbit = constr_orbit_from_osv(osvs[i].r, osvs[i].v, cb);
+		search.min_radius[i] = orbit.a * (1 - orbit.e);
+		search.period[i] = orbit.e < 1 ? calc_orbital_period(orbit) : INFINITY;
+	}
+	orbitlib_mutex_init(&search.mutex);
+
+	int num_object_tasks = (num_objects + CONJUNCTION_OBJECT_CHUNK - 1) / CONJUNCTION_OBJECT_CHUNK;
+	int num_bucket_tasks = (int) ((search.num_buckets + CONJUNCTION_BUCKET_CHUNK - 1) / CONJUNCTION_BUCKET_CHUNK);
+	int num_steps = (int) ceil((params->max_epoch - params->min_epoch) / params->time_step);
+	if(num_steps < 1) num_steps = 1;
+
+	// states at the start of the time span
+	search.t0 = search.t1 = params->min_epoch;
+	search.is_first_step = 1;
+	run_parallel_ctx(ctx, num_object_tasks, propagate_conjunction_task, &search);
+
+	for(int step = 0; step < num_steps && !search.out_of_memory; step++) {
+		OSV *states = search.states0;
+		search.states0 = search.states1;
+		search.states1 = states;
+		search.t0 = search.t1;
+		search.t1 = step == num_steps-1 ? params->max_epoch : params->min_epoch + (step+1) * params->time_step;
+		search.is_first_step = step == 0;
+		search.is_last_step = step == num_steps-1;
+
+		run_parallel_ctx(ctx, num_object_tasks, propagate_conjunction_task, &search);
+		if(!build_conjunction_grid(&search)) {
+			search.out_of_memory = 1;
+			break;
+		}
+		search.num_candidates = 0;
+		run_parallel_ctx(ctx, num_bucket_tasks + search.num_large_objects, find_conjunction_candidates_task, &search);
+		search.total_candidates += search.num_candidates;
+		run_parallel_ctx(ctx, search.num_candidates, refine_conjunction_task, &search);
+	}
+	if(search.out_of_memory) fprintf(stderr, "Conjunction search out of memory; events incomplete\n");
+
+	// deterministic order regardless of the threads' timing (pairs sharing cells of the same bucket are found twice)
+	int num_unique = 0;
+	if(search.num_events > 0) {
+		qsort(search.events, search.num_events, sizeof(ConjunctionEvent), compare_conjunction_events);
+		for(int i = 0; i < search.num_events; i++) {
+			if(num_unique > 0 && compare_conjunction_events(&search.events[num_unique-1], &search.events[i]) == 0) continue;
+			search.events[num_unique++] = search.events[i];
+		}
+	}
+	int num_results = num_unique < max_events ? num_unique : (max_events > 0 ? max_events : 0);
+	for(int i = 0; i < num_results; i++) events[i] = search.events[i];
+
+	if(stats != NULL) {
+		stats->num_steps = num_steps;
+		stats->num_candidates = search.total_candidates;
+		stats->num_events = num_unique;
+	}
+	orbitlib_mutex_destroy(&search.mutex);
+	free_conjunction_search(&search);
+	TRACE_END(span);
+	return num_results;
+}
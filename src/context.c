@@ -0,0 +1,183 @@
+#include "orbitlib_context.h"
+#include "context_internal.h"
+#include "alloc_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static OrbitlibContext *default_context = NULL;
+static OrbitlibOnce default_context_once = ORBITLIB_ONCE_INITIALIZER;
+static ORBITLIB_THREAD_LOCAL OrbitlibContext *bound_context = NULL;
+
+
+OrbitlibContextConfig get_default_orbitlib_context_config() {
+	OrbitlibContextConfig config = {
+			.ephem_directory = "../Ephemerides",
+			.ephem_min_date = {1950, 1, 1},
+			.ephem_max_date = {2100, 1, 1},
+			.ephem_time_step = {0, 1},
+			.allow_download = 1,
+			.cache_ephems = 1,
+			.num_threads = 0,
+			.diag_sink = NULL,
+			.diag_user_data = NULL,
+			.allocator = NULL
+	};
+	return config;
+}
+
+OrbitlibContext * new_orbitlib_context(const OrbitlibContextConfig *config) {
+	OrbitlibContextConfig default_config = get_default_orbitlib_context_config();
+	if(config == NULL) config = &default_config;
+
+	OrbitlibContext *ctx = calloc(1, sizeof(OrbitlibContext));
+	if(ctx == NULL) return NULL;
+	snprintf(ctx->ephem_directory, sizeof(ctx->ephem_directory), "%s",
+			 config->ephem_directory != NULL ? config->ephem_directory : default_config.ephem_directory);
+	ctx->ephem_min_date = config->ephem_min_date;
+	ctx->ephem_max_date = config->ephem_max_date;
+	ctx->ephem_time_step = config->ephem_time_step;
+	ctx->allow_download = config->allow_download;
+	ctx->cache_ephems = config->cache_ephems;
+	ctx->diag_sink = config->diag_sink;
+	ctx->diag_user_data = config->diag_user_data;
+	if(config->allocator != NULL) ctx->allocator = *config->allocator;
+	orbitlib_mutex_init(&ctx->cache_mutex);
+
+	int num_threads = config->num_threads >= 0 ? config->num_threads : orbitlib_get_num_processors() - 1;
+	if(num_threads > 0) ctx->thread_pool = orbitlib_thread_pool_create(num_threads);
+	return ctx;
+}
+
+void free_orbitlib_context(OrbitlibContext *ctx) {
+	if(ctx == NULL || ctx == default_context) return;
+	orbitlib_thread_pool_free(ctx->thread_pool);
+	clear_context_ephem_cache(ctx);
+	orbitlib_mutex_destroy(&ctx->cache_mutex);
+	if(bound_context == ctx) bound_context = NULL;
+	free(ctx);
+}
+
+static void init_default_context() {
+	default_context = new_orbitlib_context(NULL);
+}
+
+OrbitlibContext * get_default_orbitlib_context() {
+	orbitlib_call_once(&default_context_once, init_default_context);
+	return default_context;
+}
+
+OrbitlibContext * bind_orbitlib_context(OrbitlibContext *ctx) {
+	OrbitlibContext *prev = bound_context;
+	bound_context = ctx;
+	return prev;
+}
+
+OrbitlibContext * get_bound_orbitlib_context() {
+	return bound_context;
+}
+
+const char * get_context_ephem_directory(OrbitlibContext *ctx) {
+	return ctx->ephem_directory;
+}
+
+int get_context_num_threads(OrbitlibContext *ctx) {
+	return orbitlib_thread_pool_size(ctx->thread_pool);
+}
+
+
+/*
+ * ------------------------------------
+ * Ephemeris Cache
+ * ------------------------------------
+ */
+
+static EphemCacheEntry * find_cached_ephems(OrbitlibContext *ctx, int body_id) {
+	for(int i = 0; i < ctx->num_cached_ephems; i++) {
+		if(ctx->ephem_cache[i].body_id == body_id) return &ctx->ephem_cache[i];
+	}
+	return NULL;
+}
+
+int get_cached_ephems(OrbitlibContext *ctx, Body *body) {
+	if(!ctx->cache_ephems) return 0;
+	orbitlib_mutex_lock(&ctx->cache_mutex);
+	EphemCacheEntry *entry = find_cached_ephems(ctx, body->id);
+	Ephem *ephem = NULL;
+	if(entry != NULL) {
+		OrbitlibAllocator allocator = get_body_allocator(body);
+		ephem = allocator_malloc(&allocator, entry->num_ephems * sizeof(Ephem));
+		if(ephem != NULL) {
+			memcpy(ephem, entry->ephem, entry->num_ephems * sizeof(Ephem));
+			allocator_free(&allocator, body->ephem);
+			body->ephem = ephem;
+			body->num_ephems = entry->num_ephems;
+		}
+	}
+	orbitlib_mutex_unlock(&ctx->cache_mutex);
+	return ephem != NULL;
+}
+
+void store_cached_ephems(OrbitlibContext *ctx, Body *body) {
+	if(!ctx->cache_ephems || body->ephem == NULL || body->num_ephems == 0) return;
+	Ephem *ephem = malloc(body->num_ephems * sizeof(Ephem));
+	if(ephem == NULL) return;
+	memcpy(ephem, body->ephem, body->num_ephems * sizeof(Ephem));
+
+	orbitlib_mutex_lock(&ctx->cache_mutex);
+	// another thread might have loaded the same body in the meantime
+	if(find_cached_ephems(ctx, body->id) != NULL) {
+		orbitlib_mutex_unlock(&ctx->cache_mutex);
+		free(ephem);
+		return;
+	}
+	if(ctx->num_cached_ephems == ctx->max_cached_ephems) {
+		int max_entries = ctx->max_cached_ephems > 0 ? ctx->max_cached_ephems * 2 : 16;
+		EphemCacheEntry *temp = realloc(ctx->ephem_cache, max_entries * sizeof(EphemCacheEntry));
+		if(temp == NULL) {
+			orbitlib_mutex_unlock(&ctx->cache_mutex);
+			free(ephem);
+			return;
+		}
+		ctx->ephem_cache = temp;
+		ctx->max_cached_ephems = max_entries;
+	}
+	ctx->ephem_cache[ctx->num_cached_ephems++] = (EphemCacheEntry) {body->id, ephem, body->num_ephems};
+	orbitlib_mutex_unlock(&ctx->cache_mutex);
+}
+
+void clear_context_ephem_cache(OrbitlibContext *ctx) {
+	orbitlib_mutex_lock(&ctx->cache_mutex);
+	for(int i = 0; i < ctx->num_cached_ephems; i++) free(ctx->ephem_cache[i].ephem);
+	free(ctx->ephem_cache);
+	ctx->ephem_cache = NULL;
+	ctx->num_cached_ephems = 0;
+	ctx->max_cached_ephems = 0;
+	orbitlib_mutex_unlock(&ctx->cache_mutex);
+}
+
+
+/*
+ * ------------------------------------
+ * Parallel Tasks
+ * ------------------------------------
+ */
+
+typedef struct ContextTask {
+	OrbitlibContext *ctx;
+	void (*task)(void *arg, int index);
+	void *arg;
+} ContextTask;
+
+static void run_context_task(void *ptr, int index) {
+	ContextTask *context_task = ptr;
+	OrbitlibContext *prev = bind_orbitlib_context(context_task->ctx);
+	context_task->task(context_task->arg, index);
+	bind_orbitlib_context(prev);
+}
+
+void run_parallel_ctx(OrbitlibContext *ctx, int num_tasks, void (*task)(void *arg, int index), void *arg) {
+	ContextTask context_task = {ctx, task, arg};
+	orbitlib_parallel_for(ctx->thread_pool, num_tasks, run_context_task, &context_task);
+}
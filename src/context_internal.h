@@ -0,0 +1,39 @@
+#ifndef ORBITLIB_CONTEXT_INTERNAL_H
+#define ORBITLIB_CONTEXT_INTERNAL_H
+
+#include "orbitlib_context.h"
+#include "orbitlib_celestial.h"
+#include "threading.h"
+
+typedef struct EphemCacheEntry {
+	int body_id;
+	Ephem *ephem;
+	int num_ephems;
+} EphemCacheEntry;
+
+struct OrbitlibContext {
+	char ephem_directory[256];
+	Datetime ephem_min_date, ephem_max_date, ephem_time_step;
+	int allow_download;
+	int cache_ephems;
+	OrbitlibThreadPool *thread_pool;
+	DiagSink diag_sink;
+	void *diag_user_data;
+	OrbitlibAllocator allocator;
+
+	OrbitlibMutex cache_mutex;
+	EphemCacheEntry *ephem_cache;
+	int num_cached_ephems, max_cached_ephems;
+};
+
+// context bound to the calling thread (NULL if none)
+OrbitlibContext * get_bound_orbitlib_context();
+
+// copies cached ephemerides of the body (by id) into the body; returns 1 if they were cached
+int get_cached_ephems(OrbitlibContext *ctx, Body *body);
+void store_cached_ephems(OrbitlibContext *ctx, Body *body);
+
+// runs task(arg, index) for all indices on the context's thread pool with the context bound to each thread
+void run_parallel_ctx(OrbitlibContext *ctx, int num_tasks, void (*task)(void *arg, int index), void *arg);
+
+#endif //ORBITLIB_CONTEXT_INTERNAL_H
@@ -1,6 +1,7 @@
 #include "orbitlib_datetime.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 
@@ -44,36 +45,213 @@ int is_string_valid_date_format(const char *s, enum DateType date_type) {
 	return 1; // Date format is valid
 }
 
+static int is_leap_year(int year) {
+	return year%4 == 0;		// same leap year rule as the JD conversions
+}
+
+static int get_month_days(int month, int year) {
+	if(month == 2) return is_leap_year(year) ? 29 : 28;
+	if(month == 4 || month == 6 || month == 9 || month == 11) return 30;
+	return 31;
+}
+
+static int get_days_per_year(enum DateType date_type) {
+	return date_type == DATE_KERBAL ? 426 : 365;
+}
+
+static int get_hours_per_day(enum DateType date_type) {
+	return date_type == DATE_KERBAL ? 6 : 24;
+}
+
+// writes exactly num_digits digits of value (value >= 0) and returns pointer behind the last digit
+static char * write_digits(char *p, unsigned value, int num_digits) {
+	for(int i = num_digits-1; i >= 0; i--) {
+		p[i] = (char) ('0' + value%10);
+		value /= 10;
+	}
+	return p + num_digits;
+}
+
+// writes at least min_digits digits of value (with sign) and returns pointer behind the last digit
+static char * write_int(char *p, int value, int min_digits) {
+	unsigned u = value < 0 ? 0u - (unsigned) value : (unsigned) value;
+	int num_digits = 1;
+	for(unsigned t = u; t >= 10; t /= 10) num_digits++;
+	if(num_digits < min_digits) num_digits = min_digits;
+	if(value < 0) *p++ = '-';
+	return write_digits(p, u, num_digits);
+}
+
+// writes hh:mm[:ss[.sss]] (at most 12 characters) and returns pointer behind the last character
+static char * write_clocktime(char *p, Datetime date, int flags) {
+	int with_seconds = !(flags & DATE_FMT_NO_SECONDS);
+	int sub_units = with_seconds && (flags & DATE_FMT_MILLIS) ? 1000 : 1;
+	int hours_per_day = get_hours_per_day(date.date_type);
+	
+	// round the seconds to the displayed precision and carry over (never rolls over the date itself)
+	long long units = with_seconds ? llround(date.s * sub_units) : 0;
+	int h = date.h, min = date.min;
+	if(units < 0) units = 0;
+	if(units >= 60LL*sub_units) {
+		min += (int) (units / (60LL*sub_units));
+		units %= 60LL*sub_units;
+	}
+	if(min >= 60) {
+		h += min / 60;
+		min %= 60;
+	}
+	if(h >= hours_per_day) {
+		h = hours_per_day-1;
+		min = 59;
+		units = 60LL*sub_units - 1;
+	}
+	if(h < 0) h = 0;
+	if(min < 0) min = 0;
+	
+	p = write_digits(p, (unsigned) h, 2);
+	*p++ = ':';
+	p = write_digits(p, (unsigned) min, 2);
+	if(with_seconds) {
+		*p++ = ':';
+		p = write_digits(p, (unsigned) (units / sub_units), 2);
+		if(sub_units > 1) {
+			*p++ = '.';
+			p = write_digits(p, (unsigned) (units % sub_units), 3);
+		}
+	}
+	return p;
+}
+
+static int finish_formatted_string(const char *tmp, size_t len, char *buf, size_t buf_size) {
+	if(buf == NULL || buf_size == 0) return -1;
+	if(len+1 > buf_size) {
+		buf[0] = '\0';
+		return -1;
+	}
+	memcpy(buf, tmp, len);
+	buf[len] = '\0';
+	return (int) len;
+}
+
+int date_format(Datetime date, char *buf, size_t buf_size, int flags) {
+	char tmp[DATE_STRING_MAX];
+	char *p = tmp;
+	if(date.date_type == DATE_ISO) {
+		p = write_int(p, date.y, 4);
+		*p++ = '-';
+		p = write_digits(p, (unsigned) (date.m < 0 ? 0 : date.m) % 100, 2);
+		*p++ = '-';
+		p = write_digits(p, (unsigned) (date.d < 0 ? 0 : date.d) % 100, 2);
+	} else {
+		p = write_int(p, date.y, 1);
+		*p++ = '-';
+		p = write_digits(p, (unsigned) (date.d < 0 ? 0 : date.d) % 1000, 3);
+	}
+	if(flags & DATE_FMT_CLOCKTIME) {
+		*p++ = flags & DATE_FMT_ISO_T ? 'T' : ' ';
+		p = write_clocktime(p, date, flags);
+	}
+	return finish_formatted_string(tmp, p-tmp, buf, buf_size);
+}
+
+int clocktime_format(Datetime date, char *buf, size_t buf_size, int flags) {
+	char tmp[DATE_STRING_MAX];
+	char *p = write_clocktime(tmp, date, flags);
+	return finish_formatted_string(tmp, p-tmp, buf, buf_size);
+}
+
 void date_to_string(Datetime date, char *s, int clocktime) {
-	if(date.date_type == DATE_ISO)
-		sprintf(s, "%d-%02d-%02d", date.y, date.m, date.d);
-	else
-		sprintf(s, "%d-%03d", date.y, date.d);
-	if(clocktime) sprintf(s,"%s %02d:%02d:%02.0f", s, date.h, date.min, date.s);
+	date_format(date, s, DATE_STRING_MAX, clocktime ? DATE_FMT_CLOCKTIME : DATE_FMT_DATE);
 }
 
 void clocktime_to_string(Datetime date, char *s, int seconds) {
-	sprintf(s,"%02d:%02d", date.h, date.min);
-	if(seconds) sprintf(s,"%s:%02.0f", s, date.s);
+	// "hh:mm:ss" or "hh:mm" plus null terminator
+	clocktime_format(date, s, seconds ? 9 : 6, seconds ? 0 : DATE_FMT_NO_SECONDS);
 }
 
-Datetime date_from_string(char *s, enum DateType date_type) {
-	int year, month, day;	// "yyyy-mm-dd" (ISO 8601)  "yyyy-ddd" (Kerbal and ISO-like Kerbal)
-	char *ptr;
+// parses between 1 and max_digits digits; returns number of digits read (0 if none)
+static int parse_digits(const char *s, const char *end, int max_digits, int *value) {
+	int num_digits = 0;
+	int v = 0;
+	while(s+num_digits < end && num_digits < max_digits && s[num_digits] >= '0' && s[num_digits] <= '9') {
+		v = v*10 + (s[num_digits] - '0');
+		num_digits++;
+	}
+	*value = v;
+	return num_digits;
+}
+
+int date_parse(const char *s, size_t len, enum DateType date_type, Datetime *date) {
+	if(s == NULL || date == NULL) return 0;
+	const char *p = s;
+	const char *end = s + len;
+	Datetime result = {0, 0, 0, 0, 0, 0, date_type};
+	int n;
 	
-	// Extract year
-	year = (int) strtol(s, &ptr, 10);
-	ptr++; // Move past the '-'
+	while(p < end && (*p == ' ' || *p == '\t')) p++;
+	
+	// year (optionally signed)
+	int negative = 0;
+	if(p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+	if((n = parse_digits(p, end, 9, &result.y)) == 0) return 0;
+	p += n;
+	if(negative) result.y *= -1;
+	if(p >= end || *p++ != '-') return 0;
 	
-	// Extract month (only with ISO time)
 	if(date_type == DATE_ISO) {
-		month = (int) strtol(ptr, &ptr, 10);
-		ptr++; // Move past the '-'
-	} else month = 0;
+		if((n = parse_digits(p, end, 2, &result.m)) == 0) return 0;
+		p += n;
+		if(p >= end || *p++ != '-') return 0;
+		if((n = parse_digits(p, end, 2, &result.d)) == 0) return 0;
+		p += n;
+		if(result.m < 1 || result.m > 12) return 0;
+		if(result.d < 1 || result.d > get_month_days(result.m, result.y)) return 0;
+	} else {
+		if((n = parse_digits(p, end, 3, &result.d)) == 0) return 0;
+		p += n;
+		if(result.d < 1 || result.d > get_days_per_year(date_type)) return 0;
+	}
+	
+	// optional clocktime: ("T" | " ") hh:mm[:ss[.fff]]
+	if(p < end && (*p == 'T' || *p == ' ') && p+1 < end && p[1] >= '0' && p[1] <= '9') {
+		p++;
+		if(parse_digits(p, end, 2, &result.h) != 2) return 0;
+		p += 2;
+		if(p >= end || *p++ != ':') return 0;
+		if(parse_digits(p, end, 2, &result.min) != 2) return 0;
+		p += 2;
+		if(p < end && *p == ':') {
+			int sec;
+			p++;
+			if(parse_digits(p, end, 2, &sec) != 2) return 0;
+			p += 2;
+			result.s = sec;
+			if(p < end && (*p == '.' || *p == ',')) {
+				double scale = 0.1;
+				p++;
+				if(p >= end || *p < '0' || *p > '9') return 0;
+				while(p < end && *p >= '0' && *p <= '9') {
+					result.s += (*p++ - '0') * scale;
+					scale *= 0.1;
+				}
+			}
+		}
+		if(result.h >= get_hours_per_day(date_type) || result.min > 59) return 0;
+		// allow leap second (23:59:60) for ISO dates
+		if(result.s >= 60 && !(date_type == DATE_ISO && result.h == 23 && result.min == 59 && result.s < 61)) return 0;
+		if(date_type == DATE_ISO && p < end && *p == 'Z') p++;
+	}
+	
+	while(p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+	if(p != end) return 0;
 	
-	// Extract day
-	day = (int) strtol(ptr, &ptr, 10);
-	Datetime date = {year, month, day, .date_type=date_type};
+	*date = result;
+	return 1;
+}
+
+Datetime date_from_string(char *s, enum DateType date_type) {
+	Datetime date = {0, 0, 0, 0, 0, 0, date_type};
+	date_parse(s, strlen(s), date_type, &date);
 	return date;
 }
 
@@ -250,7 +428,7 @@ double jd_change_date(double jd, int delta_years, int delta_months, double delta
 
 Datetime get_date_difference_from_epochs(double jd0, double jd1, enum DateType date_type) {
 	double epoch_diff = jd1 - jd0;
-	Datetime date = {0, 0};
+	Datetime date = {0};
 	// floating-point imprecision when converting to seconds 1 -> 0.999997
 	if(fmod(epoch_diff*(24*60*60), 1) > 0.9) epoch_diff += 1.0/(24*60*60*10);
 	if(fmod(epoch_diff*(24*60*60), 1) < -0.9) epoch_diff -= 1.0/(24*60*60*10);
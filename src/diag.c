@@ -0,0 +1,212 @@
+#include "orbitlib_diag.h"
+#include "diag_internal.h"
+#include "threading.h"
+#include "context_internal.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char *diag_code_names[NUM_DIAG_CODES] = {
+		"LAMBERT_FAIL_ECC", "LAMBERT_FAIL_NAN", "LAMBERT_MAX_ITERATIONS", "PROPAGATION_ITERATION_CAP", "KEPLER_ITERATION_CAP"
+};
+
+static const char *diag_value_names[NUM_DIAG_CODES][DIAG_RECORD_NUM_VALUES] = {
+		{"r0", "r1", "delta_ta", "target_dt", "ta0", "min_ta0", "max_ta0", "e"},
+		{"r0", "r1", "delta_ta", "target_dt", "ta0", "ta1", "a", "e"},
+		{"r0", "r1", "delta_ta", "target_dt", "ta0", "dt"},
+		{"a", "e", "ta0", "dt", "t", "target_t"},
+		{"e", "mean_anomaly", "ecc_anomaly", "delta"}
+};
+
+// buffered record and its destination
+typedef struct DiagSlot {
+	DiagRecord record;
+	DiagSink sink;			// sink of the context bound at recording time (NULL: global sink)
+	void *user_data;
+} DiagSlot;
+
+// single-producer (owning thread) single-consumer (drain, serialized by diag_mutex) ring buffer
+typedef struct DiagRing {
+	DiagSlot slots[DIAG_RING_BUFFER_SIZE];
+	atomic_uint head;		// next write position (written by the owning thread)
+	atomic_uint tail;		// next read position (written by the draining thread)
+	uint32_t thread;
+	struct DiagRing *prev, *next;
+} DiagRing;
+
+static OrbitlibMutex diag_mutex = ORBITLIB_MUTEX_INITIALIZER;
+static OrbitlibOnce diag_once = ORBITLIB_ONCE_INITIALIZER;
+static OrbitlibThreadKey diag_key;
+static int has_diag_key = 0;
+static DiagRing *diag_rings = NULL;
+static uint32_t num_diag_threads = 0;
+
+// records of exited threads that were not drained yet (guarded by diag_mutex)
+static DiagSlot *orphaned_records = NULL;
+static int num_orphaned_records = 0;
+
+static atomic_int diag_enabled = 0;
+static DiagSink diag_sink = NULL;		// guarded by diag_mutex
+static void *diag_user_data = NULL;		// guarded by diag_mutex
+static atomic_uint_least64_t num_dropped_records = 0;
+
+static ORBITLIB_THREAD_LOCAL DiagRing *thread_ring = NULL;
+
+
+// copies all unread records of the ring to dst (diag_mutex held); returns the number of copied records
+static int take_ring_records(DiagRing *ring, DiagSlot *dst) {
+	unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	int n = 0;
+	for(unsigned i = tail; i != head; i++) dst[n++] = ring->slots[i % DIAG_RING_BUFFER_SIZE];
+	atomic_store_explicit(&ring->tail, head, memory_order_release);
+	return n;
+}
+
+// called on thread exit: keeps the undrained records and releases the ring
+static void release_diag_ring(void *ptr) {
+	DiagRing *ring = ptr;
+	orbitlib_mutex_lock(&diag_mutex);
+	DiagSlot *temp = realloc(orphaned_records, (num_orphaned_records + DIAG_RING_BUFFER_SIZE) * sizeof(DiagSlot));
+	if(temp != NULL) {
+		orphaned_records = temp;
+		num_orphaned_records += take_ring_records(ring, orphaned_records + num_orphaned_records);
+	}
+	if(ring->prev != NULL) ring->prev->next = ring->next;
+	else diag_rings = ring->next;
+	if(ring->next != NULL) ring->next->prev = ring->prev;
+	orbitlib_mutex_unlock(&diag_mutex);
+	if(thread_ring == ring) thread_ring = NULL;
+	free(ring);
+}
+
+static void init_diag_key() {
+	has_diag_key = orbitlib_thread_key_create(&diag_key, release_diag_ring);
+}
+
+static DiagRing * register_diag_ring() {
+	DiagRing *ring = calloc(1, sizeof(DiagRing));
+	if(ring == NULL) return NULL;
+	orbitlib_call_once(&diag_once, init_diag_key);
+
+	orbitlib_mutex_lock(&diag_mutex);
+	ring->thread = num_diag_threads++;
+	ring->next = diag_rings;
+	if(diag_rings != NULL) diag_rings->prev = ring;
+	diag_rings = ring;
+	orbitlib_mutex_unlock(&diag_mutex);
+
+	if(has_diag_key) orbitlib_thread_key_set(diag_key, ring);
+	thread_ring = ring;
+	return ring;
+}
+
+int is_diag_sink_registered() {
+	OrbitlibContext *ctx = get_bound_orbitlib_context();
+	return atomic_load_explicit(&diag_enabled, memory_order_relaxed) || (ctx != NULL && ctx->diag_sink != NULL);
+}
+
+static void fill_diag_record(DiagRecord *record, enum SolverId solver, enum DiagCode code, uint32_t thread, const double *values, int num_values) {
+	record->solver = (uint16_t) solver;
+	record->code = (uint16_t) code;
+	record->thread = thread;
+	record->timestamp = orbitlib_time_ns();
+	if(num_values > DIAG_RECORD_NUM_VALUES) num_values = DIAG_RECORD_NUM_VALUES;
+	for(int i = 0; i < DIAG_RECORD_NUM_VALUES; i++) record->values[i] = i < num_values ? values[i] : 0;
+}
+
+void record_diag(enum SolverId solver, enum DiagCode code, const double *values, int num_values) {
+	// records for the sink of a bound context take the same ring and are delivered to it when drained
+	OrbitlibContext *ctx = get_bound_orbitlib_context();
+	DiagSink ctx_sink = ctx != NULL ? ctx->diag_sink : NULL;
+	if(ctx_sink == NULL && !atomic_load_explicit(&diag_enabled, memory_order_relaxed)) return;
+	DiagRing *ring = thread_ring != NULL ? thread_ring : register_diag_ring();
+	if(ring == NULL) return;
+
+	unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	if(head - tail >= DIAG_RING_BUFFER_SIZE) {
+		atomic_fetch_add_explicit(&num_dropped_records, 1, memory_order_relaxed);
+		return;
+	}
+
+	DiagSlot *slot = &ring->slots[head % DIAG_RING_BUFFER_SIZE];
+	fill_diag_record(&slot->record, solver, code, ring->thread, values, num_values);
+	slot->sink = ctx_sink;
+	slot->user_data = ctx_sink != NULL ? ctx->diag_user_data : NULL;
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void set_diag_sink(DiagSink sink, void *user_data) {
+	orbitlib_mutex_lock(&diag_mutex);
+	diag_sink = sink;
+	diag_user_data = user_data;
+	atomic_store_explicit(&diag_enabled, sink != NULL, memory_order_relaxed);
+	orbitlib_mutex_unlock(&diag_mutex);
+}
+
+int drain_diag_records() {
+	orbitlib_mutex_lock(&diag_mutex);
+	DiagSink sink = diag_sink;
+	void *user_data = diag_user_data;
+	int num_rings = 0;
+	for(DiagRing *ring = diag_rings; ring != NULL; ring = ring->next) num_rings++;
+
+	// copy out under the lock and call the sinks without it (a sink may call solvers itself)
+	int max_records = num_orphaned_records + num_rings * DIAG_RING_BUFFER_SIZE;
+	DiagSlot *slots = max_records > 0 ? malloc(max_records * sizeof(DiagSlot)) : NULL;
+	DiagRecord *records = max_records > 0 ? malloc(max_records * sizeof(DiagRecord)) : NULL;
+	int num_slots = 0;
+	if(slots != NULL && records != NULL) {
+		memcpy(slots, orphaned_records, num_orphaned_records * sizeof(DiagSlot));
+		num_slots = num_orphaned_records;
+		free(orphaned_records);
+		orphaned_records = NULL;
+		num_orphaned_records = 0;
+		for(DiagRing *ring = diag_rings; ring != NULL; ring = ring->next) num_slots += take_ring_records(ring, slots + num_slots);
+	}
+	orbitlib_mutex_unlock(&diag_mutex);
+
+	// one batch per run of records with the same destination (records without a context go to the global sink)
+	int num_forwarded = 0;
+	for(int i = 0; i < num_slots;) {
+		DiagSink dst_sink = slots[i].sink != NULL ? slots[i].sink : sink;
+		void *dst_user_data = slots[i].sink != NULL ? slots[i].user_data : user_data;
+		int n = 0;
+		for(int j = i; j < num_slots && slots[j].sink == slots[i].sink && slots[j].user_data == slots[i].user_data; j++) {
+			records[n++] = slots[j].record;
+		}
+		if(dst_sink != NULL) {
+			dst_sink(records, n, dst_user_data);
+			num_forwarded += n;
+		}
+		i += n;
+	}
+	free(slots);
+	free(records);
+	return num_forwarded;
+}
+
+uint64_t get_num_dropped_diag_records() {
+	return atomic_load_explicit(&num_dropped_records, memory_order_relaxed);
+}
+
+const char * get_diag_code_name(enum DiagCode code) {
+	if(code < 0 || code >= NUM_DIAG_CODES) return "UNKNOWN";
+	return diag_code_names[code];
+}
+
+void print_diag_record(const DiagRecord *record) {
+	printf("[%s] %s (thread %u):", get_solver_name(record->solver), get_diag_code_name(record->code), record->thread);
+	if(record->code >= NUM_DIAG_CODES) {
+		printf("\n");
+		return;
+	}
+	for(int i = 0; i < DIAG_RECORD_NUM_VALUES; i++) {
+		if(diag_value_names[record->code][i] == NULL) break;
+		printf(" %s=%g", diag_value_names[record->code][i], record->values[i]);
+	}
+	printf("\n");
+}
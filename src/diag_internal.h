@@ -0,0 +1,18 @@
+#ifndef ORBITLIB_DIAG_INTERNAL_H
+#define ORBITLIB_DIAG_INTERNAL_H
+
+// Internal recording of diagnostic records (no-op while no sink is registered)
+
+#include "orbitlib_diag.h"
+
+int is_diag_sink_registered();
+void record_diag(enum SolverId solver, enum DiagCode code, const double *values, int num_values);
+
+#define RECORD_DIAG(solver, code, ...) do { \
+	if(is_diag_sink_registered()) { \
+		double diag_values_[] = {__VA_ARGS__}; \
+		record_diag(solver, code, diag_values_, (int) (sizeof(diag_values_)/sizeof(double))); \
+	} \
+} while(0)
+
+#endif //ORBITLIB_DIAG_INTERNAL_H
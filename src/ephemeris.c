@@ -1,11 +1,18 @@
 #include "orbitlib_ephemeris.h"
 #include "orbitlib_fileio.h"
+#include "trace_internal.h"
+#include "context_internal.h"
+#include "alloc_internal.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
 
 
+// lower bound of the size of one record in an ephemeris file (epoch, position and velocity line)
+#define EPHEM_RECORD_MIN_SIZE 128
+
+
 void print_ephem(struct Ephem ephem) {
 	printf("Date: %f  (", ephem.epoch);
 	print_date(convert_JD_date(ephem.epoch, DATE_ISO), 0);
@@ -14,13 +21,19 @@ void print_ephem(struct Ephem ephem) {
 		   ephem.r.x, ephem.r.y, ephem.r.z, ephem.v.x, ephem.v.y, ephem.v.z);
 }
 
-void get_ephem_data_filepath(int id, char *filepath, const char *ephem_directory) {
-	sprintf(filepath, "%s/%d.ephem", ephem_directory, id);
+// returns 0 if the path doesn't fit into the buffer (a truncated path must not be opened)
+static int get_ephem_data_filepath(int id, char *filepath, size_t size, const char *ephem_directory) {
+	int len = snprintf(filepath, size, "%s/%d.ephem", ephem_directory, id);
+	if(len < 0 || (size_t) len >= size) {
+		fprintf(stderr, "Ephemeris file path too long: %s/%d.ephem\n", ephem_directory, id);
+		return 0;
+	}
+	return 1;
 }
 
 int is_ephem_available(int body_code, const char *ephem_directory) {
-	char filepath[50];
-	get_ephem_data_filepath(body_code, filepath, ephem_directory);
+	char filepath[256];
+	if(!get_ephem_data_filepath(body_code, filepath, sizeof(filepath), ephem_directory)) return 0;
 	FILE *file = fopen(filepath, "r");  // Try to open file in read mode
 	if (file) {
 		fclose(file);  // Close file if it was opened
@@ -29,49 +42,44 @@ int is_ephem_available(int body_code, const char *ephem_directory) {
 	return 0;          // File does not exist
 }
 
-void get_body_ephems(Body *body, Datetime min_date, Datetime max_date, Datetime time_step, const char *ephem_directory) {
-	if(body->orbit.cb == NULL) return;
-	if(!directory_exists(ephem_directory)) create_directory(ephem_directory);
+static void download_body_ephems(Body *body, Datetime min_date, Datetime max_date, Datetime time_step, const char *filepath) {
+	char d0_s[32];
+	char d1_s[32];
+	date_to_string(min_date, d0_s, 1);
+	date_to_string(max_date, d1_s, 1);
+	// Construct the URL with your API key and parameters
 	
-	char filepath[50];
-	get_ephem_data_filepath(body->id, filepath, ephem_directory);
+	char timestep_s[16];
+	if(time_step.y > 0) {
+		snprintf(timestep_s, sizeof(timestep_s), "%d y", time_step.y);
+	} else if(time_step.m > 0) {
+		snprintf(timestep_s, sizeof(timestep_s), "%d mo", time_step.m);
+	} else if(time_step.d > 0) {
+		snprintf(timestep_s, sizeof(timestep_s), "%d d", time_step.d);
+	} else return;
 	
-	if(!is_ephem_available(body->id, ephem_directory)) {
-		char d0_s[32];
-		char d1_s[32];
-		date_to_string(min_date, d0_s, 1);
-		date_to_string(max_date, d1_s, 1);
-		// Construct the URL with your API key and parameters
-		
-		char timestep_s[8];
-		if(time_step.y > 0) {
-			sprintf(timestep_s, "%d y", time_step.y);
-		} else if(time_step.m > 0) {
-			sprintf(timestep_s, "%d mo", time_step.m);
-		} else if(time_step.d > 0) {
-			sprintf(timestep_s, "%d d", time_step.d);
-		} else return;
-		
-		char body_id[24];
-		if(body->id >= 20000000) sprintf(body_id, "DES=%d", body->id);
-		else sprintf(body_id, "%d", body->id);
-		
-		char url[256];
-		sprintf(url, "https://ssd.jpl.nasa.gov/api/horizons.api?"
-					 "format=text&"
-					 "COMMAND='%s'&"
-					 "OBJ_DATA='YES'&"
-					 "MAKE_EPHEM='YES'&"
-					 "EPHEM_TYPE='VECTORS'&"
-					 "CENTER='500@%d'&"
-					 "START_TIME='%s'&"
-					 "STOP_TIME='%s'&"
-					 "STEP_SIZE='%s'&"
-					 "VEC_TABLE='2'", body_id, body->orbit.cb->id, d0_s, d1_s, timestep_s);
-		
-		download_file(url, filepath);
-	}
+	char body_id[24];
+	if(body->id >= 20000000) sprintf(body_id, "DES=%d", body->id);
+	else sprintf(body_id, "%d", body->id);
+	
+	char url[512];
+	snprintf(url, sizeof(url), "https://ssd.jpl.nasa.gov/api/horizons.api?"
+				 "format=text&"
+				 "COMMAND='%s'&"
+				 "OBJ_DATA='YES'&"
+				 "MAKE_EPHEM='YES'&"
+				 "EPHEM_TYPE='VECTORS'&"
+				 "CENTER='500@%d'&"
+				 "START_TIME='%s'&"
+				 "STOP_TIME='%s'&"
+				 "STEP_SIZE='%s'&"
+				 "VEC_TABLE='2'", body_id, body->orbit.cb->id, d0_s, d1_s, timestep_s);
 	
+	download_file(url, filepath);
+}
+
+static int read_body_ephems(Body *body, const char *filepath) {
+	OrbitlibAllocator allocator = get_body_allocator(body);
 	FILE *file;
 	char line[256];  // Assuming lines are no longer than 255 characters
 	
@@ -79,7 +87,7 @@ void get_body_ephems(Body *body, Datetime min_date, Datetime max_date, Datetime
 	
 	if(file == NULL) {
 		perror("Unable to open file");
-		return;
+		return 0;
 	}
 	
 	// Read lines from the file until the end is reached
@@ -90,11 +98,17 @@ void get_body_ephems(Body *body, Datetime min_date, Datetime max_date, Datetime
 		}
 	}
 	
-	int max_num_ephems = 12;
+	// reserve for the records in the rest of the file at once (instead of growing the array record by record)
+	long data_start = ftell(file);
+	fseek(file, 0, SEEK_END);
+	long data_size = ftell(file) - data_start;
+	fseek(file, data_start, SEEK_SET);
+	int max_num_ephems = data_size > 0 ? (int) (data_size / EPHEM_RECORD_MIN_SIZE) + 1 : 12;
 	
-	if(body->ephem != NULL) free(body->ephem);
-	body->ephem = calloc(max_num_ephems, sizeof(Ephem));
+	allocator_free(&allocator, body->ephem);
+	body->ephem = allocator_malloc(&allocator, max_num_ephems * sizeof(Ephem));
 	body->num_ephems = 0;
+	if(body->ephem == NULL) {fclose(file); return 0;}
 	
 	fgets(line, sizeof(line), file);
 	line[strcspn(line, "\n")] = '\0';
@@ -112,8 +126,9 @@ void get_body_ephems(Body *body, Datetime min_date, Datetime max_date, Datetime
 		
 		if(body->num_ephems == max_num_ephems) {
 			max_num_ephems *= 2;
-			Ephem *temp = realloc(body->ephem, max_num_ephems*sizeof(Ephem));
-			if(temp != NULL) body->ephem = temp;
+			Ephem *temp = allocator_realloc(&allocator, body->ephem, max_num_ephems*sizeof(Ephem));
+			if(temp == NULL) break;
+			body->ephem = temp;
 		}
 		
 		body->ephem[body->num_ephems].epoch = date;
@@ -129,6 +144,58 @@ void get_body_ephems(Body *body, Datetime min_date, Datetime max_date, Datetime
 		line[strcspn(line, "\n")] = '\0';
 	}
 	fclose(file);
+	
+	// give back the over-reserved memory
+	if(body->num_ephems > 0 && body->num_ephems < max_num_ephems) {
+		Ephem *temp = allocator_realloc(&allocator, body->ephem, body->num_ephems*sizeof(Ephem));
+		if(temp != NULL) body->ephem = temp;
+	}
+	return 1;
+}
+
+void get_body_ephems(Body *body, Datetime min_date, Datetime max_date, Datetime time_step, const char *ephem_directory) {
+	if(body->orbit.cb == NULL) return;
+	TRACE_BEGIN(span, "get_body_ephems");
+	if(!directory_exists(ephem_directory)) create_directory(ephem_directory);
+	
+	char filepath[256];
+	if(!get_ephem_data_filepath(body->id, filepath, sizeof(filepath), ephem_directory)) {
+		TRACE_END(span);
+		return;
+	}
+	
+	if(!is_ephem_available(body->id, ephem_directory)) download_body_ephems(body, min_date, max_date, time_step, filepath);
+	read_body_ephems(body, filepath);
+	TRACE_END(span);
+}
+
+static void fetch_body_ephems(OrbitlibContext *ctx, Body *body) {
+	TRACE_BEGIN(span, "get_body_ephems");
+	char filepath[256];
+	if(!get_ephem_data_filepath(body->id, filepath, sizeof(filepath), ctx->ephem_directory)) {
+		TRACE_END(span);
+		return;
+	}
+	
+	if(!is_ephem_available(body->id, ctx->ephem_directory)) {
+		if(!ctx->allow_download) {
+			fprintf(stderr, "Ephemeris file not available (downloads disabled): %s\n", filepath);
+			TRACE_END(span);
+			return;
+		}
+		if(!directory_exists(ctx->ephem_directory)) create_directory(ctx->ephem_directory);
+		download_body_ephems(body, ctx->ephem_min_date, ctx->ephem_max_date, ctx->ephem_time_step, filepath);
+	}
+	if(read_body_ephems(body, filepath)) store_cached_ephems(ctx, body);
+	TRACE_END(span);
+}
+
+void get_body_ephems_ctx(OrbitlibContext *ctx, Body *body) {
+	if(body->orbit.cb == NULL) return;
+	if(ctx == NULL) ctx = get_default_orbitlib_context();
+	OrbitlibContext *prev_ctx = bind_orbitlib_context(ctx);
+	if(!get_cached_ephems(ctx, body)) fetch_body_ephems(ctx, body);
+	bind_orbitlib_context(prev_ctx);
 }
 
 Ephem get_closest_ephem(Ephem *ephem, int num_ephems, double epoch) {
@@ -2,11 +2,14 @@
 #include "orbitlib_celestial.h"
 #include "orbitlib_orbit.h"
 #include "orbitlib_ephemeris.h"
+#include "trace_internal.h"
+#include "context_internal.h"
+#include "alloc_internal.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <errno.h>
-#include <ctype.h>
+#include <stdint.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -41,6 +44,7 @@ int create_directory(const char *path) {
 }
 
 void download_file(const char *url, const char *filepath) {
+	TRACE_BEGIN(span, "download_file");
 #ifdef _WIN32
 	HRESULT hr = URLDownloadToFile(NULL, url, filepath, 0, NULL);
     if (hr != S_OK) {
@@ -54,6 +58,7 @@ void download_file(const char *url, const char *filepath) {
 		fprintf(stderr, "Error executing wget: %d\n", ret_code);
 	}
 #endif
+	TRACE_END(span);
 }
 
 enum STORED_UNITS {UNITS_LEGACY, UNITS_M_DEG_PA};
@@ -68,6 +73,11 @@ void store_body_in_config_file(FILE *file, struct Body *body, CelestSystem *syst
 	fprintf(file, "sea_level_pressure = %f\n", body->sl_atmo_p);
 	fprintf(file, "scale_height = %.0f\n", body->scale_height);
 	fprintf(file, "atmosphere_altitude = %f\n", body->atmo_alt);
+	if(body->j2 != 0) fprintf(file, "j2 = %.9g\n", body->j2);
+	if(body->north_pole_ra != 0 || body->north_pole_decl != M_PI/2) {
+		fprintf(file, "north_pole_right_ascension = %f\n", rad2deg(body->north_pole_ra));
+		fprintf(file, "north_pole_declination = %f\n", rad2deg(body->north_pole_decl));
+	}
 	if(body != system->cb) {
 		fprintf(file, "semi_major_axis = %f\n", body->orbit.a);
 		fprintf(file, "eccentricity = %f\n", body->orbit.e);
@@ -89,6 +99,7 @@ void store_system_in_config_file(CelestSystem *system, const char *directory) {
 	fprintf(file, "[%s]\n", system->name);
 	fprintf(file, "propagation_method = %s\n", system->prop_method == ORB_ELEMENTS ? "ELEMENTS" : "EPHEMERIDES");
 	fprintf(file, "ut0 = %f\n", system->ut0);
+	fprintf(file, "time_scale = %s\n", time_scale_to_string(system->time_scale));
 	fprintf(file, "number_of_bodies = %d\n", system->num_bodies);
 	fprintf(file, "central_body = %s\n", system->cb->name);
 	fprintf(file, "units = M_DEG_PA\n\n");
@@ -104,6 +115,7 @@ void store_system_in_config_file(CelestSystem *system, const char *directory) {
 }
 
 void parse_and_sort_into_celestial_subsystems(CelestSystem *system) {
+	TRACE_BEGIN(span, "parse_and_sort_into_celestial_subsystems");
 	system->cb->system = system;
 	
 	for(int i = 0; i < system->num_bodies; i++) {
@@ -113,13 +125,15 @@ void parse_and_sort_into_celestial_subsystems(CelestSystem *system) {
 			if(system->bodies[j]->orbit.cb == body) num_child_bodies++;
 		}
 		if(num_child_bodies > 0) {
-			CelestSystem *child_system = new_system();
+			// subsystems share the memory ownership of the system (their bodies are allocated with it)
+			CelestSystem *child_system = new_system_with_allocator(&system->allocator);
 			sprintf(child_system->name, "%s SYSTEM", body->name);
 			child_system->num_bodies = num_child_bodies;
-			child_system->bodies = malloc(num_child_bodies * sizeof(struct Body*));
+			child_system->bodies = allocator_malloc(&system->allocator, num_child_bodies * sizeof(struct Body*));
 			child_system->cb = body;
 			child_system->prop_method = system->prop_method;
 			child_system->ut0 = system->ut0;
+			child_system->time_scale = system->time_scale;
 			body->system = child_system;
 		}
 	}
@@ -140,205 +154,722 @@ void parse_and_sort_into_celestial_subsystems(CelestSystem *system) {
 		}
 	}
 	
-	struct Body **temp = realloc(system->bodies, system->num_bodies*(sizeof(struct Body*)));
-	if(temp == NULL) return;
-	system->bodies = temp;
+	struct Body **temp = allocator_realloc(&system->allocator, system->bodies, system->num_bodies*(sizeof(struct Body*)));
+	if(temp != NULL) system->bodies = temp;
+	TRACE_END(span);
 }
 
-int get_key_and_value_from_config(char *key, char *value, char *line) {
-	char *equalSign = strchr(line, '=');  // Find '='
-	if (equalSign) {
-		size_t keyLen = equalSign - line;
-		strncpy(key, line, keyLen);  // Copy key
-		key[keyLen] = '\0';  // Null-terminate
-		if(isspace(key[keyLen-1])) key[keyLen-1] = '\0';	// remove space
-		
-		strcpy(value,  equalSign + (isspace(*(equalSign + 1)) ? 2 : 1));  // Copy value and skip space
-		
-		// remove line breaks
-		size_t len = strlen(value);
-		if (len > 0 && (value[len - 1] == '\n' || value[len - 1] == '\r')) {
-			value[len - 1] = '\0';  // Replace newline with null terminator
-		}
-		if (len > 0 && value[len - 2] == '\r') {
-			value[len - 2] = '\0';  // Replace newline with null terminator
-		}
-		return 1;
+/*
+ * ------------------------------------
+ * Config Parser
+ * ------------------------------------
+ */
+
+enum CfgKey {
+	CFG_KEY_UNKNOWN,
+	// system keys
+	CFG_PROPAGATION_METHOD, CFG_UT0, CFG_TIME_SCALE, CFG_NUMBER_OF_BODIES, CFG_CENTRAL_BODY, CFG_UNITS,
+	// body keys
+	CFG_COLOR, CFG_ID, CFG_GRAVITATIONAL_PARAMETER, CFG_G_ASL, CFG_RADIUS, CFG_ROTATIONAL_PERIOD, CFG_SEA_LEVEL_PRESSURE,
+	CFG_SCALE_HEIGHT, CFG_ATMOSPHERE_ALTITUDE, CFG_NORTH_POLE_RA, CFG_NORTH_POLE_DECL, CFG_ROTATION_UT0,
+	CFG_SEMI_MAJOR_AXIS, CFG_ECCENTRICITY, CFG_INCLINATION, CFG_RAAN, CFG_ARGUMENT_OF_PERIAPSIS,
+	CFG_TRUE_ANOMALY_UT0, CFG_MEAN_ANOMALY_UT0, CFG_PARENT_BODY, CFG_IS_HOMEBODY, CFG_J2
+};
+
+// Perfect hash over all known keys: (7*len + 9*first + last + middle) & 63 is collision-free for this key set.
+// Found by brute-force search over the multipliers; search again when adding keys.
+#define CFG_KEY_HASH(key, len) ((7*(len) + 9*(unsigned char)(key)[0] + (unsigned char)(key)[(len)-1] + (unsigned char)(key)[(len)/2]) & 63)
+
+static const struct CfgKeyEntry {
+	const char *name;
+	enum CfgKey key;
+} cfg_key_table[64] = {
+	[1]  = {"propagation_method", CFG_PROPAGATION_METHOD},
+	[7]  = {"id", CFG_ID},
+	[8]  = {"radius", CFG_RADIUS},
+	[10] = {"north_pole_declination", CFG_NORTH_POLE_DECL},
+	[12] = {"eccentricity", CFG_ECCENTRICITY},
+	[13] = {"sea_level_pressure", CFG_SEA_LEVEL_PRESSURE},
+	[15] = {"g_asl", CFG_G_ASL},
+	[17] = {"semi_major_axis", CFG_SEMI_MAJOR_AXIS},
+	[19] = {"gravitational_parameter", CFG_GRAVITATIONAL_PARAMETER},
+	[21] = {"argument_of_periapsis", CFG_ARGUMENT_OF_PERIAPSIS},
+	[22] = {"ut0", CFG_UT0},
+	[26] = {"inclination", CFG_INCLINATION},
+	[28] = {"units", CFG_UNITS},
+	[33] = {"true_anomaly_ut0", CFG_TRUE_ANOMALY_UT0},
+	[34] = {"mean_anomaly_ut0", CFG_MEAN_ANOMALY_UT0},
+	[36] = {"is_homebody", CFG_IS_HOMEBODY},
+	[39] = {"number_of_bodies", CFG_NUMBER_OF_BODIES},
+	[41] = {"north_pole_right_ascension", CFG_NORTH_POLE_RA},
+	[42] = {"parent_body", CFG_PARENT_BODY},
+	[44] = {"j2", CFG_J2},
+	[45] = {"raan", CFG_RAAN},
+	[50] = {"time_scale", CFG_TIME_SCALE},
+	[52] = {"central_body", CFG_CENTRAL_BODY},
+	[53] = {"rotation_ut0", CFG_ROTATION_UT0},
+	[56] = {"atmosphere_altitude", CFG_ATMOSPHERE_ALTITUDE},
+	[59] = {"scale_height", CFG_SCALE_HEIGHT},
+	[60] = {"color", CFG_COLOR},
+	[62] = {"rotational_period", CFG_ROTATIONAL_PERIOD},
+};
+
+static enum CfgKey get_cfg_key(const char *key, size_t len) {
+	if(len == 0) return CFG_KEY_UNKNOWN;
+	const struct CfgKeyEntry *entry = &cfg_key_table[CFG_KEY_HASH(key, len)];
+	if(entry->name == NULL || strncmp(entry->name, key, len) != 0 || entry->name[len] != '\0') return CFG_KEY_UNKNOWN;
+	return entry->key;
+}
+
+typedef struct CfgParser {
+	CelestSystem *system;
+	enum STORED_UNITS units;
+	const char *central_body_name;	// points into the parsed buffer
+	int declared_num_bodies;		// -1 if not given
+	int max_bodies;
+	int section;					// -1: before first section; 0: system; 1: central body; 2...: orbiting bodies
+	int line;
+	const char *line_start;
+	CfgParseError *error;
+	
+	// state of the body currently parsed
+	struct Body *body;
+	double mean_anomaly;
+	double g_asl;
+	int has_mean_anomaly;
+	int has_g_asl;
+	const char *parent_name;
+} CfgParser;
+
+static int cfg_error(CfgParser *parser, const char *pos, const char *message) {
+	if(parser->error != NULL) {
+		parser->error->line = parser->line;
+		parser->error->column = pos != NULL ? (int) (pos - parser->line_start) + 1 : 0;
+		snprintf(parser->error->message, sizeof(parser->error->message), "%s", message);
 	}
 	return 0;
 }
 
-struct Body * load_body_from_config_file(FILE *file, CelestSystem *system, enum STORED_UNITS units) {
-	struct Body *body = new_body();
-	double mean_anomaly = 0;
-	double g_asl = 0;
-	int has_mean_anomaly = 0;
-	int has_g_asl = 0;
-	int has_central_body_name = 0;
-	char central_body_name[50];
-	
-	char line[256];  // Buffer for each line
-	while (fgets(line, sizeof(line), file)) {
-		if(strncmp(line, "[", 1) == 0) {
-			sscanf(line, "[%50[^]]]", body->name);
-		} else if(strcmp(line, "\n") == 0 || strcmp(line,"\r\n") == 0){
-			break;
-		} else {
-			char key[50], value[50];
-			if(get_key_and_value_from_config(key, value, line)) {
-				if (strcmp(key, "color") == 0) {
-					sscanf(value, "[%lf, %lf, %lf]", &body->color[0], &body->color[1], &body->color[2]);
-				} else if (strcmp(key, "id") == 0) {
-					sscanf(value, "%d", &body->id);
-				} else if (strcmp(key, "gravitational_parameter") == 0) {
-					sscanf(value, "%lg", &body->mu);
-				} else if (strcmp(key, "g_asl") == 0) {
-					sscanf(value, "%lg", &g_asl); has_g_asl = 1;
-				} else if (strcmp(key, "radius") == 0) {
-					sscanf(value, "%lf", &body->radius);
-				} else if (strcmp(key, "rotational_period") == 0) {
-					sscanf(value, "%lf", &body->rotation_period);
-				} else if (strcmp(key, "sea_level_pressure") == 0) {
-					sscanf(value, "%lf", &body->sl_atmo_p);
-				} else if (strcmp(key, "scale_height") == 0) {
-					sscanf(value, "%lf", &body->scale_height);
-				} else if (strcmp(key, "atmosphere_altitude") == 0) {
-					sscanf(value, "%lf", &body->atmo_alt);
-				} else if (strcmp(key, "north_pole_right_ascension") == 0) {
-					sscanf(value, "%lf", &body->north_pole_ra);
-					body->north_pole_ra = deg2rad(body->north_pole_ra);
-				} else if (strcmp(key, "north_pole_declination") == 0) {
-					sscanf(value, "%lf", &body->north_pole_decl);
-					body->north_pole_decl = deg2rad(body->north_pole_decl);
-				}  else if (strcmp(key, "rotation_ut0") == 0) {
-					sscanf(value, "%lf", &body->rot_ut0);
-					body->rot_ut0 = deg2rad(body->rot_ut0);
-				}  else if (strcmp(key, "semi_major_axis") == 0) {
-					sscanf(value, "%lf", &body->orbit.a);
-				} else if (strcmp(key, "eccentricity") == 0) {
-					sscanf(value, "%lf", &body->orbit.e);
-				} else if (strcmp(key, "inclination") == 0) {
-					sscanf(value, "%lf", &body->orbit.i);
-					body->orbit.i = deg2rad(body->orbit.i);
-				} else if (strcmp(key, "raan") == 0) {
-					sscanf(value, "%lf", &body->orbit.raan);
-					body->orbit.raan = deg2rad(body->orbit.raan);
-				} else if (strcmp(key, "argument_of_periapsis") == 0) {
-					sscanf(value, "%lf", &body->orbit.arg_peri);
-					body->orbit.arg_peri = deg2rad(body->orbit.arg_peri);
-				} else if (strcmp(key, "true_anomaly_ut0") == 0) {
-					sscanf(value, "%lf", &body->orbit.ta);
-					body->orbit.ta = deg2rad(body->orbit.ta);
-				} else if (strcmp(key, "mean_anomaly_ut0") == 0) {
-					sscanf(value, "%lf", &mean_anomaly);
-					has_mean_anomaly = 1;
-				} else if (strcmp(key, "parent_body") == 0) {
-					sscanf(value, "%s", central_body_name);
-					has_central_body_name = 1;
-				} else if (strcmp(key, "is_homebody") == 0) {
-					char is_homebody[10];
-					sscanf(value, "%s", is_homebody);
-					if (strcmp(is_homebody, "True") == 0) {
-						system->home_body = body;
-					}
-				}
-			}
-		}
+static int cfg_parse_double(CfgParser *parser, const char *value, double *result) {
+	char *end;
+	double d = strtod(value, &end);
+	if(end == value || *end != '\0') return cfg_error(parser, value, "expected number");
+	*result = d;
+	return 1;
+}
+
+static int cfg_parse_angle(CfgParser *parser, const char *value, double *result) {
+	if(!cfg_parse_double(parser, value, result)) return 0;
+	*result = deg2rad(*result);
+	return 1;
+}
+
+static int cfg_parse_int(CfgParser *parser, const char *value, int *result) {
+	char *end;
+	long l = strtol(value, &end, 10);
+	if(end == value || *end != '\0') return cfg_error(parser, value, "expected integer");
+	*result = (int) l;
+	return 1;
+}
+
+static int cfg_parse_color(CfgParser *parser, const char *value, double *color) {
+	const char *p = value;
+	char *end;
+	if(*p++ != '[') return cfg_error(parser, value, "expected color as [r, g, b]");
+	for(int i = 0; i < 3; i++) {
+		color[i] = strtod(p, &end);
+		if(end == p) return cfg_error(parser, p, "expected number");
+		p = end;
+		while(*p == ' ' || *p == '\t') p++;
+		if(*p++ != (i < 2 ? ',' : ']')) return cfg_error(parser, p-1, i < 2 ? "expected ','" : "expected ']'");
+	}
+	return 1;
+}
+
+static int cfg_handle_system_key(CfgParser *parser, enum CfgKey key, const char *value) {
+	CelestSystem *system = parser->system;
+	switch(key) {
+		case CFG_PROPAGATION_METHOD:
+			if(strcmp(value, "EPHEMERIDES") == 0) system->prop_method = EPHEMS;
+			return 1;
+		case CFG_UT0: return cfg_parse_double(parser, value, &system->ut0);
+		case CFG_TIME_SCALE:
+			if(!time_scale_from_string(value, &system->time_scale)) return cfg_error(parser, value, "unknown time scale");
+			return 1;
+		case CFG_NUMBER_OF_BODIES:
+			if(!cfg_parse_int(parser, value, &parser->declared_num_bodies)) return 0;
+			if(parser->declared_num_bodies < 0) return cfg_error(parser, value, "negative number of bodies");
+			return 1;
+		case CFG_CENTRAL_BODY: parser->central_body_name = value; return 1;
+		case CFG_UNITS:
+			if(strcmp(value, "M_DEG_PA") == 0) parser->units = UNITS_M_DEG_PA;
+			return 1;
+		default: return 1;	// unknown keys are ignored
 	}
-	if(units == UNITS_LEGACY) {
+}
+
+static int cfg_handle_body_key(CfgParser *parser, enum CfgKey key, const char *value) {
+	struct Body *body = parser->body;
+	switch(key) {
+		case CFG_COLOR: return cfg_parse_color(parser, value, body->color);
+		case CFG_ID: return cfg_parse_int(parser, value, &body->id);
+		case CFG_GRAVITATIONAL_PARAMETER: return cfg_parse_double(parser, value, &body->mu);
+		case CFG_G_ASL: parser->has_g_asl = 1; return cfg_parse_double(parser, value, &parser->g_asl);
+		case CFG_RADIUS: return cfg_parse_double(parser, value, &body->radius);
+		case CFG_ROTATIONAL_PERIOD: return cfg_parse_double(parser, value, &body->rotation_period);
+		case CFG_SEA_LEVEL_PRESSURE: return cfg_parse_double(parser, value, &body->sl_atmo_p);
+		case CFG_SCALE_HEIGHT: return cfg_parse_double(parser, value, &body->scale_height);
+		case CFG_ATMOSPHERE_ALTITUDE: return cfg_parse_double(parser, value, &body->atmo_alt);
+		case CFG_NORTH_POLE_RA: return cfg_parse_angle(parser, value, &body->north_pole_ra);
+		case CFG_NORTH_POLE_DECL: return cfg_parse_angle(parser, value, &body->north_pole_decl);
+		case CFG_ROTATION_UT0: return cfg_parse_angle(parser, value, &body->rot_ut0);
+		case CFG_J2: return cfg_parse_double(parser, value, &body->j2);
+		case CFG_SEMI_MAJOR_AXIS: return cfg_parse_double(parser, value, &body->orbit.a);
+		case CFG_ECCENTRICITY: return cfg_parse_double(parser, value, &body->orbit.e);
+		case CFG_INCLINATION: return cfg_parse_angle(parser, value, &body->orbit.i);
+		case CFG_RAAN: return cfg_parse_angle(parser, value, &body->orbit.raan);
+		case CFG_ARGUMENT_OF_PERIAPSIS: return cfg_parse_angle(parser, value, &body->orbit.arg_peri);
+		case CFG_TRUE_ANOMALY_UT0: return cfg_parse_angle(parser, value, &body->orbit.ta);
+		case CFG_MEAN_ANOMALY_UT0: parser->has_mean_anomaly = 1; return cfg_parse_double(parser, value, &parser->mean_anomaly);
+		case CFG_PARENT_BODY: parser->parent_name = value; return 1;
+		case CFG_IS_HOMEBODY:
+			if(strcmp(value, "True") == 0) parser->system->home_body = body;
+			return 1;
+		default: return 1;	// unknown keys are ignored
+	}
+}
+
+static int cfg_finish_body(CfgParser *parser) {
+	struct Body *body = parser->body;
+	CelestSystem *system = parser->system;
+	parser->body = NULL;
+	if(body == NULL) return 1;
+	
+	if(parser->units == UNITS_LEGACY) {
 		body->radius *= 1e3;  // Convert from km to m
 		body->sl_atmo_p *= 1e3;  // Convert from kpa to pa
 		body->atmo_alt *= 1e3;  // Convert from km to m
 		body->orbit.a *= 1e3;  // Convert from km to m
 	}
 	
-	if(has_g_asl) body->mu = 9.81*g_asl * body->radius*body->radius;
+	if(parser->has_g_asl) body->mu = 9.81*parser->g_asl * body->radius*body->radius;
 	
-	if(system != NULL) {
-		struct Body *attractor = system->cb;
-		if(has_central_body_name) {
-			struct Body *attr_temp = get_body_by_name(central_body_name, system);
-			if(attr_temp != NULL) attractor = attr_temp;
+	if(parser->section == 1) {
+		system->cb = body;
+		if(parser->central_body_name == NULL || strcmp(parser->central_body_name, body->name) != 0) {
+			parser->line = 0;
+			return cfg_error(parser, NULL, "Central Body not in first position");
 		}
-		
-		body->orbit = constr_orbit_from_elements(
-				body->orbit.a,
-				body->orbit.e,
-				body->orbit.i,
-				body->orbit.raan,
-				body->orbit.arg_peri,
-				has_mean_anomaly ? calc_true_anomaly_from_mean_anomaly(body->orbit, mean_anomaly) : body->orbit.ta,
-				attractor
-		);
+		return 1;
+	}
+	
+	struct Body *attractor = system->cb;
+	if(parser->parent_name != NULL) {
+		struct Body *attr_temp = get_body_by_name((char *) parser->parent_name, system);
+		if(attr_temp != NULL) attractor = attr_temp;
+	}
+	
+	body->orbit = constr_orbit_from_elements(
+			body->orbit.a,
+			body->orbit.e,
+			body->orbit.i,
+			body->orbit.raan,
+			body->orbit.arg_peri,
+			parser->has_mean_anomaly ? calc_true_anomaly_from_mean_anomaly(body->orbit, parser->mean_anomaly) : body->orbit.ta,
+			attractor
+	);
+	
+	if(system->num_bodies == parser->max_bodies) {
+		parser->max_bodies = parser->max_bodies > 0 ? parser->max_bodies*2 : 8;
+		struct Body **temp = allocator_realloc(&system->allocator, system->bodies, parser->max_bodies * sizeof(struct Body*));
+		if(temp == NULL) {allocator_free(&system->allocator, body); return cfg_error(parser, NULL, "out of memory");}
+		system->bodies = temp;
+	}
+	system->bodies[system->num_bodies++] = body;
+	return 1;
+}
+
+static int cfg_begin_section(CfgParser *parser, char *name_start) {
+	if(!cfg_finish_body(parser)) return 0;
+	parser->section++;
+	
+	char *name_end = strchr(name_start, ']');
+	if(name_end == NULL) return cfg_error(parser, name_start + strlen(name_start), "expected ']'");
+	*name_end = '\0';
+	
+	if(parser->section == 0) {
+		snprintf(parser->system->name, sizeof(parser->system->name), "%s", name_start);
+		return 1;
 	}
-	return body;
+	if(parser->section == 1 && parser->declared_num_bodies >= 0 && parser->max_bodies < parser->declared_num_bodies) {
+		parser->max_bodies = parser->declared_num_bodies;
+		parser->system->bodies = allocator_malloc(&parser->system->allocator, (parser->max_bodies > 0 ? parser->max_bodies : 1) * sizeof(struct Body*));
+		if(parser->system->bodies == NULL) return cfg_error(parser, NULL, "out of memory");
+	}
+	// bodies beyond the declared number of bodies are ignored
+	if(parser->declared_num_bodies >= 0 && parser->section-1 > parser->declared_num_bodies) return 1;
+	
+	parser->body = new_body();
+	snprintf(parser->body->name, sizeof(parser->body->name), "%s", name_start);
+	parser->mean_anomaly = 0;
+	parser->g_asl = 0;
+	parser->has_mean_anomaly = 0;
+	parser->has_g_asl = 0;
+	parser->parent_name = NULL;
+	return 1;
 }
 
+static int is_cfg_space(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
 
-CelestSystem * load_celestial_system_from_cfg_file(char *filename) {
-	enum STORED_UNITS units = UNITS_LEGACY;
+static int parse_cfg_buffer(CfgParser *parser, char *buffer, size_t size) {
+	char *p = buffer;
+	char *end = buffer + size;
+	
+	while(p < end) {
+		char *line_end = memchr(p, '\n', end-p);
+		if(line_end == NULL) line_end = end;
+		*line_end = '\0';
+		parser->line++;
+		parser->line_start = p;
+		
+		char *q = p;
+		while(is_cfg_space(*q)) q++;
+		char *last = line_end;
+		while(last > q && is_cfg_space(last[-1])) last--;
+		*last = '\0';
+		
+		if(*q == '[') {
+			if(!cfg_begin_section(parser, q+1)) return 0;
+		} else if(*q != '\0' && *q != '#' && *q != ';') {
+			char *equal_sign = strchr(q, '=');
+			if(equal_sign == NULL) return cfg_error(parser, q, "expected 'key = value'");
+			if(parser->section < 0) return cfg_error(parser, q, "key outside of section");
+			
+			char *key_end = equal_sign;
+			while(key_end > q && is_cfg_space(key_end[-1])) key_end--;
+			char *value = equal_sign+1;
+			while(is_cfg_space(*value)) value++;
+			
+			enum CfgKey key = get_cfg_key(q, key_end-q);
+			int success = 1;
+			if(parser->section == 0) success = cfg_handle_system_key(parser, key, value);
+			else if(parser->body != NULL) success = cfg_handle_body_key(parser, key, value);
+			if(!success) return 0;
+		}
+		p = line_end+1;
+	}
+	
+	if(!cfg_finish_body(parser)) return 0;
+	parser->line = 0;
+	if(parser->system->cb == NULL) return cfg_error(parser, NULL, "Couldn't load Central Body");
+	if(parser->declared_num_bodies >= 0 && parser->system->num_bodies < parser->declared_num_bodies) {
+		if(parser->error != NULL) {
+			parser->error->line = 0;
+			parser->error->column = 0;
+			snprintf(parser->error->message, sizeof(parser->error->message), "expected %d bodies, found %d", parser->declared_num_bodies, parser->system->num_bodies);
+		}
+		return 0;
+	}
+	return 1;
+}
+
+static char * read_file_to_buffer(const char *filepath, size_t *size) {
+	FILE *file = fopen(filepath, "rb");
+	if(file == NULL) return NULL;
 	
+	fseek(file, 0, SEEK_END);
+	long file_size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if(file_size < 0) {fclose(file); return NULL;}
+	
+	char *buffer = orbitlib_malloc(file_size + 1);
+	if(buffer == NULL) {fclose(file); return NULL;}
+	*size = fread(buffer, 1, file_size, file);
+	buffer[*size] = '\0';
+	fclose(file);
+	return buffer;
+}
+
+CelestSystem * load_celestial_system_from_cfg_buffer(char *buffer, size_t size, CfgParseError *error) {
+	TRACE_BEGIN(span, "load_celestial_system_from_cfg_buffer");
 	CelestSystem *system = new_system();
 	system->num_bodies = 0;
 	system->prop_method = ORB_ELEMENTS;
-	char central_body_name[50];
 	
-	FILE *file = fopen(filename, "r");
-	if (!file) {
+	CfgParser parser = {
+			.system = system,
+			.units = UNITS_LEGACY,
+			.declared_num_bodies = -1,
+			.section = -1,
+			.line_start = buffer,
+			.error = error
+	};
+	
+	if(!parse_cfg_buffer(&parser, buffer, size)) {
+		OrbitlibAllocator allocator = system->allocator;
+		allocator_free(&allocator, parser.body);
+		for(int i = 0; i < system->num_bodies; i++) allocator_free(&allocator, system->bodies[i]);
+		allocator_free(&allocator, system->bodies);
+		allocator_free(&allocator, system->cb);
+		allocator_free(&allocator, system);
+		TRACE_END(span);
+		return NULL;
+	}
+	
+	parse_and_sort_into_celestial_subsystems(system);
+	
+	TRACE_END(span);
+	return system;
+}
+
+void load_celestial_system_ephems(CelestSystem *system, const char *ephem_directory) {
+	TRACE_BEGIN(span, "load_celestial_system_ephems");
+	// download window of the default context, so files don't depend on the entry point they were first requested through
+	OrbitlibContext *ctx = get_default_orbitlib_context();
+	for(int i = 0; i < system->num_bodies; i++) {
+		struct Body *body = system->bodies[i];
+		get_body_ephems(body, ctx->ephem_min_date, ctx->ephem_max_date, ctx->ephem_time_step, ephem_directory);
+		// Needed for orbit visualization scale
+		OSV osv = osv_from_ephem(body->ephem, body->num_ephems, system->ut0, body->orbit.cb);
+		body->orbit = constr_orbit_from_osv(osv.r, osv.v, body->orbit.cb);
+		if(body->system != NULL) load_celestial_system_ephems(body->system, ephem_directory);
+	}
+	TRACE_END(span);
+}
+
+static int count_system_bodies(CelestSystem *system) {
+	int num_bodies = system->num_bodies;
+	for(int i = 0; i < system->num_bodies; i++) {
+		if(system->bodies[i]->system != NULL) num_bodies += count_system_bodies(system->bodies[i]->system);
+	}
+	return num_bodies;
+}
+
+static int collect_system_bodies(CelestSystem *system, struct Body **bodies, int num_bodies) {
+	for(int i = 0; i < system->num_bodies; i++) {
+		bodies[num_bodies++] = system->bodies[i];
+		if(system->bodies[i]->system != NULL) num_bodies = collect_system_bodies(system->bodies[i]->system, bodies, num_bodies);
+	}
+	return num_bodies;
+}
+
+typedef struct EphemLoadTask {
+	OrbitlibContext *ctx;
+	struct Body **bodies;
+	double ut0;
+} EphemLoadTask;
+
+static void load_body_ephems_task(void *arg, int index) {
+	EphemLoadTask *task = arg;
+	struct Body *body = task->bodies[index];
+	get_body_ephems_ctx(task->ctx, body);
+	if(body->ephem == NULL || body->num_ephems == 0) return;
+	// Needed for orbit visualization scale
+	OSV osv = osv_from_ephem(body->ephem, body->num_ephems, task->ut0, body->orbit.cb);
+	body->orbit = constr_orbit_from_osv(osv.r, osv.v, body->orbit.cb);
+}
+
+void load_celestial_system_ephems_ctx(OrbitlibContext *ctx, CelestSystem *system) {
+	if(ctx == NULL) ctx = get_default_orbitlib_context();
+	TRACE_BEGIN(span, "load_celestial_system_ephems");
+	OrbitlibContext *prev_ctx = bind_orbitlib_context(ctx);
+	int num_bodies = count_system_bodies(system);
+	struct Body **bodies = orbitlib_malloc(num_bodies * sizeof(struct Body *));
+	if(bodies != NULL) {
+		collect_system_bodies(system, bodies, 0);
+		// bodies are independent of each other -> load in parallel on the context's threads
+		EphemLoadTask task = {ctx, bodies, system->ut0};
+		run_parallel_ctx(ctx, num_bodies, load_body_ephems_task, &task);
+		orbitlib_free(bodies);
+	}
+	bind_orbitlib_context(prev_ctx);
+	TRACE_END(span);
+}
+
+CelestSystem * load_celestial_system_from_cfg_file(char *filename) {
+	return load_celestial_system_from_cfg_file_ctx(get_default_orbitlib_context(), filename);
+}
+
+CelestSystem * load_celestial_system_from_cfg_file_ctx(OrbitlibContext *ctx, const char *filename) {
+	if(ctx == NULL) ctx = get_default_orbitlib_context();
+	TRACE_BEGIN(span, "load_celestial_system_from_cfg_file");
+	OrbitlibContext *prev_ctx = bind_orbitlib_context(ctx);
+	size_t size;
+	char *buffer = read_file_to_buffer(filename, &size);
+	if(buffer == NULL) {
 		perror("Failed to open file");
-		free(system);
+		bind_orbitlib_context(prev_ctx);
+		TRACE_END(span);
 		return NULL;
 	}
 	
-	char line[256];  // Buffer for each line
-	while (fgets(line, sizeof(line), file)) {
-		if(strncmp(line, "[", 1) == 0) {
-			sscanf(line, "[%50[^]]]", system->name);
-		} else if(strcmp(line, "\n") == 0 || strcmp(line, "\r\n") == 0){
-			break;
-		} else {
-			char key[50], value[50];
-			if(get_key_and_value_from_config(key, value, line)) {
-				if (strcmp(key, "propagation_method") == 0) {
-					if(strcmp(value, "EPHEMERIDES") == 0) system->prop_method = EPHEMS;
-				} else if (strcmp(key, "ut0") == 0) {
-					sscanf(value, "%lf", &system->ut0);
-				} else if (strcmp(key, "number_of_bodies") == 0) {
-					sscanf(value, "%d", &system->num_bodies);
-				} else if (strcmp(key, "central_body") == 0) {
-					sprintf(central_body_name, "%s", value);
-				} else if (strcmp(key, "units") == 0) {
-					if(strcmp(value, "M_DEG_PA") == 0) units = UNITS_M_DEG_PA;
-				}
-			}
+	CfgParseError error = {0};
+	CelestSystem *system = load_celestial_system_from_cfg_buffer(buffer, size, &error);
+	if(system == NULL) {
+		if(error.line > 0) fprintf(stderr, "%s:%d:%d: %s\n", filename, error.line, error.column, error.message);
+		else fprintf(stderr, "%s: %s\n", filename, error.message);
+	} else if(system->prop_method == EPHEMS) {
+		load_celestial_system_ephems_ctx(ctx, system);
+	}
+	
+	orbitlib_free(buffer);
+	bind_orbitlib_context(prev_ctx);
+	TRACE_END(span);
+	return system;
+}
+
+
+
+
+
+
+/*
+ * ------------------------------------
+ * Binary Snapshot
+ * ------------------------------------
+ */
+
+#define SNAPSHOT_MAGIC "ORBSNAP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_ENDIAN_CHECK 0x01020304u
+
+// Structs are stored as they are in memory (pointers replaced by index+1; 0 = NULL), so snapshots are only
+// valid for the same struct layout (checked via the sizes and the endianness check in the header)
+typedef struct SnapshotHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t endian_check;
+	uint32_t sizeof_system, sizeof_body, sizeof_ephem, sizeof_pointer;
+	uint32_t num_systems, num_bodies, num_body_ptrs, num_ephems;
+	uint64_t payload_size;
+} SnapshotHeader;
+
+typedef struct SnapshotLayout {
+	CelestSystem *systems;
+	struct Body *bodies;
+	struct Body **body_ptrs;
+	Ephem *ephems;
+	uint32_t num_systems, num_bodies, num_body_ptrs, num_ephems;
+} SnapshotLayout;
+
+static void * encode_snapshot_index(uint32_t idx) {
+	return (void *) (uintptr_t) (idx+1);
+}
+
+static void get_snapshot_layout(SnapshotLayout *layout, void *payload) {
+	char *p = payload;
+	layout->systems = (CelestSystem *) p;
+	p += layout->num_systems * sizeof(CelestSystem);
+	layout->bodies = (struct Body *) p;
+	p += layout->num_bodies * sizeof(struct Body);
+	layout->body_ptrs = (struct Body **) p;
+	p += layout->num_body_ptrs * sizeof(struct Body *);
+	layout->ephems = (Ephem *) p;
+}
+
+static size_t get_snapshot_payload_size(SnapshotLayout *layout) {
+	return layout->num_systems * sizeof(CelestSystem) + layout->num_bodies * sizeof(struct Body) +
+		   layout->num_body_ptrs * sizeof(struct Body *) + layout->num_ephems * sizeof(Ephem);
+}
+
+static void count_snapshot_elements(CelestSystem *system, int include_ephems, SnapshotLayout *layout) {
+	layout->num_systems++;
+	layout->num_body_ptrs += system->num_bodies;
+	for(int i = 0; i < system->num_bodies; i++) {
+		layout->num_bodies++;
+		if(include_ephems && system->bodies[i]->ephem != NULL) layout->num_ephems += system->bodies[i]->num_ephems;
+		if(system->bodies[i]->system != NULL) count_snapshot_elements(system->bodies[i]->system, include_ephems, layout);
+	}
+}
+
+// copies the system and all its subsystems into the layout (counters of layout are used as fill levels)
+static void pack_snapshot_system(CelestSystem *system, uint32_t cb_idx, int include_ephems, SnapshotLayout *layout) {
+	uint32_t sys_idx = layout->num_systems++;
+	uint32_t ptr_offset = layout->num_body_ptrs;
+	layout->num_body_ptrs += system->num_bodies;
+	
+	CelestSystem *packed_system = &layout->systems[sys_idx];
+	*packed_system = *system;
+	packed_system->cb = encode_snapshot_index(cb_idx);
+	packed_system->bodies = system->num_bodies > 0 ? encode_snapshot_index(ptr_offset) : NULL;
+	packed_system->home_body = NULL;
+	packed_system->mem_block = NULL;
+	packed_system->allocator = (OrbitlibAllocator) {NULL, NULL, NULL, NULL};
+	if(!include_ephems) packed_system->prop_method = ORB_ELEMENTS;
+	
+	for(int i = 0; i < system->num_bodies; i++) {
+		struct Body *body = system->bodies[i];
+		uint32_t body_idx = layout->num_bodies++;
+		layout->body_ptrs[ptr_offset + i] = encode_snapshot_index(body_idx);
+		if(system->home_body == body) packed_system->home_body = encode_snapshot_index(body_idx);
+		
+		struct Body *packed_body = &layout->bodies[body_idx];
+		*packed_body = *body;
+		packed_body->orbit.cb = encode_snapshot_index(cb_idx);
+		packed_body->ephem = NULL;
+		packed_body->num_ephems = 0;
+		if(include_ephems && body->ephem != NULL) {
+			packed_body->ephem = encode_snapshot_index(layout->num_ephems);
+			packed_body->num_ephems = body->num_ephems;
+			memcpy(&layout->ephems[layout->num_ephems], body->ephem, body->num_ephems * sizeof(Ephem));
+			layout->num_ephems += body->num_ephems;
+		}
+		if(body->system != NULL) {
+			packed_body->system = encode_snapshot_index(layout->num_systems);
+			pack_snapshot_system(body->system, body_idx, include_ephems, layout);
 		}
 	}
+}
+
+static void * pack_snapshot(CelestSystem *system, int include_ephems, SnapshotLayout *layout) {
+	memset(layout, 0, sizeof(*layout));
+	layout->num_bodies = 1;		// central body of top-level system
+	count_snapshot_elements(system, include_ephems, layout);
 	
-	struct Body *cb = load_body_from_config_file(file, NULL, units);
+	size_t payload_size = get_snapshot_payload_size(layout);
+	void *payload = orbitlib_calloc(1, payload_size);
+	if(payload == NULL) return NULL;
 	
-	if(cb == NULL) {printf("Couldn't load Central Body!\n"); free(system); return NULL;}
-	if(strcmp(central_body_name, cb->name) != 0) {printf("Central Body not in first position!\n"); free(system); free(cb); return NULL;}
+	SnapshotLayout fill = *layout;
+	get_snapshot_layout(&fill, payload);
+	fill.num_systems = fill.num_bodies = fill.num_body_ptrs = fill.num_ephems = 0;
 	
-	system->cb = cb;
-	system->bodies = (struct Body**) calloc(system->num_bodies, sizeof(struct Body*));
-	for(int i = 0; i < system->num_bodies; i++) system->bodies[i] = load_body_from_config_file(file, system, units);
+	uint32_t cb_idx = fill.num_bodies++;
+	fill.bodies[cb_idx] = *system->cb;
+	fill.bodies[cb_idx].orbit.cb = NULL;
+	fill.bodies[cb_idx].ephem = NULL;
+	fill.bodies[cb_idx].num_ephems = 0;
+	fill.bodies[cb_idx].system = encode_snapshot_index(0);
+	pack_snapshot_system(system, cb_idx, include_ephems, &fill);
 	
-	if(system->prop_method == EPHEMS) {
-		for(int i = 0; i < system->num_bodies; i++) {
-			get_body_ephems(system->bodies[i], (Datetime){1950,1,1}, (Datetime){2100,1,1}, (Datetime){0,1}, "../Ephemerides");
-			// Needed for orbit visualization scale
-			OSV osv = osv_from_ephem(system->bodies[i]->ephem, system->bodies[i]->num_ephems, system->ut0, system->bodies[i]->orbit.cb);
-			system->bodies[i]->orbit = constr_orbit_from_osv(osv.r, osv.v, system->bodies[i]->orbit.cb);
-		}
+	get_snapshot_layout(layout, payload);
+	return payload;
+}
+
+// replaces the stored indices by pointers into the payload; returns 0 if an index is out of bounds
+static int fixup_snapshot_pointer(void **ptr, void *base, size_t elem_size, uint32_t num_elements) {
+	uintptr_t idx = (uintptr_t) *ptr;
+	if(idx == 0) return 1;
+	if(idx > num_elements) return 0;
+	*ptr = (char *) base + (idx-1) * elem_size;
+	return 1;
+}
+
+static CelestSystem * fixup_snapshot(void *payload, SnapshotLayout *layout) {
+	get_snapshot_layout(layout, payload);
+	int valid = layout->num_systems > 0 && layout->num_bodies > 0;
+	
+	for(uint32_t i = 0; i < layout->num_systems && valid; i++) {
+		CelestSystem *system = &layout->systems[i];
+		valid &= fixup_snapshot_pointer((void **) &system->cb, layout->bodies, sizeof(struct Body), layout->num_bodies);
+		valid &= fixup_snapshot_pointer((void **) &system->home_body, layout->bodies, sizeof(struct Body), layout->num_bodies);
+		valid &= fixup_snapshot_pointer((void **) &system->bodies, layout->body_ptrs, sizeof(struct Body *), layout->num_body_ptrs);
+		valid &= system->cb != NULL && system->num_bodies >= 0;
+		if(valid && system->num_bodies > 0) valid &= system->bodies != NULL && system->bodies - layout->body_ptrs + system->num_bodies <= layout->num_body_ptrs;
+		system->mem_block = NULL;
+		system->allocator = get_orbitlib_allocator();	// payload is allocated with the current allocator
 	}
+	for(uint32_t i = 0; i < layout->num_body_ptrs && valid; i++) {
+		valid &= fixup_snapshot_pointer((void **) &layout->body_ptrs[i], layout->bodies, sizeof(struct Body), layout->num_bodies);
+	}
+	for(uint32_t i = 0; i < layout->num_bodies && valid; i++) {
+		struct Body *body = &layout->bodies[i];
+		valid &= fixup_snapshot_pointer((void **) &body->orbit.cb, layout->bodies, sizeof(struct Body), layout->num_bodies);
+		valid &= fixup_snapshot_pointer((void **) &body->system, layout->systems, sizeof(CelestSystem), layout->num_systems);
+		valid &= fixup_snapshot_pointer((void **) &body->ephem, layout->ephems, sizeof(Ephem), layout->num_ephems);
+		if(valid && body->ephem != NULL) valid &= body->num_ephems >= 0 && body->ephem - layout->ephems + body->num_ephems <= layout->num_ephems;
+	}
+	if(!valid) return NULL;
 	
-	parse_and_sort_into_celestial_subsystems(system);
+	layout->systems[0].mem_block = payload;
+	return &layout->systems[0];
+}
+
+int save_celestial_system_snapshot(CelestSystem *system, const char *filepath, int include_ephems) {
+	SnapshotLayout layout;
+	void *payload = pack_snapshot(system, include_ephems, &layout);
+	if(payload == NULL) return 0;
 	
+	SnapshotHeader header = {
+			.magic = SNAPSHOT_MAGIC,
+			.version = SNAPSHOT_VERSION,
+			.endian_check = SNAPSHOT_ENDIAN_CHECK,
+			.sizeof_system = sizeof(CelestSystem),
+			.sizeof_body = sizeof(struct Body),
+			.sizeof_ephem = sizeof(Ephem),
+			.sizeof_pointer = sizeof(void *),
+			.num_systems = layout.num_systems,
+			.num_bodies = layout.num_bodies,
+			.num_body_ptrs = layout.num_body_ptrs,
+			.num_ephems = layout.num_ephems,
+			.payload_size = get_snapshot_payload_size(&layout)
+	};
+	
+	FILE *file = fopen(filepath, "wb");
+	if(file == NULL) {
+		perror("Unable to open snapshot file");
+		orbitlib_free(payload);
+		return 0;
+	}
+	int success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(payload, 1, header.payload_size, file) == header.payload_size;
 	fclose(file);
+	orbitlib_free(payload);
+	return success;
+}
+
+CelestSystem * load_celestial_system_snapshot(const char *filepath) {
+	FILE *file = fopen(filepath, "rb");
+	if(file == NULL) return NULL;
 	
+	SnapshotHeader header;
+	if(fread(&header, sizeof(header), 1, file) != 1 ||
+	   memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+	   header.version != SNAPSHOT_VERSION ||
+	   header.endian_check != SNAPSHOT_ENDIAN_CHECK ||
+	   header.sizeof_system != sizeof(CelestSystem) ||
+	   header.sizeof_body != sizeof(struct Body) ||
+	   header.sizeof_ephem != sizeof(Ephem) ||
+	   header.sizeof_pointer != sizeof(void *)) {
+		fclose(file);
+		return NULL;
+	}
+	
+	SnapshotLayout layout = {
+			.num_systems = header.num_systems,
+			.num_bodies = header.num_bodies,
+			.num_body_ptrs = header.num_body_ptrs,
+			.num_ephems = header.num_ephems
+	};
+	if(header.payload_size != get_snapshot_payload_size(&layout)) {
+		fclose(file);
+		return NULL;
+	}
+	
+	void *payload = orbitlib_malloc(header.payload_size);
+	if(payload == NULL || fread(payload, 1, header.payload_size, file) != header.payload_size) {
+		orbitlib_free(payload);
+		fclose(file);
+		return NULL;
+	}
+	fclose(file);
+	
+	CelestSystem *system = fixup_snapshot(payload, &layout);
+	if(system == NULL) orbitlib_free(payload);
 	return system;
 }
 
+CelestSystem * clone_celestial_system(CelestSystem *system, int include_ephems) {
+	SnapshotLayout layout;
+	void *payload = pack_snapshot(system, include_ephems, &layout);
+	if(payload == NULL) return NULL;
+	
+	CelestSystem *clone = fixup_snapshot(payload, &layout);
+	if(clone == NULL) orbitlib_free(payload);
+	return clone;
+}
 
 
 
@@ -351,6 +882,14 @@ int ends_with(const char *filename, const char *ext) {
 	return len >= ext_len && strcmp(filename + len - ext_len, ext) == 0;
 }
 
+// Copy of the string allocated with the current allocator
+static char *copy_filename(const char *filename) {
+	size_t len = strlen(filename) + 1;
+	char *copy = orbitlib_malloc(len);
+	if(copy != NULL) memcpy(copy, filename, len);
+	return copy;
+}
+
 // List matching files in 'path' with given 'extension'
 // Returns an array of strings and fills *count
 char **list_files_with_extension(const char *path, const char *extension, int *count) {
@@ -359,7 +898,7 @@ char **list_files_with_extension(const char *path, const char *extension, int *c
 	char **results = NULL;
 	int capacity = 10;
 	int found = 0;
-	results = malloc(capacity * sizeof(char*));
+	results = orbitlib_malloc(capacity * sizeof(char*));
 	if (!results) return NULL;
 
 #ifdef _WIN32
@@ -375,10 +914,10 @@ char **list_files_with_extension(const char *path, const char *extension, int *c
                 if (ends_with(fd.cFileName, extension)) {
                     if (found >= capacity) {
                         capacity *= 2;
-                        results = realloc(results, capacity * sizeof(char*));
+                        results = orbitlib_realloc(results, capacity * sizeof(char*));
                         if (!results) return NULL;
                     }
-                    results[found++] = _strdup(fd.cFileName);  // Windows-specific strdup
+                    results[found++] = copy_filename(fd.cFileName);
                 }
             }
         } while (FindNextFileA(hFind, &fd));
@@ -389,7 +928,7 @@ char **list_files_with_extension(const char *path, const char *extension, int *c
 	DIR *dir = opendir(path);
 	if (!dir) {
 		perror("opendir failed");
-		free(results);
+		orbitlib_free(results);
 		return NULL;
 	}
 	
@@ -407,10 +946,10 @@ char **list_files_with_extension(const char *path, const char *extension, int *c
 			if (ends_with(entry->d_name, extension)) {
 				if (found >= capacity) {
 					capacity *= 2;
-					results = realloc(results, capacity * sizeof(char*));
+					results = orbitlib_realloc(results, capacity * sizeof(char*));
 					if (!results) return NULL;
 				}
-				results[found++] = strdup(entry->d_name);  // POSIX strdup
+				results[found++] = copy_filename(entry->d_name);
 			}
 		}
 	}
@@ -0,0 +1,437 @@
+#include "orbitlib_matrix.h"
+#include "orbitlib_window.h"
+#include "context_internal.h"
+#include "trace_internal.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define TRANSFER_MATRIX_MAGIC "ORBTMAT"
+#define TRANSFER_MATRIX_VERSION 1
+#define TRANSFER_MATRIX_ENDIAN_CHECK 0x01020304u
+
+// Header at the start of the memory block (and the file), followed by the bodies, groups, entries and windows.
+// All records consist of fixed-width fields with sizes in multiples of 8 bytes, so the tables are aligned without padding.
+typedef struct TransferMatrixHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t endian_check;
+	uint32_t sizeof_body, sizeof_group, sizeof_entry, sizeof_window;
+	uint32_t num_bodies, num_groups, max_windows, reserved;
+	uint64_t num_entries;
+	uint64_t data_size;
+	double min_departure_epoch, max_departure_epoch;
+} TransferMatrixHeader;
+
+typedef struct TransferMatrixBuild {
+	OrbitlibContext *ctx;
+	const TransferMatrixParams *params;
+	TransferMatrixBody *bodies;
+	TransferMatrixGroup *groups;
+	TransferMatrixEntry *entries;
+	TransferMatrixWindow *windows;
+	Body **body_ptrs;		// bodies of the matrix (same order)
+	uint32_t num_bodies, num_groups;
+	uint64_t num_entries;
+} TransferMatrixBuild;
+
+
+TransferMatrixParams get_default_transfer_matrix_params() {
+	TransferMatrixParams params = {
+			.min_departure_epoch = 0,
+			.max_departure_epoch = 0,
+			.min_duration_factor = 0.5,
+			.max_duration_factor = 1.5,
+			.seeds_per_synodic_period = 8,
+			.max_departure_seeds = 256,
+			.num_duration_seeds = 6,
+			.max_windows = 4,
+			.transfer_type = circcap,
+			.departure_altitude = 200e3,
+			.arrival_altitude = 200e3
+	};
+	return params;
+}
+
+
+/*
+ * ------------------------------------
+ * Layout
+ * ------------------------------------
+ */
+
+// a*b+c (0 if it overflows)
+static int add_product_u64(uint64_t a, uint64_t b, uint64_t c, uint64_t *result) {
+	if(b != 0 && a > (UINT64_MAX - c) / b) return 0;
+	*result = a*b + c;
+	return 1;
+}
+
+// size of the memory block of a matrix with these dimensions (0 if it overflows 64 bits or size_t)
+static uint64_t get_transfer_matrix_data_size(uint64_t num_bodies, uint64_t num_groups, uint64_t num_entries, uint64_t max_windows) {
+	uint64_t entry_size, size = sizeof(TransferMatrixHeader);
+	if(!add_product_u64(max_windows, sizeof(TransferMatrixWindow), sizeof(TransferMatrixEntry), &entry_size) ||
+	   !add_product_u64(num_bodies, sizeof(TransferMatrixBody), size, &size) ||
+	   !add_product_u64(num_groups, sizeof(TransferMatrixGroup), size, &size) ||
+	   !add_product_u64(num_entries, entry_size, size, &size) ||
+	   size > SIZE_MAX) {
+		return 0;
+	}
+	return size;
+}
+
+// points the tables of the matrix into its memory block (sizes taken from the header)
+static void set_transfer_matrix_tables(TransferMatrix *matrix) {
+	const TransferMatrixHeader *header = matrix->data;
+	const char *p = (const char *) matrix->data + sizeof(TransferMatrixHeader);
+	matrix->bodies = (const TransferMatrixBody *) p;
+	p += header->num_bodies * sizeof(TransferMatrixBody);
+	matrix->groups = (const TransferMatrixGroup *) p;
+	p += header->num_groups * sizeof(TransferMatrixGroup);
+	matrix->entries = (const TransferMatrixEntry *) p;
+	p += header->num_entries * sizeof(TransferMatrixEntry);
+	matrix->windows = (const TransferMatrixWindow *) p;
+	matrix->num_bodies = (int) header->num_bodies;
+	matrix->num_groups = (int) header->num_groups;
+	matrix->max_windows = (int) header->max_windows;
+	matrix->min_departure_epoch = header->min_departure_epoch;
+	matrix->max_departure_epoch = header->max_departure_epoch;
+}
+
+// checks the header, that all group and body indices stay within the tables and that no entry claims more windows than
+// stored (queries don't check them again)
+static int is_transfer_matrix_valid(const void *data, size_t size) {
+	const TransferMatrixHeader *header = data;
+	if(size < sizeof(TransferMatrixHeader) ||
+	   memcmp(header->magic, TRANSFER_MATRIX_MAGIC, sizeof(TRANSFER_MATRIX_MAGIC)) != 0 ||
+	   header->version != TRANSFER_MATRIX_VERSION ||
+	   header->endian_check != TRANSFER_MATRIX_ENDIAN_CHECK ||
+	   header->sizeof_body != sizeof(TransferMatrixBody) ||
+	   header->sizeof_group != sizeof(TransferMatrixGroup) ||
+	   header->sizeof_entry != sizeof(TransferMatrixEntry) ||
+	   header->sizeof_window != sizeof(TransferMatrixWindow) ||
+	   header->data_size != size ||
+	   get_transfer_matrix_data_size(header->num_bodies, header->num_groups, header->num_entries, header->max_windows) != size) {
+		return 0;
+	}
+
+	TransferMatrix matrix = {.data = (void *) data};
+	set_transfer_matrix_tables(&matrix);
+	for(int i = 0; i < matrix.num_groups; i++) {
+		const TransferMatrixGroup *group = &matrix.groups[i];
+		if(group->first_body < 0 || group->num_bodies < 0 || (uint64_t) group->first_body + group->num_bodies > header->num_bodies ||
+		   group->first_entry > header->num_entries ||
+		   (uint64_t) group->num_bodies * group->num_bodies > header->num_entries - group->first_entry) {
+			return 0;
+		}
+	}
+	for(int i = 0; i < matrix.num_bodies; i++) {
+		const TransferMatrixBody *body = &matrix.bodies[i];
+		if(body->group < 0 || body->group >= matrix.num_groups || body->index < 0 || body->index >= matrix.groups[body->group].num_bodies) return 0;
+	}
+	for(uint64_t i = 0; i < header->num_entries; i++) {
+		int32_t num_windows = matrix.entries[i].num_windows;
+		if(num_windows < 0 || (uint32_t) num_windows > header->max_windows) return 0;
+	}
+	return 1;
+}
+
+
+/*
+ * ------------------------------------
+ * Precomputation
+ * ------------------------------------
+ */
+
+static void count_transfer_matrix_groups(CelestSystem *system, TransferMatrixBuild *build) {
+	if(system->num_bodies > 0) {
+		build->num_groups++;
+		build->num_bodies += system->num_bodies;
+		build->num_entries += (uint64_t) system->num_bodies * system->num_bodies;
+	}
+	for(int i = 0; i < system->num_bodies; i++) {
+		if(system->bodies[i]->system != NULL) count_transfer_matrix_groups(system->bodies[i]->system, build);
+	}
+}
+
+// fills the groups and bodies of the system and its subsystems (counters of build are used as fill levels)
+static void fill_transfer_matrix_groups(CelestSystem *system, TransferMatrixBuild *build) {
+	if(system->num_bodies > 0) {
+		uint32_t group_idx = build->num_groups++;
+		TransferMatrixGroup *group = &build->groups[group_idx];
+		snprintf(group->cb_name, sizeof(group->cb_name), "%s", system->cb->name);
+		group->first_body = (int32_t) build->num_bodies;
+		group->num_bodies = system->num_bodies;
+		group->first_entry = build->num_entries;
+		build->num_entries += (uint64_t) system->num_bodies * system->num_bodies;
+
+		for(int i = 0; i < system->num_bodies; i++) {
+			uint32_t body_idx = build->num_bodies++;
+			TransferMatrixBody *body = &build->bodies[body_idx];
+			snprintf(body->name, sizeof(body->name), "%s", system->bodies[i]->name);
+			body->id = system->bodies[i]->id;
+			body->group = (int32_t) group_idx;
+			body->index = i;
+			build->body_ptrs[body_idx] = system->bodies[i];
+		}
+	}
+	for(int i = 0; i < system->num_bodies; i++) {
+		if(system->bodies[i]->system != NULL) fill_transfer_matrix_groups(system->bodies[i]->system, build);
+	}
+}
+
+// last group starting at or before the entry
+static const TransferMatrixGroup * find_entry_group(const TransferMatrixBuild *build, uint64_t entry_idx) {
+	uint32_t lo = 0, hi = build->num_groups;
+	while(hi - lo > 1) {
+		uint32_t mid = (lo + hi) / 2;
+		if(build->groups[mid].first_entry <= entry_idx) lo = mid;
+		else hi = mid;
+	}
+	return &build->groups[lo];
+}
+
+static void build_transfer_matrix_entry_task(void *arg, int index) {
+	TransferMatrixBuild *build = arg;
+	const TransferMatrixParams *params = build->params;
+	const TransferMatrixGroup *group = find_entry_group(build, index);
+	uint64_t local_idx = index - group->first_entry;
+	int i = (int) (local_idx / group->num_bodies), j = (int) (local_idx % group->num_bodies);
+	TransferMatrixEntry *entry = &build->entries[index];
+	if(i == j) return;
+
+	Body *dep_body = build->body_ptrs[group->first_body + i], *arr_body = build->body_ptrs[group->first_body + j];
+	Hohmann hohmann = calc_hohmann_transfer(dep_body->orbit.a, arr_body->orbit.a, dep_body->orbit.cb);
+	entry->hohmann_duration = hohmann.dur;
+	entry->hohmann_dv_departure = hohmann.dv_dep;
+	entry->hohmann_dv_arrival = hohmann.dv_arr;
+	if(params->max_windows <= 0 || !isfinite(hohmann.dur)) return;
+
+	// departure seeds resolving every synodic period (the pair's geometry repeats after it)
+	double horizon = params->max_departure_epoch - params->min_departure_epoch;
+	double num_periods = horizon / (calc_synodic_period(dep_body, arr_body) / 86400);
+	double num_seeds = fmin(ceil(num_periods * params->seeds_per_synodic_period) + 1, params->max_departure_seeds);
+
+	TransferOptimParams optim_params = get_default_transfer_optim_params();
+	optim_params.departure_body = dep_body;
+	optim_params.arrival_body = arr_body;
+	optim_params.transfer_type = params->transfer_type;
+	optim_params.departure_altitude = params->departure_altitude;
+	optim_params.arrival_altitude = params->arrival_altitude;
+	optim_params.min_departure_epoch = params->min_departure_epoch;
+	optim_params.max_departure_epoch = params->max_departure_epoch;
+	optim_params.min_duration = params->min_duration_factor * hohmann.dur / 86400;
+	optim_params.max_duration = params->max_duration_factor * hohmann.dur / 86400;
+	optim_params.num_departure_seeds = (int) fmax(num_seeds, 2);
+	optim_params.num_duration_seeds = params->num_duration_seeds;
+
+	TransferOptimResult *results = orbitlib_malloc(params->max_windows * sizeof(TransferOptimResult));
+	if(results == NULL) return;
+	// runs serially, as this task already is on the context's threads
+	int num_results = search_optimal_transfers(build->ctx, &optim_params, results, params->max_windows);
+	TransferMatrixWindow *windows = &build->windows[(uint64_t) index * params->max_windows];
+	for(int k = 0; k < num_results; k++) {
+		windows[k] = (TransferMatrixWindow) {results[k].departure_epoch, results[k].duration, results[k].dv_departure, results[k].dv_arrival, results[k].dv};
+	}
+	entry->num_windows = num_results;
+	orbitlib_free(results);
+}
+
+TransferMatrix * build_transfer_matrix(OrbitlibContext *ctx, CelestSystem *system, const TransferMatrixParams *params) {
+	if(system == NULL || params->max_windows < 0 || params->max_departure_epoch < params->min_departure_epoch ||
+	   params->min_duration_factor <= 0 || params->max_duration_factor < params->min_duration_factor ||
+	   params->seeds_per_synodic_period <= 0 || params->max_departure_seeds < 2 || params->num_duration_seeds <= 0) {
+		fprintf(stderr, "Invalid transfer matrix parameters\n");
+		return NULL;
+	}
+	if(ctx == NULL) ctx = get_default_orbitlib_context();
+
+	TransferMatrixBuild build = {.ctx = ctx, .params = params};
+	count_transfer_matrix_groups(system, &build);
+	if(build.num_entries > INT32_MAX) {
+		fprintf(stderr, "Transfer matrix too large\n");
+		return NULL;
+	}
+	TRACE_BEGIN(span, "build_transfer_matrix");
+
+	size_t data_size = get_transfer_matrix_data_size(build.num_bodies, build.num_groups, build.num_entries, params->max_windows);
+	if(data_size == 0) {
+		fprintf(stderr, "Transfer matrix too large\n");
+		TRACE_END(span);
+		return NULL;
+	}
+	TransferMatrix *matrix = orbitlib_malloc(sizeof(TransferMatrix));
+	void *data = orbitlib_calloc(1, data_size);
+	build.body_ptrs = orbitlib_malloc((build.num_bodies > 0 ? build.num_bodies : 1) * sizeof(Body *));
+	if(matrix == NULL || data == NULL || build.body_ptrs == NULL) {
+		orbitlib_free(build.body_ptrs);
+		orbitlib_free(data);
+		orbitlib_free(matrix);
+		TRACE_END(span);
+		return NULL;
+	}
+
+	TransferMatrixHeader *header = data;
+	*header = (TransferMatrixHeader) {
+			.magic = TRANSFER_MATRIX_MAGIC,
+			.version = TRANSFER_MATRIX_VERSION,
+			.endian_check = TRANSFER_MATRIX_ENDIAN_CHECK,
+			.sizeof_body = sizeof(TransferMatrixBody),
+			.sizeof_group = sizeof(TransferMatrixGroup),
+			.sizeof_entry = sizeof(TransferMatrixEntry),
+			.sizeof_window = sizeof(TransferMatrixWindow),
+			.num_bodies = build.num_bodies,
+			.num_groups = build.num_groups,
+			.max_windows = (uint32_t) params->max_windows,
+			.num_entries = build.num_entries,
+			.data_size = data_size,
+			.min_departure_epoch = params->min_departure_epoch,
+			.max_departure_epoch = params->max_departure_epoch
+	};
+	*matrix = (TransferMatrix) {.data = data, .data_size = data_size, .is_mapped = 0};
+	set_transfer_matrix_tables(matrix);
+
+	// tables are written through the build (the matrix only exposes them read-only)
+	build.bodies = (TransferMatrixBody *) matrix->bodies;
+	build.groups = (TransferMatrixGroup *) matrix->groups;
+	build.entries = (TransferMatrixEntry *) matrix->entries;
+	build.windows = (TransferMatrixWindow *) matrix->windows;
+	build.num_bodies = build.num_groups = 0;
+	build.num_entries = 0;
+	fill_transfer_matrix_groups(system, &build);
+
+	run_parallel_ctx(ctx, (int) build.num_entries, build_transfer_matrix_entry_task, &build);
+
+	orbitlib_free(build.body_ptrs);
+	TRACE_END(span);
+	return matrix;
+}
+
+
+/*
+ * ------------------------------------
+ * File
+ * ------------------------------------
+ */
+
+int save_transfer_matrix(const TransferMatrix *matrix, const char *filepath) {
+	FILE *file = fopen(filepath, "wb");
+	if(file == NULL) {
+		perror("Unable to open transfer matrix file");
+		return 0;
+	}
+	int success = fwrite(matrix->data, 1, matrix->data_size, file) == matrix->data_size;
+	if(fclose(file) != 0) success = 0;
+	return success;
+}
+
+// maps the whole file read-only (NULL if it can't be mapped)
+static void * map_file(const char *filepath, size_t *size) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE) return NULL;
+	LARGE_INTEGER file_size;
+	if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 || (uint64_t) file_size.QuadPart > SIZE_MAX) {
+		CloseHandle(file);
+		return NULL;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if(mapping == NULL) return NULL;
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);	// the view keeps the mapping alive
+	if(data == NULL) return NULL;
+	*size = (size_t) file_size.QuadPart;
+	return data;
+#else
+	int fd = open(filepath, O_RDONLY);
+	if(fd < 0) return NULL;
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return NULL;
+	}
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);	// the mapping stays valid
+	if(data == MAP_FAILED) return NULL;
+	*size = st.st_size;
+	return data;
+#endif
+}
+
+static void unmap_file(void *data, size_t size) {
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+#else
+	munmap(data, size);
+#endif
+}
+
+TransferMatrix * load_transfer_matrix(const char *filepath) {
+	size_t size;
+	void *data = map_file(filepath, &size);
+	if(data == NULL) return NULL;
+
+	TransferMatrix *matrix = is_transfer_matrix_valid(data, size) ? orbitlib_malloc(sizeof(TransferMatrix)) : NULL;
+	if(matrix == NULL) {
+		unmap_file(data, size);
+		return NULL;
+	}
+	*matrix = (TransferMatrix) {.data = data, .data_size = size, .is_mapped = 1};
+	set_transfer_matrix_tables(matrix);
+	return matrix;
+}
+
+void free_transfer_matrix(TransferMatrix *matrix) {
+	if(matrix == NULL) return;
+	if(matrix->is_mapped) unmap_file(matrix->data, matrix->data_size);
+	else orbitlib_free(matrix->data);
+	orbitlib_free(matrix);
+}
+
+
+/*
+ * ------------------------------------
+ * Queries
+ * ------------------------------------
+ */
+
+int find_transfer_matrix_body(const TransferMatrix *matrix, const char *name) {
+	for(int i = 0; i < matrix->num_bodies; i++) {
+		if(strncmp(matrix->bodies[i].name, name, sizeof(matrix->bodies[i].name)) == 0) return i;
+	}
+	return -1;
+}
+
+// index of the entry of the pair (-1 if there is none)
+static int64_t get_transfer_matrix_entry_idx(const TransferMatrix *matrix, int departure_body, int arrival_body) {
+	if(departure_body < 0 || arrival_body < 0 || departure_body >= matrix->num_bodies || arrival_body >= matrix->num_bodies) return -1;
+	const TransferMatrixBody *dep_body = &matrix->bodies[departure_body], *arr_body = &matrix->bodies[arrival_body];
+	if(dep_body->group != arr_body->group) return -1;
+	const TransferMatrixGroup *group = &matrix->groups[dep_body->group];
+	return (int64_t) (group->first_entry + (uint64_t) dep_body->index * group->num_bodies + arr_body->index);
+}
+
+const TransferMatrixEntry * get_transfer_matrix_entry(const TransferMatrix *matrix, int departure_body, int arrival_body) {
+	int64_t entry_idx = get_transfer_matrix_entry_idx(matrix, departure_body, arrival_body);
+	return entry_idx >= 0 ? &matrix->entries[entry_idx] : NULL;
+}
+
+const TransferMatrixWindow * get_transfer_matrix_windows(const TransferMatrix *matrix, int departure_body, int arrival_body, int *num_windows) {
+	int64_t entry_idx = get_transfer_matrix_entry_idx(matrix, departure_body, arrival_body);
+	if(entry_idx < 0) {
+		*num_windows = 0;
+		return NULL;
+	}
+	*num_windows = matrix->entries[entry_idx].num_windows;
+	return &matrix->windows[entry_idx * matrix->max_windows];
+}
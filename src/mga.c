@@ -0,0 +1,261 @@
+#include "orbitlib_mga.h"
+#include "orbitlib_datetime.h"
+#include "context_internal.h"
+#include "trace_internal.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+
+
+typedef struct MgaSearch {
+	const MgaSearchParams *params;
+	Body *cb;
+	Body **next_bodies;		// flyby bodies followed by the arrival body
+	int num_next_bodies;
+	int num_departure_epochs;
+	int num_leg_durations;
+
+	OrbitlibMutex results_mutex;
+	MgaTrajectory *results;
+	int num_results;
+	_Atomic double dv_bound;	// total delta-v a trajectory has to undercut to get into the results
+	atomic_llong num_legs, num_pruned;
+} MgaSearch;
+
+// state of the depth-first search of one subtree
+typedef struct MgaBranch {
+	MgaTrajectory trajectory;
+	int64_t num_legs, num_pruned;
+} MgaBranch;
+
+
+MgaSearchParams get_default_mga_search_params() {
+	MgaSearchParams params = {
+			.departure_body = NULL,
+			.arrival_body = NULL,
+			.flyby_bodies = NULL,
+			.num_flyby_bodies = 0,
+			.max_flybys = 2,
+			.min_departure_epoch = 0,
+			.max_departure_epoch = 0,
+			.departure_epoch_step = 10,
+			.min_leg_duration = 30,
+			.max_leg_duration = 1500,
+			.leg_duration_step = 10,
+			.max_duration = 0,
+			.transfer_type = circcap,
+			.departure_altitude = 200e3,
+			.arrival_altitude = 200e3,
+			.min_flyby_altitude = 0,
+			.max_vinf_mismatch = 100,
+			.max_dv = INFINITY,
+			.max_results = 10
+	};
+	return params;
+}
+
+
+/*
+ * ------------------------------------
+ * Results
+ * ------------------------------------
+ */
+
+static int is_same_sequence(const MgaTrajectory *a, const MgaTrajectory *b) {
+	if(a->num_bodies != b->num_bodies) return 0;
+	for(int i = 0; i < a->num_bodies; i++) if(a->bodies[i] != b->bodies[i]) return 0;
+	return 1;
+}
+
+static void submit_mga_trajectory(MgaSearch *search, const MgaTrajectory *trajectory) {
+	int max_results = search->params->max_results;
+	orbitlib_mutex_lock(&search->results_mutex);
+
+	// only the best trajectory per sequence (neighbouring dates of the same sequence would fill up the results otherwise)
+	int idx = search->num_results;
+	for(int i = 0; i < search->num_results; i++) {
+		if(is_same_sequence(&search->results[i], trajectory)) {idx = i; break;}
+	}
+	if(idx < search->num_results && search->results[idx].dv <= trajectory->dv) {
+		orbitlib_mutex_unlock(&search->results_mutex);
+		return;
+	}
+	if(idx == max_results) {
+		if(search->results[max_results-1].dv <= trajectory->dv) {
+			orbitlib_mutex_unlock(&search->results_mutex);
+			return;
+		}
+		idx = max_results-1;
+	} else if(idx == search->num_results) {
+		search->num_results++;
+	}
+
+	// move to sorted position
+	while(idx > 0 && search->results[idx-1].dv > trajectory->dv) {
+		search->results[idx] = search->results[idx-1];
+		idx--;
+	}
+	search->results[idx] = *trajectory;
+
+	if(search->num_results == max_results) atomic_store(&search->dv_bound, search->results[max_results-1].dv);
+	orbitlib_mutex_unlock(&search->results_mutex);
+}
+
+
+/*
+ * ------------------------------------
+ * Search
+ * ------------------------------------
+ */
+
+// expands the leg from the last body of the branch's trajectory (state osv0; v_arr: heliocentric arrival velocity, ignored at departure)
+static void expand_mga_branch(MgaSearch *search, MgaBranch *branch, OSV osv0, Vector3 v_arr, double dv, int first_body_idx, int last_body_idx) {
+	const MgaSearchParams *params = search->params;
+	MgaTrajectory *trajectory = &branch->trajectory;
+	int depth = trajectory->num_bodies - 1;
+	Body *body = trajectory->bodies[depth];
+	double epoch0 = trajectory->epochs[depth];
+
+	// after the maximum number of flybys, only the arrival body is left
+	if(depth >= params->max_flybys) first_body_idx = search->num_next_bodies-1;
+
+	for(int b = first_body_idx; b <= last_body_idx; b++) {
+		Body *next_body = search->next_bodies[b];
+		int is_arrival = b == search->num_next_bodies-1;
+
+		for(int d = 0; d < search->num_leg_durations; d++) {
+			double leg_duration = params->min_leg_duration + d * params->leg_duration_step;
+			double epoch1 = epoch0 + leg_duration;
+			if(params->max_duration > 0 && epoch1 - trajectory->epochs[0] > params->max_duration) break;
+
+			OSV osv1 = get_body_osv(next_body, epoch1);
+			Lambert3 leg = calc_lambert3(osv0.r, osv1.r, leg_duration * 86400, search->cb);
+			branch->num_legs++;
+			if(leg.success != LAMBERT_SUCCESS) {branch->num_pruned++; continue;}
+
+			double vinf_out = mag_vec3(subtract_vec3(leg.v0, osv0.v));
+			double leg_dv;
+			if(depth == 0) {
+				leg_dv = dv_departure(body, body->radius + params->departure_altitude, vinf_out, params->transfer_type);
+				trajectory->vinf[0] = vinf_out;
+			} else {
+				// powered flyby: difference in excess speed has to be made up by a maneuver
+				double vinf_in = mag_vec3(subtract_vec3(v_arr, osv0.v));
+				leg_dv = fabs(vinf_out - vinf_in);
+				if(leg_dv > params->max_vinf_mismatch ||
+				   get_flyby_periapsis(v_arr, leg.v0, osv0.v, body) < body->radius + body->atmo_alt + params->min_flyby_altitude) {
+					branch->num_pruned++;
+					continue;
+				}
+			}
+
+			double leg_total_dv = dv + leg_dv;
+			// branch-and-bound: delta-v can only grow further down the tree
+			if(leg_total_dv >= atomic_load_explicit(&search->dv_bound, memory_order_relaxed)) {branch->num_pruned++; continue;}
+
+			trajectory->bodies[depth+1] = next_body;
+			trajectory->epochs[depth+1] = epoch1;
+			trajectory->vinf[depth+1] = mag_vec3(subtract_vec3(leg.v1, osv1.v));
+			trajectory->num_bodies = depth+2;
+
+			if(is_arrival) {
+				double dv_arr = dv_arrival(next_body, next_body->radius + params->arrival_altitude, trajectory->vinf[depth+1], params->transfer_type);
+				trajectory->dv = leg_total_dv + dv_arr;
+				trajectory->dv_arrival = dv_arr;
+				if(depth == 0) trajectory->dv_departure = leg_dv;
+				trajectory->dv_flybys = trajectory->dv - trajectory->dv_departure - dv_arr;
+				if(trajectory->dv < atomic_load_explicit(&search->dv_bound, memory_order_relaxed)) submit_mga_trajectory(search, trajectory);
+			} else {
+				if(depth == 0) trajectory->dv_departure = leg_dv;
+				expand_mga_branch(search, branch, osv1, leg.v1, leg_total_dv, 0, search->num_next_bodies-1);
+			}
+			trajectory->num_bodies = depth+1;
+		}
+	}
+}
+
+// one subtree per departure epoch and first leg target (handed out dynamically to the context's threads)
+static void search_mga_subtree(void *arg, int index) {
+	MgaSearch *search = arg;
+	int epoch_idx = index / search->num_next_bodies;
+	int body_idx = index % search->num_next_bodies;
+	if(search->params->max_flybys <= 0 && body_idx != search->num_next_bodies-1) return;
+
+	MgaBranch branch = {.trajectory = {.num_bodies = 1}};
+	branch.trajectory.bodies[0] = search->params->departure_body;
+	branch.trajectory.epochs[0] = search->params->min_departure_epoch + epoch_idx * search->params->departure_epoch_step;
+
+	OSV osv0 = get_body_osv(search->params->departure_body, branch.trajectory.epochs[0]);
+	expand_mga_branch(search, &branch, osv0, vec3(0,0,0), 0, body_idx, body_idx);
+
+	atomic_fetch_add_explicit(&search->num_legs, branch.num_legs, memory_order_relaxed);
+	atomic_fetch_add_explicit(&search->num_pruned, branch.num_pruned, memory_order_relaxed);
+}
+
+static int are_mga_params_valid(const MgaSearchParams *params) {
+	if(params->departure_body == NULL || params->arrival_body == NULL || params->departure_body->orbit.cb == NULL) return 0;
+	if(params->max_flybys < 0 || params->max_flybys > MGA_MAX_FLYBYS || params->max_results <= 0) return 0;
+	if(params->departure_epoch_step <= 0 || params->leg_duration_step <= 0 || params->min_leg_duration <= 0) return 0;
+	if(params->max_departure_epoch < params->min_departure_epoch || params->max_leg_duration < params->min_leg_duration) return 0;
+	Body *cb = params->departure_body->orbit.cb;
+	if(params->arrival_body->orbit.cb != cb) return 0;
+	for(int i = 0; i < params->num_flyby_bodies; i++) {
+		if(params->flyby_bodies[i] == NULL || params->flyby_bodies[i]->orbit.cb != cb) return 0;
+	}
+	return 1;
+}
+
+int search_mga_trajectories(OrbitlibContext *ctx, const MgaSearchParams *params, MgaTrajectory *results, MgaSearchStats *stats) {
+	if(stats != NULL) *stats = (MgaSearchStats) {0, 0};
+	if(!are_mga_params_valid(params)) {
+		fprintf(stderr, "Invalid MGA search parameters\n");
+		return 0;
+	}
+	if(ctx == NULL) ctx = get_default_orbitlib_context();
+	TRACE_BEGIN(span, "search_mga_trajectories");
+
+	Body **next_bodies = orbitlib_malloc((params->num_flyby_bodies + 1) * sizeof(Body *));
+	if(next_bodies == NULL) {
+		TRACE_END(span);
+		return 0;
+	}
+	for(int i = 0; i < params->num_flyby_bodies; i++) next_bodies[i] = params->flyby_bodies[i];
+	next_bodies[params->num_flyby_bodies] = params->arrival_body;
+
+	MgaSearch search = {
+			.params = params,
+			.cb = params->departure_body->orbit.cb,
+			.next_bodies = next_bodies,
+			.num_next_bodies = params->num_flyby_bodies + 1,
+			.num_departure_epochs = (int) ((params->max_departure_epoch - params->min_departure_epoch) / params->departure_epoch_step) + 1,
+			.num_leg_durations = (int) ((params->max_leg_duration - params->min_leg_duration) / params->leg_duration_step) + 1,
+			.results = results,
+			.num_results = 0
+	};
+	orbitlib_mutex_init(&search.results_mutex);
+	atomic_init(&search.dv_bound, params->max_dv);
+	atomic_init(&search.num_legs, 0);
+	atomic_init(&search.num_pruned, 0);
+
+	run_parallel_ctx(ctx, search.num_departure_epochs * search.num_next_bodies, search_mga_subtree, &search);
+
+	orbitlib_mutex_destroy(&search.results_mutex);
+	orbitlib_free(next_bodies);
+	if(stats != NULL) {
+		stats->num_legs = atomic_load(&search.num_legs);
+		stats->num_pruned = atomic_load(&search.num_pruned);
+	}
+	TRACE_END(span);
+	return search.num_results;
+}
+
+void print_mga_trajectory(const MgaTrajectory *trajectory) {
+	char date_string[DATE_STRING_MAX];
+	for(int i = 0; i < trajectory->num_bodies; i++) {
+		date_to_string(convert_JD_date(trajectory->epochs[i], DATE_ISO), date_string, 0);
+		printf("%s%s (%s, vinf: %.0f m/s)", i > 0 ? " -> " : "", trajectory->bodies[i]->name, date_string, trajectory->vinf[i]);
+	}
+	printf("\nDelta-v: %.0f m/s (departure: %.0f m/s, flybys: %.0f m/s, arrival: %.0f m/s)\n",
+		   trajectory->dv, trajectory->dv_departure, trajectory->dv_flybys, trajectory->dv_arrival);
+}
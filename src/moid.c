@@ -0,0 +1,494 @@
+#include "orbitlib_moid.h"
+#include "context_internal.h"
+#include "trace_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdatomic.h>
+
+// samples along the scanned orbit (coarse scan for the minima of the distance)
+#define MOID_NUM_SAMPLES 64
+// samples per orbit of the fallback grid
+#define MOID_GRID_SIZE 48
+// hyperbolas are sampled up to this fraction of the asymptote's true anomaly
+#define MOID_MAX_TA_FRACTION 0.98
+// fallback grid minima refined by Newton's method
+#define MOID_MAX_GRID_MINIMA 8
+
+
+// conic section of an orbit in the central body's frame, parameterized by the eccentric (ellipses) or hyperbolic anomaly
+typedef struct MoidConic {
+	Vector3 p, q, w;	// unit vectors towards the periapsis, 90° ahead of it and along the orbit normal
+	double a, e;
+	double b;			// semi-minor axis (ellipses) or a*sqrt(e²-1) with the sign making it positive (hyperbolas)
+	double max_anomaly;	// range of the anomaly (INFINITY for ellipses, as they wrap around)
+	double min_r, max_r;// periapsis and apoapsis radius (INFINITY for open orbits)
+	Body *cb;
+} MoidConic;
+
+static MoidConic get_moid_conic(Orbit orbit) {
+	MoidConic conic = {
+			.p = heliocentric_rot(vec2(1, 0), orbit.raan, orbit.arg_peri, orbit.i),
+			.q = heliocentric_rot(vec2(0, 1), orbit.raan, orbit.arg_peri, orbit.i),
+			.a = orbit.a,
+			.e = orbit.e,
+			.min_r = orbit.a * (1 - orbit.e),
+			.cb = orbit.cb
+	};
+	conic.w = cross_vec3(conic.p, conic.q);
+	if(orbit.e < 1) {
+		conic.b = orbit.a * sqrt(1 - orbit.e*orbit.e);
+		conic.max_anomaly = INFINITY;
+		conic.max_r = orbit.a * (1 + orbit.e);
+	} else {
+		conic.b = -orbit.a * sqrt(orbit.e*orbit.e - 1);
+		double max_ta = MOID_MAX_TA_FRACTION * acos(-1 / orbit.e);
+		conic.max_anomaly = 2 * atanh(tan(max_ta / 2) * sqrt((orbit.e - 1) / (orbit.e + 1)));
+		conic.max_r = INFINITY;
+	}
+	return conic;
+}
+
+// position at the anomaly and optionally its first (d1) and second (d2) derivative with respect to the anomaly
+static Vector3 get_conic_position(const MoidConic *conic, double anomaly, Vector3 *d1, Vector3 *d2) {
+	double c, s;
+	if(conic->e < 1) {
+		c = cos(anomaly);
+		s = sin(anomaly);
+		if(d1 != NULL) *d1 = add_vec3(scale_vec3(conic->p, -conic->a * s), scale_vec3(conic->q, conic->b * c));
+		if(d2 != NULL) *d2 = add_vec3(scale_vec3(conic->p, -conic->a * c), scale_vec3(conic->q, -conic->b * s));
+	} else {
+		c = cosh(anomaly);
+		s = sinh(anomaly);
+		if(d1 != NULL) *d1 = add_vec3(scale_vec3(conic->p, conic->a * s), scale_vec3(conic->q, conic->b * c));
+		if(d2 != NULL) *d2 = add_vec3(scale_vec3(conic->p, conic->a * c), scale_vec3(conic->q, conic->b * s));
+	}
+	return add_vec3(scale_vec3(conic->p, conic->a * (c - conic->e)), scale_vec3(conic->q, conic->b * s));
+}
+
+static double anomaly_to_true_anomaly(const MoidConic *conic, double anomaly) {
+	double e = conic->e;
+	if(e < 1) return 2 * atan2(sqrt(1 + e) * sin(anomaly / 2), sqrt(1 - e) * cos(anomaly / 2));
+	return 2 * atan(sqrt((e + 1) / (e - 1)) * tanh(anomaly / 2));
+}
+
+
+/*
+ * ------------------------------------
+ * Point-to-Ellipse Distance
+ * ------------------------------------
+ */
+
+// largest real root of m³ + a2 m² + a1 m + a0
+static double calc_largest_cubic_root(double a2, double a1, double a0) {
+	double p = a1 - a2*a2 / 3;
+	double q = 2*a2*a2*a2 / 27 - a2*a1 / 3 + a0;
+	double disc = q*q / 4 + p*p*p / 27;
+	double z;
+	if(disc > 0) {
+		double sqrt_disc = sqrt(disc);
+		z = cbrt(-q/2 + sqrt_disc) + cbrt(-q/2 - sqrt_disc);
+	} else {
+		z = p < 0 ? 2 * sqrt(-p/3) * cos(acos(fmax(fmin(3*q / (2*p) * sqrt(-3/p), 1), -1)) / 3) : 0;
+	}
+	double m = z - a2/3;
+	// polish (cancellation in the closed form)
+	for(int i = 0; i < 2; i++) {
+		double f = ((m + a2) * m + a1) * m + a0, df = (3*m + 2*a2) * m + a1;
+		if(df != 0) m -= f / df;
+	}
+	return m;
+}
+
+// real roots of the quadratic x² + b x + c (appended to roots)
+static int add_quadratic_roots(double b, double c, double *roots, int num_roots) {
+	double disc = b*b - 4*c;
+	if(disc < 0) return num_roots;
+	double sqrt_disc = sqrt(disc);
+	roots[num_roots++] = (-b + sqrt_disc) / 2;
+	roots[num_roots++] = (-b - sqrt_disc) / 2;
+	return num_roots;
+}
+
+// real roots of t⁴ + a3 t³ + a2 t² + a1 t + a0 (Ferrari); returns the number of roots
+static int solve_quartic(double a3, double a2, double a1, double a0, double roots[4]) {
+	// depressed quartic u⁴ + p u² + q u + r with t = u - a3/4
+	double shift = a3 / 4;
+	double p = a2 - 6*shift*shift;
+	double q = a1 - 2*a2*shift + 8*shift*shift*shift;
+	double r = a0 - a1*shift + a2*shift*shift - 3*shift*shift*shift*shift;
+
+	int num_roots = 0;
+	if(fabs(q) < 1e-14 * (fabs(p)*sqrt(fabs(p)) + sqrt(fabs(r))*sqrt(sqrt(fabs(r))) + 1e-300)) {
+		// biquadratic
+		double u2[2];
+		int num_u2 = add_quadratic_roots(p, r, u2, 0);
+		for(int i = 0; i < num_u2; i++) {
+			if(u2[i] < 0) continue;
+			roots[num_roots++] = sqrt(u2[i]);
+			roots[num_roots++] = -sqrt(u2[i]);
+		}
+	} else {
+		// (u² + p/2 + m)² = 2m u² - q u + (m² + m p + p²/4 - r) is a perfect square for the resolvent's root m > 0
+		double m = calc_largest_cubic_root(p, p*p/4 - r, -q*q/8);
+		if(!(m > 0)) return 0;
+		double s = sqrt(2*m);
+		num_roots = add_quadratic_roots(s, p/2 + m - q / (2*s), roots, num_roots);
+		num_roots = add_quadratic_roots(-s, p/2 + m + q / (2*s), roots, num_roots);
+	}
+	for(int i = 0; i < num_roots; i++) roots[i] -= shift;
+	return num_roots;
+}
+
+// minimum distance of a point to an ellipse; ecc_anomaly: eccentric anomaly of the closest point
+static double calc_point_ellipse_distance(const MoidConic *ellipse, Vector3 point, double *ecc_anomaly) {
+	double a = ellipse->a, b = ellipse->b;
+	// point in the ellipse's frame relative to its center
+	double x = dot_vec3(point, ellipse->p) + a * ellipse->e;
+	double y = dot_vec3(point, ellipse->q);
+	double z = dot_vec3(point, ellipse->w);
+
+	// stationary points: (b²-a²) sinE cosE + a x sinE - b y cosE = 0; with t = tan(E/2):
+	// b y t⁴ + 2(a²-b²+a x) t³ + 2(b²-a²+a x) t - b y = 0 (E = pi corresponds to t -> infinity)
+	double candidates[7];
+	int num_candidates = 0;
+	candidates[num_candidates++] = M_PI;
+	candidates[num_candidates++] = 0;
+	double lead = b * y;
+	if(fabs(lead) > 1e-12 * (a*a + a*fabs(x))) {
+		double roots[4];
+		int num_roots = solve_quartic(2*(a*a - b*b + a*x) / lead, 0, 2*(b*b - a*a + a*x) / lead, -1, roots);
+		for(int i = 0; i < num_roots; i++) candidates[num_candidates++] = 2 * atan(roots[i]);
+	} else if(a > b) {
+		// point on the major axis: sinE = 0 (already included) or cosE = a x / (a²-b²)
+		double c = a * x / (a*a - b*b);
+		if(fabs(c) <= 1) {
+			candidates[num_candidates++] = acos(c);
+			candidates[num_candidates++] = -acos(c);
+		}
+	}
+
+	double min_dist2 = INFINITY;
+	for(int i = 0; i < num_candidates; i++) {
+		double ecc = candidates[i];
+		// Newton on the stationary condition (accuracy of the roots of the quartic)
+		for(int j = 0; j < 2; j++) {
+			double s = sin(ecc), c = cos(ecc);
+			double f = (b*b - a*a) * s*c + a*x * s - b*y * c;
+			double df = (b*b - a*a) * (c*c - s*s) + a*x * c + b*y * s;
+			if(df == 0) break;
+			double step = f / df;
+			if(!(fabs(step) < 0.1)) break;
+			ecc -= step;
+		}
+		double dx = a * cos(ecc) - x, dy = b * sin(ecc) - y;
+		double dist2 = dx*dx + dy*dy;
+		if(dist2 < min_dist2) {
+			min_dist2 = dist2;
+			*ecc_anomaly = ecc;
+		}
+	}
+	return sqrt(min_dist2 + z*z);
+}
+
+
+/*
+ * ------------------------------------
+ * MOID
+ * ------------------------------------
+ */
+
+// position along the scanned orbit: sample i of num_samples (closed orbits wrap around, open ones include both limits)
+static double get_sample_anomaly(const MoidConic *conic, int i, int num_samples) {
+	if(conic->e < 1) return 2*M_PI * i / num_samples;
+	return -conic->max_anomaly + 2*conic->max_anomaly * i / (num_samples - 1);
+}
+
+static double calc_moid_at_anomaly(const MoidConic *conic, const MoidConic *ellipse, double anomaly, double *ecc_anomaly) {
+	return calc_point_ellipse_distance(ellipse, get_conic_position(conic, anomaly, NULL, NULL), ecc_anomaly);
+}
+
+// scan along the first orbit, each point's distance to the ellipse found algebraically; minima refined by golden-section searches
+static MoidResult calc_moid_scan(const MoidConic *conic, const MoidConic *ellipse) {
+	const double inv_phi = (sqrt(5) - 1) / 2;
+	int is_closed = conic->e < 1;
+	double dist[MOID_NUM_SAMPLES], ecc1;
+	for(int i = 0; i < MOID_NUM_SAMPLES; i++) dist[i] = calc_moid_at_anomaly(conic, ellipse, get_sample_anomaly(conic, i, MOID_NUM_SAMPLES), &ecc1);
+
+	MoidResult result = {INFINITY, 0, 0};
+	for(int i = 0; i < MOID_NUM_SAMPLES; i++) {
+		double prev = is_closed || i > 0 ? dist[(i + MOID_NUM_SAMPLES - 1) % MOID_NUM_SAMPLES] : INFINITY;
+		double next = is_closed || i < MOID_NUM_SAMPLES-1 ? dist[(i + 1) % MOID_NUM_SAMPLES] : INFINITY;
+		if(!(dist[i] <= prev && dist[i] <= next)) continue;
+
+		// golden-section search between the neighbouring samples
+		double lo = get_sample_anomaly(conic, i-1, MOID_NUM_SAMPLES), hi = get_sample_anomaly(conic, i+1, MOID_NUM_SAMPLES);
+		if(!is_closed) {
+			lo = fmax(lo, -conic->max_anomaly);
+			hi = fmin(hi, conic->max_anomaly);
+		}
+		double x0 = hi - inv_phi * (hi - lo), x1 = lo + inv_phi * (hi - lo);
+		double d0 = calc_moid_at_anomaly(conic, ellipse, x0, &ecc1);
+		double d1 = calc_moid_at_anomaly(conic, ellipse, x1, &ecc1);
+		while(hi - lo > 1e-10) {
+			if(d0 < d1) {
+				hi = x1; x1 = x0; d1 = d0;
+				x0 = hi - inv_phi * (hi - lo);
+				d0 = calc_moid_at_anomaly(conic, ellipse, x0, &ecc1);
+			} else {
+				lo = x0; x0 = x1; d0 = d1;
+				x1 = lo + inv_phi * (hi - lo);
+				d1 = calc_moid_at_anomaly(conic, ellipse, x1, &ecc1);
+			}
+		}
+		double anomaly = d0 < d1 ? x0 : x1;
+		double moid = calc_moid_at_anomaly(conic, ellipse, anomaly, &ecc1);
+		if(moid < result.moid) {
+			result = (MoidResult) {moid, anomaly_to_true_anomaly(conic, anomaly), anomaly_to_true_anomaly(ellipse, ecc1)};
+		}
+	}
+	return result;
+}
+
+static double calc_conic_distance2(const MoidConic *conic0, const MoidConic *conic1, double anomaly0, double anomaly1) {
+	Vector3 dr = subtract_vec3(get_conic_position(conic0, anomaly0, NULL, NULL), get_conic_position(conic1, anomaly1, NULL, NULL));
+	return dot_vec3(dr, dr);
+}
+
+// Newton's method on the squared distance over both anomalies (from a grid point); only steps decreasing the distance are taken
+static MoidResult refine_moid_newton(const MoidConic *conic0, const MoidConic *conic1, double x0, double x1) {
+	double dist2 = calc_conic_distance2(conic0, conic1, x0, x1);
+	for(int i = 0; i < 50; i++) {
+		Vector3 d1_0, d2_0, d1_1, d2_1;
+		Vector3 r0 = get_conic_position(conic0, x0, &d1_0, &d2_0);
+		Vector3 r1 = get_conic_position(conic1, x1, &d1_1, &d2_1);
+		Vector3 dr = subtract_vec3(r0, r1);
+		// gradient and Hessian of |r0 - r1|² / 2
+		double g0 = dot_vec3(dr, d1_0), g1 = -dot_vec3(dr, d1_1);
+		double h00 = dot_vec3(d1_0, d1_0) + dot_vec3(dr, d2_0);
+		double h11 = dot_vec3(d1_1, d1_1) - dot_vec3(dr, d2_1);
+		double h01 = -dot_vec3(d1_0, d1_1);
+		// not convex here: shift the Hessian to be positive definite (Levenberg-Marquardt)
+		double min_eigenvalue = (h00 + h11) / 2 - sqrt((h00 - h11)*(h00 - h11) / 4 + h01*h01);
+		double min_curvature = 1e-3 * (dot_vec3(d1_0, d1_0) + dot_vec3(d1_1, d1_1));
+		if(min_eigenvalue < min_curvature) {
+			h00 += min_curvature - min_eigenvalue;
+			h11 += min_curvature - min_eigenvalue;
+		}
+		double det = h00*h11 - h01*h01;
+		double step0 = (h11*g0 - h01*g1) / det, step1 = (h00*g1 - h01*g0) / det;
+		// at a limit of an open orbit: keep the anomaly at the limit and minimize over the other one
+		double clamped0 = fmax(fmin(x0 - step0, conic0->max_anomaly), -conic0->max_anomaly);
+		double clamped1 = fmax(fmin(x1 - step1, conic1->max_anomaly), -conic1->max_anomaly);
+		if(clamped0 != x0 - step0) {
+			step0 = x0 - clamped0;
+			step1 = (g1 - h01*step0) / h11;
+		} else if(clamped1 != x1 - step1) {
+			step1 = x1 - clamped1;
+			step0 = (g0 - h01*step1) / h00;
+		}
+		// limit the step to the grid spacing
+		double max_step = 2*M_PI / MOID_GRID_SIZE, scale = fmax(fabs(step0), fabs(step1)) / max_step;
+		if(scale > 1) {step0 /= scale; step1 /= scale;}
+
+		int improved = 0;
+		for(int j = 0; j < 30 && !improved; j++) {
+			double new_x0 = fmax(fmin(x0 - step0, conic0->max_anomaly), -conic0->max_anomaly);
+			double new_x1 = fmax(fmin(x1 - step1, conic1->max_anomaly), -conic1->max_anomaly);
+			double new_dist2 = calc_conic_distance2(conic0, conic1, new_x0, new_x1);
+			if(new_dist2 < dist2) {
+				x0 = new_x0; x1 = new_x1; dist2 = new_dist2;
+				improved = 1;
+			} else {
+				step0 /= 2; step1 /= 2;
+			}
+		}
+		if(!improved || (fabs(step0) < 1e-12 && fabs(step1) < 1e-12)) break;
+	}
+	return (MoidResult) {sqrt(dist2), anomaly_to_true_anomaly(conic0, x0), anomaly_to_true_anomaly(conic1, x1)};
+}
+
+typedef struct MoidGridMinimum {
+	int i, j;
+	double dist;
+} MoidGridMinimum;
+
+// fallback for two open orbits: grid over both orbits, its local minima refined by Newton's method
+static MoidResult calc_moid_grid(const MoidConic *conic0, const MoidConic *conic1) {
+	Vector3 r0[MOID_GRID_SIZE], r1[MOID_GRID_SIZE];
+	int wrap0 = conic0->e < 1, wrap1 = conic1->e < 1;
+	for(int i = 0; i < MOID_GRID_SIZE; i++) {
+		r0[i] = get_conic_position(conic0, get_sample_anomaly(conic0, i, MOID_GRID_SIZE), NULL, NULL);
+		r1[i] = get_conic_position(conic1, get_sample_anomaly(conic1, i, MOID_GRID_SIZE), NULL, NULL);
+	}
+	static const int offsets[8][2] = {{-1,-1}, {-1,0}, {-1,1}, {0,-1}, {0,1}, {1,-1}, {1,0}, {1,1}};
+
+	MoidGridMinimum minima[MOID_MAX_GRID_MINIMA];
+	int num_minima = 0;
+	for(int i = 0; i < MOID_GRID_SIZE; i++) {
+		for(int j = 0; j < MOID_GRID_SIZE; j++) {
+			double dist = mag_vec3(subtract_vec3(r0[i], r1[j]));
+			int is_minimum = 1;
+			for(int k = 0; k < 8 && is_minimum; k++) {
+				int ni = i + offsets[k][0], nj = j + offsets[k][1];
+				if(wrap0) ni = (ni + MOID_GRID_SIZE) % MOID_GRID_SIZE;
+				if(wrap1) nj = (nj + MOID_GRID_SIZE) % MOID_GRID_SIZE;
+				if(ni < 0 || nj < 0 || ni >= MOID_GRID_SIZE || nj >= MOID_GRID_SIZE) continue;
+				if(mag_vec3(subtract_vec3(r0[ni], r1[nj])) < dist) is_minimum = 0;
+			}
+			if(!is_minimum) continue;
+
+			// keep the closest minima (sorted)
+			int idx;
+			if(num_minima == MOID_MAX_GRID_MINIMA) {
+				if(minima[MOID_MAX_GRID_MINIMA-1].dist <= dist) continue;
+				idx = MOID_MAX_GRID_MINIMA-1;
+			} else {
+				idx = num_minima++;
+			}
+			while(idx > 0 && minima[idx-1].dist > dist) {
+				minima[idx] = minima[idx-1];
+				idx--;
+			}
+			minima[idx] = (MoidGridMinimum) {i, j, dist};
+		}
+	}
+
+	MoidResult result = {INFINITY, 0, 0};
+	for(int k = 0; k < num_minima; k++) {
+		MoidResult refined = refine_moid_newton(conic0, conic1, get_sample_anomaly(conic0, minima[k].i, MOID_GRID_SIZE),
+											   get_sample_anomaly(conic1, minima[k].j, MOID_GRID_SIZE));
+		if(refined.moid < result.moid) result = refined;
+	}
+	return result;
+}
+
+static MoidResult calc_moid_conics(const MoidConic *conic0, const MoidConic *conic1) {
+	MoidResult result = {NAN, 0, 0};
+	if(conic1->e < 1) {
+		result = calc_moid_scan(conic0, conic1);
+	} else if(conic0->e < 1) {
+		MoidResult swapped = calc_moid_scan(conic1, conic0);
+		result = (MoidResult) {swapped.moid, swapped.ta1, swapped.ta0};
+	}
+	if(!isfinite(result.moid)) result = calc_moid_grid(conic0, conic1);
+	if(!isfinite(result.moid)) result.moid = NAN;
+	return result;
+}
+
+MoidResult calc_moid(Orbit orbit0, Orbit orbit1) {
+	MoidConic conic0 = get_moid_conic(orbit0), conic1 = get_moid_conic(orbit1);
+	return calc_moid_conics(&conic0, &conic1);
+}
+
+
+/*
+ * ------------------------------------
+ * Screening
+ * ------------------------------------
+ */
+
+typedef struct MoidScreen {
+	const MoidConic *conics0, *conics1;
+	int num_conics1;
+	double threshold;
+
+	OrbitlibMutex pairs_mutex;
+	MoidPair *pairs;		// all pairs within the threshold (grown as needed)
+	int num_pairs, max_pairs;
+	int out_of_memory;
+	atomic_llong num_prefiltered, num_computed;
+} MoidScreen;
+
+static void add_moid_screen_pair(MoidScreen *screen, MoidPair pair) {
+	orbitlib_mutex_lock(&screen->pairs_mutex);
+	if(screen->num_pairs == screen->max_pairs) {
+		int max_pairs = screen->max_pairs > 0 ? 2 * screen->max_pairs : 64;
+		MoidPair *pairs = orbitlib_realloc(screen->pairs, max_pairs * sizeof(MoidPair));
+		if(pairs == NULL) {
+			screen->out_of_memory = 1;
+			orbitlib_mutex_unlock(&screen->pairs_mutex);
+			return;
+		}
+		screen->pairs = pairs;
+		screen->max_pairs = max_pairs;
+	}
+	screen->pairs[screen->num_pairs++] = pair;
+	orbitlib_mutex_unlock(&screen->pairs_mutex);
+}
+
+// one orbit of the first list against all orbits of the second list
+static void screen_moid_task(void *arg, int index) {
+	MoidScreen *screen = arg;
+	const MoidConic *conic0 = &screen->conics0[index];
+	int64_t num_prefiltered = 0, num_computed = 0;
+	for(int j = 0; j < screen->num_conics1; j++) {
+		const MoidConic *conic1 = &screen->conics1[j];
+		// the orbits can't come closer than their radial ranges
+		double min_dist = fmax(conic0->min_r - conic1->max_r, conic1->min_r - conic0->max_r);
+		if(conic0->cb != conic1->cb || min_dist > screen->threshold) {num_prefiltered++; continue;}
+
+		MoidResult moid = calc_moid_conics(conic0, conic1);
+		num_computed++;
+		if(moid.moid <= screen->threshold) add_moid_screen_pair(screen, (MoidPair) {index, j, moid});
+	}
+	atomic_fetch_add_explicit(&screen->num_prefiltered, num_prefiltered, memory_order_relaxed);
+	atomic_fetch_add_explicit(&screen->num_computed, num_computed, memory_order_relaxed);
+}
+
+static int compare_moid_pairs(const void *a, const void *b) {
+	const MoidPair *pair_a = a, *pair_b = b;
+	if(pair_a->moid.moid != pair_b->moid.moid) return (pair_a->moid.moid > pair_b->moid.moid) - (pair_a->moid.moid < pair_b->moid.moid);
+	if(pair_a->idx0 != pair_b->idx0) return pair_a->idx0 - pair_b->idx0;
+	return pair_a->idx1 - pair_b->idx1;
+}
+
+int screen_moid(OrbitlibContext *ctx, const Orbit *orbits0, int num_orbits0, const Orbit *orbits1, int num_orbits1, double threshold,
+				MoidPair *pairs, int max_pairs, MoidScreenStats *stats) {
+	if(stats != NULL) *stats = (MoidScreenStats) {0, 0, 0, 0};
+	if(num_orbits0 <= 0 || num_orbits1 <= 0) return 0;
+	if(ctx == NULL) ctx = get_default_orbitlib_context();
+	TRACE_BEGIN(span, "screen_moid");
+
+	MoidConic *conics0 = orbitlib_malloc(num_orbits0 * sizeof(MoidConic));
+	MoidConic *conics1 = orbitlib_malloc(num_orbits1 * sizeof(MoidConic));
+	if(conics0 == NULL || conics1 == NULL) {
+		orbitlib_free(conics1);
+		orbitlib_free(conics0);
+		TRACE_END(span);
+		return 0;
+	}
+	for(int i = 0; i < num_orbits0; i++) conics0[i] = get_moid_conic(orbits0[i]);
+	for(int i = 0; i < num_orbits1; i++) conics1[i] = get_moid_conic(orbits1[i]);
+
+	MoidScreen screen = {
+			.conics0 = conics0,
+			.conics1 = conics1,
+			.num_conics1 = num_orbits1,
+			.threshold = threshold
+	};
+	orbitlib_mutex_init(&screen.pairs_mutex);
+	atomic_init(&screen.num_prefiltered, 0);
+	atomic_init(&screen.num_computed, 0);
+
+	run_parallel_ctx(ctx, num_orbits0, screen_moid_task, &screen);
+
+	// deterministic order regardless of the threads' timing
+	if(screen.num_pairs > 0) qsort(screen.pairs, screen.num_pairs, sizeof(MoidPair), compare_moid_pairs);
+	int num_results = screen.num_pairs < max_pairs ? screen.num_pairs : (max_pairs > 0 ? max_pairs : 0);
+	for(int i = 0; i < num_results; i++) pairs[i] = screen.pairs[i];
+	if(screen.out_of_memory) fprintf(stderr, "MOID screening out of memory; pairs incomplete\n");
+
+	if(stats != NULL) {
+		stats->num_pairs = (int64_t) num_orbits0 * num_orbits1;
+		stats->num_prefiltered = atomic_load(&screen.num_prefiltered);
+		stats->num_computed = atomic_load(&screen.num_computed);
+		stats->num_found = screen.num_pairs;
+	}
+	orbitlib_mutex_destroy(&screen.pairs_mutex);
+	orbitlib_free(screen.pairs);
+	orbitlib_free(conics1);
+	orbitlib_free(conics0);
+	TRACE_END(span);
+	return num_results;
+}
@@ -0,0 +1,261 @@
+#include "orbitlib_montecarlo.h"
+#include "orbitlib_celestial.h"
+#include "context_internal.h"
+#include "trace_internal.h"
+#include <math.h>
+
+// samples per task and per block of statistics (fixed, so the merge order doesn't depend on the number of threads)
+#define MONTE_CARLO_BLOCK_SIZE 1024
+
+
+// running mean and sum of squared deviations (Welford; blocks merged with Chan's formula)
+typedef struct MonteCarloMoments {
+	int64_t n;
+	double mean[6];
+	double m2[6][6];
+} MonteCarloMoments;
+
+typedef struct MonteCarloRun {
+	OSV nominal;
+	Body *cb;
+	const DispersionModel *dispersions;
+	const MonteCarloParams *params;
+	OSV target_osv;
+	Vector3 b_t_dir, b_r_dir;
+	int has_bplane;
+	MonteCarloSample *samples;
+	MonteCarloMoments *state_moments, *bplane_moments;	// per block
+} MonteCarloRun;
+
+
+MonteCarloParams get_default_monte_carlo_params() {
+	MonteCarloParams params = {
+			.num_samples = 10000,
+			.seed = 0,
+			.epoch = 0,
+			.duration = 0,
+			.target = NULL
+	};
+	return params;
+}
+
+
+/*
+ * ------------------------------------
+ * Random Streams
+ * ------------------------------------
+ */
+
+// Philox4x32-10 (Salmon et al., Parallel Random Numbers: As Easy as 1, 2, 3)
+static void philox4x32(uint32_t ctr[4], uint64_t seed) {
+	uint32_t key[2] = {(uint32_t) seed, (uint32_t) (seed >> 32)};
+	for(int round = 0; round < 10; round++) {
+		uint64_t prod0 = (uint64_t) 0xD2511F53u * ctr[0];
+		uint64_t prod1 = (uint64_t) 0xCD9E8D57u * ctr[2];
+		uint32_t next[4] = {(uint32_t) (prod1 >> 32) ^ ctr[1] ^ key[0], (uint32_t) prod1, (uint32_t) (prod0 >> 32) ^ ctr[3] ^ key[1], (uint32_t) prod0};
+		for(int i = 0; i < 4; i++) ctr[i] = next[i];
+		key[0] += 0x9E3779B9u;
+		key[1] += 0xBB67AE85u;
+	}
+}
+
+// fills normals with standard normally distributed numbers of the sample's stream (Box-Muller; count even)
+static void draw_normals(uint64_t seed, int64_t sample_idx, double *normals, int count) {
+	for(int block = 0; block < count/2; block++) {
+		uint32_t ctr[4] = {(uint32_t) sample_idx, (uint32_t) ((uint64_t) sample_idx >> 32), (uint32_t) block, 0};
+		philox4x32(ctr, seed);
+		// uniform in (0,1) with 53 bits
+		double u0 = ((double) (((uint64_t) ctr[0] << 32 | ctr[1]) >> 11) + 0.5) / 9007199254740992.0;
+		double u1 = ((double) (((uint64_t) ctr[2] << 32 | ctr[3]) >> 11) + 0.5) / 9007199254740992.0;
+		double radius = sqrt(-2 * log(u0));
+		normals[2*block] = radius * cos(2*M_PI * u1);
+		normals[2*block+1] = radius * sin(2*M_PI * u1);
+	}
+}
+
+
+/*
+ * ------------------------------------
+ * Statistics
+ * ------------------------------------
+ */
+
+static void add_moments_sample(MonteCarloMoments *moments, const double *x, int dim) {
+	moments->n++;
+	double delta[6];
+	for(int i = 0; i < dim; i++) {
+		delta[i] = x[i] - moments->mean[i];
+		moments->mean[i] += delta[i] / (double) moments->n;
+	}
+	for(int i = 0; i < dim; i++)
+		for(int j = 0; j < dim; j++) moments->m2[i][j] += delta[i] * (x[j] - moments->mean[j]);
+}
+
+static void merge_moments(MonteCarloMoments *moments, const MonteCarloMoments *other, int dim) {
+	if(other->n == 0) return;
+	if(moments->n == 0) {
+		*moments = *other;
+		return;
+	}
+	double n = (double) (moments->n + other->n);
+	double delta[6];
+	for(int i = 0; i < dim; i++) delta[i] = other->mean[i] - moments->mean[i];
+	for(int i = 0; i < dim; i++)
+		for(int j = 0; j < dim; j++) moments->m2[i][j] += other->m2[i][j] + delta[i]*delta[j] * (double) moments->n * (double) other->n / n;
+	for(int i = 0; i < dim; i++) moments->mean[i] += delta[i] * (double) other->n / n;
+	moments->n += other->n;
+}
+
+
+/*
+ * ------------------------------------
+ * Samples
+ * ------------------------------------
+ */
+
+// B-vector and incoming asymptote direction of a state relative to the target (0 if the approach is not hyperbolic)
+static int calc_b_vector(OSV rel, double mu, Vector3 *b_vec, Vector3 *s_dir) {
+	double r_mag = mag_vec3(rel.r), v_sq = dot_vec3(rel.v, rel.v);
+	Vector3 h = cross_vec3(rel.r, rel.v);
+	Vector3 e_vec = scale_vec3(subtract_vec3(scale_vec3(rel.r, v_sq - mu/r_mag), scale_vec3(rel.v, dot_vec3(rel.r, rel.v))), 1/mu);
+	double e = mag_vec3(e_vec), h_mag = mag_vec3(h);
+	if(!(e > 1) || h_mag == 0) return 0;
+	Vector3 e_dir = scale_vec3(e_vec, 1/e), h_dir = scale_vec3(h, 1/h_mag);
+	*s_dir = add_vec3(scale_vec3(e_dir, 1/e), scale_vec3(cross_vec3(h_dir, e_dir), sqrt(1 - 1/(e*e))));
+	double a = 1 / (2/r_mag - v_sq/mu);
+	*b_vec = scale_vec3(cross_vec3(*s_dir, h_dir), -a * sqrt(e*e - 1));
+	return 1;
+}
+
+static OSV apply_dispersions(const MonteCarloRun *run, int64_t sample_idx) {
+	const DispersionModel *dispersions = run->dispersions;
+	double n[10];
+	draw_normals(run->params->seed, sample_idx, n, 10);
+	OSV osv = run->nominal;
+	osv.r = add_vec3(osv.r, scale_vec3(vec3(n[0], n[1], n[2]), dispersions->pos_sigma));
+	osv.v = add_vec3(osv.v, scale_vec3(vec3(n[3], n[4], n[5]), dispersions->vel_sigma));
+
+	double dv_mag = mag_vec3(dispersions->dv);
+	if(dv_mag > 0) {
+		Vector3 dv_dir = scale_vec3(dispersions->dv, 1/dv_mag);
+		// perpendicular axes of the pointing error
+		Vector3 axis0 = cross_vec3(dv_dir, fabs(dv_dir.z) < 0.9 ? vec3(0, 0, 1) : vec3(1, 0, 0));
+		axis0 = norm_vec3(axis0);
+		Vector3 axis1 = cross_vec3(dv_dir, axis0);
+		double error0 = n[7] * dispersions->dv_pointing_sigma, error1 = n[8] * dispersions->dv_pointing_sigma;
+		double angle = sqrt(error0*error0 + error1*error1);
+		Vector3 dv = dv_dir;
+		if(angle > 0) dv = add_vec3(scale_vec3(dv_dir, cos(angle)), scale_vec3(add_vec3(scale_vec3(axis0, error0), scale_vec3(axis1, error1)), sin(angle)/angle));
+		osv.v = add_vec3(osv.v, scale_vec3(dv, dv_mag * (1 + n[6] * dispersions->dv_mag_sigma)));
+	}
+	return osv;
+}
+
+// propagates a (dispersed) departure state and maps it into the nominal B-plane (NAN if not hyperbolic)
+static MonteCarloSample propagate_sample(const MonteCarloRun *run, OSV osv) {
+	MonteCarloSample sample = {propagate_osv_time_stm(osv, run->cb, run->params->duration, NULL), NAN, NAN};
+	if(!run->has_bplane) return sample;
+	OSV rel = {subtract_vec3(sample.osv.r, run->target_osv.r), subtract_vec3(sample.osv.v, run->target_osv.v)};
+	Vector3 b_vec, s_dir;
+	if(calc_b_vector(rel, run->params->target->mu, &b_vec, &s_dir)) {
+		sample.b_t = dot_vec3(b_vec, run->b_t_dir);
+		sample.b_r = dot_vec3(b_vec, run->b_r_dir);
+	}
+	return sample;
+}
+
+static void monte_carlo_task(void *arg, int index) {
+	MonteCarloRun *run = arg;
+	MonteCarloMoments *state_moments = &run->state_moments[index], *bplane_moments = &run->bplane_moments[index];
+	int end = (index + 1) * MONTE_CARLO_BLOCK_SIZE < run->params->num_samples ? (index + 1) * MONTE_CARLO_BLOCK_SIZE : run->params->num_samples;
+	for(int i = index * MONTE_CARLO_BLOCK_SIZE; i < end; i++) {
+		MonteCarloSample sample = propagate_sample(run, apply_dispersions(run, i));
+		if(run->samples != NULL) run->samples[i] = sample;
+		double state[6] = {sample.osv.r.x, sample.osv.r.y, sample.osv.r.z, sample.osv.v.x, sample.osv.v.y, sample.osv.v.z};
+		add_moments_sample(state_moments, state, 6);
+		if(!isnan(sample.b_t)) {
+			double b[2] = {sample.b_t, sample.b_r};
+			add_moments_sample(bplane_moments, b, 2);
+		}
+	}
+}
+
+
+/*
+ * ------------------------------------
+ * Monte Carlo Dispersion Analysis
+ * ------------------------------------
+ */
+
+int run_monte_carlo(OrbitlibContext *ctx, OSV nominal, Body *cb, const DispersionModel *dispersions, const MonteCarloParams *params,
+					MonteCarloSample *samples, MonteCarloStats *stats) {
+	if(cb == NULL || dispersions == NULL || params == NULL || stats == NULL || params->num_samples < 2) return 0;
+	if(ctx == NULL) ctx = get_default_orbitlib_context();
+	TRACE_BEGIN(span, "run_monte_carlo");
+
+	MonteCarloRun run = {.nominal = nominal, .cb = cb, .dispersions = dispersions, .params = params, .samples = samples};
+	*stats = (MonteCarloStats) {.num_samples = params->num_samples, .nominal_b_t = NAN, .nominal_b_r = NAN};
+
+	// B-plane frame of the nominal approach
+	OSV departure = {nominal.r, add_vec3(nominal.v, dispersions->dv)};
+	if(params->target != NULL) {
+		run.target_osv = get_body_osv(params->target, params->epoch + params->duration / 86400);
+		OSV arrival = propagate_osv_time_stm(departure, cb, params->duration, NULL);
+		OSV rel = {subtract_vec3(arrival.r, run.target_osv.r), subtract_vec3(arrival.v, run.target_osv.v)};
+		Vector3 b_vec, s_dir;
+		if(calc_b_vector(rel, params->target->mu, &b_vec, &s_dir)) {
+			Vector3 t_dir = cross_vec3(s_dir, vec3(0, 0, 1));
+			if(mag_vec3(t_dir) < 1e-9) t_dir = cross_vec3(s_dir, vec3(0, 1, 0));
+			run.b_t_dir = norm_vec3(t_dir);
+			run.b_r_dir = cross_vec3(s_dir, run.b_t_dir);
+			run.has_bplane = 1;
+		}
+	}
+	MonteCarloSample nominal_sample = propagate_sample(&run, departure);
+	stats->nominal = nominal_sample.osv;
+	stats->has_bplane = run.has_bplane;
+	stats->nominal_b_t = nominal_sample.b_t;
+	stats->nominal_b_r = nominal_sample.b_r;
+
+	int num_blocks = (params->num_samples + MONTE_CARLO_BLOCK_SIZE - 1) / MONTE_CARLO_BLOCK_SIZE;
+	run.state_moments = orbitlib_calloc(num_blocks, sizeof(MonteCarloMoments));
+	run.bplane_moments = orbitlib_calloc(num_blocks, sizeof(MonteCarloMoments));
+	if(run.state_moments == NULL || run.bplane_moments == NULL) {
+		orbitlib_free(run.state_moments);
+		orbitlib_free(run.bplane_moments);
+		TRACE_END(span);
+		return 0;
+	}
+	run_parallel_ctx(ctx, num_blocks, monte_carlo_task, &run);
+
+	MonteCarloMoments state_moments = {0}, bplane_moments = {0};
+	for(int i = 0; i < num_blocks; i++) {
+		merge_moments(&state_moments, &run.state_moments[i], 6);
+		merge_moments(&bplane_moments, &run.bplane_moments[i], 2);
+	}
+	stats->mean = (OSV) {vec3(state_moments.mean[0], state_moments.mean[1], state_moments.mean[2]),
+						 vec3(state_moments.mean[3], state_moments.mean[4], state_moments.mean[5])};
+	for(int i = 0; i < 6; i++)
+		for(int j = 0; j < 6; j++) stats->cov[i][j] = state_moments.m2[i][j] / (double) (state_moments.n - 1);
+
+	stats->num_bplane_samples = (int) bplane_moments.n;
+	stats->mean_b_t = stats->mean_b_r = stats->ellipse_semi_major = stats->ellipse_semi_minor = stats->ellipse_angle = NAN;
+	if(bplane_moments.n >= 2) {
+		stats->mean_b_t = bplane_moments.mean[0];
+		stats->mean_b_r = bplane_moments.mean[1];
+		for(int i = 0; i < 2; i++)
+			for(int j = 0; j < 2; j++) stats->cov_b[i][j] = bplane_moments.m2[i][j] / (double) (bplane_moments.n - 1);
+		// eigen decomposition of the 2x2 covariance
+		double mid = (stats->cov_b[0][0] + stats->cov_b[1][1]) / 2;
+		double half_diff = (stats->cov_b[0][0] - stats->cov_b[1][1]) / 2;
+		double root = sqrt(half_diff*half_diff + stats->cov_b[0][1]*stats->cov_b[0][1]);
+		stats->ellipse_semi_major = sqrt(mid + root);
+		stats->ellipse_semi_minor = sqrt(fmax(mid - root, 0));
+		stats->ellipse_angle = 0.5 * atan2(2*stats->cov_b[0][1], stats->cov_b[0][0] - stats->cov_b[1][1]);
+	}
+
+	orbitlib_free(run.state_moments);
+	orbitlib_free(run.bplane_moments);
+	TRACE_END(span);
+	return 1;
+}
@@ -0,0 +1,246 @@
+#include "orbitlib_optim.h"
+#include "context_internal.h"
+#include "trace_internal.h"
+#include <stdlib.h>
+#include <math.h>
+
+
+TransferOptimParams get_default_transfer_optim_params() {
+	TransferOptimParams params = {
+			.departure_body = NULL,
+			.arrival_body = NULL,
+			.transfer_type = circcap,
+			.departure_altitude = 200e3,
+			.arrival_altitude = 200e3,
+			.min_departure_epoch = 0,
+			.max_departure_epoch = 0,
+			.min_duration = 30,
+			.max_duration = 1000,
+			.num_departure_seeds = 12,
+			.num_duration_seeds = 6,
+			.epoch_tolerance = 60,
+			.dv_tolerance = 0.1,
+			.max_evaluations = 200
+	};
+	return params;
+}
+
+TransferOptimResult calc_transfer_dv(const TransferOptimParams *params, double departure_epoch, double duration) {
+	TransferOptimResult transfer = {departure_epoch, duration, INFINITY, INFINITY, INFINITY, 1, 0};
+	Body *dep_body = params->departure_body, *arr_body = params->arrival_body;
+	OSV osv0 = get_body_osv(dep_body, departure_epoch);
+	OSV osv1 = get_body_osv(arr_body, departure_epoch + duration);
+	Lambert3 leg = calc_lambert3(osv0.r, osv1.r, duration * 86400, dep_body->orbit.cb);
+	if(leg.success != LAMBERT_SUCCESS) return transfer;
+
+	double vinf_dep = mag_vec3(subtract_vec3(leg.v0, osv0.v));
+	double vinf_arr = mag_vec3(subtract_vec3(leg.v1, osv1.v));
+	transfer.dv_departure = dv_departure(dep_body, dep_body->radius + params->departure_altitude, vinf_dep, params->transfer_type);
+	transfer.dv_arrival = dv_arrival(arr_body, arr_body->radius + params->arrival_altitude, vinf_arr, params->transfer_type);
+	transfer.dv = transfer.dv_departure + transfer.dv_arrival;
+	return transfer;
+}
+
+
+/*
+ * ------------------------------------
+ * Nelder-Mead
+ * ------------------------------------
+ */
+
+// vertex of the simplex over (departure epoch, duration) in days
+typedef struct SimplexVertex {
+	double x[2];
+	TransferOptimResult transfer;
+} SimplexVertex;
+
+static void clamp_to_bounds(const TransferOptimParams *params, double x[2]) {
+	x[0] = fmin(fmax(x[0], params->min_departure_epoch), params->max_departure_epoch);
+	x[1] = fmin(fmax(x[1], params->min_duration), params->max_duration);
+}
+
+static SimplexVertex eval_vertex(const TransferOptimParams *params, double x0, double x1, int *num_evaluations) {
+	SimplexVertex vertex = {.x = {x0, x1}};
+	clamp_to_bounds(params, vertex.x);
+	vertex.transfer = calc_transfer_dv(params, vertex.x[0], vertex.x[1]);
+	(*num_evaluations)++;
+	return vertex;
+}
+
+static void sort_simplex(SimplexVertex simplex[3]) {
+	for(int i = 1; i < 3; i++) {
+		SimplexVertex vertex = simplex[i];
+		int j = i;
+		while(j > 0 && simplex[j-1].transfer.dv > vertex.transfer.dv) {
+			simplex[j] = simplex[j-1];
+			j--;
+		}
+		simplex[j] = vertex;
+	}
+}
+
+static int has_simplex_converged(const TransferOptimParams *params, SimplexVertex simplex[3]) {
+	if(!isfinite(simplex[2].transfer.dv) || simplex[2].transfer.dv - simplex[0].transfer.dv > params->dv_tolerance) return 0;
+	for(int i = 1; i < 3; i++) {
+		for(int j = 0; j < 2; j++) {
+			if(fabs(simplex[i].x[j] - simplex[0].x[j]) * 86400 > params->epoch_tolerance) return 0;
+		}
+	}
+	return 1;
+}
+
+// simplex with initial steps of step0 and step1 [days]
+static TransferOptimResult run_nelder_mead(const TransferOptimParams *params, double departure_epoch, double duration, double step0, double step1) {
+	int num_evaluations = 0;
+	SimplexVertex simplex[3];
+	simplex[0] = eval_vertex(params, departure_epoch, duration, &num_evaluations);
+	// step away from the bounds
+	simplex[1] = eval_vertex(params, departure_epoch + (departure_epoch + step0 <= params->max_departure_epoch ? step0 : -step0), duration, &num_evaluations);
+	simplex[2] = eval_vertex(params, departure_epoch, duration + (duration + step1 <= params->max_duration ? step1 : -step1), &num_evaluations);
+	sort_simplex(simplex);
+
+	int converged = 0;
+	while(num_evaluations < params->max_evaluations) {
+		if(has_simplex_converged(params, simplex)) {converged = 1; break;}
+
+		double centroid[2] = {(simplex[0].x[0] + simplex[1].x[0]) / 2, (simplex[0].x[1] + simplex[1].x[1]) / 2};
+		double dir[2] = {centroid[0] - simplex[2].x[0], centroid[1] - simplex[2].x[1]};
+
+		SimplexVertex reflected = eval_vertex(params, centroid[0] + dir[0], centroid[1] + dir[1], &num_evaluations);
+		if(reflected.transfer.dv < simplex[0].transfer.dv) {
+			SimplexVertex expanded = eval_vertex(params, centroid[0] + 2*dir[0], centroid[1] + 2*dir[1], &num_evaluations);
+			simplex[2] = expanded.transfer.dv < reflected.transfer.dv ? expanded : reflected;
+		} else if(reflected.transfer.dv < simplex[1].transfer.dv) {
+			simplex[2] = reflected;
+		} else {
+			// contraction towards the better of the reflected and the worst vertex
+			int outside = reflected.transfer.dv < simplex[2].transfer.dv;
+			double factor = outside ? 0.5 : -0.5;
+			SimplexVertex contracted = eval_vertex(params, centroid[0] + factor*dir[0], centroid[1] + factor*dir[1], &num_evaluations);
+			if(contracted.transfer.dv < (outside ? reflected.transfer.dv : simplex[2].transfer.dv)) {
+				simplex[2] = contracted;
+			} else {
+				// shrink towards the best vertex
+				for(int i = 1; i < 3; i++) {
+					simplex[i] = eval_vertex(params, (simplex[0].x[0] + simplex[i].x[0]) / 2, (simplex[0].x[1] + simplex[i].x[1]) / 2, &num_evaluations);
+				}
+			}
+		}
+		sort_simplex(simplex);
+	}
+
+	TransferOptimResult result = simplex[0].transfer;
+	result.num_evaluations = num_evaluations;
+	result.converged = converged;
+	return result;
+}
+
+static double get_seed_spacing(double min, double max, int num_seeds) {
+	return num_seeds > 1 ? (max - min) / (num_seeds - 1) : max - min;
+}
+
+TransferOptimResult optimize_transfer(const TransferOptimParams *params, double departure_epoch, double duration) {
+	double step0 = get_seed_spacing(params->min_departure_epoch, params->max_departure_epoch, params->num_departure_seeds) / 2;
+	double step1 = get_seed_spacing(params->min_duration, params->max_duration, params->num_duration_seeds) / 2;
+	// at least one day (also for an empty departure window)
+	return run_nelder_mead(params, departure_epoch, duration, fmax(step0, 1), fmax(step1, 1));
+}
+
+
+/*
+ * ------------------------------------
+ * Seeded Search
+ * ------------------------------------
+ */
+
+typedef struct TransferSeedSearch {
+	const TransferOptimParams *params;
+	double dep_spacing, dur_spacing;
+	double *grid_dv;		// coarse grid (departure-major)
+	int *seeds;				// grid indices of the local minima
+	TransferOptimResult *minima;
+} TransferSeedSearch;
+
+static void eval_seed_grid_task(void *arg, int index) {
+	TransferSeedSearch *search = arg;
+	const TransferOptimParams *params = search->params;
+	int i = index / params->num_duration_seeds, j = index % params->num_duration_seeds;
+	search->grid_dv[index] = calc_transfer_dv(params, params->min_departure_epoch + i * search->dep_spacing, params->min_duration + j * search->dur_spacing).dv;
+}
+
+static void optimize_seed_task(void *arg, int index) {
+	TransferSeedSearch *search = arg;
+	const TransferOptimParams *params = search->params;
+	int seed = search->seeds[index];
+	int i = seed / params->num_duration_seeds, j = seed % params->num_duration_seeds;
+	search->minima[index] = run_nelder_mead(params, params->min_departure_epoch + i * search->dep_spacing, params->min_duration + j * search->dur_spacing,
+											fmax(search->dep_spacing / 2, 1), fmax(search->dur_spacing / 2, 1));
+}
+
+// local minimum of the grid among its (up to 8) neighbours
+static int is_grid_minimum(const TransferOptimParams *params, const double *grid_dv, int i, int j) {
+	double dv = grid_dv[i * params->num_duration_seeds + j];
+	if(!isfinite(dv)) return 0;
+	for(int di = -1; di <= 1; di++) {
+		for(int dj = -1; dj <= 1; dj++) {
+			int ni = i + di, nj = j + dj;
+			if((di == 0 && dj == 0) || ni < 0 || nj < 0 || ni >= params->num_departure_seeds || nj >= params->num_duration_seeds) continue;
+			if(grid_dv[ni * params->num_duration_seeds + nj] < dv) return 0;
+		}
+	}
+	return 1;
+}
+
+static int compare_transfer_dv(const void *a, const void *b) {
+	double dv_a = ((const TransferOptimResult *) a)->dv, dv_b = ((const TransferOptimResult *) b)->dv;
+	return (dv_a > dv_b) - (dv_a < dv_b);
+}
+
+int search_optimal_transfers(OrbitlibContext *ctx, const TransferOptimParams *params, TransferOptimResult *results, int max_results) {
+	if(params->num_departure_seeds <= 0 || params->num_duration_seeds <= 0 || max_results <= 0) return 0;
+	if(ctx == NULL) ctx = get_default_orbitlib_context();
+	TRACE_BEGIN(span, "search_optimal_transfers");
+
+	int num_grid_points = params->num_departure_seeds * params->num_duration_seeds;
+	TransferSeedSearch search = {
+			.params = params,
+			.dep_spacing = get_seed_spacing(params->min_departure_epoch, params->max_departure_epoch, params->num_departure_seeds),
+			.dur_spacing = get_seed_spacing(params->min_duration, params->max_duration, params->num_duration_seeds),
+			.grid_dv = orbitlib_malloc(num_grid_points * sizeof(double)),
+			.seeds = orbitlib_malloc(num_grid_points * sizeof(int)),
+			.minima = orbitlib_malloc(num_grid_points * sizeof(TransferOptimResult))
+	};
+	int num_results = 0;
+	if(search.grid_dv != NULL && search.seeds != NULL && search.minima != NULL) {
+		run_parallel_ctx(ctx, num_grid_points, eval_seed_grid_task, &search);
+
+		int num_seeds = 0;
+		for(int i = 0; i < params->num_departure_seeds; i++) {
+			for(int j = 0; j < params->num_duration_seeds; j++) {
+				if(is_grid_minimum(params, search.grid_dv, i, j)) search.seeds[num_seeds++] = i * params->num_duration_seeds + j;
+			}
+		}
+		run_parallel_ctx(ctx, num_seeds, optimize_seed_task, &search);
+		qsort(search.minima, num_seeds, sizeof(TransferOptimResult), compare_transfer_dv);
+
+		// seeds converging to the same minimum (within half a grid cell) are merged
+		for(int i = 0; i < num_seeds && num_results < max_results; i++) {
+			if(!isfinite(search.minima[i].dv)) break;
+			int is_duplicate = 0;
+			for(int j = 0; j < num_results; j++) {
+				if(fabs(results[j].departure_epoch - search.minima[i].departure_epoch) < search.dep_spacing / 2 &&
+				   fabs(results[j].duration - search.minima[i].duration) < search.dur_spacing / 2) {
+					is_duplicate = 1;
+					break;
+				}
+			}
+			if(!is_duplicate) results[num_results++] = search.minima[i];
+		}
+	}
+
+	orbitlib_free(search.minima);
+	orbitlib_free(search.seeds);
+	orbitlib_free(search.grid_dv);
+	TRACE_END(span);
+	return num_results;
+}
@@ -1,5 +1,7 @@
 #include "orbitlib_orbit.h"
 #include "orbitlib_celestial.h"
+#include "solver_stats.h"
+#include "diag_internal.h"
 #include <math.h>
 #include <stdio.h>
 
@@ -85,13 +87,18 @@ Vector2 calc_vel_vec2(double r_mag, double v_mag, double true_anomaly, double fl
 }
 
 double calc_true_anomaly_from_mean_anomaly(struct Orbit orbit, double mean_anomaly) {
+	SOLVER_STATS_START(stats_start);
 	// Solve Kepler's equation
 	double ecc_anomaly = mean_anomaly; // Initial guess
 	double delta;
+	int iterations = 0;
 	do {
 		delta = (ecc_anomaly - orbit.e * sin(ecc_anomaly) - mean_anomaly) / (1 - orbit.e * cos(ecc_anomaly));
 		ecc_anomaly -= delta;
-	} while (fabs(delta) > 1e-6);
+		iterations++;
+	} while (fabs(delta) > 1e-6 && iterations < 100);	// cap for non-converging cases (e.g. e close to 1 or NaN inputs)
+	if(fabs(delta) > 1e-6) RECORD_DIAG(SOLVER_KEPLER, DIAG_KEPLER_ITERATION_CAP, orbit.e, mean_anomaly, ecc_anomaly, delta);
+	SOLVER_STATS_RECORD(SOLVER_KEPLER, stats_start, iterations, fabs(delta) > 1e-6, -1);
 	
 	// True anomaly from eccentric anomaly and eccentricity
 	return 2 * atan(sqrt((1 + orbit.e) / (1 - orbit.e)) * tan(ecc_anomaly / 2));
@@ -195,6 +202,7 @@ OSV osv_from_elements(Orbit orbit, double epoch) {
 
 
 Orbit propagate_orbit_time(Orbit orbit, double dt) {
+	SOLVER_STATS_START(stats_start);
 	double ta = orbit.ta;
 	double e = orbit.e;
 	double a = orbit.a;
@@ -254,8 +262,10 @@ Orbit propagate_orbit_time(Orbit orbit, double dt) {
 		}
 		ta += step;
 	}
+	if(c == 500) RECORD_DIAG(SOLVER_PROPAGATE_ORBIT_TIME, DIAG_PROPAGATION_ITERATION_CAP, a, e, orbit.ta, dt, t, target_t);
 	ta -= step; // reset theta1 from last change inside the loop
 	orbit.ta = ta;
+	SOLVER_STATS_RECORD(SOLVER_PROPAGATE_ORBIT_TIME, stats_start, c, c == 500, -1);
 	return orbit;
 }
 
@@ -265,6 +275,149 @@ OSV propagate_osv_time(OSV osv, Body *cb, double dt) {
 	return osv_from_orbit(orbit);
 }
 
+// Stumpff functions c0(z) to c5(z) (c_n = 1/n! - z*c_(n+2))
+static void calc_stumpff_functions(double z, double c[6]) {
+	if(fabs(z) < 0.1) {
+		// series c_n = sum_k (-z)^k / (2k+n)! (closed forms lose precision for small z)
+		double term_start = 1;	// 1/n!
+		for(int n = 0; n < 6; n++) {
+			if(n > 0) term_start /= n;
+			double term = term_start, sum = 0;
+			for(int k = 0; k < 8; k++) {
+				sum += term;
+				term *= -z / ((2*k+n+1) * (2*k+n+2));
+			}
+			c[n] = sum;
+		}
+		return;
+	}
+	if(z > 0) {
+		double sqrt_z = sqrt(z);
+		c[0] = cos(sqrt_z);
+		c[1] = sin(sqrt_z) / sqrt_z;
+	} else {
+		double sqrt_z = sqrt(-z);
+		c[0] = cosh(sqrt_z);
+		c[1] = sinh(sqrt_z) / sqrt_z;
+	}
+	c[2] = (1 - c[0]) / z;
+	c[3] = (1 - c[1]) / z;
+	c[4] = (0.5 - c[2]) / z;
+	c[5] = (1.0/6 - c[3]) / z;
+}
+
+UniversalOrbit prepare_universal_orbit(OSV osv, Body *cb) {
+	UniversalOrbit orbit = {.osv = osv, .mu = cb->mu, .sqrt_mu = sqrt(cb->mu), .r0 = mag_vec3(osv.r)};
+	orbit.sigma0 = dot_vec3(osv.r, osv.v) / orbit.sqrt_mu;
+	orbit.alpha = 2/orbit.r0 - dot_vec3(osv.v, osv.v)/orbit.mu;
+	return orbit;
+}
+
+static OSV propagate_universal_orbit_stm(const UniversalOrbit *orbit, double dt, double stm[6][6]) {
+	double mu = orbit->mu;
+	double sqrt_mu = orbit->sqrt_mu;
+	Vector3 r0 = orbit->osv.r, v0 = orbit->osv.v;
+	double r0_mag = orbit->r0;
+	double sigma0 = orbit->sigma0;
+	double alpha = orbit->alpha;		// 1/a
+	
+	// initial guess of the universal anomaly (Vallado)
+	double chi;
+	if(alpha*r0_mag > 1e-6) {
+		chi = sqrt_mu * dt * alpha;
+	} else {
+		double a = 1/alpha;
+		double sign_dt = dt < 0 ? -1 : 1;
+		chi = sign_dt * sqrt(-a) * log((-2*mu*alpha*dt) / (sigma0*sqrt_mu + sign_dt*sqrt(-mu*a)*(1 - r0_mag*alpha)));
+		// (near) parabolic
+		if(!isfinite(chi)) chi = sqrt_mu * dt / r0_mag;
+	}
+	
+	// universal Kepler equation sqrt(mu)*dt = r0*U1 + sigma0*U2 + U3 solved with Laguerre-Conway
+	double c[6], U[6];
+	for(int i = 0; i < 50; i++) {
+		calc_stumpff_functions(alpha*chi*chi, c);
+		double chi_pow = 1;
+		for(int n = 0; n < 6; n++) {U[n] = chi_pow * c[n]; chi_pow *= chi;}
+		double F = r0_mag*U[1] + sigma0*U[2] + U[3] - sqrt_mu*dt;
+		double dF = r0_mag*U[0] + sigma0*U[1] + U[2];
+		double ddF = sigma0*U[0] + (1 - alpha*r0_mag)*U[1];
+		double root = sqrt(fabs(16*dF*dF - 20*F*ddF));
+		double delta = 5*F / (dF + (dF < 0 ? -root : root));
+		chi -= delta;
+		if(fabs(delta) <= 1e-13 * fmax(fabs(chi), 1)) break;
+	}
+	calc_stumpff_functions(alpha*chi*chi, c);
+	double chi_pow = 1;
+	for(int n = 0; n < 6; n++) {U[n] = chi_pow * c[n]; chi_pow *= chi;}
+	
+	// Lagrange coefficients
+	double r_mag = r0_mag*U[0] + sigma0*U[1] + U[2];
+	double F = 1 - U[2]/r0_mag;
+	double G = (r0_mag*U[1] + sigma0*U[2]) / sqrt_mu;
+	double Ft = -sqrt_mu * U[1] / (r_mag * r0_mag);
+	double Gt = 1 - U[2]/r_mag;
+	Vector3 r = add_vec3(scale_vec3(r0, F), scale_vec3(v0, G));
+	Vector3 v = add_vec3(scale_vec3(r0, Ft), scale_vec3(v0, Gt));
+	if(stm == NULL) return (OSV) {r, v};
+	
+	// Battin, An Introduction to the Mathematics and Methods of Astrodynamics, section 9.7
+	double C = (3*U[5] - chi*U[4] - sqrt_mu*dt*U[2]) / sqrt_mu;
+	Vector3 dr = subtract_vec3(r, r0), dv = subtract_vec3(v, v0);
+	double r_sq = r_mag*r_mag, r_cb = r_sq*r_mag, r0_cb = r0_mag*r0_mag*r0_mag;
+	// (r v^T - v r^T) r
+	Vector3 w = subtract_vec3(scale_vec3(r, dot_vec3(v, r)), scale_vec3(v, r_sq));
+	double rv[3] = {r.x, r.y, r.z}, vv[3] = {v.x, v.y, v.z}, r0v[3] = {r0.x, r0.y, r0.z}, v0v[3] = {v0.x, v0.y, v0.z};
+	double drv[3] = {dr.x, dr.y, dr.z}, dvv[3] = {dv.x, dv.y, dv.z}, wv[3] = {w.x, w.y, w.z};
+	for(int i = 0; i < 3; i++) {
+		for(int j = 0; j < 3; j++) {
+			double id = i == j ? 1 : 0;
+			// dr/dr0
+			stm[i][j] = r_mag/mu * dvv[i]*dvv[j] + (r0_mag*(1-F) * rv[i]*r0v[j] + C * vv[i]*r0v[j]) / r0_cb + F*id;
+			// dr/dv0
+			stm[i][j+3] = r0_mag/mu * (1-F) * (drv[i]*v0v[j] - dvv[i]*r0v[j]) + C/mu * vv[i]*v0v[j] + G*id;
+			// dv/dr0
+			stm[i+3][j] = -dvv[i]*r0v[j] / (r0_mag*r0_mag) - rv[i]*dvv[j] / r_sq
+					+ Ft * (id - rv[i]*rv[j]/r_sq + wv[i]*dvv[j] / (mu*r_mag))
+					- mu*C / (r_cb*r0_cb) * rv[i]*r0v[j];
+			// dv/dv0
+			stm[i+3][j+3] = r0_mag/mu * dvv[i]*dvv[j] + (r0_mag*(1-F) * rv[i]*r0v[j] - C * rv[i]*v0v[j]) / r_cb + Gt*id;
+		}
+	}
+	return (OSV) {r, v};
+}
+
+OSV propagate_universal_orbit(const UniversalOrbit *orbit, double dt) {
+	return propagate_universal_orbit_stm(orbit, dt, NULL);
+}
+
+OSV propagate_osv_time_stm(OSV osv, Body *cb, double dt, double stm[6][6]) {
+	UniversalOrbit orbit = prepare_universal_orbit(osv, cb);
+	return propagate_universal_orbit_stm(&orbit, dt, stm);
+}
+
+void propagate_osv_covariance_batch(const OSV *osvs, double (*covs)[6][6], int num, Body *cb, double dt, OSV *out_osvs, double (*out_covs)[6][6]) {
+	double stm[6][6], stm_cov[6][6];
+	for(int n = 0; n < num; n++) {
+		out_osvs[n] = propagate_osv_time_stm(osvs[n], cb, dt, stm);
+		for(int i = 0; i < 6; i++) {
+			for(int j = 0; j < 6; j++) {
+				double sum = 0;
+				for(int k = 0; k < 6; k++) sum += stm[i][k] * covs[n][k][j];
+				stm_cov[i][j] = sum;
+			}
+		}
+		// symmetric result: upper triangle mirrored
+		for(int i = 0; i < 6; i++) {
+			for(int j = i; j < 6; j++) {
+				double sum = 0;
+				for(int k = 0; k < 6; k++) sum += stm_cov[i][k] * stm[j][k];
+				out_covs[n][i][j] = out_covs[n][j][i] = sum;
+			}
+		}
+	}
+}
+
 OSV propagate_osv_ta(OSV osv, Body *cb, double delta_ta) {
 	Orbit orbit = constr_orbit_from_osv(osv.r, osv.v, cb);
 	orbit.ta = pi_norm(orbit.ta+delta_ta);
@@ -0,0 +1,359 @@
+#include "orbitlib_propagator.h"
+#include "orbitlib_celestial.h"
+#include <math.h>
+
+// attempts per step before giving up (step size shrinks by at least a factor of 5 per rejection)
+#define PROPAGATOR_MAX_ATTEMPTS 50
+
+
+// Dormand-Prince 5(4) (Hairer, Norsett & Wanner, Solving Ordinary Differential Equations I, dopri5)
+static const double dp_c[7] = {0, 1.0/5, 3.0/10, 4.0/5, 8.0/9, 1, 1};
+static const double dp_a[7][6] = {
+		{0},
+		{1.0/5},
+		{3.0/40, 9.0/40},
+		{44.0/45, -56.0/15, 32.0/9},
+		{19372.0/6561, -25360.0/2187, 64448.0/6561, -212.0/729},
+		{9017.0/3168, -355.0/33, 46732.0/5247, 49.0/176, -5103.0/18656},
+		{35.0/384, 0, 500.0/1113, 125.0/192, -2187.0/6784, 11.0/84}
+};
+// difference of the 5th and 4th order solutions
+static const double dp_e[7] = {71.0/57600, 0, -71.0/16695, 71.0/1920, -17253.0/339200, 22.0/525, -1.0/40};
+// continuous extension
+static const double dp_d[7] = {-12715105075.0/11282082432, 0, 87487479700.0/32700410799, -10690763975.0/1880347072,
+							   701980252875.0/199316789632, -1453857185.0/822651844, 69997945.0/29380423};
+
+
+PropagatorParams get_default_propagator_params() {
+	PropagatorParams params = {
+			.rel_tol = 1e-10,
+			.abs_tol_pos = 1e-3,
+			.abs_tol_vel = 1e-6,
+			.max_step = 0,
+			.use_j2 = 1,
+			.use_third_bodies = 1
+	};
+	return params;
+}
+
+
+/*
+ * ------------------------------------
+ * Force Model
+ * ------------------------------------
+ */
+
+static int is_ephem_body(const Body *body) {
+	CelestSystem *system = body->orbit.cb != NULL ? body->orbit.cb->system : NULL;
+	return system != NULL && system->prop_method == EPHEMS && body->ephem != NULL && body->num_ephems > 0;
+}
+
+// keeps the most massive perturbing bodies (sorted by mu, descending)
+static void add_third_body(Propagator *prop, PropagatorThirdBody third_body) {
+	int idx = prop->num_third_bodies;
+	if(idx == PROPAGATOR_MAX_THIRD_BODIES) {
+		if(third_body.mu <= prop->third_bodies[idx-1].mu) return;
+		idx--;
+	} else {
+		prop->num_third_bodies++;
+	}
+	for(; idx > 0 && prop->third_bodies[idx-1].mu < third_body.mu; idx--) prop->third_bodies[idx] = prop->third_bodies[idx-1];
+	prop->third_bodies[idx] = third_body;
+}
+
+static void init_third_bodies(Propagator *prop) {
+	prop->num_third_bodies = 0;
+	if(!prop->params.use_third_bodies) return;
+	Body *cb = prop->cb;
+	for(int i = 0; cb->system != NULL && i < cb->system->num_bodies; i++) {
+		Body *body = cb->system->bodies[i];
+		if(body == NULL || body->mu <= 0) continue;
+		add_third_body(prop, (PropagatorThirdBody) {body, cb, body->mu, get_body_osv(body, prop->epoch), 0, 0});
+	}
+	if(cb->orbit.cb != NULL && cb->orbit.cb->mu > 0) {
+		add_third_body(prop, (PropagatorThirdBody) {cb->orbit.cb, cb->orbit.cb, cb->orbit.cb->mu, get_body_osv(cb, prop->epoch), 0, 1});
+	}
+}
+
+// ephemeris states are only accurate close to their epoch: new reference states at the start of each step
+static void refresh_third_bodies(Propagator *prop) {
+	for(int i = 0; i < prop->num_third_bodies; i++) {
+		PropagatorThirdBody *third_body = &prop->third_bodies[i];
+		Body *moving_body = third_body->is_parent ? prop->cb : third_body->body;
+		if(!is_ephem_body(moving_body)) continue;
+		third_body->osv = get_body_osv(moving_body, prop->epoch + prop->t / 86400);
+		third_body->t_ref = prop->t;
+	}
+}
+
+// derivatives of num states (component c of state i at y[c*stride + i]) at t [s since the start epoch]; positions of the
+// perturbing bodies are evaluated once for all states
+static void calc_derivatives(const Propagator *prop, double t, const double *y, double *dy, int num, int stride) {
+	Vector3 tb_pos[PROPAGATOR_MAX_THIRD_BODIES];
+	Vector3 tb_indirect[PROPAGATOR_MAX_THIRD_BODIES];		// acceleration of the central body towards the perturbing body / mu
+	for(int k = 0; k < prop->num_third_bodies; k++) {
+		const PropagatorThirdBody *third_body = &prop->third_bodies[k];
+		OSV osv = propagate_osv_time_stm(third_body->osv, third_body->attractor, t - third_body->t_ref, NULL);
+		tb_pos[k] = third_body->is_parent ? scale_vec3(osv.r, -1) : osv.r;
+		double dist = mag_vec3(tb_pos[k]);
+		tb_indirect[k] = scale_vec3(tb_pos[k], 1 / (dist*dist*dist));
+	}
+	double mu = prop->cb->mu;
+	double j2_factor = prop->params.use_j2 ? 1.5 * prop->cb->j2 * mu * prop->cb->radius * prop->cb->radius : 0;
+	Vector3 pole = prop->pole;
+
+	for(int i = 0; i < num; i++) {
+		double x = y[i], yy = y[stride + i], z = y[2*stride + i];
+		double r_sq = x*x + yy*yy + z*z;
+		double r = sqrt(r_sq);
+		double central = -mu / (r_sq*r);
+		double ax = central*x, ay = central*yy, az = central*z;
+		if(j2_factor != 0) {
+			// -3/2 J2 mu R² / r^5 * ((1 - 5 (z/r)²) r + 2 z k), z along the pole k
+			double z_pole = x*pole.x + yy*pole.y + z*pole.z;
+			double j2_scale = -j2_factor / (r_sq*r_sq*r);
+			double radial = j2_scale * (1 - 5*z_pole*z_pole/r_sq), axial = j2_scale * 2*z_pole;
+			ax += radial*x + axial*pole.x;
+			ay += radial*yy + axial*pole.y;
+			az += radial*z + axial*pole.z;
+		}
+		for(int k = 0; k < prop->num_third_bodies; k++) {
+			double dx = tb_pos[k].x - x, dyy = tb_pos[k].y - yy, dz = tb_pos[k].z - z;
+			double d_sq = dx*dx + dyy*dyy + dz*dz;
+			double direct = 1 / (d_sq*sqrt(d_sq));
+			double tb_mu = prop->third_bodies[k].mu;
+			ax += tb_mu * (dx*direct - tb_indirect[k].x);
+			ay += tb_mu * (dyy*direct - tb_indirect[k].y);
+			az += tb_mu * (dz*direct - tb_indirect[k].z);
+		}
+		dy[i] = y[3*stride + i];
+		dy[stride + i] = y[4*stride + i];
+		dy[2*stride + i] = y[5*stride + i];
+		dy[3*stride + i] = ax;
+		dy[4*stride + i] = ay;
+		dy[5*stride + i] = az;
+	}
+}
+
+
+/*
+ * ------------------------------------
+ * Dormand-Prince Steps
+ * ------------------------------------
+ */
+
+static double get_error_scale(const Propagator *prop, int component, double y0, double y1) {
+	return (component < 3 ? prop->params.abs_tol_pos : prop->params.abs_tol_vel) + prop->params.rel_tol * fmax(fabs(y0), fabs(y1));
+}
+
+// one step of size h from t for num states (layout of calc_derivatives(); k: 7 stages of 6*stride values, k[0] holds the
+// derivative at y); returns the largest scaled error norm of the states (<= 1: acceptable)
+static double attempt_dopri_step(const Propagator *prop, double t, double h, const double *y, double *k, double *y_new, int num, int stride) {
+	int size = 6*stride;
+	double y_stage[6*PROPAGATOR_BATCH_LANES];
+	for(int s = 1; s < 7; s++) {
+		for(int c = 0; c < 6; c++) {
+			for(int i = 0; i < num; i++) {
+				double sum = 0;
+				for(int j = 0; j < s; j++) sum += dp_a[s][j] * k[j*size + c*stride + i];
+				(s < 6 ? y_stage : y_new)[c*stride + i] = y[c*stride + i] + h*sum;
+			}
+		}
+		// the last stage is the derivative at the new state (first stage of the next step)
+		calc_derivatives(prop, t + dp_c[s]*h, s < 6 ? y_stage : y_new, &k[s*size], num, stride);
+	}
+
+	double max_error = 0;
+	for(int i = 0; i < num; i++) {
+		double sum_sq = 0;
+		for(int c = 0; c < 6; c++) {
+			double error = 0;
+			for(int j = 0; j < 7; j++) error += dp_e[j] * k[j*size + c*stride + i];
+			error *= h / get_error_scale(prop, c, y[c*stride + i], y_new[c*stride + i]);
+			sum_sq += error*error;
+		}
+		double norm = sqrt(sum_sq / 6);
+		if(isnan(norm)) return norm;
+		if(norm > max_error) max_error = norm;
+	}
+	return max_error;
+}
+
+// first step size guess (Hairer's heuristic): change of the state by about 1% of its scale
+static double calc_initial_step(const Propagator *prop, const double *y, const double *dy, int num, int stride) {
+	double h = INFINITY;
+	for(int i = 0; i < num; i++) {
+		double norm_y = 0, norm_dy = 0;
+		for(int c = 0; c < 6; c++) {
+			double scale = get_error_scale(prop, c, y[c*stride + i], y[c*stride + i]);
+			norm_y += pow(y[c*stride + i] / scale, 2);
+			norm_dy += pow(dy[c*stride + i] / scale, 2);
+		}
+		double h_state = norm_dy > 0 ? 0.01 * sqrt(norm_y / norm_dy) : 1;
+		if(h_state < h) h = h_state;
+	}
+	return fmax(h, 1e-6);
+}
+
+static double calc_next_step(double h, double error) {
+	double factor = error > 0 ? 0.9 * pow(error, -0.2) : 5;
+	return h * fmin(5, fmax(0.2, factor));
+}
+
+static void osv_to_array(OSV osv, double *y, int stride) {
+	y[0] = osv.r.x; y[stride] = osv.r.y; y[2*stride] = osv.r.z;
+	y[3*stride] = osv.v.x; y[4*stride] = osv.v.y; y[5*stride] = osv.v.z;
+}
+
+static OSV osv_from_array(const double *y, int stride) {
+	return (OSV) {vec3(y[0], y[stride], y[2*stride]), vec3(y[3*stride], y[4*stride], y[5*stride])};
+}
+
+
+/*
+ * ------------------------------------
+ * Numerical Propagation
+ * ------------------------------------
+ */
+
+void init_propagator(Propagator *prop, OSV osv, double epoch, Body *cb, const PropagatorParams *params) {
+	prop->cb = cb;
+	prop->params = *params;
+	prop->epoch = epoch;
+	prop->t = 0;
+	prop->osv = osv;
+	prop->dense_t0 = 0;
+	prop->dense_h = 0;
+	prop->pole = vec3_from_angles(cb->north_pole_ra, cb->north_pole_decl);
+	prop->num_steps = 0;
+	prop->num_rejected = 0;
+	init_third_bodies(prop);
+
+	double y[6];
+	osv_to_array(osv, y, 1);
+	calc_derivatives(prop, 0, y, prop->k[0], 1, 1);
+	prop->h = calc_initial_step(prop, y, prop->k[0], 1, 1);
+}
+
+int step_propagator(Propagator *prop, double t_end) {
+	double remaining = t_end - prop->t;
+	if(remaining == 0) return 0;
+	double direction = remaining > 0 ? 1 : -1;
+	refresh_third_bodies(prop);
+
+	double y[6], y_new[6];
+	osv_to_array(prop->osv, y, 1);
+	for(int attempt = 0; attempt < PROPAGATOR_MAX_ATTEMPTS; attempt++) {
+		double h = fmin(fabs(prop->h), fabs(remaining));
+		if(prop->params.max_step > 0) h = fmin(h, prop->params.max_step);
+		if(h < 1e-12 * fmax(fabs(prop->t), 1)) return 0;
+		h *= direction;
+
+		double error = attempt_dopri_step(prop, prop->t, h, y, &prop->k[0][0], y_new, 1, 1);
+		if(!(error <= 1)) {
+			prop->h = isnan(error) ? h / 5 : calc_next_step(h, error);
+			prop->num_rejected++;
+			continue;
+		}
+		for(int c = 0; c < 6; c++) {
+			double diff = y_new[c] - y[c];
+			double bspl = h*prop->k[0][c] - diff;
+			double dense4 = 0;
+			for(int j = 0; j < 7; j++) dense4 += dp_d[j] * prop->k[j][c];
+			prop->dense[0][c] = y[c];
+			prop->dense[1][c] = diff;
+			prop->dense[2][c] = bspl;
+			prop->dense[3][c] = diff - h*prop->k[6][c] - bspl;
+			prop->dense[4][c] = h * dense4;
+			prop->k[0][c] = prop->k[6][c];
+		}
+		prop->dense_t0 = prop->t;
+		prop->dense_h = h;
+		// land exactly on t_end
+		prop->t = fabs(h) == fabs(remaining) ? t_end : prop->t + h;
+		prop->osv = osv_from_array(y_new, 1);
+		prop->h = calc_next_step(h, error);
+		prop->num_steps++;
+		return 1;
+	}
+	return 0;
+}
+
+OSV interpolate_propagator(const Propagator *prop, double t) {
+	if(prop->dense_h == 0) return prop->osv;
+	double theta = (t - prop->dense_t0) / prop->dense_h, theta1 = 1 - theta;
+	double y[6];
+	for(int c = 0; c < 6; c++) {
+		y[c] = prop->dense[0][c] + theta*(prop->dense[1][c] + theta1*(prop->dense[2][c] + theta*(prop->dense[3][c] + theta1*prop->dense[4][c])));
+	}
+	return osv_from_array(y, 1);
+}
+
+OSV propagate_osv_numerical(OSV osv, double epoch, Body *cb, double dt, const PropagatorParams *params) {
+	Propagator prop;
+	init_propagator(&prop, osv, epoch, cb, params);
+	while(prop.t != dt) {
+		if(!step_propagator(&prop, dt)) return (OSV) {vec3(NAN, NAN, NAN), vec3(NAN, NAN, NAN)};
+	}
+	return prop.osv;
+}
+
+// integrates up to PROPAGATOR_BATCH_LANES states in lockstep (shared step size; largest error decides)
+static void propagate_batch_lanes(Propagator *prop, const OSV *osvs, int num, double dt, OSV *out) {
+	double y[6*PROPAGATOR_BATCH_LANES], y_new[6*PROPAGATOR_BATCH_LANES], k[7*6*PROPAGATOR_BATCH_LANES];
+	int stride = PROPAGATOR_BATCH_LANES;
+	for(int i = 0; i < num; i++) osv_to_array(osvs[i], &y[i], stride);
+	prop->t = 0;
+	calc_derivatives(prop, 0, y, k, num, stride);
+	double h_next = calc_initial_step(prop, y, k, num, stride);
+	double direction = dt < 0 ? -1 : 1;
+
+	while(prop->t != dt) {
+		refresh_third_bodies(prop);
+		double remaining = dt - prop->t;
+		int accepted = 0;
+		for(int attempt = 0; attempt < PROPAGATOR_MAX_ATTEMPTS && !accepted; attempt++) {
+			double h = fmin(h_next, fabs(remaining));
+			if(prop->params.max_step > 0) h = fmin(h, prop->params.max_step);
+			if(h < 1e-12 * fmax(fabs(prop->t), 1)) break;
+			h *= direction;
+
+			double error = attempt_dopri_step(prop, prop->t, h, y, k, y_new, num, stride);
+			if(!(error <= 1)) {
+				h_next = fabs(isnan(error) ? h / 5 : calc_next_step(h, error));
+				continue;
+			}
+			for(int c = 0; c < 6; c++) {
+				for(int i = 0; i < num; i++) {
+					y[c*stride + i] = y_new[c*stride + i];
+					k[c*stride + i] = k[6*6*stride + c*stride + i];
+				}
+			}
+			prop->t = fabs(h) == fabs(remaining) ? dt : prop->t + h;
+			h_next = fabs(calc_next_step(h, error));
+			accepted = 1;
+		}
+		if(!accepted) {
+			for(int i = 0; i < num; i++) out[i] = (OSV) {vec3(NAN, NAN, NAN), vec3(NAN, NAN, NAN)};
+			return;
+		}
+	}
+	for(int i = 0; i < num; i++) out[i] = osv_from_array(&y[i], stride);
+}
+
+void propagate_osv_numerical_batch(const OSV *osvs, int num, double epoch, Body *cb, double dt, const PropagatorParams *params, OSV *out) {
+	if(num <= 0) return;
+	Propagator prop;
+	init_propagator(&prop, osvs[0], epoch, cb, params);
+	PropagatorThirdBody initial_third_bodies[PROPAGATOR_MAX_THIRD_BODIES];
+	for(int k = 0; k < prop.num_third_bodies; k++) initial_third_bodies[k] = prop.third_bodies[k];
+
+	for(int first = 0; first < num; first += PROPAGATOR_BATCH_LANES) {
+		int num_lanes = num - first < PROPAGATOR_BATCH_LANES ? num - first : PROPAGATOR_BATCH_LANES;
+		for(int k = 0; k < prop.num_third_bodies; k++) prop.third_bodies[k] = initial_third_bodies[k];
+		// copy first: out may alias osvs
+		OSV lanes[PROPAGATOR_BATCH_LANES];
+		for(int i = 0; i < num_lanes; i++) lanes[i] = osvs[first + i];
+		propagate_batch_lanes(&prop, lanes, num_lanes, dt, &out[first]);
+	}
+}
@@ -0,0 +1,45 @@
+#include "rootfind_internal.h"
+#include <stddef.h>
+#include <math.h>
+
+
+RootBracket init_root_bracket(Vector2 p0, Vector2 p1) {
+	return (RootBracket) {p0, p1, -1};
+}
+
+double root_bracket_next_x(const RootBracket *bracket) {
+	Vector2 p0 = bracket->p0, p1 = bracket->p1;
+	if(fabs(p0.y) <= 1e50 && fabs(p1.y) <= 1e50) {
+		double x = p0.x - p0.y * (p1.x - p0.x) / (p1.y - p0.y);
+		if(x > fmin(p0.x, p1.x) && x < fmax(p0.x, p1.x)) return x;
+	}
+	double x = (p0.x + p1.x) / 2;
+	return x == p0.x || x == p1.x ? NAN : x;
+}
+
+void root_bracket_insert(RootBracket *bracket, Vector2 p) {
+	if((p.y < 0) == (bracket->p0.y < 0)) {
+		bracket->p0 = p;
+		if(bracket->kept == 1) bracket->p1.y /= 2;
+		bracket->kept = 1;
+	} else {
+		bracket->p1 = p;
+		if(bracket->kept == 0) bracket->p0.y /= 2;
+		bracket->kept = 0;
+	}
+}
+
+double find_bracketed_root(double (*f)(double x, void *data), void *data, double x0, double f0, double x1, double f1, double tolerance, double *fx) {
+	RootBracket bracket = init_root_bracket(vec2(x0, f0), vec2(x1, f1));
+	double x = x0, y = f0;
+	for(int i = 0; i < ROOT_BRACKET_MAX_ITERATIONS && fabs(bracket.p1.x - bracket.p0.x) > tolerance; i++) {
+		double next_x = root_bracket_next_x(&bracket);
+		if(isnan(next_x)) break;
+		x = next_x;
+		y = f(x, data);
+		if(y == 0) break;
+		root_bracket_insert(&bracket, vec2(x, y));
+	}
+	if(fx != NULL) *fx = y;
+	return x;
+}
@@ -0,0 +1,29 @@
+#ifndef ORBITLIB_ROOTFIND_INTERNAL_H
+#define ORBITLIB_ROOTFIND_INTERNAL_H
+
+// Bracketed root finding (regula falsi with the Illinois modification) shared by the Lambert solver and the event searches
+
+#include "geometrylib.h"
+
+// maximum number of function evaluations of find_bracketed_root()
+#define ROOT_BRACKET_MAX_ITERATIONS 100
+
+// bracket around the root of a function (kept on the stack; no allocations)
+typedef struct RootBracket {
+	Vector2 p0, p1;		// points (x, f(x)) with function values of opposite sign; |f| > 1e50 marks an end at "infinity"
+	int kept;			// point kept in the last step (0 or 1; -1 if none) -> Illinois modification against one-sided convergence
+} RootBracket;
+
+RootBracket init_root_bracket(Vector2 p0, Vector2 p1);
+
+// next x by regula falsi (bisection if an end is at "infinity" or the secant leaves the bracket); NAN if the bracket can not be narrowed anymore
+double root_bracket_next_x(const RootBracket *bracket);
+
+// replaces the end with the same sign as p.y
+void root_bracket_insert(RootBracket *bracket, Vector2 p);
+
+// refines the root of f within [x0, x1] (f0 and f1 of opposite sign) until the bracket is narrower than tolerance, f is 0 or
+// ROOT_BRACKET_MAX_ITERATIONS evaluations are reached; returns the last evaluated x (x0 if none) and its value in fx (can be NULL)
+double find_bracketed_root(double (*f)(double x, void *data), void *data, double x0, double f0, double x1, double f1, double tolerance, double *fx);
+
+#endif //ORBITLIB_ROOTFIND_INTERNAL_H
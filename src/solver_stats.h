@@ -0,0 +1,20 @@
+#ifndef ORBITLIB_SOLVER_STATS_H
+#define ORBITLIB_SOLVER_STATS_H
+
+// Internal recording of solver statistics; compiles to nothing without ORBITLIB_SOLVER_STATS
+
+#include "orbitlib_stats.h"
+
+#ifdef ORBITLIB_SOLVER_STATS
+#include "threading.h"
+
+void record_solver_stats(enum SolverId solver, uint64_t start_ns, int iterations, int cap_hit, int result);
+
+#define SOLVER_STATS_START(start) uint64_t start = orbitlib_time_ns()
+#define SOLVER_STATS_RECORD(solver, start, iterations, cap_hit, result) record_solver_stats(solver, start, iterations, cap_hit, result)
+#else
+#define SOLVER_STATS_START(start)
+#define SOLVER_STATS_RECORD(solver, start, iterations, cap_hit, result) ((void) 0)
+#endif
+
+#endif //ORBITLIB_SOLVER_STATS_H
@@ -0,0 +1,192 @@
+#include "orbitlib_stats.h"
+#include "solver_stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char *solver_names[NUM_SOLVERS] = {"lambert2", "propagate_orbit_time", "kepler", "lambert_multirev"};
+static const char *lambert_result_names[SOLVER_STATS_NUM_RESULTS] = {
+		"LAMBERT_SUCCESS", "LAMBERT_IMPRECISION", "LAMBERT_MAX_ITERATIONS", "LAMBERT_FAIL_NAN", "LAMBERT_FAIL_ECC"
+};
+
+
+#ifdef ORBITLIB_SOLVER_STATS
+#include <stdatomic.h>
+
+typedef struct AtomicSolverStats {
+	atomic_uint_least64_t calls, iterations, max_iterations, cap_hits, time_ns;
+	atomic_uint_least64_t histogram[SOLVER_STATS_NUM_BINS];
+	atomic_uint_least64_t results[SOLVER_STATS_NUM_RESULTS];
+} AtomicSolverStats;
+
+// counters of one thread (only written by the owning thread -> no read-modify-write atomics needed, just tear-free loads/stores)
+typedef struct ThreadSolverStats {
+	AtomicSolverStats solvers[NUM_SOLVERS];
+	struct ThreadSolverStats *prev, *next;
+} ThreadSolverStats;
+
+#define STAT_LOAD(counter) atomic_load_explicit(&(counter), memory_order_relaxed)
+#define STAT_STORE(counter, value) atomic_store_explicit(&(counter), (value), memory_order_relaxed)
+#define STAT_ADD(counter, value) STAT_STORE(counter, STAT_LOAD(counter) + (value))
+
+static OrbitlibMutex stats_mutex = ORBITLIB_MUTEX_INITIALIZER;
+static OrbitlibOnce stats_once = ORBITLIB_ONCE_INITIALIZER;
+static OrbitlibThreadKey stats_key;
+static int has_stats_key = 0;
+static ThreadSolverStats *thread_stats_list = NULL;
+static ThreadSolverStats retired_stats;		// merged counters of exited threads (guarded by stats_mutex)
+static ORBITLIB_THREAD_LOCAL ThreadSolverStats *thread_stats = NULL;
+
+static void merge_atomic_solver_stats(AtomicSolverStats *dst, AtomicSolverStats *src) {
+	STAT_ADD(dst->calls, STAT_LOAD(src->calls));
+	STAT_ADD(dst->iterations, STAT_LOAD(src->iterations));
+	STAT_ADD(dst->cap_hits, STAT_LOAD(src->cap_hits));
+	STAT_ADD(dst->time_ns, STAT_LOAD(src->time_ns));
+	if(STAT_LOAD(src->max_iterations) > STAT_LOAD(dst->max_iterations)) STAT_STORE(dst->max_iterations, STAT_LOAD(src->max_iterations));
+	for(int i = 0; i < SOLVER_STATS_NUM_BINS; i++) STAT_ADD(dst->histogram[i], STAT_LOAD(src->histogram[i]));
+	for(int i = 0; i < SOLVER_STATS_NUM_RESULTS; i++) STAT_ADD(dst->results[i], STAT_LOAD(src->results[i]));
+}
+
+static void reset_atomic_solver_stats(AtomicSolverStats *stats) {
+	STAT_STORE(stats->calls, 0);
+	STAT_STORE(stats->iterations, 0);
+	STAT_STORE(stats->max_iterations, 0);
+	STAT_STORE(stats->cap_hits, 0);
+	STAT_STORE(stats->time_ns, 0);
+	for(int i = 0; i < SOLVER_STATS_NUM_BINS; i++) STAT_STORE(stats->histogram[i], 0);
+	for(int i = 0; i < SOLVER_STATS_NUM_RESULTS; i++) STAT_STORE(stats->results[i], 0);
+}
+
+// called on thread exit: keeps the counters of the thread and releases its block
+static void retire_thread_stats(void *ptr) {
+	ThreadSolverStats *stats = ptr;
+	orbitlib_mutex_lock(&stats_mutex);
+	for(int i = 0; i < NUM_SOLVERS; i++) merge_atomic_solver_stats(&retired_stats.solvers[i], &stats->solvers[i]);
+	if(stats->prev != NULL) stats->prev->next = stats->next;
+	else thread_stats_list = stats->next;
+	if(stats->next != NULL) stats->next->prev = stats->prev;
+	orbitlib_mutex_unlock(&stats_mutex);
+	if(thread_stats == stats) thread_stats = NULL;
+	free(stats);
+}
+
+static void init_stats_key() {
+	has_stats_key = orbitlib_thread_key_create(&stats_key, retire_thread_stats);
+}
+
+static ThreadSolverStats * register_thread_stats() {
+	ThreadSolverStats *stats = calloc(1, sizeof(ThreadSolverStats));
+	if(stats == NULL) return NULL;
+	orbitlib_call_once(&stats_once, init_stats_key);
+
+	orbitlib_mutex_lock(&stats_mutex);
+	stats->next = thread_stats_list;
+	if(thread_stats_list != NULL) thread_stats_list->prev = stats;
+	thread_stats_list = stats;
+	orbitlib_mutex_unlock(&stats_mutex);
+
+	if(has_stats_key) orbitlib_thread_key_set(stats_key, stats);
+	thread_stats = stats;
+	return stats;
+}
+
+static int get_histogram_bin(int iterations) {
+	if(iterations <= 0) return 0;
+	int bin = 1;
+	while(bin < SOLVER_STATS_NUM_BINS-1 && (1 << bin) <= iterations) bin++;
+	return bin;
+}
+
+void record_solver_stats(enum SolverId solver, uint64_t start_ns, int iterations, int cap_hit, int result) {
+	uint64_t elapsed = orbitlib_time_ns() - start_ns;
+	ThreadSolverStats *stats = thread_stats != NULL ? thread_stats : register_thread_stats();
+	if(stats == NULL) return;
+
+	AtomicSolverStats *s = &stats->solvers[solver];
+	STAT_ADD(s->calls, 1);
+	STAT_ADD(s->iterations, (uint64_t) (iterations > 0 ? iterations : 0));
+	if((uint64_t) iterations > STAT_LOAD(s->max_iterations) && iterations > 0) STAT_STORE(s->max_iterations, (uint64_t) iterations);
+	if(cap_hit) STAT_ADD(s->cap_hits, 1);
+	STAT_ADD(s->time_ns, elapsed);
+	STAT_ADD(s->histogram[get_histogram_bin(iterations)], 1);
+	if(result >= 0 && result < SOLVER_STATS_NUM_RESULTS) STAT_ADD(s->results[result], 1);
+}
+
+int are_solver_stats_enabled() {
+	return 1;
+}
+
+SolverStats get_solver_stats(enum SolverId solver) {
+	SolverStats stats = {0};
+	if(solver < 0 || solver >= NUM_SOLVERS) return stats;
+
+	AtomicSolverStats merged;
+	reset_atomic_solver_stats(&merged);
+	orbitlib_mutex_lock(&stats_mutex);
+	merge_atomic_solver_stats(&merged, &retired_stats.solvers[solver]);
+	for(ThreadSolverStats *s = thread_stats_list; s != NULL; s = s->next) merge_atomic_solver_stats(&merged, &s->solvers[solver]);
+	orbitlib_mutex_unlock(&stats_mutex);
+
+	stats.calls = STAT_LOAD(merged.calls);
+	stats.iterations = STAT_LOAD(merged.iterations);
+	stats.max_iterations = STAT_LOAD(merged.max_iterations);
+	stats.cap_hits = STAT_LOAD(merged.cap_hits);
+	stats.time = (double) STAT_LOAD(merged.time_ns) * 1e-9;
+	for(int i = 0; i < SOLVER_STATS_NUM_BINS; i++) stats.histogram[i] = STAT_LOAD(merged.histogram[i]);
+	for(int i = 0; i < SOLVER_STATS_NUM_RESULTS; i++) stats.results[i] = STAT_LOAD(merged.results[i]);
+	return stats;
+}
+
+void reset_solver_stats() {
+	orbitlib_mutex_lock(&stats_mutex);
+	for(int i = 0; i < NUM_SOLVERS; i++) {
+		reset_atomic_solver_stats(&retired_stats.solvers[i]);
+		for(ThreadSolverStats *s = thread_stats_list; s != NULL; s = s->next) reset_atomic_solver_stats(&s->solvers[i]);
+	}
+	orbitlib_mutex_unlock(&stats_mutex);
+}
+
+#else
+
+int are_solver_stats_enabled() {
+	return 0;
+}
+
+SolverStats get_solver_stats(enum SolverId solver) {
+	(void) solver;
+	SolverStats stats = {0};
+	return stats;
+}
+
+void reset_solver_stats() {}
+
+#endif
+
+
+const char * get_solver_name(enum SolverId solver) {
+	if(solver < 0 || solver >= NUM_SOLVERS) return "unknown";
+	return solver_names[solver];
+}
+
+void dump_solver_stats_json(FILE *file) {
+	fprintf(file, "{\"enabled\": %s, \"solvers\": {", are_solver_stats_enabled() ? "true" : "false");
+	for(int i = 0; i < NUM_SOLVERS; i++) {
+		SolverStats stats = get_solver_stats(i);
+		fprintf(file, "%s\n  \"%s\": {\"calls\": %llu, \"iterations\": %llu, \"mean_iterations\": %.3f, \"max_iterations\": %llu, "
+					  "\"cap_hits\": %llu, \"time_s\": %.9f, \"histogram\": [",
+				i > 0 ? "," : "", solver_names[i], (unsigned long long) stats.calls, (unsigned long long) stats.iterations,
+				stats.calls > 0 ? (double) stats.iterations / (double) stats.calls : 0.0, (unsigned long long) stats.max_iterations,
+				(unsigned long long) stats.cap_hits, stats.time);
+		for(int j = 0; j < SOLVER_STATS_NUM_BINS; j++) fprintf(file, "%s%llu", j > 0 ? ", " : "", (unsigned long long) stats.histogram[j]);
+		fprintf(file, "]");
+		if(i == SOLVER_LAMBERT2 || i == SOLVER_LAMBERT_MULTIREV) {
+			fprintf(file, ", \"results\": {");
+			for(int j = 0; j < SOLVER_STATS_NUM_RESULTS; j++) {
+				fprintf(file, "%s\"%s\": %llu", j > 0 ? ", " : "", lambert_result_names[j], (unsigned long long) stats.results[j]);
+			}
+			fprintf(file, "}");
+		}
+		fprintf(file, "}");
+	}
+	fprintf(file, "\n}}\n");
+}
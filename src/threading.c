@@ -0,0 +1,323 @@
+#include "threading.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <time.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+void orbitlib_mutex_init(OrbitlibMutex *mutex) {
+	InitializeSRWLock(mutex);
+}
+
+void orbitlib_mutex_destroy(OrbitlibMutex *mutex) {
+	(void) mutex;
+}
+
+void orbitlib_mutex_lock(OrbitlibMutex *mutex) {
+	AcquireSRWLockExclusive(mutex);
+}
+
+void orbitlib_mutex_unlock(OrbitlibMutex *mutex) {
+	ReleaseSRWLockExclusive(mutex);
+}
+
+void orbitlib_cond_init(OrbitlibCond *cond) {
+	InitializeConditionVariable(cond);
+}
+
+void orbitlib_cond_destroy(OrbitlibCond *cond) {
+	(void) cond;
+}
+
+void orbitlib_cond_wait(OrbitlibCond *cond, OrbitlibMutex *mutex) {
+	SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+}
+
+void orbitlib_cond_broadcast(OrbitlibCond *cond) {
+	WakeAllConditionVariable(cond);
+}
+
+typedef struct ThreadStart {
+	void (*func)(void *);
+	void *arg;
+} ThreadStart;
+
+static DWORD WINAPI thread_start_routine(LPVOID ptr) {
+	ThreadStart start = *(ThreadStart *) ptr;
+	free(ptr);
+	start.func(start.arg);
+	return 0;
+}
+
+int orbitlib_thread_start(OrbitlibThread *thread, void (*func)(void *), void *arg) {
+	ThreadStart *start = malloc(sizeof(ThreadStart));
+	if(start == NULL) return 0;
+	*start = (ThreadStart) {func, arg};
+	*thread = CreateThread(NULL, 0, thread_start_routine, start, 0, NULL);
+	if(*thread == NULL) {
+		free(start);
+		return 0;
+	}
+	return 1;
+}
+
+void orbitlib_thread_join(OrbitlibThread thread) {
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+}
+
+int orbitlib_get_num_processors() {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int) info.dwNumberOfProcessors : 1;
+}
+
+static BOOL CALLBACK call_once_callback(PINIT_ONCE once, PVOID init, PVOID *context) {
+	(void) once; (void) context;
+	((void (*)(void)) init)();
+	return TRUE;
+}
+
+void orbitlib_call_once(OrbitlibOnce *once, void (*init)(void)) {
+	InitOnceExecuteOnce(once, call_once_callback, (PVOID) init, NULL);
+}
+
+int orbitlib_thread_key_create(OrbitlibThreadKey *key, void (*destructor)(void *)) {
+	(void) destructor;
+	*key = TlsAlloc();
+	return *key != TLS_OUT_OF_INDEXES;
+}
+
+void orbitlib_thread_key_set(OrbitlibThreadKey key, void *value) {
+	TlsSetValue(key, value);
+}
+
+uint64_t orbitlib_time_ns() {
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (uint64_t) ((double) count.QuadPart * 1e9 / (double) freq.QuadPart);
+}
+
+#else
+
+void orbitlib_mutex_init(OrbitlibMutex *mutex) {
+	pthread_mutex_init(mutex, NULL);
+}
+
+void orbitlib_mutex_destroy(OrbitlibMutex *mutex) {
+	pthread_mutex_destroy(mutex);
+}
+
+void orbitlib_mutex_lock(OrbitlibMutex *mutex) {
+	pthread_mutex_lock(mutex);
+}
+
+void orbitlib_mutex_unlock(OrbitlibMutex *mutex) {
+	pthread_mutex_unlock(mutex);
+}
+
+void orbitlib_cond_init(OrbitlibCond *cond) {
+	pthread_cond_init(cond, NULL);
+}
+
+void orbitlib_cond_destroy(OrbitlibCond *cond) {
+	pthread_cond_destroy(cond);
+}
+
+void orbitlib_cond_wait(OrbitlibCond *cond, OrbitlibMutex *mutex) {
+	pthread_cond_wait(cond, mutex);
+}
+
+void orbitlib_cond_broadcast(OrbitlibCond *cond) {
+	pthread_cond_broadcast(cond);
+}
+
+typedef struct ThreadStart {
+	void (*func)(void *);
+	void *arg;
+} ThreadStart;
+
+static void * thread_start_routine(void *ptr) {
+	ThreadStart start = *(ThreadStart *) ptr;
+	free(ptr);
+	start.func(start.arg);
+	return NULL;
+}
+
+int orbitlib_thread_start(OrbitlibThread *thread, void (*func)(void *), void *arg) {
+	ThreadStart *start = malloc(sizeof(ThreadStart));
+	if(start == NULL) return 0;
+	*start = (ThreadStart) {func, arg};
+	if(pthread_create(thread, NULL, thread_start_routine, start) != 0) {
+		free(start);
+		return 0;
+	}
+	return 1;
+}
+
+void orbitlib_thread_join(OrbitlibThread thread) {
+	pthread_join(thread, NULL);
+}
+
+int orbitlib_get_num_processors() {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int) n : 1;
+}
+
+void orbitlib_call_once(OrbitlibOnce *once, void (*init)(void)) {
+	pthread_once(once, init);
+}
+
+int orbitlib_thread_key_create(OrbitlibThreadKey *key, void (*destructor)(void *)) {
+	return pthread_key_create(key, destructor) == 0;
+}
+
+void orbitlib_thread_key_set(OrbitlibThreadKey key, void *value) {
+	pthread_setspecific(key, value);
+}
+
+uint64_t orbitlib_time_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+#endif
+
+/*
+ * ------------------------------------
+ * Thread Pool
+ * ------------------------------------
+ */
+
+struct OrbitlibThreadPool {
+	OrbitlibMutex mutex;
+	OrbitlibCond work_cond;		// signalled on new work or shutdown
+	OrbitlibCond done_cond;		// signalled when the last worker finished its part
+	OrbitlibMutex job_mutex;	// serializes parallel_for calls from different threads
+	OrbitlibThread *threads;
+	int num_threads;
+	uint64_t generation;		// incremented for each job
+	int num_busy;
+	int shutdown;
+
+	void (*task)(void *arg, int index);
+	void *arg;
+	int num_tasks;
+	atomic_int next_index;
+};
+
+// pool of the current thread while it works on tasks (for nested parallel_for calls)
+static ORBITLIB_THREAD_LOCAL OrbitlibThreadPool *current_pool = NULL;
+
+static void run_thread_pool_tasks(OrbitlibThreadPool *pool) {
+	for(;;) {
+		int index = atomic_fetch_add_explicit(&pool->next_index, 1, memory_order_relaxed);
+		if(index >= pool->num_tasks) break;
+		pool->task(pool->arg, index);
+	}
+}
+
+static void thread_pool_worker(void *ptr) {
+	OrbitlibThreadPool *pool = ptr;
+	current_pool = pool;
+
+	uint64_t seen_generation = 0;
+	for(;;) {
+		orbitlib_mutex_lock(&pool->mutex);
+		while(!pool->shutdown && pool->generation == seen_generation) orbitlib_cond_wait(&pool->work_cond, &pool->mutex);
+		if(pool->shutdown) {
+			orbitlib_mutex_unlock(&pool->mutex);
+			return;
+		}
+		seen_generation = pool->generation;
+		orbitlib_mutex_unlock(&pool->mutex);
+
+		run_thread_pool_tasks(pool);
+
+		orbitlib_mutex_lock(&pool->mutex);
+		if(--pool->num_busy == 0) orbitlib_cond_broadcast(&pool->done_cond);
+		orbitlib_mutex_unlock(&pool->mutex);
+	}
+}
+
+OrbitlibThreadPool * orbitlib_thread_pool_create(int num_threads) {
+	if(num_threads <= 0) return NULL;
+	OrbitlibThreadPool *pool = calloc(1, sizeof(OrbitlibThreadPool));
+	if(pool == NULL) return NULL;
+	pool->threads = calloc(num_threads, sizeof(OrbitlibThread));
+	if(pool->threads == NULL) {
+		free(pool);
+		return NULL;
+	}
+	orbitlib_mutex_init(&pool->mutex);
+	orbitlib_mutex_init(&pool->job_mutex);
+	orbitlib_cond_init(&pool->work_cond);
+	orbitlib_cond_init(&pool->done_cond);
+
+	for(int i = 0; i < num_threads; i++) {
+		if(!orbitlib_thread_start(&pool->threads[i], thread_pool_worker, pool)) break;
+		pool->num_threads++;
+	}
+	if(pool->num_threads == 0) {
+		orbitlib_thread_pool_free(pool);
+		return NULL;
+	}
+	return pool;
+}
+
+void orbitlib_thread_pool_free(OrbitlibThreadPool *pool) {
+	if(pool == NULL) return;
+	orbitlib_mutex_lock(&pool->mutex);
+	pool->shutdown = 1;
+	orbitlib_cond_broadcast(&pool->work_cond);
+	orbitlib_mutex_unlock(&pool->mutex);
+	for(int i = 0; i < pool->num_threads; i++) orbitlib_thread_join(pool->threads[i]);
+
+	orbitlib_cond_destroy(&pool->work_cond);
+	orbitlib_cond_destroy(&pool->done_cond);
+	orbitlib_mutex_destroy(&pool->mutex);
+	orbitlib_mutex_destroy(&pool->job_mutex);
+	free(pool->threads);
+	free(pool);
+}
+
+int orbitlib_thread_pool_size(OrbitlibThreadPool *pool) {
+	return pool != NULL ? pool->num_threads + 1 : 1;
+}
+
+void orbitlib_parallel_for(OrbitlibThreadPool *pool, int num_tasks, void (*task)(void *arg, int index), void *arg) {
+	if(num_tasks <= 0) return;
+	if(pool == NULL || current_pool == pool) {
+		for(int i = 0; i < num_tasks; i++) task(arg, i);
+		return;
+	}
+
+	orbitlib_mutex_lock(&pool->job_mutex);
+	orbitlib_mutex_lock(&pool->mutex);
+	pool->task = task;
+	pool->arg = arg;
+	pool->num_tasks = num_tasks;
+	atomic_store(&pool->next_index, 0);
+	pool->num_busy = pool->num_threads;
+	pool->generation++;
+	orbitlib_cond_broadcast(&pool->work_cond);
+	orbitlib_mutex_unlock(&pool->mutex);
+
+	// the calling thread takes part in the work
+	OrbitlibThreadPool *prev_pool = current_pool;
+	current_pool = pool;
+	run_thread_pool_tasks(pool);
+	current_pool = prev_pool;
+
+	orbitlib_mutex_lock(&pool->mutex);
+	while(pool->num_busy > 0) orbitlib_cond_wait(&pool->done_cond, &pool->mutex);
+	orbitlib_mutex_unlock(&pool->mutex);
+	orbitlib_mutex_unlock(&pool->job_mutex);
+}
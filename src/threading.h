@@ -0,0 +1,77 @@
+#ifndef ORBITLIB_THREADING_H
+#define ORBITLIB_THREADING_H
+
+// Internal platform layer for threads, locks and thread-local storage (POSIX threads or Win32)
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef SRWLOCK OrbitlibMutex;
+#define ORBITLIB_MUTEX_INITIALIZER SRWLOCK_INIT
+typedef INIT_ONCE OrbitlibOnce;
+#define ORBITLIB_ONCE_INITIALIZER INIT_ONCE_STATIC_INIT
+typedef DWORD OrbitlibThreadKey;
+typedef CONDITION_VARIABLE OrbitlibCond;
+typedef HANDLE OrbitlibThread;
+#else
+#include <pthread.h>
+typedef pthread_mutex_t OrbitlibMutex;
+#define ORBITLIB_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+typedef pthread_once_t OrbitlibOnce;
+#define ORBITLIB_ONCE_INITIALIZER PTHREAD_ONCE_INIT
+typedef pthread_key_t OrbitlibThreadKey;
+typedef pthread_cond_t OrbitlibCond;
+typedef pthread_t OrbitlibThread;
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define ORBITLIB_THREAD_LOCAL __declspec(thread)
+#else
+#define ORBITLIB_THREAD_LOCAL _Thread_local
+#endif
+
+
+void orbitlib_mutex_init(OrbitlibMutex *mutex);
+void orbitlib_mutex_destroy(OrbitlibMutex *mutex);
+void orbitlib_mutex_lock(OrbitlibMutex *mutex);
+void orbitlib_mutex_unlock(OrbitlibMutex *mutex);
+
+void orbitlib_cond_init(OrbitlibCond *cond);
+void orbitlib_cond_destroy(OrbitlibCond *cond);
+void orbitlib_cond_wait(OrbitlibCond *cond, OrbitlibMutex *mutex);
+void orbitlib_cond_broadcast(OrbitlibCond *cond);
+
+// returns 1 if the thread was started
+int orbitlib_thread_start(OrbitlibThread *thread, void (*func)(void *), void *arg);
+void orbitlib_thread_join(OrbitlibThread thread);
+
+// number of logical processors (at least 1)
+int orbitlib_get_num_processors();
+
+// calls init exactly once (thread-safe)
+void orbitlib_call_once(OrbitlibOnce *once, void (*init)(void));
+
+// thread-specific value with a destructor called on thread exit (POSIX only; on Windows, values are kept until process exit)
+int orbitlib_thread_key_create(OrbitlibThreadKey *key, void (*destructor)(void *));
+void orbitlib_thread_key_set(OrbitlibThreadKey key, void *value);
+
+// monotonic clock [ns]
+uint64_t orbitlib_time_ns();
+
+
+// Thread pool with persistent workers; the calling thread takes part in the work as well
+typedef struct OrbitlibThreadPool OrbitlibThreadPool;
+
+// num_threads: number of worker threads besides the calling thread (NULL if no worker could be started)
+OrbitlibThreadPool * orbitlib_thread_pool_create(int num_threads);
+void orbitlib_thread_pool_free(OrbitlibThreadPool *pool);
+
+// number of threads working on a parallel_for (workers + calling thread; 1 without pool)
+int orbitlib_thread_pool_size(OrbitlibThreadPool *pool);
+
+// calls task(arg, index) for all indices in [0, num_tasks) and returns when all tasks are done
+// (serial if pool is NULL or if called from inside a task of the same pool)
+void orbitlib_parallel_for(OrbitlibThreadPool *pool, int num_tasks, void (*task)(void *arg, int index), void *arg);
+
+#endif //ORBITLIB_THREADING_H
@@ -0,0 +1,199 @@
+#include "orbitlib_timescale.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+#define TT_TAI_OFFSET 32.184		// TT-TAI [s]
+#define NTP_EPOCH_JD 2415020.5		// 1900-01-01T00:00 (UTC)
+#define J2000_UT0 2451545.0			// 2000-01-01T12:00
+
+static const LeapSecond builtin_leap_seconds[] = {
+	{2441317.5, 10},	// 1972-01-01
+	{2441499.5, 11},	// 1972-07-01
+	{2441683.5, 12},	// 1973-01-01
+	{2442048.5, 13},	// 1974-01-01
+	{2442413.5, 14},	// 1975-01-01
+	{2442778.5, 15},	// 1976-01-01
+	{2443144.5, 16},	// 1977-01-01
+	{2443509.5, 17},	// 1978-01-01
+	{2443874.5, 18},	// 1979-01-01
+	{2444239.5, 19},	// 1980-01-01
+	{2444786.5, 20},	// 1981-07-01
+	{2445151.5, 21},	// 1982-07-01
+	{2445516.5, 22},	// 1983-07-01
+	{2446247.5, 23},	// 1985-07-01
+	{2447161.5, 24},	// 1988-01-01
+	{2447892.5, 25},	// 1990-01-01
+	{2448257.5, 26},	// 1991-01-01
+	{2448804.5, 27},	// 1992-07-01
+	{2449169.5, 28},	// 1993-07-01
+	{2449534.5, 29},	// 1994-07-01
+	{2450083.5, 30},	// 1996-01-01
+	{2450630.5, 31},	// 1997-07-01
+	{2451179.5, 32},	// 1999-01-01
+	{2453736.5, 33},	// 2006-01-01
+	{2454832.5, 34},	// 2009-01-01
+	{2456109.5, 35},	// 2012-07-01
+	{2457204.5, 36},	// 2015-07-01
+	{2457754.5, 37},	// 2017-01-01
+};
+
+static const LeapSecond *leap_seconds = builtin_leap_seconds;
+static int num_leap_seconds = sizeof(builtin_leap_seconds)/sizeof(LeapSecond);
+static LeapSecond *loaded_leap_seconds = NULL;
+
+
+int load_leap_second_table(const char *filepath) {
+	FILE *file = fopen(filepath, "r");
+	if(file == NULL) {
+		perror("Unable to open leap second file");
+		return 0;
+	}
+
+	int max_entries = 64;
+	int num_entries = 0;
+	LeapSecond *entries = malloc(max_entries * sizeof(LeapSecond));
+	if(entries == NULL) {fclose(file); return 0;}
+
+	char line[256];
+	while(fgets(line, sizeof(line), file) != NULL) {
+		if(line[0] == '#') continue;
+		double ntp_seconds, tai_utc;
+		if(sscanf(line, "%lf %lf", &ntp_seconds, &tai_utc) != 2) continue;
+
+		if(num_entries == max_entries) {
+			max_entries *= 2;
+			LeapSecond *temp = realloc(entries, max_entries * sizeof(LeapSecond));
+			if(temp == NULL) break;
+			entries = temp;
+		}
+		entries[num_entries].jd_utc = NTP_EPOCH_JD + ntp_seconds/86400;
+		entries[num_entries].tai_utc = tai_utc;
+		// table needs to be sorted for the binary search
+		if(num_entries > 0 && entries[num_entries].jd_utc <= entries[num_entries-1].jd_utc) {
+			fprintf(stderr, "Leap second file not sorted by date: %s\n", filepath);
+			free(entries);
+			fclose(file);
+			return 0;
+		}
+		num_entries++;
+	}
+	fclose(file);
+
+	if(num_entries == 0) {
+		fprintf(stderr, "No leap seconds found in file: %s\n", filepath);
+		free(entries);
+		return 0;
+	}
+
+	free(loaded_leap_seconds);
+	loaded_leap_seconds = entries;
+	leap_seconds = loaded_leap_seconds;
+	num_leap_seconds = num_entries;
+	return 1;
+}
+
+void reset_leap_second_table() {
+	leap_seconds = builtin_leap_seconds;
+	num_leap_seconds = sizeof(builtin_leap_seconds)/sizeof(LeapSecond);
+	free(loaded_leap_seconds);
+	loaded_leap_seconds = NULL;
+}
+
+const LeapSecond * get_leap_second_table(int *num_entries) {
+	if(num_entries != NULL) *num_entries = num_leap_seconds;
+	return leap_seconds;
+}
+
+// index of the last entry valid at the given epoch (key = UTC, or TAI if tai_keys is set); -1 if before the first entry
+static int find_leap_second_index(double jd, int tai_keys) {
+	int n = num_leap_seconds;
+	// most epochs lie after the last leap second -> check that first
+	double last_key = leap_seconds[n-1].jd_utc + (tai_keys ? leap_seconds[n-1].tai_utc/86400 : 0);
+	if(jd >= last_key) return n-1;
+
+	int lo = 0, hi = n-1;	// invariant: key(hi) > jd
+	if(jd < leap_seconds[0].jd_utc + (tai_keys ? leap_seconds[0].tai_utc/86400 : 0)) return -1;
+	while(hi - lo > 1) {
+		int mid = (lo + hi) / 2;
+		double key = leap_seconds[mid].jd_utc + (tai_keys ? leap_seconds[mid].tai_utc/86400 : 0);
+		if(key <= jd) lo = mid;
+		else hi = mid;
+	}
+	return lo;
+}
+
+double get_tai_utc_offset(double jd_utc) {
+	int idx = find_leap_second_index(jd_utc, 0);
+	return leap_seconds[idx < 0 ? 0 : idx].tai_utc;
+}
+
+double get_tdb_tt_offset(double jd_tt) {
+	double T = (jd_tt - J2000_UT0) / 36525;
+	return 0.001657 * sin(628.3076*T + 6.2401)
+		 + 0.000022 * sin(575.3385*T + 4.2970)
+		 + 0.000014 * sin(1256.6152*T + 6.1969)
+		 + 0.000005 * sin(606.9777*T + 4.0212)
+		 + 0.000005 * sin(52.9691*T + 0.4444)
+		 + 0.000002 * sin(21.3299*T + 5.5431)
+		 + 0.000010 * T * sin(628.3076*T + 4.2490);
+}
+
+static double jd_to_tai(double jd, enum TimeScale from) {
+	switch(from) {
+		case TIMESCALE_UTC: return jd + get_tai_utc_offset(jd)/86400;
+		case TIMESCALE_TAI: return jd;
+		case TIMESCALE_TT: return jd - TT_TAI_OFFSET/86400;
+		case TIMESCALE_TDB: return jd - (get_tdb_tt_offset(jd) + TT_TAI_OFFSET)/86400;
+	}
+	return jd;
+}
+
+static double jd_from_tai(double jd_tai, enum TimeScale to) {
+	switch(to) {
+		case TIMESCALE_UTC: {
+			int idx = find_leap_second_index(jd_tai, 1);
+			return jd_tai - leap_seconds[idx < 0 ? 0 : idx].tai_utc/86400;
+		}
+		case TIMESCALE_TAI: return jd_tai;
+		case TIMESCALE_TT: return jd_tai + TT_TAI_OFFSET/86400;
+		case TIMESCALE_TDB: {
+			double jd_tt = jd_tai + TT_TAI_OFFSET/86400;
+			return jd_tt + get_tdb_tt_offset(jd_tt)/86400;
+		}
+	}
+	return jd_tai;
+}
+
+double convert_jd_time_scale(double jd, enum TimeScale from, enum TimeScale to) {
+	if(from == to) return jd;
+	// TT <-> TDB directly to not lose precision on the way over TAI
+	if(from == TIMESCALE_TT && to == TIMESCALE_TDB) return jd + get_tdb_tt_offset(jd)/86400;
+	if(from == TIMESCALE_TDB && to == TIMESCALE_TT) return jd - get_tdb_tt_offset(jd)/86400;
+	return jd_from_tai(jd_to_tai(jd, from), to);
+}
+
+Epoch convert_epoch_time_scale(Epoch epoch, enum TimeScale to) {
+	return (Epoch) {convert_jd_time_scale(epoch.jd, epoch.scale, to), to};
+}
+
+const char * time_scale_to_string(enum TimeScale scale) {
+	switch(scale) {
+		case TIMESCALE_UTC: return "UTC";
+		case TIMESCALE_TAI: return "TAI";
+		case TIMESCALE_TT: return "TT";
+		case TIMESCALE_TDB: return "TDB";
+	}
+	return "TDB";
+}
+
+int time_scale_from_string(const char *s, enum TimeScale *scale) {
+	if(strcmp(s, "UTC") == 0) *scale = TIMESCALE_UTC;
+	else if(strcmp(s, "TAI") == 0) *scale = TIMESCALE_TAI;
+	else if(strcmp(s, "TT") == 0) *scale = TIMESCALE_TT;
+	else if(strcmp(s, "TDB") == 0) *scale = TIMESCALE_TDB;
+	else return 0;
+	return 1;
+}
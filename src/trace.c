@@ -0,0 +1,157 @@
+#include "orbitlib_trace.h"
+#include "trace_internal.h"
+#include <stdio.h>
+
+
+#ifdef ORBITLIB_TRACING
+#include "threading.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define TRACE_CHUNK_SIZE 1024
+
+typedef struct TraceEvent {
+	const char *name;
+	uint64_t start;
+	uint64_t duration;
+} TraceEvent;
+
+typedef struct TraceChunk {
+	TraceEvent events[TRACE_CHUNK_SIZE];
+	atomic_int num_events;				// published count (written by the owning thread)
+	_Atomic(struct TraceChunk *) next;
+} TraceChunk;
+
+// event buffer of one thread (kept after thread exit, so its spans can still be exported)
+typedef struct TraceBuffer {
+	_Atomic(TraceChunk *) first;
+	TraceChunk *last;					// only used by the owning thread
+	uint32_t thread;
+	struct TraceBuffer *next;
+} TraceBuffer;
+
+static OrbitlibMutex trace_mutex = ORBITLIB_MUTEX_INITIALIZER;
+static TraceBuffer *trace_buffers = NULL;
+static uint32_t num_trace_threads = 0;
+static atomic_int tracing = 0;
+static atomic_uint_least64_t trace_epoch = 0;
+static ORBITLIB_THREAD_LOCAL TraceBuffer *thread_buffer = NULL;
+
+static TraceBuffer * register_trace_buffer() {
+	TraceBuffer *buffer = calloc(1, sizeof(TraceBuffer));
+	if(buffer == NULL) return NULL;
+	orbitlib_mutex_lock(&trace_mutex);
+	buffer->thread = num_trace_threads++;
+	buffer->next = trace_buffers;
+	trace_buffers = buffer;
+	orbitlib_mutex_unlock(&trace_mutex);
+	thread_buffer = buffer;
+	return buffer;
+}
+
+TraceSpan trace_span_begin(const char *name) {
+	TraceSpan span = {name, 0};
+	if(atomic_load_explicit(&tracing, memory_order_relaxed)) span.start = orbitlib_time_ns();
+	return span;
+}
+
+void trace_span_end(TraceSpan span) {
+	if(span.start == 0) return;
+	uint64_t end = orbitlib_time_ns();
+	TraceBuffer *buffer = thread_buffer != NULL ? thread_buffer : register_trace_buffer();
+	if(buffer == NULL) return;
+
+	TraceChunk *chunk = atomic_load_explicit(&buffer->first, memory_order_relaxed) != NULL ? buffer->last : NULL;
+	if(chunk == NULL || atomic_load_explicit(&chunk->num_events, memory_order_relaxed) == TRACE_CHUNK_SIZE) {
+		TraceChunk *new_chunk = calloc(1, sizeof(TraceChunk));
+		if(new_chunk == NULL) return;
+		if(chunk == NULL) atomic_store_explicit(&buffer->first, new_chunk, memory_order_release);
+		else atomic_store_explicit(&chunk->next, new_chunk, memory_order_release);
+		buffer->last = chunk = new_chunk;
+	}
+
+	int n = atomic_load_explicit(&chunk->num_events, memory_order_relaxed);
+	chunk->events[n] = (TraceEvent) {span.name, span.start, end - span.start};
+	atomic_store_explicit(&chunk->num_events, n+1, memory_order_release);
+}
+
+int is_tracing_available() {
+	return 1;
+}
+
+void start_tracing() {
+	uint64_t expected = 0;
+	atomic_compare_exchange_strong(&trace_epoch, &expected, orbitlib_time_ns());
+	atomic_store(&tracing, 1);
+}
+
+void stop_tracing() {
+	atomic_store(&tracing, 0);
+}
+
+void clear_trace() {
+	orbitlib_mutex_lock(&trace_mutex);
+	for(TraceBuffer *buffer = trace_buffers; buffer != NULL; buffer = buffer->next) {
+		TraceChunk *chunk = atomic_load(&buffer->first);
+		atomic_store(&buffer->first, NULL);
+		while(chunk != NULL) {
+			TraceChunk *next = atomic_load(&chunk->next);
+			free(chunk);
+			chunk = next;
+		}
+	}
+	orbitlib_mutex_unlock(&trace_mutex);
+}
+
+int export_trace_json(const char *filepath) {
+	FILE *file = fopen(filepath, "w");
+	if(file == NULL) {
+		perror("Unable to open trace file");
+		return 0;
+	}
+	uint64_t epoch = atomic_load(&trace_epoch);
+
+	fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	int first_event = 1;
+	orbitlib_mutex_lock(&trace_mutex);
+	for(TraceBuffer *buffer = trace_buffers; buffer != NULL; buffer = buffer->next) {
+		fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"orbitlib thread %u\"}}",
+				first_event ? "" : ",\n", buffer->thread, buffer->thread);
+		first_event = 0;
+		// only published events are read, so threads can keep recording during the export
+		for(TraceChunk *chunk = atomic_load_explicit(&buffer->first, memory_order_acquire); chunk != NULL;
+			chunk = atomic_load_explicit(&chunk->next, memory_order_acquire)) {
+			int n = atomic_load_explicit(&chunk->num_events, memory_order_acquire);
+			for(int i = 0; i < n; i++) {
+				TraceEvent *event = &chunk->events[i];
+				fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"orbitlib\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u}",
+						event->name, (double) (event->start - epoch) * 1e-3, (double) event->duration * 1e-3, buffer->thread);
+			}
+		}
+	}
+	orbitlib_mutex_unlock(&trace_mutex);
+	fprintf(file, "\n]}\n");
+
+	int success = !ferror(file);
+	fclose(file);
+	return success;
+}
+
+#else
+
+int is_tracing_available() {
+	return 0;
+}
+
+void start_tracing() {}
+
+void stop_tracing() {}
+
+void clear_trace() {}
+
+int export_trace_json(const char *filepath) {
+	(void) filepath;
+	return 0;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef ORBITLIB_TRACE_INTERNAL_H
+#define ORBITLIB_TRACE_INTERNAL_H
+
+// Internal span instrumentation; compiles to nothing without ORBITLIB_TRACING
+
+#include "orbitlib_trace.h"
+
+#ifdef ORBITLIB_TRACING
+#include <stdint.h>
+
+typedef struct TraceSpan {
+	const char *name;	// static string
+	uint64_t start;		// 0 if not recording
+} TraceSpan;
+
+TraceSpan trace_span_begin(const char *name);
+void trace_span_end(TraceSpan span);
+
+#define TRACE_BEGIN(span, name) TraceSpan span = trace_span_begin(name)
+#define TRACE_END(span) trace_span_end(span)
+#else
+#define TRACE_BEGIN(span, name)
+#define TRACE_END(span) ((void) 0)
+#endif
+
+#endif //ORBITLIB_TRACE_INTERNAL_H
@@ -0,0 +1,259 @@
+#include "orbitlib_trajectory.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#define TRAJECTORY_MAGIC "ORBTRAJ"
+#define TRAJECTORY_VERSION 1
+#define TRAJECTORY_ENDIAN_CHECK 0x01020304u
+// maximum angle around the central body spanned by one polyline chord [radians]
+#define TRAJECTORY_MAX_CHORD_ANGLE (M_PI/12)
+// maximum bisection depth of the polyline sampling
+#define TRAJECTORY_MAX_SAMPLE_DEPTH 24
+
+// Header of the serialized form, followed by one record per segment (fixed-width fields, multiples of 8 bytes)
+typedef struct TrajectoryHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t endian_check;
+	uint32_t sizeof_segment;
+	uint32_t num_segments;
+} TrajectoryHeader;
+
+typedef struct TrajectoryRecord {
+	double start_epoch, end_epoch;
+	double r[3], v[3], dv[3];
+	int32_t cb_id;
+	int32_t reserved;
+} TrajectoryRecord;
+
+
+Trajectory * new_trajectory() {
+	Trajectory *trajectory = orbitlib_malloc(sizeof(Trajectory));
+	if(trajectory == NULL) return NULL;
+	*trajectory = (Trajectory) {.segments = NULL, .num_segments = 0, .max_segments = 0};
+	return trajectory;
+}
+
+void free_trajectory(Trajectory *trajectory) {
+	if(trajectory == NULL) return;
+	orbitlib_free(trajectory->segments);
+	orbitlib_free(trajectory);
+}
+
+
+/*
+ * ------------------------------------
+ * Trajectory Construction
+ * ------------------------------------
+ */
+
+static int append_trajectory_segment(Trajectory *trajectory, TrajectorySegment segment) {
+	if(!(segment.end_epoch >= segment.start_epoch) || segment.cb == NULL) return -1;
+	if(trajectory->num_segments > 0 && segment.start_epoch < trajectory->segments[trajectory->num_segments-1].end_epoch) return -1;
+	if(trajectory->num_segments == trajectory->max_segments) {
+		int max_segments = trajectory->max_segments > 0 ? 2*trajectory->max_segments : 8;
+		TrajectorySegment *segments = orbitlib_realloc(trajectory->segments, max_segments * sizeof(TrajectorySegment));
+		if(segments == NULL) return -1;
+		trajectory->segments = segments;
+		trajectory->max_segments = max_segments;
+	}
+	segment.orbit = constr_orbit_from_osv(segment.osv.r, segment.osv.v, segment.cb);
+	segment.universal_orbit = prepare_universal_orbit(segment.osv, segment.cb);
+	trajectory->segments[trajectory->num_segments] = segment;
+	return trajectory->num_segments++;
+}
+
+static OSV get_segment_osv(const TrajectorySegment *segment, double epoch) {
+	return propagate_universal_orbit(&segment->universal_orbit, (epoch - segment->start_epoch) * 86400);
+}
+
+int add_trajectory_coast(Trajectory *trajectory, OSV osv, double start_epoch, double end_epoch, Body *cb) {
+	TrajectorySegment segment = {.start_epoch = start_epoch, .end_epoch = end_epoch, .cb = cb, .osv = osv, .dv = vec3(0, 0, 0)};
+	return append_trajectory_segment(trajectory, segment);
+}
+
+int add_trajectory_impulse(Trajectory *trajectory, Vector3 dv, double end_epoch) {
+	if(trajectory->num_segments == 0) return -1;
+	const TrajectorySegment *last = &trajectory->segments[trajectory->num_segments-1];
+	OSV osv = get_segment_osv(last, last->end_epoch);
+	osv.v = add_vec3(osv.v, dv);
+	TrajectorySegment segment = {.start_epoch = last->end_epoch, .end_epoch = end_epoch, .cb = last->cb, .osv = osv, .dv = dv};
+	return append_trajectory_segment(trajectory, segment);
+}
+
+
+/*
+ * ------------------------------------
+ * Trajectory Evaluation
+ * ------------------------------------
+ */
+
+int find_trajectory_segment(const Trajectory *trajectory, double epoch) {
+	// last segment starting at or before the epoch
+	int low = 0, high = trajectory->num_segments - 1, idx = -1;
+	while(low <= high) {
+		int mid = (low + high) / 2;
+		if(trajectory->segments[mid].start_epoch <= epoch) {
+			idx = mid;
+			low = mid + 1;
+		} else {
+			high = mid - 1;
+		}
+	}
+	if(idx < 0 || epoch > trajectory->segments[idx].end_epoch) return -1;
+	return idx;
+}
+
+OSV get_trajectory_osv(const Trajectory *trajectory, double epoch, Body **cb) {
+	int idx = find_trajectory_segment(trajectory, epoch);
+	if(cb != NULL) *cb = idx >= 0 ? trajectory->segments[idx].cb : NULL;
+	if(idx < 0) return (OSV) {vec3(NAN, NAN, NAN), vec3(NAN, NAN, NAN)};
+	return get_segment_osv(&trajectory->segments[idx], epoch);
+}
+
+typedef struct TrajectorySampling {
+	const TrajectorySegment *segment;
+	double tolerance;
+	Vector3 *points;
+	double *epochs;
+	int max_points;
+	int num_points;
+} TrajectorySampling;
+
+static void add_sample_point(TrajectorySampling *sampling, Vector3 point, double epoch) {
+	if(sampling->num_points < sampling->max_points) {
+		if(sampling->points != NULL) sampling->points[sampling->num_points] = point;
+		if(sampling->epochs != NULL) sampling->epochs[sampling->num_points] = epoch;
+	}
+	sampling->num_points++;
+}
+
+// adds the points between p0 and p1 (exclusive)
+static void refine_sample_interval(TrajectorySampling *sampling, double t0, Vector3 p0, double t1, Vector3 p1, int depth) {
+	double t_mid = (t0 + t1) / 2;
+	Vector3 p_mid = get_segment_osv(sampling->segment, t_mid).r;
+	if(depth < TRAJECTORY_MAX_SAMPLE_DEPTH) {
+		// distance of the mid point from the chord
+		Vector3 chord = subtract_vec3(p1, p0), offset = subtract_vec3(p_mid, p0);
+		double chord_sq = dot_vec3(chord, chord);
+		double deviation = chord_sq > 0 ? mag_vec3(cross_vec3(chord, offset)) / sqrt(chord_sq) : mag_vec3(offset);
+		if(deviation > sampling->tolerance || angle_vec3_vec3(p0, p1) > TRAJECTORY_MAX_CHORD_ANGLE) {
+			refine_sample_interval(sampling, t0, p0, t_mid, p_mid, depth+1);
+			add_sample_point(sampling, p_mid, t_mid);
+			refine_sample_interval(sampling, t_mid, p_mid, t1, p1, depth+1);
+		}
+	}
+}
+
+int sample_trajectory_segment(const Trajectory *trajectory, int segment, double tolerance, Vector3 *points, double *epochs, int max_points) {
+	if(segment < 0 || segment >= trajectory->num_segments || !(tolerance > 0)) return 0;
+	TrajectorySampling sampling = {&trajectory->segments[segment], tolerance, points, epochs, max_points, 0};
+	double start = sampling.segment->start_epoch, end = sampling.segment->end_epoch;
+
+	// at most an eighth of a revolution per initial interval, so chords of closed orbits don't degenerate
+	int num_intervals = 1;
+	if(sampling.segment->orbit.e < 1) {
+		double period = calc_orbital_period(sampling.segment->orbit) / 86400;
+		num_intervals = (int) fmin(ceil(8 * (end - start) / period), 1 << 16);
+		if(num_intervals < 1) num_intervals = 1;
+	}
+	Vector3 p0 = sampling.segment->osv.r;
+	add_sample_point(&sampling, p0, start);
+	for(int i = 0; i < num_intervals; i++) {
+		double t0 = start + (end - start) * i / num_intervals;
+		double t1 = i == num_intervals-1 ? end : start + (end - start) * (i+1) / num_intervals;
+		Vector3 p1 = get_segment_osv(sampling.segment, t1).r;
+		refine_sample_interval(&sampling, t0, p0, t1, p1, 0);
+		add_sample_point(&sampling, p1, t1);
+		p0 = p1;
+	}
+	return sampling.num_points;
+}
+
+
+/*
+ * ------------------------------------
+ * Serialization
+ * ------------------------------------
+ */
+
+size_t serialize_trajectory(const Trajectory *trajectory, void *buffer, size_t buffer_size) {
+	size_t size = sizeof(TrajectoryHeader) + trajectory->num_segments * sizeof(TrajectoryRecord);
+	if(buffer == NULL || buffer_size < size) return size;
+
+	TrajectoryHeader header = {
+			.magic = TRAJECTORY_MAGIC,
+			.version = TRAJECTORY_VERSION,
+			.endian_check = TRAJECTORY_ENDIAN_CHECK,
+			.sizeof_segment = sizeof(TrajectoryRecord),
+			.num_segments = (uint32_t) trajectory->num_segments
+	};
+	memcpy(buffer, &header, sizeof(header));
+	char *p = (char *) buffer + sizeof(header);
+	for(int i = 0; i < trajectory->num_segments; i++) {
+		const TrajectorySegment *segment = &trajectory->segments[i];
+		TrajectoryRecord record = {
+				.start_epoch = segment->start_epoch,
+				.end_epoch = segment->end_epoch,
+				.r = {segment->osv.r.x, segment->osv.r.y, segment->osv.r.z},
+				.v = {segment->osv.v.x, segment->osv.v.y, segment->osv.v.z},
+				.dv = {segment->dv.x, segment->dv.y, segment->dv.z},
+				.cb_id = segment->cb->id,
+				.reserved = 0
+		};
+		memcpy(p, &record, sizeof(record));
+		p += sizeof(record);
+	}
+	return size;
+}
+
+static Body * find_body_by_id(CelestSystem *system, int id) {
+	if(system->cb != NULL && system->cb->id == id) return system->cb;
+	for(int i = 0; i < system->num_bodies; i++) {
+		Body *body = system->bodies[i];
+		if(body == NULL) continue;
+		if(body->id == id) return body;
+		if(body->system != NULL) {
+			Body *found = find_body_by_id(body->system, id);
+			if(found != NULL) return found;
+		}
+	}
+	return NULL;
+}
+
+Trajectory * deserialize_trajectory(const void *buffer, size_t size, CelestSystem *system) {
+	TrajectoryHeader header;
+	if(buffer == NULL || system == NULL || size < sizeof(header)) return NULL;
+	memcpy(&header, buffer, sizeof(header));
+	if(memcmp(header.magic, TRAJECTORY_MAGIC, sizeof(TRAJECTORY_MAGIC)) != 0 ||
+	   header.version != TRAJECTORY_VERSION ||
+	   header.endian_check != TRAJECTORY_ENDIAN_CHECK ||
+	   header.sizeof_segment != sizeof(TrajectoryRecord) ||
+	   (size - sizeof(header)) / sizeof(TrajectoryRecord) < header.num_segments) {
+		fprintf(stderr, "Invalid or incompatible serialized trajectory\n");
+		return NULL;
+	}
+
+	Trajectory *trajectory = new_trajectory();
+	if(trajectory == NULL) return NULL;
+	const char *p = (const char *) buffer + sizeof(header);
+	for(uint32_t i = 0; i < header.num_segments; i++) {
+		TrajectoryRecord record;
+		memcpy(&record, p + i * sizeof(record), sizeof(record));
+		Body *cb = find_body_by_id(system, record.cb_id);
+		TrajectorySegment segment = {
+				.start_epoch = record.start_epoch,
+				.end_epoch = record.end_epoch,
+				.cb = cb,
+				.osv = {vec3(record.r[0], record.r[1], record.r[2]), vec3(record.v[0], record.v[1], record.v[2])},
+				.dv = vec3(record.dv[0], record.dv[1], record.dv[2])
+		};
+		if(cb == NULL || append_trajectory_segment(trajectory, segment) < 0) {
+			if(cb == NULL) fprintf(stderr, "Body with ID %d of serialized trajectory not found\n", record.cb_id);
+			free_trajectory(trajectory);
+			return NULL;
+		}
+	}
+	return trajectory;
+}
@@ -1,5 +1,9 @@
 #include "orbitlib_transfer.h"
 #include "geometrylib.h"
+#include "solver_stats.h"
+#include "diag_internal.h"
+#include "trace_internal.h"
+#include "rootfind_internal.h"
 #include <math.h>
 #include <stdio.h>
 
@@ -24,6 +28,20 @@ double dv_capture(struct Body *body, double rp, double vinf) {
 	return sqrt(2 * body->mu / rp + vinf * vinf) - sqrt(2 * body->mu / rp);
 }
 
+double dv_departure(struct Body *body, double rp, double vinf, enum Transfer_Type type) {
+	return type == circcap || type == circcirc || type == circfb ? dv_circ(body, rp, vinf) : dv_capture(body, rp, vinf);
+}
+
+double dv_arrival(struct Body *body, double rp, double vinf, enum Transfer_Type type) {
+	switch(type) {
+		case capcap:
+		case circcap: return dv_capture(body, rp, vinf);
+		case capcirc:
+		case circcirc: return dv_circ(body, rp, vinf);
+		default: return 0;
+	}
+}
+
 Hohmann calc_hohmann_transfer(double r0, double r1, struct Body *cb) {
 	double sma_pow_3 = pow(((r0 + r1) / 2),3);
 	double dur = M_PI * sqrt(sma_pow_3 / cb->mu);
@@ -90,7 +108,19 @@ double departure_true_anomaly_at_max_dt(double r0, double r1, double delta_ta) {
 	return pi_norm(min_arr_ta);
 }
 
-Lambert2 calc_lambert2(double r0, double r1, double delta_ta, double target_dt, Body *cb) {
+// geometry of a 2D Lambert problem (independent of the transfer time)
+typedef struct Lambert2Setup {
+	double r0, r1, delta_ta;
+	double min_ta0, max_ta0;	// departure true anomalies at the limits of the transfer time (not normed)
+} Lambert2Setup;
+
+// departure true anomaly (not normed to pi) with the resulting orbit and transfer time
+typedef struct Lambert2Point {
+	double ta0_pun, ta0, ta1;
+	double a, e, dt;
+} Lambert2Point;
+
+static Lambert2Setup setup_lambert2(double r0, double r1, double delta_ta) {
 	// 0°, 180° and 360° are extreme edge cases with funky stuff happening with floating point imprecision -> adjust delta in true anomaly
 	if(fabs(delta_ta) < 0.001 ||
 	   fabs(delta_ta-M_PI) < 0.001) delta_ta += 0.001;
@@ -100,110 +130,144 @@ Lambert2 calc_lambert2(double r0, double r1, double delta_ta, double target_dt,
 	double max_ta0 = r1/r0 > 1 ? departure_true_anomaly_at_max_dt(r0, r1, delta_ta) : departure_true_anomaly_at_min_dt(r0, r1, delta_ta);
 	
 	if(min_ta0 > max_ta0) min_ta0 -= 2*M_PI;
+	return (Lambert2Setup) {r0, r1, delta_ta, min_ta0, max_ta0};
+}
+
+static RootBracket init_lambert2_bracket(const Lambert2Setup *setup, double target_dt) {
+	return init_root_bracket(
+			vec2(setup->min_ta0, setup->r1/setup->r0 > 1 ? -target_dt : 1e100),
+			vec2(setup->max_ta0, setup->r1/setup->r0 > 1 ? 1e100 : -target_dt));
+}
+
+// evaluates the transfer time at the point's departure true anomaly; returns LAMBERT_SUCCESS if the orbit is valid
+static enum LAMBERT_SOLVER_SUCCESS eval_lambert2_point(const Lambert2Setup *setup, double target_dt, double mu, Lambert2Point *point) {
+	double r0 = setup->r0, r1 = setup->r1, delta_ta = setup->delta_ta;
+	double ta0 = pi_norm(point->ta0_pun);
+	double ta1 = pi_norm(ta0 + delta_ta);
+	double e = (r1 - r0) / (r0 * cos(ta0) - r1*cos(ta1));
+	point->ta0 = ta0;
+	point->ta1 = ta1;
+	point->e = e;
+	
+	if(e < 0){  // not possible
+		RECORD_DIAG(SOLVER_LAMBERT2, DIAG_LAMBERT_FAIL_ECC, r0, r1, delta_ta, target_dt, ta0, setup->min_ta0, setup->max_ta0, e);
+		return LAMBERT_FAIL_ECC;
+	}
+	if(e==1) e += 1e-10;	// no calculations for parabola -> make it a hyperbola
+	
+	double rp = r0*(1 + e * cos(ta0))/(1 + e);
+	if(rp <= 0) rp = 1e-10;
+	double a = rp/(1-e);
+	double n = sqrt(mu / pow(fabs(a),3));
+	
+	double t1,t2,dt;
+	double T = 2*M_PI/n;
+	if(e < 1) {
+		double E1 = acos((e + cos(ta0))/(1 + e*cos(ta0)));
+		t1 = (E1 - e * sin(E1)) / n;
+		if(ta0 > M_PI) t1 = T - t1;
+		double E2 = acos((e + cos(ta1))/(1 + e*cos(ta1)));
+		t2 = (E2 - e * sin(E2)) / n;
+		if(ta1 > M_PI) t2 = T - t2;
+		dt = ta0 < ta1 ? t2 - t1 : T - t1 + t2;
+	} else {
+		double one_plus_ecos = (1 + e*cos(ta0));
+		// imprecision in extreme cases can lead to (1 + e*cos(ta0)) = 0, which is adjusted so F0 doesn't get infinity
+		if(one_plus_ecos == 0) one_plus_ecos = 1e-10;
+		double F0 = acosh((e + cos(ta0))/one_plus_ecos);
+		t1 = (e * sinh(F0) - F0) / n;
+		one_plus_ecos = (1 + e*cos(ta1));
+		// imprecision in extreme cases can lead to (1 + e*cos(ta1)) = 0, which is adjusted so F1 doesn't get infinity
+		if(one_plus_ecos == 0) one_plus_ecos = 1e-10;
+		double F1 = acosh((e + cos(ta1))/one_plus_ecos);
+		t2 = (e * sinh(F1) - F1) / n;
+		// different quadrant
+		if((ta0 < M_PI) != (ta1 < M_PI)) dt = t1 + t2;
+			// past periapsis
+		else if(ta0 < M_PI) dt = t2 - t1;
+			// before periapsis
+		else dt = t1-t2;
+	}
+	point->a = a;
+	point->e = e;
+	point->dt = dt;
 	
-	DataArray2 *data = data_array2_create();
-	
-	data_array2_insert_new(data, vec2(min_ta0, r1/r0 > 1 ? -target_dt : 1e100));
-	data_array2_insert_new(data, vec2(max_ta0, r1/r0 > 1 ? 1e100 : -target_dt));
-	
-	// true anomaly of r0, theta1 not normed to pi and true anomaly of r1
-	double ta0, ta0_pun, ta1;
-	double mu = cb->mu;
-	
-	double dt;
-	double a, e;
-	
+	if(isnan(dt)){  // at this ta0 orbit not solvable
+		RECORD_DIAG(SOLVER_LAMBERT2, DIAG_LAMBERT_FAIL_NAN, r0, r1, delta_ta, target_dt, ta0, ta1, a, e);
+		return LAMBERT_FAIL_NAN;
+	}
+	return LAMBERT_SUCCESS;
+}
+
+// solves for the target time within the bracket; first_ta0 is evaluated first if it is within the bracket (NAN: none)
+static Lambert2 solve_lambert2(const Lambert2Setup *setup, double target_dt, Body *cb, RootBracket bracket, double first_ta0, Lambert2Point *point) {
+	SOLVER_STATS_START(stats_start);
 	enum LAMBERT_SOLVER_SUCCESS success = LAMBERT_MAX_ITERATIONS;
+	int iterations = 0;
 	
+	if(!(first_ta0 > fmin(bracket.p0.x, bracket.p1.x) && first_ta0 < fmax(bracket.p0.x, bracket.p1.x))) first_ta0 = NAN;
 	for(int i = 0; i < 100; i++) {
-		ta0_pun = root_finder_monot_func_next_x(data, 0.01, 1e-20);
-		if(i > 3 && isnan(ta0_pun)) { success = LAMBERT_IMPRECISION; break;}	// increments are 0 (due to imprecision)
-		
-		ta0 = pi_norm(ta0_pun);
-		ta1 = pi_norm(ta0 + delta_ta);
-		e = (r1 - r0) / (r0 * cos(ta0) - r1*cos(ta1));
+		iterations++;
+		point->ta0_pun = i == 0 && !isnan(first_ta0) ? first_ta0 : root_bracket_next_x(&bracket);
+		if(i > 3 && isnan(point->ta0_pun)) { success = LAMBERT_IMPRECISION; break;}	// increments are 0 (due to imprecision)
 		
-		if(e < 0){  // not possible
-			printf("\n\n!!!!! PANIC e < 0 !!!!!!!!\n");
-			printf("ta0: %.10f°; ta1: %f°; target dt: %fd\nr0: %fe6m; r1: %fe6m; delta_ta: %f°\n", rad2deg(ta0), rad2deg(ta1), target_dt/86400, r0*1e-9, r1*1e-9, rad2deg(delta_ta));
-			printf("min ta0: %f°; max ta0: %f°\ne: %f; a: %f\n", rad2deg(min_ta0), rad2deg(max_ta0), e, a);
-			print_data_array2(data, "ta0", "dt");
-			printf("-------------\n\n");
-			success = LAMBERT_FAIL_ECC;
+		enum LAMBERT_SOLVER_SUCCESS point_status = eval_lambert2_point(setup, target_dt, cb->mu, point);
+		if(point_status != LAMBERT_SUCCESS) {
+			success = point_status;
 			break;
 		}
-		if(e==1) e += 1e-10;	// no calculations for parabola -> make it a hyperbola
-		
-		double rp = r0*(1 + e * cos(ta0))/(1 + e);
-		if(rp <= 0) rp = 1e-10;
-		a = rp/(1-e);
-		double n = sqrt(mu / pow(fabs(a),3));
-		
-		double t1,t2;
-		double T = 2*M_PI/n;
-		if(e < 1) {
-			double E1 = acos((e + cos(ta0))/(1 + e*cos(ta0)));
-			t1 = (E1 - e * sin(E1)) / n;
-			if(ta0 > M_PI) t1 = T - t1;
-			double E2 = acos((e + cos(ta1))/(1 + e*cos(ta1)));
-			t2 = (E2 - e * sin(E2)) / n;
-			if(ta1 > M_PI) t2 = T - t2;
-			dt = ta0 < ta1 ? t2 - t1 : T - t1 + t2;
-		} else {
-			double one_plus_ecos = (1 + e*cos(ta0));
-			// imprecision in extreme cases can lead to (1 + e*cos(ta0)) = 0, which is adjusted so F0 doesn't get infinity
-			if(one_plus_ecos == 0) one_plus_ecos = 1e-10;
-			double F0 = acosh((e + cos(ta0))/one_plus_ecos);
-			t1 = (e * sinh(F0) - F0) / n;
-			one_plus_ecos = (1 + e*cos(ta1));
-			// imprecision in extreme cases can lead to (1 + e*cos(ta1)) = 0, which is adjusted so F1 doesn't get infinity
-			if(one_plus_ecos == 0) one_plus_ecos = 1e-10;
-			double F1 = acosh((e + cos(ta1))/one_plus_ecos);
-			t2 = (e * sinh(F1) - F1) / n;
-			// different quadrant
-			if((ta0 < M_PI) != (ta1 < M_PI)) dt = t1 + t2;
-				// past periapsis
-			else if(ta0 < M_PI) dt = t2 - t1;
-				// before periapsis
-			else dt = t1-t2;
-		}
+		root_bracket_insert(&bracket, vec2(point->ta0_pun, point->dt - target_dt));
 		
-		if(isnan(dt)){  // at this ta0 orbit not solvable
-			printf("---!!!!   NAN   !!!!---\n");
-			printf("ta0: %.10f°; ta1: %f°; target dt: %fd\nr0: %fe6m; r1: %fe6m; delta_ta: %f°\n", rad2deg(ta0), rad2deg(ta1), target_dt/86400, r0*1e-9, r1*1e-9, rad2deg(delta_ta));
-			printf("min ta0: %f°; max ta0: %f°\nt1: %fd; t2: %fd; T: %fd; T/2: %fd\ne: %f; a: %f\n", rad2deg(min_ta0), rad2deg(max_ta0), t1/86400, t2/86400, T/86400, T/2/86400, e, a);
-			print_data_array2(data, "ta0", "dt");
-			printf("-------------\n\n");
-			success = LAMBERT_FAIL_NAN;
-			break;
-		}
-		data_array2_insert_new(data, vec2(ta0_pun, dt - target_dt));
-		
-		if(fabs(target_dt-dt) < 1) {
+		if(fabs(target_dt-point->dt) < 1) {
 			success = LAMBERT_SUCCESS;
 			break;
 		}
 	}
 	
-	data_array2_free(data);
-	Lambert2 solution = {constr_orbit_from_elements(a, e, 0, 0, 0, 0, cb), ta0, ta1, success};
+	if(success == LAMBERT_MAX_ITERATIONS) RECORD_DIAG(SOLVER_LAMBERT2, DIAG_LAMBERT_MAX_ITERATIONS, setup->r0, setup->r1, setup->delta_ta, target_dt, point->ta0, point->dt);
+	SOLVER_STATS_RECORD(SOLVER_LAMBERT2, stats_start, iterations, success == LAMBERT_MAX_ITERATIONS, success);
+	Lambert2 solution = {constr_orbit_from_elements(point->a, point->e, 0, 0, 0, 0, cb), point->ta0, point->ta1, success, 0, LAMBERT_BRANCH_SINGLE};
 	return solution;
 }
 
-Lambert3 calc_lambert3(Vector3 r0, Vector3 r1, double target_dt, Body *cb) {
-	double r0_mag = mag_vec3(r0);
-	double r1_mag = mag_vec3(r1);
-	double delta_ta = angle_vec3_vec3(r0, r1);
-	if (cross_vec3(r0, r1).z < 0) delta_ta = 2 * M_PI - delta_ta;
-	Lambert2 solution2d = calc_lambert2(r0_mag, r1_mag, delta_ta, target_dt, cb);
-	
-	if(solution2d.success == LAMBERT_FAIL_ECC) {
-		return (Lambert3) {.success = solution2d.success};
+Lambert2 calc_lambert2(double r0, double r1, double delta_ta, double target_dt, Body *cb) {
+	Lambert2Setup setup = setup_lambert2(r0, r1, delta_ta);
+	Lambert2Point point = {0};
+	return solve_lambert2(&setup, target_dt, cb, init_lambert2_bracket(&setup, target_dt), NAN, &point);
+}
+
+// orientation of the transfer plane between two positions (shared by all solutions between them)
+typedef struct LambertPlane {
+	double raan, incl;
+	double arg_peri_offset;		// argument of periapsis = arg_peri_offset - true anomaly at r0
+} LambertPlane;
+
+static LambertPlane calc_lambert_plane(Vector3 r0, Vector3 r1) {
+	// normal of the prograde transfer plane (the change in true anomaly is measured counter-clockwise around z)
+	Vector3 normal = cross_vec3(r0, r1);
+	if(mag_vec3(normal) <= 1e-12 * mag_vec3(r0) * mag_vec3(r1)) {
+		// collinear positions: plane through r0 closest to the reference plane
+		Vector3 r0_dir = norm_vec3(r0);
+		normal = subtract_vec3(vec3(0,0,1), scale_vec3(r0_dir, r0_dir.z));
+		if(mag_vec3(normal) <= 1e-12) normal = vec3(1,0,0);
 	}
-	
-	Vector3 origin = {0, 0, 0};
-	Plane3 p_0 = constr_plane3(origin, vec3(1,0,0), vec3(0,1,0));
-	Plane3 p_T = constr_plane3(origin, r0, r1);
+	if(normal.z < 0) normal = scale_vec3(normal, -1);
+	normal = norm_vec3(normal);
+	
+	// ascending node (any direction works for transfers within the reference plane; the argument of periapsis compensates)
+	Vector3 node = vec3(-normal.y, normal.x, 0);
+	if(mag_vec3(node) <= 1e-12) node = vec3(1,0,0);
+	node = norm_vec3(node);
+	double raan = atan2(node.y, node.x);
+	if(raan < 0) raan += 2*M_PI;
+	double i = atan2(sqrt(normal.x*normal.x + normal.y*normal.y), normal.z);
+	
+	// argument of latitude of r0 (from the ascending node in the direction of motion)
+	double arg_lat0 = atan2(dot_vec3(cross_vec3(node, r0), normal), dot_vec3(node, r0));
+	return (LambertPlane) {raan, i, 2*M_PI + arg_lat0};
+}
+
+static Lambert3 lambert3_from_lambert2(Lambert2 solution2d, Vector3 r0, Vector3 r1, LambertPlane plane) {
 	Orbit orbit2d = solution2d.orbit;
 	double e = orbit2d.e;
 	double ta0 = solution2d.true_anomaly0;
@@ -212,35 +276,404 @@ Lambert3 calc_lambert3(Vector3 r0, Vector3 r1, double target_dt, Body *cb) {
 	double fpa0 = calc_orbit_flight_path_angle(e, ta0);
 	double fpa1 = calc_orbit_flight_path_angle(e, ta1);
 	
+	double r0_mag = mag_vec3(r0);
+	double r1_mag = mag_vec3(r1);
 	double v0_mag = calc_orbital_speed(orbit2d, r0_mag);
 	double v1_mag = calc_orbital_speed(orbit2d, r1_mag);
 	
 	Vector2 v0_2d = calc_vel_vec2(r0_mag, v0_mag, ta0, fpa0);
 	Vector2 v1_2d = calc_vel_vec2(r1_mag, v1_mag, ta1, fpa1);
 	
-	// calculate RAAN, inclination and argument of periapsis
-	Vector3 inters_line = calc_intersecting_line_dir_plane3(p_0, p_T);
-	if(inters_line.y < 0) inters_line = scale_vec3(inters_line, -1); // for rotation of raan in clock-wise direction
-	Vector3 in_plane_up = cross_vec3(inters_line, norm_vector_plane3(p_T));    // 90° to intersecting line and norm vector of plane
-	if(in_plane_up.z < 0) in_plane_up = scale_vec3(in_plane_up, -1);   // this vector is always 90° before raan for prograde orbits
-	double raan = in_plane_up.x <= 0 ? angle_vec3_vec3(vec3(1,0,0), inters_line) : angle_vec3_vec3(vec3(1,0,0), inters_line) + M_PI;   // raan 90° behind in_plane_up
+	double arg_peri = plane.arg_peri_offset - ta0;
+	Vector3 v0 = heliocentric_rot(v0_2d, plane.raan, arg_peri, plane.incl);
+	Vector3 v1 = heliocentric_rot(v1_2d, plane.raan, arg_peri, plane.incl);
+	return (Lambert3) {r0, v0, r1, v1, solution2d.success, solution2d.num_revs, solution2d.branch};
+}
+
+// change in true anomaly between two positions (prograde)
+static double calc_lambert_delta_ta(Vector3 r0, Vector3 r1) {
+	double delta_ta = angle_vec3_vec3(r0, r1);
+	if (cross_vec3(r0, r1).z < 0) delta_ta = 2 * M_PI - delta_ta;
+	return delta_ta;
+}
+
+Lambert3 calc_lambert3(Vector3 r0, Vector3 r1, double target_dt, Body *cb) {
+	TRACE_BEGIN(span, "calc_lambert3");
+	Lambert2 solution2d = calc_lambert2(mag_vec3(r0), mag_vec3(r1), calc_lambert_delta_ta(r0, r1), target_dt, cb);
 	
-	//double i = angle_plane_plane(p_T, p_0);   // can create angles greater than 90°
-	double i = angle_plane3_vec3(p_0, in_plane_up);   // also possible to get angle between p_0 and in_plane_up
+	if(solution2d.success == LAMBERT_FAIL_ECC) {
+		TRACE_END(span);
+		return (Lambert3) {.success = solution2d.success};
+	}
 	
-	double arg_peri = 2*M_PI - ta0;
-	if(raan < M_PI) {
-		if(r0.z >= 0) arg_peri += angle_vec3_vec3(inters_line, r0);
-		else arg_peri += 2*M_PI - angle_vec3_vec3(inters_line, r0);
-	} else {
-		if(r0.z <= 0) arg_peri += angle_vec3_vec3(inters_line, r0)+M_PI;
-		else arg_peri += M_PI - angle_vec3_vec3(inters_line, r0);
+	Lambert3 solution = lambert3_from_lambert2(solution2d, r0, r1, calc_lambert_plane(r0, r1));
+	TRACE_END(span);
+	return solution;
+}
+
+
+/*
+ * ------------------------------------
+ * Multi-Revolution Lambert
+ * ------------------------------------
+ */
+
+// elliptic transfer orbits between two radii; e = (r1-r0) / (r0*cos(ta0) - r1*cos(ta0+delta_ta)) is in [0,1) for departure
+// true anomalies within half_width around center (the denominator is the cosine of ta0 - phase, scaled by the chord length)
+typedef struct LambertEllipses {
+	double r0, r1, delta_ta, mu;
+	double center, half_width;
+} LambertEllipses;
+
+static LambertEllipses calc_lambert_ellipses(double r0, double r1, double delta_ta, double mu) {
+	// same edge case adjustments as calc_lambert2(); equal radii would make all orbits with e > 0 collapse onto a single ta0
+	if(fabs(delta_ta) < 0.001 ||
+	   fabs(delta_ta-M_PI) < 0.001) delta_ta += 0.001;
+	if(fabs(delta_ta-2*M_PI) < 0.001) delta_ta -= 0.001;
+	if(fabs(r1 - r0) < 1e-6 * r0) r1 = r0 * (1 + 1e-6);
+	
+	double a = r0 - r1*cos(delta_ta), b = r1*sin(delta_ta);
+	double chord = sqrt(a*a + b*b);
+	double c = r1 - r0;
+	double center = atan2(b, a) + (c < 0 ? M_PI : 0);
+	double half_width = acos(fmin(fabs(c) / chord, 1));
+	return (LambertEllipses) {r0, r1, delta_ta, mu, center, half_width};
+}
+
+static double calc_mean_anomaly_from_true_anomaly(double e, double true_anomaly) {
+	double ecc_anomaly = 2 * atan2(sqrt(1 - e) * sin(true_anomaly/2), sqrt(1 + e) * cos(true_anomaly/2));
+	return ecc_anomaly - e * sin(ecc_anomaly);
+}
+
+// transfer time with num_revs complete revolutions for departure true anomaly ta0 (INFINITY for non-elliptic orbits)
+static double calc_lambert_multirev_dt(const LambertEllipses *ellipses, double ta0, int num_revs, double *a_out, double *e_out) {
+	double r0 = ellipses->r0, r1 = ellipses->r1;
+	double e = (r1 - r0) / (r0 * cos(ta0) - r1 * cos(ta0 + ellipses->delta_ta));
+	if(!(e >= 0 && e < 1)) return INFINITY;
+	
+	double a = r0 * (1 + e*cos(ta0)) / (1 - e*e);
+	double n = sqrt(ellipses->mu / (a*a*a));
+	double delta_mean_anomaly = calc_mean_anomaly_from_true_anomaly(e, ta0 + ellipses->delta_ta) - calc_mean_anomaly_from_true_anomaly(e, ta0);
+	while(delta_mean_anomaly < 0) delta_mean_anomaly += 2*M_PI;
+	while(delta_mean_anomaly >= 2*M_PI) delta_mean_anomaly -= 2*M_PI;
+	
+	if(a_out != NULL) *a_out = a;
+	if(e_out != NULL) *e_out = e;
+	return (delta_mean_anomaly + 2*M_PI * num_revs) / n;
+}
+
+// departure true anomaly of the minimum-time transfer with num_revs revolutions (golden-section search; transfer time
+// grows towards the parabolic orbits at both ends of the elliptic interval)
+static double find_lambert_min_dt_ta0(const LambertEllipses *ellipses, int num_revs, double *min_dt) {
+	const double inv_phi = (sqrt(5) - 1) / 2;
+	double lo = ellipses->center - ellipses->half_width, hi = ellipses->center + ellipses->half_width;
+	double x0 = hi - inv_phi * (hi - lo), x1 = lo + inv_phi * (hi - lo);
+	double dt0 = calc_lambert_multirev_dt(ellipses, x0, num_revs, NULL, NULL);
+	double dt1 = calc_lambert_multirev_dt(ellipses, x1, num_revs, NULL, NULL);
+	while(hi - lo > 1e-10) {
+		if(dt0 < dt1) {
+			hi = x1; x1 = x0; dt1 = dt0;
+			x0 = hi - inv_phi * (hi - lo);
+			dt0 = calc_lambert_multirev_dt(ellipses, x0, num_revs, NULL, NULL);
+		} else {
+			lo = x0; x0 = x1; dt0 = dt1;
+			x1 = lo + inv_phi * (hi - lo);
+			dt1 = calc_lambert_multirev_dt(ellipses, x1, num_revs, NULL, NULL);
+		}
 	}
+	*min_dt = fmin(dt0, dt1);
+	return dt0 < dt1 ? x0 : x1;
+}
+
+// solves one branch between the minimum-time transfer and an end of the elliptic interval (transfer time -> infinity)
+static Lambert2 solve_lambert_branch(const LambertEllipses *ellipses, double target_dt, int num_revs, enum LambertBranch branch,
+									 double min_dt_ta0, double min_dt, Body *cb) {
+	SOLVER_STATS_START(stats_start);
+	Vector2 min_point = vec2(min_dt_ta0, min_dt - target_dt);
+	RootBracket bracket = branch == LAMBERT_BRANCH_LEFT ?
+			init_root_bracket(vec2(ellipses->center - ellipses->half_width, 1e100), min_point) :
+			init_root_bracket(min_point, vec2(ellipses->center + ellipses->half_width, 1e100));
 	
-	Vector3 v0 = heliocentric_rot(v0_2d, raan, arg_peri, i);
-	Vector3 v1 = heliocentric_rot(v1_2d, raan, arg_peri, i);
+	enum LAMBERT_SOLVER_SUCCESS success = LAMBERT_MAX_ITERATIONS;
+	double ta0 = min_dt_ta0, dt = min_dt, a = 0, e = 0;
+	int iterations = 0;
+	for(int i = 0; i < 100; i++) {
+		iterations++;
+		double x = root_bracket_next_x(&bracket);
+		if(isnan(x)) { success = LAMBERT_IMPRECISION; break;}	// increments are 0 (due to imprecision)
+		
+		dt = calc_lambert_multirev_dt(ellipses, x, num_revs, &a, &e);
+		if(isinf(dt)) dt = 1e100;	// rounding at the parabolic end
+		ta0 = x;
+		root_bracket_insert(&bracket, vec2(x, dt - target_dt));
+		
+		if(fabs(target_dt-dt) < 1) {
+			success = LAMBERT_SUCCESS;
+			break;
+		}
+	}
 	
-	return (Lambert3) {r0, v0, r1, v1, solution2d.success};
+	if(success == LAMBERT_MAX_ITERATIONS) RECORD_DIAG(SOLVER_LAMBERT_MULTIREV, DIAG_LAMBERT_MAX_ITERATIONS, ellipses->r0, ellipses->r1, ellipses->delta_ta, target_dt, ta0, dt);
+	SOLVER_STATS_RECORD(SOLVER_LAMBERT_MULTIREV, stats_start, iterations, success == LAMBERT_MAX_ITERATIONS, success);
+	Lambert2 solution = {constr_orbit_from_elements(a, e, 0, 0, 0, 0, cb), pi_norm(ta0), pi_norm(ta0 + ellipses->delta_ta), success, num_revs, branch};
+	return solution;
+}
+
+// solves both branches with num_revs revolutions; returns the number of solutions (-1 if the target time is below the minimum)
+static int solve_lambert_revolution(const LambertEllipses *ellipses, double target_dt, int num_revs, Body *cb, Lambert2 solutions[2]) {
+	double min_dt;
+	double min_dt_ta0 = find_lambert_min_dt_ta0(ellipses, num_revs, &min_dt);
+	if(!(min_dt < target_dt)) return -1;
+	
+	int num_solutions = 0;
+	for(enum LambertBranch branch = LAMBERT_BRANCH_LEFT; branch <= LAMBERT_BRANCH_RIGHT; branch++) {
+		Lambert2 solution = solve_lambert_branch(ellipses, target_dt, num_revs, branch, min_dt_ta0, min_dt, cb);
+		if(solution.success == LAMBERT_SUCCESS) solutions[num_solutions++] = solution;
+	}
+	return num_solutions;
+}
+
+int calc_lambert2_multirev(double r0, double r1, double delta_ta, double target_dt, Body *cb, int max_revs, Lambert2 *solutions, int max_solutions) {
+	if(max_solutions <= 0) return 0;
+	int num_solutions = 0;
+	Lambert2 solution = calc_lambert2(r0, r1, delta_ta, target_dt, cb);
+	if(solution.success == LAMBERT_SUCCESS) solutions[num_solutions++] = solution;
+	
+	LambertEllipses ellipses = calc_lambert_ellipses(r0, r1, delta_ta, cb->mu);
+	for(int num_revs = 1; num_revs <= max_revs && num_solutions < max_solutions; num_revs++) {
+		Lambert2 rev_solutions[2];
+		int num_rev_solutions = solve_lambert_revolution(&ellipses, target_dt, num_revs, cb, rev_solutions);
+		if(num_rev_solutions < 0) break;
+		for(int i = 0; i < num_rev_solutions && num_solutions < max_solutions; i++) solutions[num_solutions++] = rev_solutions[i];
+	}
+	return num_solutions;
+}
+
+int calc_lambert3_multirev(Vector3 r0, Vector3 r1, double target_dt, Body *cb, int max_revs, Lambert3 *solutions, int max_solutions) {
+	if(max_solutions <= 0) return 0;
+	TRACE_BEGIN(span, "calc_lambert3_multirev");
+	double r0_mag = mag_vec3(r0), r1_mag = mag_vec3(r1);
+	double delta_ta = calc_lambert_delta_ta(r0, r1);
+	LambertPlane plane = calc_lambert_plane(r0, r1);
+	
+	int num_solutions = 0;
+	Lambert2 solution = calc_lambert2(r0_mag, r1_mag, delta_ta, target_dt, cb);
+	if(solution.success == LAMBERT_SUCCESS) solutions[num_solutions++] = lambert3_from_lambert2(solution, r0, r1, plane);
+	
+	LambertEllipses ellipses = calc_lambert_ellipses(r0_mag, r1_mag, delta_ta, cb->mu);
+	for(int num_revs = 1; num_revs <= max_revs && num_solutions < max_solutions; num_revs++) {
+		Lambert2 rev_solutions[2];
+		int num_rev_solutions = solve_lambert_revolution(&ellipses, target_dt, num_revs, cb, rev_solutions);
+		if(num_rev_solutions < 0) break;
+		for(int i = 0; i < num_rev_solutions && num_solutions < max_solutions; i++) {
+			solutions[num_solutions++] = lambert3_from_lambert2(rev_solutions[i], r0, r1, plane);
+		}
+	}
+	TRACE_END(span);
+	return num_solutions;
+}
+
+
+/*
+ * ------------------------------------
+ * Time of Flight Sweep
+ * ------------------------------------
+ */
+
+int calc_lambert3_tof_sweep(Vector3 r0, Vector3 r1, const double *target_dts, int num_dts, Body *cb, Lambert3 *solutions) {
+	TRACE_BEGIN(span, "calc_lambert3_tof_sweep");
+	Lambert2Setup setup = setup_lambert2(mag_vec3(r0), mag_vec3(r1), calc_lambert_delta_ta(r0, r1));
+	LambertPlane plane = calc_lambert_plane(r0, r1);
+	
+	// converged points of the last two solutions (most recent first) for the continuation
+	Lambert2Point prev[2];
+	int num_prev = 0;
+	int num_solved = 0;
+	for(int i = 0; i < num_dts; i++) {
+		double target_dt = target_dts[i];
+		RootBracket bracket = init_lambert2_bracket(&setup, target_dt);
+		double first_ta0 = NAN;
+		if(num_prev > 0) {
+			// transfer time is monotonic in ta0 -> the previous solution bounds the new one on one side
+			root_bracket_insert(&bracket, vec2(prev[0].ta0_pun, prev[0].dt - target_dt));
+			bracket.kept = -1;
+			// secant through the last two solutions as first guess
+			if(num_prev > 1 && prev[0].dt != prev[1].dt) {
+				first_ta0 = prev[0].ta0_pun + (target_dt - prev[0].dt) * (prev[0].ta0_pun - prev[1].ta0_pun) / (prev[0].dt - prev[1].dt);
+			}
+		}
+		
+		Lambert2Point point = {0};
+		Lambert2 solution2d = solve_lambert2(&setup, target_dt, cb, bracket, first_ta0, &point);
+		// the continuation can step onto invalid orbits the plain bracket avoids -> retry without it
+		if(solution2d.success != LAMBERT_SUCCESS && num_prev > 0) {
+			solution2d = solve_lambert2(&setup, target_dt, cb, init_lambert2_bracket(&setup, target_dt), NAN, &point);
+		}
+		if(solution2d.success == LAMBERT_FAIL_ECC) {
+			solutions[i] = (Lambert3) {.success = solution2d.success};
+			num_prev = 0;
+			continue;
+		}
+		solutions[i] = lambert3_from_lambert2(solution2d, r0, r1, plane);
+		if(solution2d.success != LAMBERT_SUCCESS) {
+			num_prev = 0;
+			continue;
+		}
+		prev[1] = prev[0];
+		prev[0] = point;
+		if(num_prev < 2) num_prev++;
+		num_solved++;
+	}
+	TRACE_END(span);
+	return num_solved;
+}
+
+
+/*
+ * ------------------------------------
+ * Lambert Partials
+ * ------------------------------------
+ */
+
+static double invert_mat3(double m[3][3], double inv[3][3]) {
+	double det = m[0][0]*(m[1][1]*m[2][2] - m[1][2]*m[2][1])
+			   - m[0][1]*(m[1][0]*m[2][2] - m[1][2]*m[2][0])
+			   + m[0][2]*(m[1][0]*m[2][1] - m[1][1]*m[2][0]);
+	for(int i = 0; i < 3; i++) {
+		for(int j = 0; j < 3; j++) {
+			// adjugate (cofactor of the transposed position)
+			int r0 = (j+1)%3, r1 = (j+2)%3, c0 = (i+1)%3, c1 = (i+2)%3;
+			inv[i][j] = (m[r0][c0]*m[r1][c1] - m[r0][c1]*m[r1][c0]) / det;
+		}
+	}
+	return det;
+}
+
+static void mul_mat3(double a[3][3], double b[3][3], double result[3][3]) {
+	for(int i = 0; i < 3; i++) {
+		for(int j = 0; j < 3; j++) {
+			result[i][j] = a[i][0]*b[0][j] + a[i][1]*b[1][j] + a[i][2]*b[2][j];
+		}
+	}
+}
+
+static void mul_mat3_vec(double m[3][3], const double v[3], double result[3]) {
+	for(int i = 0; i < 3; i++) result[i] = m[i][0]*v[0] + m[i][1]*v[1] + m[i][2]*v[2];
+}
+
+Lambert3 calc_lambert3_partials(Vector3 r0, Vector3 r1, double target_dt, Body *cb, LambertPartials *partials) {
+	Lambert3 solution = calc_lambert3(r0, r1, target_dt, cb);
+	if(solution.success != LAMBERT_SUCCESS || partials == NULL) return solution;
+	
+	double stm[6][6];
+	propagate_osv_time_stm((OSV) {r0, solution.v0}, cb, target_dt, stm);
+	double phi_rr[3][3], phi_rv[3][3], phi_vr[3][3], phi_vv[3][3], phi_rv_inv[3][3];
+	for(int i = 0; i < 3; i++) {
+		for(int j = 0; j < 3; j++) {
+			phi_rr[i][j] = stm[i][j];
+			phi_rv[i][j] = stm[i][j+3];
+			phi_vr[i][j] = stm[i+3][j];
+			phi_vv[i][j] = stm[i+3][j+3];
+		}
+	}
+	double det = invert_mat3(phi_rv, phi_rv_inv);
+	if(!isfinite(det) || det == 0) {
+		for(int i = 0; i < 3; i++) {
+			for(int j = 0; j < 3; j++) phi_rv_inv[i][j] = NAN;
+		}
+	}
+	
+	// r1 = r1(r0, v0, tof) held fixed: dr1 = phi_rr dr0 + phi_rv dv0 + v1 dtof = 0 (for r0 and tof variations)
+	double v1[3] = {solution.v1.x, solution.v1.y, solution.v1.z};
+	double r1_mag = mag_vec3(r1);
+	double a1[3] = {-cb->mu*r1.x/pow(r1_mag, 3), -cb->mu*r1.y/pow(r1_mag, 3), -cb->mu*r1.z/pow(r1_mag, 3)};
+	
+	mul_mat3(phi_rv_inv, phi_rr, partials->dv0_dr0);
+	for(int i = 0; i < 3; i++) {
+		for(int j = 0; j < 3; j++) {
+			partials->dv0_dr0[i][j] *= -1;
+			partials->dv0_dr1[i][j] = phi_rv_inv[i][j];
+		}
+	}
+	mul_mat3_vec(phi_rv_inv, v1, partials->dv0_dtof);
+	for(int i = 0; i < 3; i++) partials->dv0_dtof[i] *= -1;
+	
+	// v1 = v1(r0, v0, tof): dv1 = phi_vr dr0 + phi_vv dv0 + a1 dtof
+	double vv_dv0_dr0[3][3];
+	mul_mat3(phi_vv, partials->dv0_dr0, vv_dv0_dr0);
+	mul_mat3(phi_vv, phi_rv_inv, partials->dv1_dr1);
+	for(int i = 0; i < 3; i++) {
+		for(int j = 0; j < 3; j++) partials->dv1_dr0[i][j] = phi_vr[i][j] + vv_dv0_dr0[i][j];
+	}
+	mul_mat3_vec(phi_vv, partials->dv0_dtof, partials->dv1_dtof);
+	for(int i = 0; i < 3; i++) partials->dv1_dtof[i] += a1[i];
+	return solution;
+}
+
+static void set_partials_column(LambertPartials *partials, int param, Lambert3 plus, Lambert3 minus, double step) {
+	double dv0[3] = {(plus.v0.x - minus.v0.x) / (2*step), (plus.v0.y - minus.v0.y) / (2*step), (plus.v0.z - minus.v0.z) / (2*step)};
+	double dv1[3] = {(plus.v1.x - minus.v1.x) / (2*step), (plus.v1.y - minus.v1.y) / (2*step), (plus.v1.z - minus.v1.z) / (2*step)};
+	for(int i = 0; i < 3; i++) {
+		if(param < 3) {
+			partials->dv0_dr0[i][param] = dv0[i];
+			partials->dv1_dr0[i][param] = dv1[i];
+		} else if(param < 6) {
+			partials->dv0_dr1[i][param-3] = dv0[i];
+			partials->dv1_dr1[i][param-3] = dv1[i];
+		} else {
+			partials->dv0_dtof[i] = dv0[i];
+			partials->dv1_dtof[i] = dv1[i];
+		}
+	}
+}
+
+int calc_lambert3_partials_fd(Vector3 r0, Vector3 r1, double target_dt, Body *cb, LambertPartials *partials) {
+	// large relative steps as the solver only converges to a time of flight within 1s
+	double pos_step = 1e-4 * fmin(mag_vec3(r0), mag_vec3(r1));
+	double tof_step = 1e-4 * target_dt;
+	int success = 1;
+	for(int param = 0; param < 7; param++) {
+		Vector3 r0p = r0, r0m = r0, r1p = r1, r1m = r1;
+		double tof_p = target_dt, tof_m = target_dt, step = pos_step;
+		double *comp_p, *comp_m;
+		if(param < 6) {
+			Vector3 *vp = param < 3 ? &r0p : &r1p, *vm = param < 3 ? &r0m : &r1m;
+			int axis = param % 3;
+			comp_p = axis == 0 ? &vp->x : axis == 1 ? &vp->y : &vp->z;
+			comp_m = axis == 0 ? &vm->x : axis == 1 ? &vm->y : &vm->z;
+		} else {
+			comp_p = &tof_p;
+			comp_m = &tof_m;
+			step = tof_step;
+		}
+		*comp_p += step;
+		*comp_m -= step;
+		Lambert3 plus = calc_lambert3(r0p, r1p, tof_p, cb);
+		Lambert3 minus = calc_lambert3(r0m, r1m, tof_m, cb);
+		if(plus.success != LAMBERT_SUCCESS || minus.success != LAMBERT_SUCCESS) success = 0;
+		set_partials_column(partials, param, plus, minus, step);
+	}
+	return success;
+}
+
+static double compare_partials_block(const double *a, const double *b, int n) {
+	double norm = 0, max_diff = 0;
+	for(int i = 0; i < n; i++) {
+		norm = fmax(norm, fabs(b[i]));
+		max_diff = fmax(max_diff, fabs(a[i] - b[i]));
+	}
+	return norm > 0 ? max_diff / norm : max_diff;
+}
+
+double compare_lambert_partials(const LambertPartials *partials, const LambertPartials *reference) {
+	double deviation = 0;
+	deviation = fmax(deviation, compare_partials_block(&partials->dv0_dr0[0][0], &reference->dv0_dr0[0][0], 9));
+	deviation = fmax(deviation, compare_partials_block(&partials->dv0_dr1[0][0], &reference->dv0_dr1[0][0], 9));
+	deviation = fmax(deviation, compare_partials_block(partials->dv0_dtof, reference->dv0_dtof, 3));
+	deviation = fmax(deviation, compare_partials_block(&partials->dv1_dr0[0][0], &reference->dv1_dr0[0][0], 9));
+	deviation = fmax(deviation, compare_partials_block(&partials->dv1_dr1[0][0], &reference->dv1_dr1[0][0], 9));
+	deviation = fmax(deviation, compare_partials_block(partials->dv1_dtof, reference->dv1_dtof, 3));
+	return deviation;
 }
 
 
@@ -308,6 +741,111 @@ HyperbolaParams get_hyperbola_params(Vector3 v_arr, Vector3 v_dep, Vector3 v_bod
 	return hyperbola_params;
 }
 
+// number of inputs converted to structure of arrays at once (stack buffers)
+#define HYPERBOLA_BATCH_BLOCK 64
+
+// declination and b-plane angle of a departure leg (closed forms of get_dep_hyperbola_params() without plane constructions)
+static void calc_hyperbola_leg_angles_block(const double *restrict x, const double *restrict y, const double *restrict z, int n, int incoming,
+											double *restrict decl, double *restrict bplane_angle) {
+	if(decl != NULL) {
+		for(int i = 0; i < n; i++) {
+			// angle to the xy-plane, signed with z
+			double d = atan2(z[i], sqrt(x[i]*x[i] + y[i]*y[i]));
+			decl[i] = incoming ? -d : d;
+		}
+	}
+	if(bplane_angle != NULL) {
+		for(int i = 0; i < n; i++) {
+			// unsigned angle to the xz-plane, mirrored for negative x
+			double a = atan2(fabs(y[i]), sqrt(x[i]*x[i] + z[i]*z[i]));
+			double angle = x[i] < 0 ? M_PI + a : -a;
+			bplane_angle[i] = pi_norm(incoming ? M_PI + angle : angle);
+		}
+	}
+}
+
+void get_hyperbola_params_batch(const Vector3 *v_arr, const Vector3 *v_dep, const Vector3 *v_body, int num, struct Body *body, double h_pe,
+								enum HyperbolaType type, HyperbolaParamsArrays *out) {
+	double arr_x[HYPERBOLA_BATCH_BLOCK], arr_y[HYPERBOLA_BATCH_BLOCK], arr_z[HYPERBOLA_BATCH_BLOCK];
+	double dep_x[HYPERBOLA_BATCH_BLOCK], dep_y[HYPERBOLA_BATCH_BLOCK], dep_z[HYPERBOLA_BATCH_BLOCK];
+	int has_arr = type != HYP_DEPARTURE, has_dep = type != HYP_ARRIVAL;
+	
+	for(int start = 0; start < num; start += HYPERBOLA_BATCH_BLOCK) {
+		int n = num - start < HYPERBOLA_BATCH_BLOCK ? num - start : HYPERBOLA_BATCH_BLOCK;
+		// excess velocities as structure of arrays
+		for(int i = 0; i < n; i++) {
+			Vector3 vb = v_body[start+i];
+			if(has_arr) {
+				arr_x[i] = v_arr[start+i].x - vb.x;
+				arr_y[i] = v_arr[start+i].y - vb.y;
+				arr_z[i] = v_arr[start+i].z - vb.z;
+			}
+			if(has_dep) {
+				dep_x[i] = v_dep[start+i].x - vb.x;
+				dep_y[i] = v_dep[start+i].y - vb.y;
+				dep_z[i] = v_dep[start+i].z - vb.z;
+			}
+		}
+		
+		if(has_arr) {
+			calc_hyperbola_leg_angles_block(arr_x, arr_y, arr_z, n, 1,
+											out->incoming.decl ? out->incoming.decl + start : NULL,
+											out->incoming.bplane_angle ? out->incoming.bplane_angle + start : NULL);
+		}
+		if(has_dep) {
+			calc_hyperbola_leg_angles_block(dep_x, dep_y, dep_z, n, 0,
+											out->outgoing.decl ? out->outgoing.decl + start : NULL,
+											out->outgoing.bplane_angle ? out->outgoing.bplane_angle + start : NULL);
+		}
+		
+		for(int leg = 0; leg < 2; leg++) {
+			double *bvazi = leg == 0 ? out->incoming.bvazi : out->outgoing.bvazi;
+			if(bvazi == NULL || (leg == 0 ? !has_arr : !has_dep)) continue;
+			bvazi += start;
+			if(type != HYP_FLYBY) {
+				for(int i = 0; i < n; i++) bvazi[i] = M_PI/2;
+				continue;
+			}
+			for(int i = 0; i < n; i++) {
+				// N = vinf_arr x vinf_dep; B = vinf_arr x N (incoming) or vinf_dep x -N (outgoing)
+				double nx = arr_y[i]*dep_z[i] - arr_z[i]*dep_y[i];
+				double ny = arr_z[i]*dep_x[i] - arr_x[i]*dep_z[i];
+				double nz = arr_x[i]*dep_y[i] - arr_y[i]*dep_x[i];
+				double vx = leg == 0 ? arr_x[i] : dep_x[i], vy = leg == 0 ? arr_y[i] : dep_y[i], vz = leg == 0 ? arr_z[i] : dep_z[i];
+				double sign = leg == 0 ? 1 : -1;
+				double bx = sign * (vy*nz - vz*ny);
+				double by = sign * (vz*nx - vx*nz);
+				double bz = sign * (vx*ny - vy*nx);
+				// angle from south, negative for retrograde orbits
+				double azimuth = atan2(sqrt(bx*bx + by*by), -bz);
+				bvazi[i] = nz < 0 ? -azimuth : azimuth;
+			}
+		}
+		
+		if(out->rp != NULL) {
+			double *rp = out->rp + start;
+			if(type == HYP_FLYBY) {
+				for(int i = 0; i < n; i++) {
+					// turn angle between the asymptotes (see get_flyby_periapsis())
+					double cx = arr_y[i]*dep_z[i] - arr_z[i]*dep_y[i];
+					double cy = arr_z[i]*dep_x[i] - arr_x[i]*dep_z[i];
+					double cz = arr_x[i]*dep_y[i] - arr_y[i]*dep_x[i];
+					double turn_angle = atan2(sqrt(cx*cx + cy*cy + cz*cz), arr_x[i]*dep_x[i] + arr_y[i]*dep_y[i] + arr_z[i]*dep_z[i]);
+					double sq_vinf = arr_x[i]*arr_x[i] + arr_y[i]*arr_y[i] + arr_z[i]*arr_z[i];
+					rp[i] = (1 / sin(turn_angle/2) - 1) * (body->mu / sq_vinf);
+				}
+			} else {
+				for(int i = 0; i < n; i++) rp[i] = h_pe + body->radius;
+			}
+		}
+		if(out->c3_energy != NULL) {
+			double *c3 = out->c3_energy + start;
+			const double *x = has_arr ? arr_x : dep_x, *y = has_arr ? arr_y : dep_y, *z = has_arr ? arr_z : dep_z;
+			for(int i = 0; i < n; i++) c3[i] = x[i]*x[i] + y[i]*y[i] + z[i]*z[i];
+		}
+	}
+}
+
 bool is_flyby_viable(Vector3 v_arr, Vector3 v_dep, Vector3 v_body, Body *body, double precision) {
 	double rp = get_flyby_periapsis(v_arr, v_dep, v_body, body);
 	if(rp < body->radius+body->atmo_alt) return false;
@@ -0,0 +1,97 @@
+#include "orbitlib_window.h"
+#include "trace_internal.h"
+#include "rootfind_internal.h"
+#include <math.h>
+
+// convergence tolerance of the departure epoch [days]
+#define WINDOW_EPOCH_TOLERANCE (1.0 / 1440)
+// refined windows have to meet the phase angle within this tolerance [radians]
+#define WINDOW_PHASE_TOLERANCE 1e-3
+
+
+// angle normed to -pi to pi
+static double wrap_angle(double angle) {
+	angle = pi_norm(angle);
+	return angle > M_PI ? angle - 2*M_PI : angle;
+}
+
+double calc_synodic_period(Body *body0, Body *body1) {
+	double rate = 1 / calc_orbital_period(body0->orbit) - 1 / calc_orbital_period(body1->orbit);
+	return rate == 0 ? INFINITY : fabs(1 / rate);
+}
+
+double calc_hohmann_phase_angle(Body *departure_body, Body *arrival_body) {
+	Hohmann hohmann = calc_hohmann_transfer(departure_body->orbit.a, arrival_body->orbit.a, departure_body->orbit.cb);
+	// arrival body has to be opposite of the departure point after the transfer
+	double arrival_motion = 2*M_PI * hohmann.dur / calc_orbital_period(arrival_body->orbit);
+	return wrap_angle(M_PI - arrival_motion);
+}
+
+double calc_phase_angle(Body *departure_body, Body *arrival_body, double epoch) {
+	OSV osv0 = get_body_osv(departure_body, epoch);
+	OSV osv1 = get_body_osv(arrival_body, epoch);
+	Vector3 h = cross_vec3(osv0.r, osv0.v);
+	double sin_part = dot_vec3(cross_vec3(osv0.r, osv1.r), h) / mag_vec3(h);
+	return atan2(sin_part, dot_vec3(osv0.r, osv1.r));
+}
+
+// deviation from the required phase angle (root at the window)
+static double calc_phase_offset(Body *departure_body, Body *arrival_body, double epoch, double phase_angle) {
+	return wrap_angle(calc_phase_angle(departure_body, arrival_body, epoch) - phase_angle);
+}
+
+typedef struct PhaseOffsetRoot {
+	Body *departure_body, *arrival_body;
+	double phase_angle;
+} PhaseOffsetRoot;
+
+static double calc_phase_offset_root(double epoch, void *data) {
+	PhaseOffsetRoot *root = data;
+	return calc_phase_offset(root->departure_body, root->arrival_body, epoch, root->phase_angle);
+}
+
+// root of the phase offset within [t0, t1] (offsets f0 and f1 of opposite sign)
+static double refine_window_epoch(Body *departure_body, Body *arrival_body, double phase_angle, double t0, double f0, double t1, double f1, double *offset) {
+	PhaseOffsetRoot root = {departure_body, arrival_body, phase_angle};
+	return find_bracketed_root(calc_phase_offset_root, &root, t0, f0, t1, f1, WINDOW_EPOCH_TOLERANCE, offset);
+}
+
+int find_launch_windows(Body *departure_body, Body *arrival_body, double min_epoch, double max_epoch, LaunchWindow *windows, int max_windows) {
+	Body *cb = departure_body->orbit.cb;
+	if(cb == NULL || arrival_body->orbit.cb != cb || max_windows <= 0 || max_epoch < min_epoch) return 0;
+	double synodic_period = calc_synodic_period(departure_body, arrival_body) / 86400;
+	if(!isfinite(synodic_period)) return 0;
+	TRACE_BEGIN(span, "find_launch_windows");
+	
+	// the phase angle changes with the difference of the mean motions
+	int phase_increasing = calc_orbital_period(arrival_body->orbit) < calc_orbital_period(departure_body->orbit);
+	double phase_angle = calc_hohmann_phase_angle(departure_body, arrival_body);
+	double offset0 = calc_phase_offset(departure_body, arrival_body, min_epoch, phase_angle);
+	double first_window = min_epoch + pi_norm(phase_increasing ? -offset0 : offset0) / (2*M_PI) * synodic_period;
+	
+	// predictions one synodic period apart, each refined within a quarter period (half a turn of the phase angle is +-pi)
+	int num_windows = 0;
+	double half_width = synodic_period / 4;
+	for(int k = 0; num_windows < max_windows; k++) {
+		double prediction = first_window + k * synodic_period;
+		if(prediction - half_width > max_epoch) break;
+		double t0 = prediction - half_width, t1 = prediction + half_width;
+		double f0 = calc_phase_offset(departure_body, arrival_body, t0, phase_angle);
+		double f1 = calc_phase_offset(departure_body, arrival_body, t1, phase_angle);
+		if((f0 < 0) == (f1 < 0)) continue;
+		
+		double offset;
+		double epoch = refine_window_epoch(departure_body, arrival_body, phase_angle, t0, f0, t1, f1, &offset);
+		if(fabs(offset) > WINDOW_PHASE_TOLERANCE || epoch < min_epoch || epoch > max_epoch) continue;
+		// the wrap-around of the phase angle can fall into the bracket of eccentric orbits -> same window found twice
+		if(num_windows > 0 && epoch - windows[num_windows-1].departure_epoch < synodic_period / 2) continue;
+		
+		OSV osv0 = get_body_osv(departure_body, epoch);
+		Hohmann estimate = calc_hohmann_transfer(departure_body->orbit.a, arrival_body->orbit.a, cb);
+		OSV osv1 = get_body_osv(arrival_body, epoch + estimate.dur / 86400);
+		Hohmann transfer = calc_hohmann_transfer(mag_vec3(osv0.r), mag_vec3(osv1.r), cb);
+		windows[num_windows++] = (LaunchWindow) {epoch, epoch + transfer.dur / 86400, phase_angle, transfer};
+	}
+	TRACE_END(span);
+	return num_windows;
+}
@@ -0,0 +1,301 @@
+// Generates C source with static body catalogs from system config files (.cfg)
+//
+// Usage: orbitlib_catalog_gen [--ephemerides <dir>] <output.c> <output.h> <system.cfg>...
+//
+// With --ephemerides, systems propagated with ephemerides embed the ephemeris files found in <dir> (never downloaded).
+// Without it, these systems are compiled in as propagated with orbital elements.
+
+#include "orbitlib.h"
+#include "orbitlib_fileio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+
+typedef struct CatalogLayout {
+	CelestSystem **systems;
+	struct Body **bodies;
+	int num_systems, num_bodies;
+} CatalogLayout;
+
+static void collect_catalog_layout(CelestSystem *system, CatalogLayout *layout) {
+	layout->systems[layout->num_systems++] = system;
+	for(int i = 0; i < system->num_bodies; i++) {
+		layout->bodies[layout->num_bodies++] = system->bodies[i];
+		if(system->bodies[i]->system != NULL) collect_catalog_layout(system->bodies[i]->system, layout);
+	}
+}
+
+static int count_catalog_bodies(CelestSystem *system) {
+	int num_bodies = system->num_bodies;
+	for(int i = 0; i < system->num_bodies; i++) {
+		if(system->bodies[i]->system != NULL) num_bodies += count_catalog_bodies(system->bodies[i]->system);
+	}
+	return num_bodies;
+}
+
+static int get_catalog_body_index(CatalogLayout *layout, struct Body *body) {
+	for(int i = 0; i < layout->num_bodies; i++) if(layout->bodies[i] == body) return i;
+	return -1;
+}
+
+static int get_catalog_system_index(CatalogLayout *layout, CelestSystem *system) {
+	for(int i = 0; i < layout->num_systems; i++) if(layout->systems[i] == system) return i;
+	return -1;
+}
+
+// lower-case identifier (upper_case for macros) from a name
+static void get_identifier(const char *name, char *identifier, size_t size, int upper_case) {
+	size_t n = 0;
+	for(const char *p = name; *p != '\0' && n+1 < size; p++) {
+		char c = (char) (isalnum((unsigned char) *p) ? *p : '_');
+		identifier[n++] = (char) (upper_case ? toupper((unsigned char) c) : tolower((unsigned char) c));
+	}
+	identifier[n] = '\0';
+	if(n == 0 || isdigit((unsigned char) identifier[0])) {
+		memmove(identifier+1, identifier, n+1 < size ? n+1 : size-1);
+		identifier[0] = '_';
+	}
+}
+
+static void fprint_double(FILE *file, double d) {
+	if(isnan(d)) fprintf(file, "NAN");
+	else if(isinf(d)) fprintf(file, d > 0 ? "INFINITY" : "-INFINITY");
+	else {
+		// keep it a floating-point literal (e.g. for divisions in user code using the macros)
+		char buf[32];
+		snprintf(buf, sizeof(buf), "%.17g", d);
+		fprintf(file, strpbrk(buf, ".en") != NULL ? "%s" : "%s.0", buf);
+	}
+}
+
+static void fprint_string_literal(FILE *file, const char *s) {
+	fputc('"', file);
+	for(; *s != '\0'; s++) {
+		if(*s == '"' || *s == '\\') fputc('\\', file);
+		fputc(*s, file);
+	}
+	fputc('"', file);
+}
+
+static void fprint_body_ref(FILE *file, const char *sym, int idx) {
+	if(idx < 0) fprintf(file, "NULL");
+	else fprintf(file, "&%s_bodies[%d]", sym, idx);
+}
+
+static void fprint_vec3(FILE *file, Vector3 v) {
+	fprintf(file, "{.x = "); fprint_double(file, v.x);
+	fprintf(file, ", .y = "); fprint_double(file, v.y);
+	fprintf(file, ", .z = "); fprint_double(file, v.z);
+	fprintf(file, "}");
+}
+
+static void write_catalog(FILE *src, FILE *hdr, CelestSystem *system, const char *sym, const char *macro_prefix) {
+	int max_bodies = count_catalog_bodies(system) + 1;
+	CatalogLayout layout = {
+			.systems = malloc((get_number_of_subsystems(system) + 1) * sizeof(CelestSystem *)),
+			.bodies = malloc(max_bodies * sizeof(struct Body *))
+	};
+	layout.bodies[layout.num_bodies++] = system->cb;
+	collect_catalog_layout(system, &layout);
+
+	// writable storage (read-only through the public const pointers), so the bodies' and systems' non-const pointers to each
+	// other don't cast away the const of read-only objects
+	fprintf(src, "\n// %s\n", system->name);
+	fprintf(src, "static CelestSystem %s_systems[%d];\n", sym, layout.num_systems);
+	fprintf(src, "static struct Body %s_bodies[%d];\n\n", sym, layout.num_bodies);
+
+	// ephemerides
+	for(int i = 0; i < layout.num_bodies; i++) {
+		struct Body *body = layout.bodies[i];
+		if(body->ephem == NULL || body->num_ephems == 0) continue;
+		fprintf(src, "static Ephem %s_ephem_%d[%d] = {\n", sym, i, body->num_ephems);
+		for(int j = 0; j < body->num_ephems; j++) {
+			fprintf(src, "\t{");
+			fprint_double(src, body->ephem[j].epoch);
+			fprintf(src, ", ");
+			fprint_vec3(src, body->ephem[j].r);
+			fprintf(src, ", ");
+			fprint_vec3(src, body->ephem[j].v);
+			fprintf(src, "},\n");
+		}
+		fprintf(src, "};\n\n");
+	}
+
+	// bodies of each system
+	for(int i = 0; i < layout.num_systems; i++) {
+		CelestSystem *s = layout.systems[i];
+		if(s->num_bodies == 0) continue;
+		fprintf(src, "static struct Body *%s_bodies_of_%d[%d] = {\n", sym, i, s->num_bodies);
+		for(int j = 0; j < s->num_bodies; j++) {
+			fprintf(src, "\t");
+			fprint_body_ref(src, sym, get_catalog_body_index(&layout, s->bodies[j]));
+			fprintf(src, ",\n");
+		}
+		fprintf(src, "};\n\n");
+	}
+
+	fprintf(src, "static struct Body %s_bodies[%d] = {\n", sym, layout.num_bodies);
+	for(int i = 0; i < layout.num_bodies; i++) {
+		struct Body *b = layout.bodies[i];
+		fprintf(src, "\t{\n\t\t.name = ");
+		fprint_string_literal(src, b->name);
+		fprintf(src, ",\n\t\t.color = {");
+		for(int j = 0; j < 3; j++) {fprint_double(src, b->color[j]); fprintf(src, j < 2 ? ", " : "},\n");}
+		fprintf(src, "\t\t.id = %d,\n", b->id);
+		fprintf(src, "\t\t.mu = "); fprint_double(src, b->mu);
+		fprintf(src, ",\n\t\t.radius = "); fprint_double(src, b->radius);
+		fprintf(src, ",\n\t\t.rotation_period = "); fprint_double(src, b->rotation_period);
+		fprintf(src, ",\n\t\t.sl_atmo_p = "); fprint_double(src, b->sl_atmo_p);
+		fprintf(src, ",\n\t\t.scale_height = "); fprint_double(src, b->scale_height);
+		fprintf(src, ",\n\t\t.atmo_alt = "); fprint_double(src, b->atmo_alt);
+		fprintf(src, ",\n\t\t.north_pole_ra = "); fprint_double(src, b->north_pole_ra);
+		fprintf(src, ",\n\t\t.north_pole_decl = "); fprint_double(src, b->north_pole_decl);
+		fprintf(src, ",\n\t\t.rot_ut0 = "); fprint_double(src, b->rot_ut0);
+		fprintf(src, ",\n\t\t.j2 = "); fprint_double(src, b->j2);
+		int sys_idx = b->system != NULL ? get_catalog_system_index(&layout, b->system) : -1;
+		if(sys_idx >= 0) fprintf(src, ",\n\t\t.system = &%s_systems[%d]", sym, sys_idx);
+		else fprintf(src, ",\n\t\t.system = NULL");
+		fprintf(src, ",\n\t\t.orbit = {.cb = ");
+		fprint_body_ref(src, sym, b->orbit.cb != NULL ? get_catalog_body_index(&layout, b->orbit.cb) : -1);
+		fprintf(src, ", .e = "); fprint_double(src, b->orbit.e);
+		fprintf(src, ", .a = "); fprint_double(src, b->orbit.a);
+		fprintf(src, ", .i = "); fprint_double(src, b->orbit.i);
+		fprintf(src, ", .raan = "); fprint_double(src, b->orbit.raan);
+		fprintf(src, ", .arg_peri = "); fprint_double(src, b->orbit.arg_peri);
+		fprintf(src, ", .ta = "); fprint_double(src, b->orbit.ta);
+		fprintf(src, "}");
+		if(b->ephem != NULL && b->num_ephems > 0) fprintf(src, ",\n\t\t.ephem = %s_ephem_%d,\n\t\t.num_ephems = %d\n\t},\n", sym, i, b->num_ephems);
+		else fprintf(src, ",\n\t\t.ephem = NULL,\n\t\t.num_ephems = 0\n\t},\n");
+
+		char body_macro[64];
+		get_identifier(b->name, body_macro, sizeof(body_macro), 1);
+		fprintf(hdr, "#define ORBITLIB_CATALOG_%s_%s_MU ", macro_prefix, body_macro); fprint_double(hdr, b->mu);
+		fprintf(hdr, "\n#define ORBITLIB_CATALOG_%s_%s_RADIUS ", macro_prefix, body_macro); fprint_double(hdr, b->radius);
+		fprintf(hdr, "\n#define ORBITLIB_CATALOG_%s_%s_ID %d\n", macro_prefix, body_macro, b->id);
+	}
+	fprintf(src, "};\n\n");
+
+	fprintf(src, "static CelestSystem %s_systems[%d] = {\n", sym, layout.num_systems);
+	for(int i = 0; i < layout.num_systems; i++) {
+		CelestSystem *s = layout.systems[i];
+		fprintf(src, "\t{\n\t\t.name = ");
+		fprint_string_literal(src, s->name);
+		fprintf(src, ",\n\t\t.num_bodies = %d,\n\t\t.cb = ", s->num_bodies);
+		fprint_body_ref(src, sym, get_catalog_body_index(&layout, s->cb));
+		fprintf(src, ",\n\t\t.home_body = ");
+		fprint_body_ref(src, sym, s->home_body != NULL ? get_catalog_body_index(&layout, s->home_body) : -1);
+		if(s->num_bodies > 0) fprintf(src, ",\n\t\t.bodies = %s_bodies_of_%d", sym, i);
+		else fprintf(src, ",\n\t\t.bodies = NULL");
+		fprintf(src, ",\n\t\t.prop_method = %s", s->prop_method == EPHEMS ? "EPHEMS" : "ORB_ELEMENTS");
+		fprintf(src, ",\n\t\t.ut0 = "); fprint_double(src, s->ut0);
+		fprintf(src, ",\n\t\t.time_scale = %s", s->time_scale == TIMESCALE_UTC ? "TIMESCALE_UTC" : s->time_scale == TIMESCALE_TAI ? "TIMESCALE_TAI" : s->time_scale == TIMESCALE_TT ? "TIMESCALE_TT" : "TIMESCALE_TDB");
+		fprintf(src, ",\n\t\t.mem_block = NULL\n\t},\n");
+	}
+	fprintf(src, "};\n");
+
+	free(layout.systems);
+	free(layout.bodies);
+}
+
+static int are_all_ephems_available(CelestSystem *system, const char *ephem_directory) {
+	for(int i = 0; i < system->num_bodies; i++) {
+		if(!is_ephem_available(system->bodies[i]->id, ephem_directory)) {
+			fprintf(stderr, "Ephemeris file of %s (%d) not found in %s\n", system->bodies[i]->name, system->bodies[i]->id, ephem_directory);
+			return 0;
+		}
+		if(system->bodies[i]->system != NULL && !are_all_ephems_available(system->bodies[i]->system, ephem_directory)) return 0;
+	}
+	return 1;
+}
+
+static CelestSystem * load_catalog_system(const char *filepath, const char *ephem_directory) {
+	FILE *file = fopen(filepath, "rb");
+	if(file == NULL) {
+		perror(filepath);
+		return NULL;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	char *buffer = malloc(size+1);
+	size = (long) fread(buffer, 1, size, file);
+	fclose(file);
+
+	CfgParseError error = {0};
+	CelestSystem *system = load_celestial_system_from_cfg_buffer(buffer, size, &error);
+	free(buffer);
+	if(system == NULL) {
+		fprintf(stderr, "%s:%d:%d: %s\n", filepath, error.line, error.column, error.message);
+		return NULL;
+	}
+
+	if(system->prop_method == EPHEMS) {
+		if(ephem_directory != NULL && are_all_ephems_available(system, ephem_directory)) {
+			load_celestial_system_ephems(system, ephem_directory);
+		} else {
+			fprintf(stderr, "%s: no ephemerides embedded; compiled in as propagated with orbital elements\n", filepath);
+			system->prop_method = ORB_ELEMENTS;
+		}
+	}
+	return system;
+}
+
+int main(int argc, char **argv) {
+	const char *ephem_directory = NULL;
+	int arg = 1;
+	if(arg+1 < argc && strcmp(argv[arg], "--ephemerides") == 0) {
+		ephem_directory = argv[arg+1];
+		arg += 2;
+	}
+	if(argc - arg < 2) {
+		fprintf(stderr, "Usage: %s [--ephemerides <dir>] <output.c> <output.h> <system.cfg>...\n", argv[0]);
+		return 1;
+	}
+	const char *src_path = argv[arg++];
+	const char *hdr_path = argv[arg++];
+
+	FILE *src = fopen(src_path, "w");
+	FILE *hdr = fopen(hdr_path, "w");
+	if(src == NULL || hdr == NULL) {
+		perror("Unable to open output file");
+		return 1;
+	}
+
+	fprintf(src, "// Generated by orbitlib_catalog_gen - do not edit\n\n"
+				 "#include \"orbitlib_celestial.h\"\n"
+				 "#include <stddef.h>\n"
+				 "#include <math.h>\n");
+	fprintf(hdr, "// Generated by orbitlib_catalog_gen - do not edit\n\n"
+				 "#ifndef ORBITLIB_CATALOG_CONSTANTS_H\n"
+				 "#define ORBITLIB_CATALOG_CONSTANTS_H\n\n");
+
+	int num_catalogs = argc - arg;
+	char (*symbols)[64] = malloc((num_catalogs > 0 ? num_catalogs : 1) * sizeof(*symbols));
+	for(int i = 0; i < num_catalogs; i++) {
+		CelestSystem *system = load_catalog_system(argv[arg+i], ephem_directory);
+		if(system == NULL) return 1;
+
+		char macro_prefix[64];
+		get_identifier(system->name, symbols[i], sizeof(symbols[i]), 0);
+		get_identifier(system->name, macro_prefix, sizeof(macro_prefix), 1);
+		fprintf(hdr, "// %s\n", system->name);
+		write_catalog(src, hdr, system, symbols[i], macro_prefix);
+		fprintf(hdr, "\n");
+		free_celestial_system(system);
+	}
+
+	fprintf(src, "\nconst int orbitlib_num_static_catalogs = %d;\n", num_catalogs);
+	fprintf(src, "const CelestSystem * const orbitlib_static_catalogs[%d] = {\n", num_catalogs > 0 ? num_catalogs : 1);
+	for(int i = 0; i < num_catalogs; i++) fprintf(src, "\t&%s_systems[0],\n", symbols[i]);
+	if(num_catalogs == 0) fprintf(src, "\tNULL\n");
+	fprintf(src, "};\n");
+	fprintf(hdr, "#endif // ORBITLIB_CATALOG_CONSTANTS_H\n");
+
+	free(symbols);
+	fclose(src);
+	fclose(hdr);
+	return 0;
+}